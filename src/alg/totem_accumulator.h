@@ -0,0 +1,108 @@
+/**
+ * Defines an open addressing hash map that accumulates values per vertex, as
+ * used by the CPU algorithms that aggregate the edges or the wedges of a
+ * vertex by neighbor or by community (totem_louvain.cu and
+ * totem_similarity.cu). Each thread owns one, which is sized for the keys of
+ * the vertex at hand; only the slots used since the last clear are reset,
+ * hence clearing costs as much as the additions did.
+ */
+
+#ifndef TOTEM_ACCUMULATOR_H
+#define TOTEM_ACCUMULATOR_H
+
+// totem includes
+#include "totem_comdef.h"
+#include "totem_mem.h"
+
+// The minimum capacity of an accumulator.
+const uint64_t ACCUMULATOR_MIN_CAPACITY = 16;
+
+// Marks an empty slot in an accumulator.
+#define ACCUMULATOR_EMPTY_SLOT ((vid_t)-1)
+
+/**
+ * An accumulator of values of type value_t. A zeroed accumulator is empty and
+ * holds no buffers.
+ */
+template<typename value_t>
+struct accumulator_t {
+  vid_t*    keys;       // the key stored in each slot
+  value_t*  values;     // the accumulated value of each slot
+  uint64_t* used;       // the slots used since the last clear
+  uint64_t  used_count;
+  uint64_t  capacity;   // a power of two, or zero before the first reserve
+};
+
+/**
+ * Frees the buffers of an accumulator, which becomes empty.
+ * @param[in] map the accumulator
+ */
+template<typename value_t>
+void accumulator_finalize(accumulator_t<value_t>* map) {
+  if (map->capacity == 0) return;
+  totem_free(map->keys, TOTEM_MEM_HOST);
+  totem_free(map->values, TOTEM_MEM_HOST);
+  totem_free(map->used, TOTEM_MEM_HOST);
+  map->capacity = 0;
+  map->used_count = 0;
+}
+
+/**
+ * Ensures that an accumulator can hold the given number of keys at a load
+ * factor of at most one half. The capacity only grows, and the accumulator
+ * must be cleared.
+ * @param[in] map the accumulator
+ * @param[in] count the number of keys
+ */
+template<typename value_t>
+void accumulator_reserve(accumulator_t<value_t>* map, uint64_t count) {
+  uint64_t capacity = map->capacity ? map->capacity : ACCUMULATOR_MIN_CAPACITY;
+  while (capacity < 2 * count) capacity <<= 1;
+  if (capacity == map->capacity) return;
+  accumulator_finalize(map);
+  map->capacity = capacity;
+  CALL_SAFE(totem_malloc(capacity * sizeof(vid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&map->keys)));
+  CALL_SAFE(totem_malloc(capacity * sizeof(value_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&map->values)));
+  CALL_SAFE(totem_malloc(capacity * sizeof(uint64_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&map->used)));
+  totem_memset(map->keys, ACCUMULATOR_EMPTY_SLOT, capacity, TOTEM_MEM_HOST);
+}
+
+/**
+ * Adds a value to the value of a key, which starts at zero.
+ * @param[in] map the accumulator
+ * @param[in] key the key, which must not be ACCUMULATOR_EMPTY_SLOT
+ * @param[in] value the value to add
+ */
+template<typename value_t>
+inline void accumulator_add(accumulator_t<value_t>* map, vid_t key,
+                            value_t value) {
+  uint64_t mask = map->capacity - 1;
+  uint64_t slot = (vid_t)(key * 2654435761u) & mask;
+  while (map->keys[slot] != key) {
+    if (map->keys[slot] == ACCUMULATOR_EMPTY_SLOT) {
+      map->keys[slot] = key;
+      map->values[slot] = 0;
+      map->used[map->used_count++] = slot;
+      break;
+    }
+    slot = (slot + 1) & mask;
+  }
+  map->values[slot] += value;
+}
+
+/**
+ * Removes all the keys of an accumulator.
+ * @param[in] map the accumulator
+ */
+template<typename value_t>
+inline void accumulator_clear(accumulator_t<value_t>* map) {
+  for (uint64_t i = 0; i < map->used_count; i++) {
+    map->keys[map->used[i]] = ACCUMULATOR_EMPTY_SLOT;
+  }
+  map->used_count = 0;
+}
+
+#endif  // TOTEM_ACCUMULATOR_H
@@ -164,6 +164,72 @@ error_t sssp_vwarp_gpu(const graph_t* graph, vid_t src_id,
                        weight_t* distance);
 error_t sssp_hybrid(vid_t src_id, weight_t* distance);
 
+/**
+ * The state of the engine that repairs BFS and SSSP distances after a batch
+ * of edge updates. It is sized by the vertex count, not tied to a graph, since
+ * every batch comes with the updated graph. Its arrays are tagged with the id
+ * of the repair or round that last wrote them, hence a repair does not pay for
+ * clearing them. An engine runs one repair at a time.
+ */
+typedef struct distance_repair_s {
+  vid_t     vertex_count;
+  uint32_t* status;         // the repair and invalidation state of each vertex
+  uint32_t* round;          // the round in which each vertex was last activated
+  vid_t*    frontier;       // the vertices relaxed in the current round
+  vid_t*    next;           // the vertices to relax in the next round
+  vid_t     next_count;
+  vid_t*    invalid;        // the vertices invalidated by the current repair
+  uint32_t  repair;         // the id of the current repair
+  uint32_t  current_round;  // the id of the current round
+} distance_repair_t;
+
+/**
+ * Builds and frees the state of the distance repair engine.
+ * @param[in]  vertex_count the number of vertices of the graphs to repair
+ * @param[out] engine the state of the engine
+ * @return generic success or failure
+ */
+error_t distance_repair_initialize(vid_t vertex_count,
+                                   distance_repair_t** engine);
+error_t distance_repair_finalize(distance_repair_t* engine);
+
+/**
+ * Repairs the distances from a source, as computed by bfs_cpu or sssp_cpu,
+ * after a batch of edge updates, with work proportional to the region of the
+ * graph whose distances change. The edges whose removal (or weight increase)
+ * leaves a vertex without a shortest path invalidate the subtree below it,
+ * which is re-derived from its valid neighbors; then, the distances are
+ * relaxed forward from the re-derived vertices and the end points of the
+ * inserted edges (or of those whose weight decreased). The edges of an
+ * undirected graph apply in both directions, and their weights are assumed to
+ * be symmetric. Algorithm details are described in totem_distance_repair.cu.
+ *
+ * @param[in] engine the state of the engine
+ * @param[in] graph the graph after the batch has been applied to it
+ * @param[in] incoming the transpose of the graph, which is only used for
+ *                     directed graphs; if NULL, it is built when the batch has
+ *                     deletions, at the cost of a pass over the edges
+ * @param[in] source the source of the distances
+ * @param[in] inserted the edges inserted by the batch, or whose weight
+ *                     decreased to the given one (SSSP)
+ * @param[in] inserted_count the number of inserted edges
+ * @param[in] deleted the edges deleted by the batch, or whose weight increased
+ *                    (SSSP)
+ * @param[in] deleted_count the number of deleted edges
+ * @param[in,out] cost the distances before the batch, repaired in place
+ * @return generic success or failure
+ */
+error_t bfs_repair_cpu(distance_repair_t* engine, const graph_t* graph,
+                       const graph_t* incoming, vid_t source,
+                       const edge_t* inserted, eid_t inserted_count,
+                       const edge_t* deleted, eid_t deleted_count,
+                       cost_t* cost);
+error_t sssp_repair_cpu(distance_repair_t* engine, const graph_t* graph,
+                        const graph_t* incoming, vid_t source,
+                        const edge_t* decreased, eid_t decreased_count,
+                        const edge_t* increased, eid_t increased_count,
+                        weight_t* distance);
+
 /**
  * Identifies the connected components in an undirected graph.
  * @param[out] labels the id of the component the vertex belongs to.
@@ -188,8 +254,37 @@ error_t apsp_cpu(graph_t* graph, weight_t** distances);
 error_t apsp_gpu(graph_t* graph, weight_t** distances);
 
 /**
- * Implements a version of the Label Propagation algorithm described in
- * [Xie 2013] for CPU. Algorithm details are described in
+ * Methods available to the CPU implementation of All Pairs Shortest Path.
+ */
+typedef enum {
+  APSP_METHOD_AUTO = 0,       // picks one of the two below based on density
+  APSP_METHOD_FLOYD_WARSHALL, // cache-blocked Floyd-Warshall, O(V^3)
+  APSP_METHOD_DIJKSTRA        // a Dijkstra run from every vertex, for sparse
+                              // graphs
+} apsp_method_t;
+
+/**
+ * Similar to apsp_cpu, with control over the method used. When file_path is
+ * not NULL, the distances are written to that file (in the same row-major
+ * layout as the in-memory result) rather than returned in memory. The file is
+ * read and written in blocks of rows, hence only a few blocks of rows are held
+ * in memory. This allows computing graphs whose distance matrix does not fit
+ * in memory.
+ *
+ * @param[in] graph an instance of the graph structure
+ * @param[in] method the method used to compute the distances
+ * @param[in] file_path the output file, or NULL for an in-memory result
+ * @param[out] distances the computed distances if file_path is NULL; NULL
+ *                       otherwise
+ * @return generic success or failure
+ */
+error_t apsp_cpu_config(graph_t* graph, apsp_method_t method,
+                        const char* file_path, weight_t** distances);
+
+/**
+ * Implements the asynchronous Label Propagation algorithm described in
+ * [Raghavan 2007] for CPU. Each vertex holds a single label, hence the memory
+ * footprint is O(V + E). Algorithm details are described in
  * totem_label_propagation.cu.
  * TODO(tanuj): Declare a data type label_t.
  *
@@ -200,6 +295,27 @@ error_t apsp_gpu(graph_t* graph, weight_t** distances);
  */
 error_t label_propagation_cpu(const graph_t* graph, vid_t* labels);
 
+/**
+ * Implements the Louvain modularity optimization algorithm described in
+ * [Blondel08] for CPU, with the parallel local moving heuristics of [Lu15].
+ * Each level moves vertices between communities until the modularity stops
+ * improving, then aggregates the communities into the vertices of a coarse
+ * graph, which is the input of the next level. The coarse graphs reuse two
+ * buffers sized after the input graph. Algorithm details are described in
+ * totem_louvain.cu.
+ *
+ * The graph must be undirected. Edge weights, if any, are taken into account,
+ * and the sum of the weights of all the edges must fit in weight_t, as the
+ * coarse graphs store the aggregated weights in it.
+ *
+ * @param[in] graph an instance of the graph structure
+ * @param[out] community the community of each vertex, densely numbered from 0
+ * @param[out] modularity the modularity of the computed communities
+ * @return generic success or failure
+ */
+error_t louvain_cpu(const graph_t* graph, vid_t* community,
+                    double* modularity);
+
 /**
  * Implements a version of the simple PageRank algorithm described in
  * [Malewicz 2010] for both CPU and CPU. Algorithm details are described in
@@ -220,6 +336,70 @@ error_t page_rank_incoming_gpu(graph_t* graph, rank_t* rank_i, rank_t* rank);
 error_t page_rank_hybrid(rank_t* rank_i, rank_t* rank);
 error_t page_rank_incoming_hybrid(rank_t* rank_i, rank_t* rank);
 
+/**
+ * The state of the engine that updates PageRank after batches of edge
+ * updates. It is sized by the vertex count, not tied to a graph, since every
+ * batch comes with the updated graph. The residuals that a batch leaves within
+ * the tolerance are kept for the next batch rather than dropped, hence the
+ * error of the ranks does not grow along a stream of batches; the activations
+ * are tagged with the id of the round that last wrote them. Hence, a batch
+ * does not pay for allocating or clearing per-vertex state. An engine runs one
+ * batch at a time, and its residuals belong to the ranks it last produced.
+ */
+typedef struct page_rank_incremental_s {
+  const graph_t* graph;     // the graph of the current batch
+  vid_t     vertex_count;
+  rank_t    tolerance;      // the tolerance of the current batch
+  rank_t*   residual;       // the residual of each vertex
+  rank_t*   delta;          // the residuals moved by the current round
+  uint32_t* round;          // the round in which each vertex was last activated
+  vid_t*    frontier;       // the vertices pushed in the current round
+  vid_t*    next;           // the vertices to push in the next round
+  vid_t     next_count;
+  uint32_t  current_round;  // the id of the current round
+  bool      ranked;         // whether the engine has produced ranks
+} page_rank_incremental_t;
+
+/**
+ * Builds and frees the state of the incremental PageRank engine.
+ * @param[in]  vertex_count the number of vertices of the graphs to update
+ * @param[out] engine the state of the engine
+ * @return generic success or failure
+ */
+error_t page_rank_incremental_initialize(vid_t vertex_count,
+                                         page_rank_incremental_t** engine);
+error_t page_rank_incremental_finalize(page_rank_incremental_t* engine);
+
+/**
+ * Updates the PageRank of a graph after a batch of edge insertions and
+ * deletions, by pushing the residual changes of the ranks from the vertices
+ * affected by the batch until no residual exceeds the tolerance. The ranks are
+ * the fixed point of the formulation of page_rank_cpu, rather than the result
+ * of a fixed number of rounds. The first call on an engine computes the ranks
+ * from scratch, ignoring the batch; each later call updates in place the ranks
+ * produced by the previous one, which the engine holds the residuals of. The
+ * previous ranks are not kept: a caller that needs them copies them first.
+ * Algorithm details are described in totem_page_rank_incremental.cu.
+ * @param[in]  engine the state of the engine
+ * @param[in]  graph the graph after the batch has been applied to it
+ * @param[in]  inserted the edges inserted by the batch
+ * @param[in]  inserted_count the number of inserted edges
+ * @param[in]  deleted the edges deleted by the batch
+ * @param[in]  deleted_count the number of deleted edges
+ * @param[in]  tolerance the largest residual left at any vertex; the error of
+ *             the ranks is at most tolerance * vertex_count /
+ *             (1 - PAGE_RANK_DAMPING_FACTOR) in total
+ * @param[in,out] rank the ranks before the batch, which are replaced by the
+ *                ranks after it; a rejected batch leaves them unchanged
+ * @return generic success or failure
+ */
+error_t page_rank_incremental_cpu(page_rank_incremental_t* engine,
+                                  const graph_t* graph,
+                                  const edge_t* inserted,
+                                  eid_t inserted_count,
+                                  const edge_t* deleted, eid_t deleted_count,
+                                  rank_t tolerance, rank_t* rank);
+
 
 /**
  * Implements the push-relabel algorithm for determining the Maximum flow
@@ -240,6 +420,43 @@ error_t maxflow_gpu(graph_t* graph, vid_t source_id, vid_t sink_id,
 error_t maxflow_vwarp_gpu(graph_t* graph, vid_t source_id, vid_t sink_id,
                           weight_t* flow_ret);
 
+/**
+ * The residual graph used by the CPU push-relabel implementation. Every edge
+ * (u,v) of the network is paired with a reverse edge (v,u); antiparallel and
+ * parallel edges are merged into one edge whose capacity is their sum, hence
+ * the CPU implementation does not require the network to be a flow network in
+ * the strict sense above. The residual graph depends only on the network, so
+ * it can be built once and shared by several flow computations.
+ */
+typedef struct maxflow_residual_s {
+  graph_t* original;  // the flow network
+  graph_t* graph;     // the merged graph, edges are sorted by neighbor
+  eid_t*   reverse;   // index of the reverse of each edge of graph
+} maxflow_residual_t;
+
+/**
+ * Builds and frees the residual graph of a flow network.
+ * @param[in]  graph the flow network
+ * @param[out] residual the residual graph of the network
+ * @return generic success or failure
+ */
+error_t maxflow_residual_initialize(graph_t* graph,
+                                    maxflow_residual_t** residual);
+error_t maxflow_residual_finalize(maxflow_residual_t* residual);
+
+/**
+ * Similar to maxflow_cpu, but runs on a residual graph built by
+ * maxflow_residual_initialize.
+ * @param[in]  residual the residual graph of the flow network
+ * @param[in]  source_id the id of the source vertex
+ * @param[in]  sink_id the id of the sink vertex
+ * @param[out] flow_ret the maximum flow through the network
+ * @return generic success or failure
+ */
+error_t maxflow_residual_cpu(const maxflow_residual_t* residual,
+                             vid_t source_id, vid_t sink_id,
+                             weight_t* flow_ret);
+
 /**
  * Given a weighted and undirected graph, the algorithm identifies for each
  * vertex the largest p-core it is part of. A p-core is the maximal subset of
@@ -253,6 +470,9 @@ error_t maxflow_vwarp_gpu(graph_t* graph, vid_t source_id, vid_t sink_id,
  * between "start" and the maximum p the graph has. In each round, "p" is
  * incremented by "step". The output array "round" stores the latest round
  * (equivalent to the highest p-core) a vertex was part of.
+ * The CPU implementation peels the vertices from bucket queues keyed by their
+ * current weight sum, hence its work is linear in the size of the graph rather
+ * than in the number of rounds times the number of vertices.
  *
  * @param[in] graph an instance of the graph structure
  * @param[in] start the start value of p
@@ -263,14 +483,440 @@ error_t maxflow_vwarp_gpu(graph_t* graph, vid_t source_id, vid_t sink_id,
 error_t pcore_cpu(const graph_t* graph, uint32_t start, uint32_t step,
                   uint32_t** round);
 
+/**
+ * Similar to pcore_cpu, but sweeps over all the vertices in every iteration of
+ * every round until no vertex falls under the round's threshold, rather than
+ * peeling vertices from bucket queues. It is kept as a reference to validate
+ * and time pcore_cpu against.
+ */
+error_t pcore_sweep_cpu(const graph_t* graph, uint32_t start, uint32_t step,
+                        uint32_t** round);
+
 error_t pcore_gpu(const graph_t* graph, uint32_t start, uint32_t step,
                   uint32_t** round);
 
+/**
+ * Computes the core number of each vertex of an undirected graph, that is, the
+ * largest k such that the vertex is part of the k-core. Edge weights, if any,
+ * are ignored. The computation shares the bucket-based peeling engine of
+ * pcore_cpu.
+ *
+ * @param[in] graph an instance of the graph structure
+ * @param[out] core the core number of each vertex, allocated in pinned memory
+ * @return generic success or failure.
+ */
+error_t kcore_cpu(const graph_t* graph, uint32_t** core);
+
+/**
+ * Computes the trussness of each edge of an undirected graph, that is, the
+ * largest k such that the edge is part of the k-truss, the largest subgraph in
+ * which every edge closes at least k - 2 triangles. Edges that are not part
+ * of any triangle have trussness 2. The neighbor lists must be sorted, and
+ * edge weights, if any, are ignored. Algorithm details are described in
+ * totem_ktruss.cu.
+ *
+ * @param[in] graph an instance of the graph structure
+ * @param[out] truss the trussness of each edge, indexed like the edges array
+ *                   of the graph (0 for self loops), allocated in pinned
+ *                   memory; NULL if the graph has no edges
+ * @return generic success or failure.
+ */
+error_t ktruss_cpu(const graph_t* graph, uint32_t** truss);
+
+/**
+ * Computes a minimum spanning forest of an undirected graph via a parallel
+ * version of Boruvka's algorithm. The weight of an edge is the one stored in
+ * the neighbor list of its smaller endpoint (DEFAULT_EDGE_WEIGHT if the graph
+ * is not weighted); ties are broken by edge index, hence the forest is unique.
+ * Algorithm details are described in totem_msf.cu.
+ *
+ * @param[in] graph an instance of the graph structure
+ * @param[out] forest the edges of the forest, as sorted indices in the edges
+ *                    array of the graph, allocated in pinned memory; NULL if
+ *                    the graph has no edges
+ * @param[out] forest_count the number of edges in the forest
+ * @param[out] total_weight the sum of the weights of the edges in the forest
+ * @return generic success or failure.
+ */
+error_t msf_cpu(const graph_t* graph, eid_t** forest, vid_t* forest_count,
+                uint64_t* total_weight);
+
+/**
+ * Colors the vertices of an undirected graph such that no two neighbors have
+ * the same color, via the Jones-Plassmann algorithm with largest-degree-first
+ * priorities. The vertices of a color class are independent, hence they can
+ * be updated concurrently by asynchronous algorithms. Self loops are ignored.
+ * Algorithm details are described in totem_coloring.cu.
+ *
+ * @param[in] graph an instance of the graph structure
+ * @param[out] colors the color of each vertex, in the range [0, color_count),
+ *                    allocated in pinned memory
+ * @param[out] color_count the number of colors used
+ * @param[out] rounds the number of rounds the algorithm took
+ * @return generic success or failure.
+ */
+error_t coloring_cpu(const graph_t* graph, uint32_t** colors,
+                     uint32_t* color_count, uint32_t* rounds);
+
+/**
+ * Computes a maximal independent set of an undirected graph via the random
+ * priority variant of Luby's algorithm. Self loops are ignored. Algorithm
+ * details are described in totem_coloring.cu.
+ *
+ * @param[in] graph an instance of the graph structure
+ * @param[out] in_set whether each vertex is in the set, allocated in pinned
+ *                    memory
+ * @param[out] set_size the number of vertices in the set
+ * @param[out] rounds the number of rounds the algorithm took
+ * @return generic success or failure.
+ */
+error_t mis_cpu(const graph_t* graph, bool** in_set, vid_t* set_size,
+                uint32_t* rounds);
+
+/**
+ * Computes the biconnected components (blocks) of an undirected graph, along
+ * with its articulation points and bridges, via a parallel version of the
+ * Tarjan-Vishkin algorithm. Algorithm details are described in
+ * totem_biconnected.cu.
+ *
+ * @param[in] graph an instance of the graph structure
+ * @param[out] block the block of each edge, in the range [0, block_count),
+ *                   indexed like the edges array of the graph (INFINITE for
+ *                   self loops), allocated in pinned memory; NULL if the graph
+ *                   has no edges
+ * @param[out] block_count the number of blocks
+ * @param[out] articulation whether each vertex is an articulation point,
+ *                          allocated in pinned memory
+ * @param[out] bridge whether each edge is a bridge, indexed like the edges
+ *                    array of the graph, allocated in pinned memory; NULL if
+ *                    the graph has no edges
+ * @return generic success or failure.
+ */
+error_t biconnected_components_cpu(const graph_t* graph, vid_t** block,
+                                   vid_t* block_count, bool** articulation,
+                                   bool** bridge);
+
+/**
+ * Configuration of the random walk engine. Walk i starts at vertex
+ * i % vertex_count; hence, the first vertex_count walks start at every vertex
+ * once, and so on. Setting both node2vec parameters to 1 yields first order
+ * walks, as in DeepWalk.
+ */
+typedef struct random_walk_config_s {
+  uint32_t walk_length;       // the number of vertices in a walk, including
+                              // its start
+  uint32_t walks_per_vertex;  // the number of walks started at each vertex
+                              // when all the walks are generated
+  bool     weighted;          // transitions proportional to the edge weights
+  double   return_param;      // node2vec p, the bias against returning to the
+                              // previous vertex
+  double   inout_param;       // node2vec q, the bias against moving away from
+                              // the previous vertex
+  uint64_t seed;              // the seed of the random number generator
+} random_walk_config_t;
+
+/**
+ * The transition state of the random walk engine, built once per graph and
+ * configuration. The alias tables are indexed like the edges array of the
+ * graph, and are only built for weighted walks.
+ */
+typedef struct random_walk_sampler_s {
+  const graph_t*       graph;
+  random_walk_config_t config;
+  float*               alias_prob;    // the probability to keep each entry
+  eid_t*               alias;         // the entry that replaces each entry
+  bool                 second_order;  // whether node2vec biases apply
+  double               max_bias;      // the largest node2vec bias
+} random_walk_sampler_t;
+
+/**
+ * Statistics of a random walk run.
+ */
+typedef struct random_walk_stats_s {
+  uint64_t walks;             // the number of walks generated
+  uint64_t steps;             // the number of transitions taken
+  double   time;              // the elapsed time in milliseconds
+  double   steps_per_second;  // the throughput of the run
+} random_walk_stats_t;
+
+/**
+ * Builds and frees the transition state of the random walk engine. Second
+ * order walks require the neighbor lists of the graph to be sorted, and
+ * weighted walks require a weighted graph. Walks follow the outgoing edges of
+ * directed graphs. Algorithm details are described in totem_random_walk.cu.
+ *
+ * @param[in]  graph an instance of the graph structure
+ * @param[in]  config the configuration of the walks
+ * @param[out] sampler the transition state of the engine
+ * @return generic success or failure
+ */
+error_t random_walk_sampler_initialize(const graph_t* graph,
+                                       const random_walk_config_t* config,
+                                       random_walk_sampler_t** sampler);
+error_t random_walk_sampler_finalize(random_walk_sampler_t* sampler);
+
+/**
+ * Generates the walks [first_walk, first_walk + walk_count) in parallel. A
+ * walk is the same regardless of the batch it is generated in, hence large
+ * runs can be split into batches that fit in memory. A walk that reaches a
+ * vertex without neighbors stops, and the rest of it is filled with INFINITE.
+ *
+ * @param[in]  sampler the transition state of the engine
+ * @param[in]  first_walk the id of the first walk to generate
+ * @param[in]  walk_count the number of walks to generate
+ * @param[out] walks the vertices of each walk, walk_count * walk_length
+ *                   entries allocated by the caller
+ * @param[out] stats the statistics of the run, or NULL
+ * @return generic success or failure
+ */
+error_t random_walk_cpu(const random_walk_sampler_t* sampler,
+                        uint64_t first_walk, uint64_t walk_count,
+                        vid_t* walks, random_walk_stats_t* stats);
+
+/**
+ * Generates walks_per_vertex walks per vertex, and streams them in batches to
+ * a binary file, in the same layout as the output of random_walk_cpu.
+ *
+ * @param[in]  sampler the transition state of the engine
+ * @param[in]  file_path the output file
+ * @param[out] stats the statistics of the run, or NULL
+ * @return generic success or failure
+ */
+error_t random_walk_file_cpu(const random_walk_sampler_t* sampler,
+                             const char* file_path,
+                             random_walk_stats_t* stats);
+
+/**
+ * Estimates the neighborhood function of a graph via the HyperANF algorithm,
+ * that is, for each distance t, the number of pairs (u, v) such that v is
+ * reachable from u via at most t edges. Each vertex holds a HyperLogLog
+ * counter of 2^log2_registers one-byte registers, whose relative standard
+ * error is about 1.04 / sqrt(2^log2_registers). Edges are followed in their
+ * direction. Algorithm details are described in totem_hyperanf.cu.
+ *
+ * @param[in] graph an instance of the graph structure
+ * @param[in] log2_registers the log of the number of registers per counter,
+ *                           in the range [4, 16]
+ * @param[in] max_distance the largest distance to compute, 0 for no limit
+ * @param[out] neighborhood the estimated number of pairs within each distance,
+ *                          allocated in pinned memory; the last entry is the
+ *                          number of reachable pairs, unless the computation
+ *                          was stopped at max_distance
+ * @param[out] distance_count the number of entries in neighborhood
+ * @param[out] effective_diameter the (interpolated) distance within which 90%
+ *                                of the reachable pairs are
+ * @param[out] average_distance the average distance of the reachable pairs of
+ *                              distinct vertices
+ * @return generic success or failure
+ */
+error_t hyperanf_cpu(const graph_t* graph, uint32_t log2_registers,
+                     uint32_t max_distance, double** neighborhood,
+                     uint32_t* distance_count, double* effective_diameter,
+                     double* average_distance);
+
+/**
+ * The metrics of the vertex similarity engine. The score of a pair (v, w)
+ * derives from their common neighbors: their number, the number divided by the
+ * size of the union of their neighbor sets (Jaccard), or the sum of
+ * 1 / log(degree) over them (Adamic-Adar).
+ */
+typedef enum {
+  SIMILARITY_COMMON_NEIGHBORS = 0,
+  SIMILARITY_JACCARD,
+  SIMILARITY_ADAMIC_ADAR
+} similarity_metric_t;
+
+/**
+ * The configuration of the vertex similarity engine.
+ */
+typedef struct similarity_config_s {
+  similarity_metric_t metric;
+  uint32_t k;                 // the maximum number of results per vertex
+  eid_t    hub_threshold;     // intermediate vertices with a larger degree
+                              // do not generate candidates, 0 for no limit
+  bool     exclude_neighbors; // whether existing neighbors are excluded, as
+                              // required for link prediction
+} similarity_config_t;
+
+/**
+ * Finds for each vertex v the (at most) k vertices w within two hops that are
+ * most similar to it, ordered by decreasing score, and by increasing id for
+ * equal scores. The candidates of v are the vertices reachable from it via a
+ * non-hub intermediate vertex, while their scores are exact. The neighbor
+ * lists must be sorted (see graph_sort_nbrs), and the graph must be
+ * undirected. Algorithm details are described in totem_similarity.cu.
+ *
+ * @param[in]  graph an instance of the graph structure
+ * @param[in]  config the configuration of the engine
+ * @param[out] offsets the results of vertex v are in the range
+ *                     [offsets[v], offsets[v + 1]) of neighbors and scores,
+ *                     allocated in pinned memory
+ * @param[out] neighbors the similar vertices, allocated in pinned memory, or
+ *                       NULL if there are no results
+ * @param[out] scores the score of each result, allocated in pinned memory, or
+ *                    NULL if there are no results
+ * @return generic success or failure
+ */
+error_t similarity_topk_cpu(const graph_t* graph,
+                            const similarity_config_t* config,
+                            eid_t** offsets, vid_t** neighbors,
+                            float** scores);
+
+/**
+ * The state of the point-to-point query engine, built once per graph and
+ * reused by every query. The arrays of each of the two searches (from the
+ * source, and towards the target) are tagged with the id of the query that
+ * last wrote them, hence a query does not pay for clearing them.
+ */
+typedef struct point_to_point_s {
+  const graph_t* graph;
+  const graph_t* incoming;     // the incoming edges, the graph itself if
+                               // undirected and unweighted
+  weight_t*      distance[2];  // the tentative distance of each vertex
+  vid_t*         parent[2];    // the predecessor in the search tree
+  vid_t*         position[2];  // the position of each vertex in the queue
+  vid_t*         heap[2];      // the priority (Dijkstra) or FIFO (BFS) queue
+  vid_t          heap_size[2];
+  uint32_t*      stamp[2];     // the query that last reached each vertex
+  uint32_t       query;        // the id of the current query
+} point_to_point_t;
+
+/**
+ * Builds and frees the state of the point-to-point query engine. For directed
+ * or weighted graphs, the transpose of the graph is built to search towards
+ * the target.
+ * An engine answers one query at a time; concurrent queries require an engine
+ * each. Algorithm details are described in totem_point_to_point.cu.
+ *
+ * @param[in]  graph an instance of the graph structure
+ * @param[out] engine the state of the engine
+ * @return generic success or failure
+ */
+error_t point_to_point_initialize(const graph_t* graph,
+                                  point_to_point_t** engine);
+error_t point_to_point_finalize(point_to_point_t* engine);
+
+/**
+ * Computes the number of hops of a shortest path from source to target via a
+ * bidirectional BFS, which expands the smaller frontier first, and stops as
+ * soon as the two searches meet.
+ *
+ * @param[in]  engine the state of the query engine
+ * @param[in]  source id of the source vertex
+ * @param[in]  target id of the target vertex
+ * @param[out] distance the number of hops, INFINITE if target is unreachable
+ * @param[out] path the vertices of a shortest path from source to target, at
+ *                  most vertex_count entries allocated by the caller, or NULL
+ * @param[out] path_length the number of vertices in path, 0 if target is
+ *                         unreachable; may be NULL if path is NULL
+ * @return generic success or failure
+ */
+error_t point_to_point_bfs_cpu(point_to_point_t* engine, vid_t source,
+                               vid_t target, vid_t* distance, vid_t* path,
+                               vid_t* path_length);
+
+/**
+ * Computes the length of a shortest path from source to target in a weighted
+ * graph via a bidirectional Dijkstra, which stops once the sum of the smallest
+ * tentative distances of the two searches is not smaller than the best path.
+ * The parameters are the same as point_to_point_bfs_cpu, except that distance
+ * is WEIGHT_MAX if target is unreachable.
+ */
+error_t point_to_point_dijkstra_cpu(point_to_point_t* engine, vid_t source,
+                                    vid_t target, weight_t* distance,
+                                    vid_t* path, vid_t* path_length);
+
+/**
+ * The heuristics that select the landmarks of a landmark index.
+ */
+typedef enum {
+  LANDMARK_SELECTION_DEGREE = 0,  // the vertices with the highest degree
+  LANDMARK_SELECTION_FARTHEST     // each landmark is the vertex farthest from
+                                  // the ones selected before it
+} landmark_selection_t;
+
+/**
+ * A landmark distance oracle: the distances from and to each landmark, stored
+ * vertex major (the distance between vertex v and landmark i is at
+ * v * landmark_count + i), in 16 bits if compact is set and in weight_t
+ * otherwise. Unreachable entries are the largest value of their type. The
+ * distances are weighted if the graph is weighted, and hop counts otherwise.
+ */
+typedef struct landmark_index_s {
+  const graph_t* graph;
+  uint32_t       landmark_count;
+  const vid_t*   landmarks;
+  bool           weighted;
+  bool           compact;
+  const void*    from;            // the distances from the landmarks
+  const void*    to;              // the distances to the landmarks, the same
+                                  // table as from if they are symmetric
+  void*          mapping;         // the mapped index file, NULL if built
+  size_t         mapping_length;
+} landmark_index_t;
+
+/**
+ * Builds a landmark index, or loads one stored in a file, and frees it. A
+ * loaded index refers to the file via a read-only memory mapping, and must be
+ * loaded with the same graph it was built for. Algorithm details are
+ * described in totem_landmark.cu.
+ *
+ * @param[in]  graph an instance of the graph structure
+ * @param[in]  landmark_count the number of landmarks, at most vertex_count
+ * @param[in]  selection the heuristic that selects the landmarks
+ * @param[out] index the landmark index
+ * @return generic success or failure
+ */
+error_t landmark_index_build_cpu(const graph_t* graph,
+                                 uint32_t landmark_count,
+                                 landmark_selection_t selection,
+                                 landmark_index_t** index);
+error_t landmark_index_store(const landmark_index_t* index,
+                             const char* file_path);
+error_t landmark_index_load(const graph_t* graph, const char* file_path,
+                            landmark_index_t** index);
+error_t landmark_index_finalize(landmark_index_t* index);
+
+/**
+ * Bounds the distance from source to target via the triangle inequality over
+ * the landmarks, without searching the graph.
+ *
+ * @param[in]  index the landmark index
+ * @param[in]  source id of the source vertex
+ * @param[in]  target id of the target vertex
+ * @param[out] lower a lower bound, INFINITE if target is proven unreachable
+ * @param[out] upper the length of the shortest path via a landmark, INFINITE
+ *                   if there is none
+ * @return generic success or failure
+ */
+error_t landmark_estimate(const landmark_index_t* index, vid_t source,
+                          vid_t target, weight_t* lower, weight_t* upper);
+
+/**
+ * Returns the lower bound of landmark_estimate for two distinct vertices,
+ * without checking its parameters.
+ */
+weight_t landmark_lower_bound(const landmark_index_t* index, vid_t source,
+                              vid_t target);
+
+/**
+ * Computes the exact distance from source to target via an A* search guided by
+ * the lower bounds of a landmark index, built for the graph of the engine.
+ * Unweighted graphs count hops. The parameters are the same as
+ * point_to_point_dijkstra_cpu, except that distance is INFINITE if target is
+ * unreachable.
+ */
+error_t point_to_point_alt_cpu(point_to_point_t* engine,
+                               const landmark_index_t* index, vid_t source,
+                               vid_t target, weight_t* distance, vid_t* path,
+                               vid_t* path_length);
+
 
 /**
  * Given an [un]directed, unweighted graph, a source vertex, and a destination
  * vertex. Check if the destination is reachable from the source using the CPU
- * and GPU, respectively.
+ * and GPU, respectively. The CPU version is a bidirectional BFS, described in
+ * totem_point_to_point.cu.
  * @param[in] source_id id of the source vertex
  * @param[in] destination_id id of the destination vertex
  * @param[in] graph the graph to perform BFS on
@@ -345,6 +991,40 @@ error_t closeness_unweighted_cpu(const graph_t* graph,
 error_t closeness_unweighted_gpu(const graph_t* graph,
                                  weight_t** centrality_score);
 
+/**
+ * Calculates closeness centrality scores for unweighted graphs. With
+ * CENTRALITY_EXACT, a BFS is run from every vertex. Otherwise, the scores are
+ * estimated from BFS traversals rooted at log2(|V|) / epsilon^2 pivots, drawn
+ * uniformly with replacement over all the vertices with a fixed seed, as
+ * described in "Fast Approximation of Centrality" [Eppstein04], which
+ * bounds the error of the estimated average distance of each vertex by
+ * epsilon times the diameter with high probability. The approximation
+ * requires an undirected graph.
+ * @param[in] graph the graph
+ * @param[in] epsilon determines how precise the results of the algorithm will
+ *            be, and thus also how long it will take to compute
+ * @param[out] centrality_score the output list of closeness centrality scores
+ *             per vertex
+ * @return generic success or failure
+ */
+error_t closeness_cpu(const graph_t* graph, double epsilon,
+                      score_t* centrality_score);
+
+/**
+ * Finds the k vertices with the highest closeness centrality and their exact
+ * scores. BFS traversals are pruned once an upper bound on the closeness of
+ * their source drops below the k-th best score found so far [Bergamini16].
+ * @param[in] graph the graph
+ * @param[in] k the number of vertices to find
+ * @param[out] top_vertices the ids of the top k vertices, in decreasing order
+ *             of closeness
+ * @param[out] top_scores the closeness centrality score of each of the top k
+ *             vertices
+ * @return generic success or failure
+ */
+error_t closeness_topk_cpu(const graph_t* graph, vid_t k, vid_t* top_vertices,
+                           score_t* top_scores);
+
 /**
  * Calculate stress centrality scores for unweighted graphs.
  * @param[in] graph the graph
@@ -357,6 +1037,41 @@ error_t stress_unweighted_cpu(const graph_t* graph,
 error_t stress_unweighted_gpu(const graph_t* graph,
                               weight_t** centrality_score);
 
+/**
+ * Selects the metrics computed by the fused centrality pass. The values are
+ * bit flags that can be combined (e.g., CENTRALITY_METRIC_CLOSENESS |
+ * CENTRALITY_METRIC_BETWEENNESS).
+ */
+typedef enum {
+  CENTRALITY_METRIC_CLOSENESS   = 0x1,
+  CENTRALITY_METRIC_STRESS      = 0x2,
+  CENTRALITY_METRIC_BETWEENNESS = 0x4,
+  CENTRALITY_METRIC_ALL         = 0x7
+} centrality_metric_t;
+
+/**
+ * Calculates closeness, stress and betweenness centrality scores for
+ * unweighted graphs from a single BFS traversal per source vertex. With
+ * CENTRALITY_EXACT, every vertex is a source, and the scores match the ones of
+ * closeness_cpu, stress_unweighted_cpu and betweenness_cpu, respectively.
+ * Otherwise, the traversals are rooted at log2(|V|) / epsilon^2 pivots drawn
+ * like in closeness_cpu: stress and betweenness are scaled by (|V| / number of
+ * pivots), and closeness is estimated as in closeness_cpu, which requires an
+ * undirected graph. Metrics that are not selected are not computed, and their
+ * output buffers may be NULL.
+ * @param[in] graph the graph
+ * @param[in] epsilon determines how precise the results of the algorithm will
+ *            be, and thus also how long it will take to compute
+ * @param[in] metrics a bitwise-or of the centrality_metric_t values to compute
+ * @param[out] closeness closeness centrality score of each vertex
+ * @param[out] stress stress centrality score of each vertex
+ * @param[out] betweenness betweenness centrality score of each vertex
+ * @return generic success or failure
+ */
+error_t centrality_cpu(const graph_t* graph, double epsilon, uint32_t metrics,
+                       score_t* closeness, score_t* stress,
+                       score_t* betweenness);
+
 
 typedef struct frontier_state_s {
   bitmap_t current;         // current frontier bitmap
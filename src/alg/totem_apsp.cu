@@ -1,6 +1,7 @@
 /*
- * All pairs shortest path algorithm based on the Floyd-Warshall algorithm for
- * the CPU implementation.
+ * All pairs shortest path algorithm. The CPU implementation is based on either
+ * a cache-blocked Floyd-Warshall for dense graphs, or a Dijkstra run from every
+ * vertex for sparse ones.
  * According to [Harish07], running Dijkstra's algorithm for every vertex on the
  * graph, as compared to a parallel Floyd-Warshall algorithm, was both more
  * memory efficient (O(V) as compared to O(V^2)) and faster.
@@ -9,6 +10,10 @@
  *      Author: Greg Redekop
  */
 
+// system includes
+#include <fcntl.h>
+#include <unistd.h>
+
 // totem includes
 #include "totem_alg.h"
 
@@ -259,50 +264,417 @@ error_t apsp_gpu(graph_t* graph, weight_t** path_ret) {
    return FAILURE;
 }
 
+// The side of the square tiles processed by the blocked Floyd-Warshall. A tile
+// of 4-byte distances is 16KB, hence the three tiles involved in a min-plus
+// product fit in the L1/L2 caches.
+#define APSP_BLOCK_SIZE 64
+
+// Repeated Dijkstra is used when the graph has fewer than V^2 / factor edges.
+// Floyd-Warshall costs V^3 regardless of the edge count, while V Dijkstra runs
+// cost about V * E * log(V) and do not vectorize.
+#define APSP_SPARSE_FACTOR 16
+
+// Number of rows read, updated and written back together when the distances
+// are computed into a file.
+#define APSP_FILE_ROW_BLOCK 256
+
+// Marks a vertex that is not in the heap of the Dijkstra traversal.
+#define APSP_NOT_IN_HEAP ((vid_t)-1)
+
 /**
- * CPU implementation of the All-Pairs Shortest Path algorithm.
+ * Adds two distances, saturating at WEIGHT_MAX (unreachable). It is branch
+ * free so that the min-plus loops below vectorize.
  */
-error_t apsp_cpu(graph_t* graph, weight_t** path_ret) {
-  bool finished;
-  error_t ret_val = check_special_cases(graph, path_ret, &finished);
-  if (finished) return ret_val;
+inline PRIVATE weight_t apsp_add(weight_t a, weight_t b) {
+  weight_t sum = a + b;
+  // If the addition wrapped around, the sum is smaller than either operand.
+  return sum | -(weight_t)(sum < a);
+}
 
+/**
+ * Initializes the rows [row_start, row_end) of the distances from the edge
+ * list. The distances buffer points to the first of these rows.
+ */
+PRIVATE void apsp_init_rows(const graph_t* graph, vid_t row_start,
+                            vid_t row_end, weight_t* distances) {
   vid_t v_count = graph->vertex_count;
-  // The distances array mimics a static array to avoid the overhead of
-  // creating an array of pointers. Thus, accessing index [i][j] will be
-  // done as distances[(i * v_count) + j]
-  weight_t* distances = NULL;
-  CALL_SAFE(totem_malloc(graph->vertex_count * graph->vertex_count * 
-                         sizeof(weight_t), TOTEM_MEM_HOST_PINNED, 
-                         (void**)&distances));
-
-  // Initialize the path cost from the edge list
-  for (vid_t src = 0; src < v_count; src++) {
-    weight_t* base = &distances[src * v_count];
-    // Initialize path lengths to WEIGHT_MAX.
+  OMP(omp parallel for schedule(static))
+  for (vid_t src = row_start; src < row_end; src++) {
+    weight_t* base = &distances[(size_t)(src - row_start) * v_count];
     for (vid_t dest = 0; dest < v_count; dest++) {
       base[dest] = (weight_t)WEIGHT_MAX;
     }
     for (eid_t edge = graph->vertices[src]; edge < graph->vertices[src + 1];
          edge++) {
-      base[graph->edges[edge]] = graph->weights[edge];
+      vid_t dest = graph->edges[edge];
+      base[dest] = min(base[dest], graph->weights[edge]);
     }
     // 0 distance to oneself
     base[src] = 0;
   }
+}
 
-  // Run the main loop |V| times to converge.
-  for (vid_t mid = 0; mid < v_count; mid++) {
-    OMP(omp parallel for)
-    for (vid_t src = 0; src < v_count; src++) {
-      weight_t* base = &distances[src * v_count];
-      weight_t* mid_base = &distances[mid * v_count];
-      for (vid_t dest = 0; dest < v_count; dest++) {
-        base[dest] = min(base[dest], base[mid] + mid_base[dest]);
+/**
+ * Relaxes the tile (ib, jb) through the vertices of tile kb:
+ * d[i][j] = min(d[i][j], d[i][k] + d[k][j]) for i, j and k in their tiles.
+ * The innermost loop is a branch-free min-plus over contiguous rows, which the
+ * compiler turns into SIMD instructions.
+ */
+PRIVATE void apsp_minplus_tile(weight_t* distances, vid_t v_count, vid_t ib,
+                               vid_t jb, vid_t kb) {
+  vid_t i_end = min(ib + APSP_BLOCK_SIZE, v_count);
+  vid_t j_end = min(jb + APSP_BLOCK_SIZE, v_count);
+  vid_t k_end = min(kb + APSP_BLOCK_SIZE, v_count);
+  for (vid_t k = kb; k < k_end; k++) {
+    const weight_t* __restrict row_k = &distances[(size_t)k * v_count];
+    for (vid_t i = ib; i < i_end; i++) {
+      weight_t* __restrict row_i = &distances[(size_t)i * v_count];
+      weight_t d_ik = row_i[k];
+      // Row k is not changed through vertex k itself, and skipping it keeps
+      // the two rows from aliasing.
+      if (i == k || d_ik == WEIGHT_MAX) continue;
+      for (vid_t j = jb; j < j_end; j++) {
+        weight_t via = apsp_add(d_ik, row_k[j]);
+        row_i[j] = via < row_i[j] ? via : row_i[j];
+      }
+    }
+  }
+}
+
+/**
+ * Cache-blocked Floyd-Warshall. For each diagonal tile kb, it runs the
+ * classical three phases: (1) the diagonal tile itself, (2) the tiles of row
+ * kb and column kb, which depend on the diagonal tile only, and (3) all the
+ * remaining tiles, which depend on the tiles of phase two only. The tiles of
+ * phases two and three are independent, and are processed in parallel.
+ */
+PRIVATE void apsp_floyd_warshall(const graph_t* graph, weight_t* distances) {
+  vid_t v_count = graph->vertex_count;
+  apsp_init_rows(graph, 0, v_count, distances);
+  vid_t tiles = (v_count + APSP_BLOCK_SIZE - 1) / APSP_BLOCK_SIZE;
+  for (vid_t kt = 0; kt < tiles; kt++) {
+    vid_t kb = kt * APSP_BLOCK_SIZE;
+    // Phase one: the diagonal tile.
+    apsp_minplus_tile(distances, v_count, kb, kb, kb);
+
+    // Phase two: the tiles in the row and the column of the diagonal tile.
+    OMP(omp parallel for schedule(dynamic))
+    for (vid_t t = 0; t < 2 * tiles; t++) {
+      vid_t other = (t % tiles) * APSP_BLOCK_SIZE;
+      if (other == kb) continue;
+      if (t < tiles) {
+        apsp_minplus_tile(distances, v_count, kb, other, kb);
+      } else {
+        apsp_minplus_tile(distances, v_count, other, kb, kb);
+      }
+    }
+
+    // Phase three: the remaining tiles.
+    OMP(omp parallel for schedule(dynamic))
+    for (uint64_t t = 0; t < (uint64_t)tiles * tiles; t++) {
+      vid_t ib = (vid_t)(t / tiles) * APSP_BLOCK_SIZE;
+      vid_t jb = (vid_t)(t % tiles) * APSP_BLOCK_SIZE;
+      if (ib == kb || jb == kb) continue;
+      apsp_minplus_tile(distances, v_count, ib, jb, kb);
+    }
+  }
+}
+
+/**
+ * Restores the heap property of the Dijkstra heap upwards from index i.
+ */
+PRIVATE void apsp_heap_up(vid_t* heap, vid_t* position,
+                          const weight_t* distance, vid_t i) {
+  vid_t v = heap[i];
+  while (i > 0) {
+    vid_t parent = (i - 1) / 2;
+    if (distance[heap[parent]] <= distance[v]) break;
+    heap[i] = heap[parent];
+    position[heap[i]] = i;
+    i = parent;
+  }
+  heap[i] = v;
+  position[v] = i;
+}
+
+/**
+ * Restores the heap property of the Dijkstra heap downwards from the root.
+ */
+PRIVATE void apsp_heap_down(vid_t* heap, vid_t* position,
+                            const weight_t* distance, vid_t size) {
+  vid_t i = 0;
+  vid_t v = heap[0];
+  while (true) {
+    vid_t child = 2 * i + 1;
+    if (child >= size) break;
+    if ((child + 1 < size) &&
+        (distance[heap[child + 1]] < distance[heap[child]])) {
+      child++;
+    }
+    if (distance[v] <= distance[heap[child]]) break;
+    heap[i] = heap[child];
+    position[heap[i]] = i;
+    i = child;
+  }
+  heap[i] = v;
+  position[v] = i;
+}
+
+/**
+ * Sequential Dijkstra from one source with an indexed binary heap. The output
+ * row is used as the distance array. Since the weights are unsigned, no
+ * reweighting is needed as in Johnson's algorithm. The position array must be
+ * set to APSP_NOT_IN_HEAP, and it is left so on return.
+ */
+PRIVATE void apsp_dijkstra(const graph_t* graph, vid_t source,
+                           weight_t* distance, vid_t* heap, vid_t* position) {
+  for (vid_t v = 0; v < graph->vertex_count; v++) {
+    distance[v] = (weight_t)WEIGHT_MAX;
+  }
+  distance[source] = 0;
+  heap[0] = source;
+  position[source] = 0;
+  vid_t size = 1;
+  while (size > 0) {
+    vid_t u = heap[0];
+    position[u] = APSP_NOT_IN_HEAP;
+    size--;
+    if (size > 0) {
+      heap[0] = heap[size];
+      apsp_heap_down(heap, position, distance, size);
+    }
+    for (eid_t e = graph->vertices[u]; e < graph->vertices[u + 1]; e++) {
+      vid_t v = graph->edges[e];
+      weight_t new_distance = apsp_add(distance[u], graph->weights[e]);
+      if (new_distance >= distance[v]) continue;
+      bool queued = (distance[v] != WEIGHT_MAX);
+      distance[v] = new_distance;
+      if (!queued) {
+        // The vertex is reached for the first time.
+        heap[size] = v;
+        apsp_heap_up(heap, position, distance, size++);
+      } else if (position[v] != APSP_NOT_IN_HEAP) {
+        apsp_heap_up(heap, position, distance, position[v]);
+      }
+    }
+  }
+}
+
+/**
+ * Runs Dijkstra from the sources [row_start, row_end) in parallel. The
+ * distances buffer points to the row of the first source.
+ */
+PRIVATE void apsp_dijkstra_rows(const graph_t* graph, vid_t row_start,
+                                vid_t row_end, weight_t* distances) {
+  vid_t v_count = graph->vertex_count;
+  OMP(omp parallel)
+  {
+    vid_t* heap = NULL;
+    vid_t* position = NULL;
+    CALL_SAFE(totem_malloc(v_count * sizeof(vid_t), TOTEM_MEM_HOST,
+                           (void**)&heap));
+    CALL_SAFE(totem_malloc(v_count * sizeof(vid_t), TOTEM_MEM_HOST,
+                           (void**)&position));
+    totem_memset(position, APSP_NOT_IN_HEAP, v_count, TOTEM_MEM_HOST);
+    OMP(omp for schedule(dynamic))
+    for (vid_t src = row_start; src < row_end; src++) {
+      apsp_dijkstra(graph, src, &distances[(size_t)(src - row_start) * v_count],
+                    heap, position);
+    }
+    totem_free(heap, TOTEM_MEM_HOST);
+    totem_free(position, TOTEM_MEM_HOST);
+  }
+}
+
+/**
+ * Resolves APSP_METHOD_AUTO to one of the two methods based on the density of
+ * the graph.
+ */
+PRIVATE apsp_method_t apsp_select_method(const graph_t* graph,
+                                         apsp_method_t method) {
+  if (method != APSP_METHOD_AUTO) return method;
+  uint64_t v_count = graph->vertex_count;
+  if ((uint64_t)graph->edge_count * APSP_SPARSE_FACTOR < v_count * v_count) {
+    return APSP_METHOD_DIJKSTRA;
+  }
+  return APSP_METHOD_FLOYD_WARSHALL;
+}
+
+/**
+ * Reads (if write is false) or writes the rows [row_start, row_end) of the
+ * distance matrix from/to the file. pread and pwrite may transfer fewer bytes
+ * than requested, hence they are retried until the whole range is done.
+ */
+PRIVATE error_t apsp_file_rows(int fd, vid_t v_count, vid_t row_start,
+                               vid_t row_end, weight_t* rows, bool write) {
+  size_t row_size = (size_t)v_count * sizeof(weight_t);
+  char* buffer = reinterpret_cast<char*>(rows);
+  size_t length = row_size * (row_end - row_start);
+  off_t offset = (off_t)(row_size * row_start);
+  while (length > 0) {
+    ssize_t done = write ? pwrite(fd, buffer, length, offset) :
+        pread(fd, buffer, length, offset);
+    if (done <= 0) return FAILURE;
+    buffer += done;
+    length -= done;
+    offset += done;
+  }
+  return SUCCESS;
+}
+
+/**
+ * Relaxes the rows [row_start, row_end) through the vertices of the panel
+ * [kb, k_end), whose rows are final: d[i][j] = min(d[i][j], d[i][k] + d[k][j]).
+ * The rows buffer points to the row of row_start. Rows of the panel itself are
+ * skipped; they are computed by apsp_file_panel.
+ */
+PRIVATE void apsp_file_relax_rows(vid_t v_count, vid_t row_start,
+                                  vid_t row_end, weight_t* rows,
+                                  const weight_t* panel, vid_t kb,
+                                  vid_t k_end) {
+  OMP(omp parallel for schedule(static))
+  for (vid_t i = row_start; i < row_end; i++) {
+    if (i >= kb && i < k_end) continue;
+    weight_t* __restrict row_i = &rows[(size_t)(i - row_start) * v_count];
+    for (vid_t k = kb; k < k_end; k++) {
+      const weight_t* __restrict row_k = &panel[(size_t)(k - kb) * v_count];
+      weight_t d_ik = row_i[k];
+      if (d_ik == WEIGHT_MAX) continue;
+      for (vid_t j = 0; j < v_count; j++) {
+        weight_t via = apsp_add(d_ik, row_k[j]);
+        row_i[j] = via < row_i[j] ? via : row_i[j];
+      }
+    }
+  }
+}
+
+/**
+ * Relaxes the rows of the panel [kb, k_end) through the vertices of the panel,
+ * one vertex at a time as in the classical Floyd-Warshall. This finalizes the
+ * panel for the current round.
+ */
+PRIVATE void apsp_file_panel(vid_t v_count, weight_t* panel, vid_t kb,
+                             vid_t k_end) {
+  for (vid_t k = kb; k < k_end; k++) {
+    const weight_t* __restrict row_k = &panel[(size_t)(k - kb) * v_count];
+    OMP(omp parallel for schedule(static))
+    for (vid_t i = kb; i < k_end; i++) {
+      weight_t* __restrict row_i = &panel[(size_t)(i - kb) * v_count];
+      weight_t d_ik = row_i[k];
+      // Row k is not changed through vertex k itself.
+      if (i == k || d_ik == WEIGHT_MAX) continue;
+      for (vid_t j = 0; j < v_count; j++) {
+        weight_t via = apsp_add(d_ik, row_k[j]);
+        row_i[j] = via < row_i[j] ? via : row_i[j];
       }
     }
   }
+}
+
+/**
+ * Out-of-core Floyd-Warshall over the distance matrix stored in the file. Each
+ * round k reads the panel of APSP_BLOCK_SIZE rows [kb, kb + APSP_BLOCK_SIZE),
+ * finalizes it and writes it back, then streams the remaining rows one block
+ * of APSP_FILE_ROW_BLOCK rows at a time and relaxes them through the panel.
+ * Hence, only the panel and one row block are resident at any time.
+ */
+PRIVATE error_t apsp_file_floyd_warshall(const graph_t* graph, int fd,
+                                         weight_t* panel, weight_t* rows) {
+  vid_t v_count = graph->vertex_count;
+  for (vid_t row = 0; row < v_count; row += APSP_FILE_ROW_BLOCK) {
+    vid_t row_end = min(row + APSP_FILE_ROW_BLOCK, v_count);
+    apsp_init_rows(graph, row, row_end, rows);
+    CHK_SUCCESS(apsp_file_rows(fd, v_count, row, row_end, rows, true), err);
+  }
+  for (vid_t kb = 0; kb < v_count; kb += APSP_BLOCK_SIZE) {
+    vid_t k_end = min(kb + APSP_BLOCK_SIZE, v_count);
+    CHK_SUCCESS(apsp_file_rows(fd, v_count, kb, k_end, panel, false), err);
+    apsp_file_panel(v_count, panel, kb, k_end);
+    CHK_SUCCESS(apsp_file_rows(fd, v_count, kb, k_end, panel, true), err);
+    for (vid_t row = 0; row < v_count; row += APSP_FILE_ROW_BLOCK) {
+      vid_t row_end = min(row + APSP_FILE_ROW_BLOCK, v_count);
+      // Skip a block that holds only panel rows.
+      if (row >= kb && row_end <= k_end) continue;
+      CHK_SUCCESS(apsp_file_rows(fd, v_count, row, row_end, rows, false), err);
+      apsp_file_relax_rows(v_count, row, row_end, rows, panel, kb, k_end);
+      CHK_SUCCESS(apsp_file_rows(fd, v_count, row, row_end, rows, true), err);
+    }
+  }
+  return SUCCESS;
+ err:
+  return FAILURE;
+}
+
+/**
+ * Computes the distances into a file through explicit reads and writes of
+ * bounded row blocks, hence the distance matrix never needs to be resident.
+ * Repeated Dijkstra computes one block of rows at a time and writes it out;
+ * Floyd-Warshall is described in apsp_file_floyd_warshall.
+ */
+PRIVATE error_t apsp_cpu_file(const graph_t* graph, apsp_method_t method,
+                              const char* file_path) {
+  vid_t v_count = graph->vertex_count;
+  size_t row_size = (size_t)v_count * sizeof(weight_t);
+  int fd = open(file_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) return FAILURE;
+
+  weight_t* rows = NULL;
+  weight_t* panel = NULL;
+  CALL_SAFE(totem_malloc(row_size * min(v_count, (vid_t)APSP_FILE_ROW_BLOCK),
+                         TOTEM_MEM_HOST, (void**)&rows));
+  error_t rc = SUCCESS;
+  if (method == APSP_METHOD_FLOYD_WARSHALL) {
+    CALL_SAFE(totem_malloc(row_size * min(v_count, (vid_t)APSP_BLOCK_SIZE),
+                           TOTEM_MEM_HOST, (void**)&panel));
+    rc = apsp_file_floyd_warshall(graph, fd, panel, rows);
+    totem_free(panel, TOTEM_MEM_HOST);
+  } else {
+    for (vid_t row = 0; row < v_count && rc == SUCCESS;
+         row += APSP_FILE_ROW_BLOCK) {
+      vid_t row_end = min(row + APSP_FILE_ROW_BLOCK, v_count);
+      apsp_dijkstra_rows(graph, row, row_end, rows);
+      rc = apsp_file_rows(fd, v_count, row, row_end, rows, true);
+    }
+  }
+  totem_free(rows, TOTEM_MEM_HOST);
+  if (close(fd) != 0) rc = FAILURE;
+  return rc;
+}
+
+error_t apsp_cpu_config(graph_t* graph, apsp_method_t method,
+                        const char* file_path, weight_t** path_ret) {
+  if (file_path != NULL) {
+    if (path_ret) *path_ret = NULL;
+    if ((graph == NULL) || !graph->weighted || graph->vertex_count == 0) {
+      return FAILURE;
+    }
+    return apsp_cpu_file(graph, apsp_select_method(graph, method), file_path);
+  }
+
+  bool finished;
+  error_t ret_val = check_special_cases(graph, path_ret, &finished);
+  if (finished) return ret_val;
+
+  // The distances array mimics a static array to avoid the overhead of
+  // creating an array of pointers. Thus, accessing index [i][j] will be
+  // done as distances[(i * v_count) + j]
+  vid_t v_count = graph->vertex_count;
+  weight_t* distances = NULL;
+  CALL_SAFE(totem_malloc((size_t)v_count * v_count * sizeof(weight_t),
+                         TOTEM_MEM_HOST_PINNED, (void**)&distances));
+  if (apsp_select_method(graph, method) == APSP_METHOD_FLOYD_WARSHALL) {
+    apsp_floyd_warshall(graph, distances);
+  } else {
+    apsp_dijkstra_rows(graph, 0, v_count, distances);
+  }
 
   *path_ret = distances;
   return SUCCESS;
 }
+
+/**
+ * CPU implementation of the All-Pairs Shortest Path algorithm.
+ */
+error_t apsp_cpu(graph_t* graph, weight_t** path_ret) {
+  return apsp_cpu_config(graph, APSP_METHOD_AUTO, NULL, path_ret);
+}
@@ -8,6 +8,7 @@
 // totem includes
 #include "totem_alg.h"
 #include "totem_centrality.h"
+#include "totem_vertex_state.h"
 
 /**
  * Allocates and initializes memory on the GPU for the successors implementation
@@ -622,6 +623,28 @@ error_t betweenness_unweighted_cpu(const graph_t* graph,
   return SUCCESS;
 }
 
+/**
+ * The per-vertex state of the CPU implementation, in the default layout of the
+ * container. The forward sweep reads only the distances of the neighbors,
+ * which the default SoA layout keeps dense; packing the three fields in one
+ * record (VSTATE=AOS) was timed slower.
+ */
+typedef struct {
+  uint32_t numSPs;    // number of shortest paths from the source
+  score_t  delta;     // dependency of the vertex
+  cost_t   distance;  // distance from the source
+} betweenness_fields_t;
+typedef vertex_state_t<betweenness_fields_t, VERTEX_STATE_DEFAULT_LAYOUT>
+    betweenness_vertex_state_t;
+
+// Accessors of the fields of the per-vertex state.
+#define BC_NUMSPS(_state, _v)                                   \
+  vertex_state_get((_state), (_v), &betweenness_fields_t::numSPs)
+#define BC_DELTA(_state, _v)                                    \
+  vertex_state_get((_state), (_v), &betweenness_fields_t::delta)
+#define BC_DISTANCE(_state, _v)                                 \
+  vertex_state_get((_state), (_v), &betweenness_fields_t::distance)
+
 /**
  * Implements the forward propagation phase of the Betweenness Centrality
  * Algorithm described in Chapter 2 of GPU Computing Gems
@@ -629,24 +652,24 @@ error_t betweenness_unweighted_cpu(const graph_t* graph,
  * @param[in] source the source node for the shortest paths
  * @param[in] level the shared level variable between backward and forward
  *            propagations
- * @param[in] numSPs an array which counts the number of shortest paths in
- *            which each node is involved 
- * @param[in] distance an array which stores the distance of the shortest
- *            path for each node
+ * @param[in] state the per-vertex state, which holds the number of shortest
+ *            paths in which each node is involved and the distance of the
+ *            shortest path for each node
  * @return void
  */
 inline PRIVATE 
 void betweenness_cpu_forward_propagation(const graph_t* graph, 
                                          vid_t source, cost_t& level,
-                                         uint32_t* numSPs, cost_t* distance) {
+                                         const betweenness_vertex_state_t&
+                                         state) {
   // Initialize the shortest path count to 0 and distance to infinity given
   // this source node
-  totem_memset(numSPs, (uint32_t)0, graph->vertex_count, TOTEM_MEM_HOST);
-  totem_memset(distance, (cost_t)INF_COST, graph->vertex_count, TOTEM_MEM_HOST);
+  vertex_state_fill(state, &betweenness_fields_t::numSPs, (uint32_t)0);
+  vertex_state_fill(state, &betweenness_fields_t::distance, (cost_t)INF_COST);
   // Set the distance from source to itself to 0
-  distance[source] = 0;
+  BC_DISTANCE(state, source) = 0;
   // Set the shortest path count to 1 (from source to itself)
-  numSPs[source] = 1;
+  BC_NUMSPS(state, source) = 1;
 
   bool done = false;
   while (!done) {
@@ -654,16 +677,16 @@ void betweenness_cpu_forward_propagation(const graph_t* graph,
     // In parallel, iterate over vertices which are at the current level
     OMP(omp parallel for schedule(runtime) reduction(& : done))
     for (vid_t v = 0; v < graph->vertex_count; v++) {
-      if (distance[v] == level) {
+      if (BC_DISTANCE(state, v) == level) {
         // For all neighbors of v, iterate over paths
         for (eid_t e = graph->vertices[v]; e < graph->vertices[v + 1]; e++) {
           vid_t w = graph->edges[e];
-          if (distance[w] == INF_COST) {
-            distance[w] = level + 1;
+          if (BC_DISTANCE(state, w) == INF_COST) {
+            BC_DISTANCE(state, w) = level + 1;
             done = false;
           }
-          if (distance[w] == level + 1) {
-            __sync_fetch_and_add(&numSPs[w], numSPs[v]);
+          if (BC_DISTANCE(state, w) == level + 1) {
+            __sync_fetch_and_add(&BC_NUMSPS(state, w), BC_NUMSPS(state, v));
           }
         }
       }
@@ -678,39 +701,39 @@ void betweenness_cpu_forward_propagation(const graph_t* graph,
  * @param[in] graph the graph for which the centrality measure is calculated
  * @param[in] level the shared level variable between backward and forward
  *            propagations
- * @param[in] numSPs an array which counts the number of shortest paths in
- *            which each node is involved 
- * @param[in] distance an array which stores the distance of the shortest
- *            path for each node
- * @param[in] delta an array of the dependencies for each node, which are used
- *            to compute the betweenness centrality measure
+ * @param[in] state the per-vertex state, which holds the number of shortest
+ *            paths, the distance and the dependency of each node
  * @param[out] betweenness_centrality the output list which contains the
  *             betweenness centrality values computed for each node
  * @return void
  */
 inline PRIVATE 
 void betweenness_cpu_backward_propagation(const graph_t* graph,
-                                          cost_t& level, uint32_t* numSPs, 
-                                          cost_t* distance, score_t* delta, 
+                                          cost_t& level,
+                                          const betweenness_vertex_state_t&
+                                          state,
                                           score_t* betweenness_centrality) {
   // Set deltas to 0 for every input node
-  memset(delta, 0, graph->vertex_count * sizeof(score_t));
+  vertex_state_fill(state, &betweenness_fields_t::delta, (score_t)0);
   while (level > 1) {
     level--;
     // In parallel, iterate over vertices which are at the current level
     OMP(omp parallel for  schedule(runtime))
     for (vid_t v = 0; v < graph->vertex_count; v++) {
-      if (distance[v] == level) {
+      if (BC_DISTANCE(state, v) == level) {
+        score_t numSPs_v = (score_t)BC_NUMSPS(state, v);
+        score_t delta_v = BC_DELTA(state, v);
         // For all neighbors of v, iterate over paths
         for (eid_t e = graph->vertices[v]; e < graph->vertices[v + 1]; e++) {
           vid_t w = graph->edges[e];
-          if (distance[w] == level + 1) {
-            delta[v] = (delta[v] + ((((score_t)numSPs[v]) /
-                       ((score_t)numSPs[w]))*(delta[w] + 1)));
+          if (BC_DISTANCE(state, w) == level + 1) {
+            delta_v = (delta_v + ((numSPs_v / ((score_t)BC_NUMSPS(state, w))) *
+                                  (BC_DELTA(state, w) + 1)));
           }
         }
+        BC_DELTA(state, v) = delta_v;
         // Add the dependency to the BC sum
-        betweenness_centrality[v] = betweenness_centrality[v] + delta[v];
+        betweenness_centrality[v] = betweenness_centrality[v] + delta_v;
       }
     }
   }
@@ -720,27 +743,22 @@ void betweenness_cpu_backward_propagation(const graph_t* graph,
  * Implements the core functionality for computing Betweenness Centrality
  * @param[in] graph the graph for which the centrality measure is calculated
  * @param[in] source the source node for the shortest paths
- * @param[in] numSPs an array which counts the number of shortest paths in
- *            which each node is involved 
- * @param[in] distance an array which stores the distance of the shortest
- *            path for each node
- * @param[in] delta an array of the dependencies for each node, which are used
- *            to compute the betweenness centrality measure
+ * @param[in] state the per-vertex state (number of shortest paths, distance
+ *            and dependency of each node)
  * @param[out] betweenness_centrality the output list which contains the
  *             betweenness centrality values computed for each node
  * @return void
  */
 inline PRIVATE void betweenness_cpu_core(const graph_t* graph, vid_t source, 
-                                         uint32_t* numSPs, cost_t* distance, 
-                                         score_t* delta, 
+                                         const betweenness_vertex_state_t&
+                                         state,
                                          score_t* betweenness_score) {
   // Initialize variable to keep track of level
   cost_t level = 0;
   // Perform the forward propagation phase for this source node
-  betweenness_cpu_forward_propagation(graph, source, level, numSPs, distance);
+  betweenness_cpu_forward_propagation(graph, source, level, state);
   // Perform the backward propagation phase for this source node
-  betweenness_cpu_backward_propagation(graph, level, numSPs, distance, delta,
-                                       betweenness_score);
+  betweenness_cpu_backward_propagation(graph, level, state, betweenness_score);
 }
 
 /**
@@ -762,9 +780,9 @@ error_t betweenness_cpu(const graph_t* graph, double epsilon,
   if (finished) return rc;
 
   // Allocate memory for the shortest paths problem
-  cost_t* distance = (cost_t*)malloc(graph->vertex_count * sizeof(cost_t));
-  uint32_t* numSPs = (uint32_t*)malloc(graph->vertex_count * sizeof(uint32_t));
-  score_t* delta = (score_t*)malloc(graph->vertex_count * sizeof(score_t));
+  betweenness_vertex_state_t state;
+  CALL_SAFE(vertex_state_initialize(graph->vertex_count, TOTEM_MEM_HOST,
+                                    &state));
 
   // Initialization stage
   // Set BC(v) to 0 for every input node
@@ -775,8 +793,7 @@ error_t betweenness_cpu(const graph_t* graph, double epsilon,
     // Compute exact values for Betweenness Centrality
     for (vid_t source = 0; source < graph->vertex_count; source++) { 
       // Perform forward and backward propagation with source node
-      betweenness_cpu_core(graph, source, numSPs, distance, delta,
-                           betweenness_score);  
+      betweenness_cpu_core(graph, source, state, betweenness_score);
     }
   } else {
     // Compute approximate values based on the value of epsilon provided
@@ -791,8 +808,7 @@ error_t betweenness_cpu(const graph_t* graph, double epsilon,
       // Get the next sample node in the array to use as a source
       vid_t source = sample_nodes[source_index];
       // Perform forward and backward propagation with source node
-      betweenness_cpu_core(graph, source, numSPs, distance, delta,
-                           betweenness_score);   
+      betweenness_cpu_core(graph, source, state, betweenness_score);
     }
     
     // Scale the computed Betweenness Centrality metrics since they were
@@ -809,9 +825,7 @@ error_t betweenness_cpu(const graph_t* graph, double epsilon,
   }
 
   // Clean up the allocated memory
-  free(numSPs);
-  free(distance);
-  free(delta);
+  vertex_state_finalize(&state);
 
   return SUCCESS;
 }
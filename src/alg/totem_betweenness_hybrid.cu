@@ -31,6 +31,12 @@ typedef struct betweenness_state_s {
                          // to perform communication or not. This array is
                          // populated during the forward phase, and used during
                          // the backward propagation phase
+  vid_t* level_list;     // CPU partitions only: the local vertices visited by
+                         // the forward phase, ordered by level. The backward
+                         // phase replays it in reverse
+  vid_t* level_offset;   // CPU partitions only: start of each level in
+                         // level_list
+  vid_t  level_tail;     // CPU partitions only: end of level_list
 } betweenness_state_t;
 
 // State shared between all partitions.
@@ -235,30 +241,46 @@ void betweenness_forward_cpu(partition_t* par) {
   betweenness_state_t* state =
       reinterpret_cast<betweenness_state_t*>(par->algo_state);
   graph_t* subgraph = &par->subgraph;
-  cost_t* distance = state->distance[par->id];
   uint32_t* numSPs = state->numSPs[par->id];
+  vid_t* level_list = state->level_list;
+  const cost_t next = state->level + 1;
   bool done = true;
   bool comm = false;
+
+  // The vertices of the current level are the ones appended to the list since
+  // the previous level was closed, either by the expansion of the previous
+  // level or by the scatter of remote updates. Close the current level, the
+  // vertices discovered below are appended after it.
+  vid_t start = state->level_offset[state->level];
+  vid_t end = state->level_tail;
+  state->level_offset[next] = end;
+
   // In parallel, iterate over vertices which are at the current level.
   OMP(omp parallel for schedule(runtime) reduction(& : done)
       reduction(| : comm))
-  for (vid_t v = 0; v < subgraph->vertex_count; v++) {
-    if (distance[v] == state->level) {
-      for (eid_t e = subgraph->vertices[v]; e < subgraph->vertices[v + 1];
-           e++) {
-        vid_t nbr = GET_VERTEX_ID(subgraph->edges[e]);
-        int nbr_pid = GET_PARTITION_ID(subgraph->edges[e]);
-        cost_t* nbr_distance = state->distance[nbr_pid];
-        if (nbr_distance[nbr] == INF_COST) {
-          nbr_distance[nbr] = state->level + 1;
+  for (vid_t i = start; i < end; i++) {
+    vid_t v = level_list[i];
+    for (eid_t e = subgraph->vertices[v]; e < subgraph->vertices[v + 1];
+         e++) {
+      vid_t nbr = GET_VERTEX_ID(subgraph->edges[e]);
+      int nbr_pid = GET_PARTITION_ID(subgraph->edges[e]);
+      cost_t* nbr_distance = state->distance[nbr_pid];
+      if (nbr_distance[nbr] == INF_COST) {
+        if (nbr_pid != par->id) {
+          nbr_distance[nbr] = next;
+          done = false;
+          comm = true;
+        } else if (__sync_bool_compare_and_swap(&nbr_distance[nbr], INF_COST,
+                                                next)) {
+          // Only the thread that claims a local vertex appends it.
+          level_list[__sync_fetch_and_add(&state->level_tail, 1)] = nbr;
           done = false;
-          if (nbr_pid != par->id) comm = true;
-        }
-        if (nbr_distance[nbr] == state->level + 1) {
-          uint32_t* nbr_numSPs = state->numSPs_f[nbr_pid];
-          __sync_fetch_and_add(&nbr_numSPs[nbr], numSPs[v]);
         }
       }
+      if (nbr_distance[nbr] == next) {
+        uint32_t* nbr_numSPs = state->numSPs_f[nbr_pid];
+        __sync_fetch_and_add(&nbr_numSPs[nbr], numSPs[v]);
+      }
     }
   }
   if (!comm) {
@@ -468,36 +490,37 @@ void betweenness_backward_cpu(partition_t* par) {
   betweenness_state_t* state =
       reinterpret_cast<betweenness_state_t*>(par->algo_state);
   graph_t* subgraph = &par->subgraph;
-  cost_t* distance = state->distance[par->id];
   uint32_t* numSPs = state->numSPs[par->id];
   score_t* delta = state->delta[par->id];
+  const vid_t* level_list = state->level_list;
 
-  // In parallel, iterate over vertices which are at the current level.
+  // In parallel, iterate over vertices which are at the current level, as
+  // recorded by the forward phase.
+  vid_t start = state->level_offset[state->level];
+  vid_t end = state->level_offset[state->level + 1];
   OMP(omp parallel for schedule(runtime))
-  for (vid_t v = 0; v < subgraph->vertex_count; v++) {
-    cost_t v_distance = distance[v];
-    if (v_distance == state->level) {
-      // For all neighbors of v, iterate over paths.
-      score_t delta_v = 0;
-      for (eid_t e = subgraph->vertices[v]; e < subgraph->vertices[v + 1];
-           e++) {
-        vid_t nbr = GET_VERTEX_ID(subgraph->edges[e]);
-        int nbr_pid = GET_PARTITION_ID(subgraph->edges[e]);
-        cost_t* nbr_distance = state->distance[nbr_pid];
-
-        // Check whether the neighbour is local or remote and update
-        // accordingly.
-        if (nbr_distance[nbr] == state->level + 1) {
-          score_t* nbr_delta = state->delta[nbr_pid];
-          uint32_t* nbr_numSPs = state->numSPs[nbr_pid];
-          delta_v += ((((score_t)(numSPs[v])) / ((score_t)(nbr_numSPs[nbr]))) *
-                      (nbr_delta[nbr] + 1));
-        }
+  for (vid_t i = start; i < end; i++) {
+    vid_t v = level_list[i];
+    // For all neighbors of v, iterate over paths.
+    score_t delta_v = 0;
+    for (eid_t e = subgraph->vertices[v]; e < subgraph->vertices[v + 1];
+         e++) {
+      vid_t nbr = GET_VERTEX_ID(subgraph->edges[e]);
+      int nbr_pid = GET_PARTITION_ID(subgraph->edges[e]);
+      cost_t* nbr_distance = state->distance[nbr_pid];
+
+      // Check whether the neighbour is local or remote and update
+      // accordingly.
+      if (nbr_distance[nbr] == state->level + 1) {
+        score_t* nbr_delta = state->delta[nbr_pid];
+        uint32_t* nbr_numSPs = state->numSPs[nbr_pid];
+        delta_v += ((((score_t)(numSPs[v])) / ((score_t)(nbr_numSPs[nbr]))) *
+                    (nbr_delta[nbr] + 1));
       }
-      // Add the dependency to the BC sum.
-      delta[v] += delta_v;
-      state->betweenness[v] += delta[v];
     }
+    // Add the dependency to the BC sum.
+    delta[v] += delta_v;
+    state->betweenness[v] += delta[v];
   }
 }
 
@@ -553,9 +576,11 @@ PRIVATE inline void betweenness_scatter_cpu(int pid, grooves_box_table_t* inbox,
     if (inbox_values[index] != 0) {
       vid_t vid = inbox->rmt_nbrs[index];
       // If the distance was previously infinity, initialize it to the
-      // current level.
+      // current level and append the vertex to the level list. A vertex
+      // appears at most once in an inbox, hence no other thread claims it.
       if (distance[vid] == INF_COST) {
         distance[vid] = state->level;
+        state->level_list[__sync_fetch_and_add(&state->level_tail, 1)] = vid;
       }
       // If the distance is equal to the current level, update the nodes
       // number of shortest paths with the pushed value.
@@ -775,6 +800,15 @@ PRIVATE void betweenness_init_forward(partition_t* par) {
                            1, type, par->streams[1]));
   }
 
+  // Initialize the level list of CPU partitions with the source vertex.
+  if (par->processor.type == PROCESSOR_CPU) {
+    state->level_tail = 0;
+    state->level_offset[0] = 0;
+    if (src_pid == par->id) {
+      state->level_list[state->level_tail++] = src_vid;
+    }
+  }
+
   // Initialize the outbox to 0 and set the level to 0
   engine_set_outbox(par->id, 0);
   state->level = 0;
@@ -827,6 +861,16 @@ PRIVATE void betweenness_init(partition_t* par) {
   totem_calloc(engine_vertex_count(), TOTEM_MEM_HOST,
                reinterpret_cast<void**>(&state->comm));
 
+  // Allocate the level list of CPU partitions. A traversal has at most one
+  // level per vertex.
+  if (par->processor.type == PROCESSOR_CPU) {
+    CALL_SAFE(totem_malloc(vcount * sizeof(vid_t), TOTEM_MEM_HOST,
+                           reinterpret_cast<void**>(&state->level_list)));
+    CALL_SAFE(totem_malloc((engine_vertex_count() + 2) * sizeof(vid_t),
+                           TOTEM_MEM_HOST,
+                           reinterpret_cast<void**>(&state->level_offset)));
+  }
+
   // Initialize the state.
   betweenness_init_forward(par);
 }
@@ -855,6 +899,10 @@ PRIVATE void betweenness_finalize(partition_t* par) {
   totem_free(state->delta[par->id], type);
   totem_free(state->betweenness, type);
   totem_free(state->comm, TOTEM_MEM_HOST);
+  if (par->processor.type == PROCESSOR_CPU) {
+    totem_free(state->level_list, TOTEM_MEM_HOST);
+    totem_free(state->level_offset, TOTEM_MEM_HOST);
+  }
 
   // Free the per-partition state and set it to NULL.
   free(state);
@@ -0,0 +1,326 @@
+/**
+ * Implements a parallel version of the Tarjan-Vishkin biconnected components
+ * algorithm for CPU [Tarjan85] R. E. Tarjan, U. Vishkin, "An Efficient
+ * Parallel Biconnectivity Algorithm", SIAM Journal on Computing 14(4), 1985.
+ *
+ * Unlike the classic sequential algorithm of Hopcroft and Tarjan, it does not
+ * require a depth-first search tree; any spanning tree works. The algorithm
+ * proceeds as follows:
+ *   - a spanning forest is built via level-synchronous BFS. The parent of a
+ *     vertex is its smallest neighbor in the previous level, hence the forest
+ *     does not depend on the interleaving of the threads.
+ *   - the subtree size and the preorder number of each vertex are computed by
+ *     sweeping the BFS levels bottom-up and top-down, respectively.
+ *   - low(v) and high(v), the smallest and largest preorder numbers reachable
+ *     from the subtree of v via a single non-tree edge, are computed by
+ *     another bottom-up sweep.
+ *   - the tree edges, each identified by its child vertex, are grouped via a
+ *     concurrent union-find according to the two rules of Tarjan-Vishkin: a
+ *     non-tree edge connects the tree edges of its two endpoints if neither
+ *     endpoint is an ancestor of the other, and a tree edge (v, w) is in the
+ *     same block as the tree edge of v if the subtree of w reaches out of the
+ *     subtree of v.
+ *   - each non-tree edge joins the block of the tree edge of its endpoint with
+ *     the larger preorder number.
+ * All the steps take O(V + E) work, and the depth of the sweeps is the depth
+ * of the BFS forest.
+ */
+
+// totem includes
+#include "totem_alg.h"
+
+/**
+ * State of the algorithm. The BFS order lists the vertices component by
+ * component, and level by level within a component; the levels are delimited
+ * by the segments array.
+ */
+typedef struct {
+  vid_t* level;          // the BFS level of each vertex
+  vid_t* parent;         // the parent in the forest, roots are their own
+  vid_t* order;          // the vertices in BFS order
+  vid_t* segments;       // the start of each level in the BFS order
+  vid_t  segment_count;
+  vid_t* size;           // the size of the subtree of each vertex
+  vid_t* pre;            // the preorder number of each vertex
+  vid_t* low;            // the smallest preorder reachable from the subtree
+  vid_t* high;           // the largest preorder reachable from the subtree
+  vid_t* link;           // the union-find forest over the tree edges
+} bcc_state_t;
+
+/**
+ * Builds the BFS tree of the component of the given root, and appends its
+ * vertices to the BFS order.
+ */
+PRIVATE void bcc_bfs(const graph_t* graph, vid_t root, bcc_state_t* state,
+                     vid_t* order_count) {
+  state->level[root] = 0;
+  state->parent[root] = root;
+  state->segments[state->segment_count++] = *order_count;
+  state->order[(*order_count)++] = root;
+  if (graph->vertices[root] == graph->vertices[root + 1]) return;
+
+  vid_t begin = state->segments[state->segment_count - 1];
+  for (vid_t depth = 0; ; depth++) {
+    vid_t end = *order_count;
+    OMP(omp parallel for schedule(dynamic, 64))
+    for (vid_t i = begin; i < end; i++) {
+      vid_t u = state->order[i];
+      for (eid_t e = graph->vertices[u]; e < graph->vertices[u + 1]; e++) {
+        vid_t w = graph->edges[e];
+        if (state->level[w] == INFINITE &&
+            __sync_bool_compare_and_swap(&state->level[w], INFINITE,
+                                         depth + 1)) {
+          state->order[__sync_fetch_and_add(order_count, 1)] = w;
+        }
+      }
+    }
+    vid_t next_end = *order_count;
+    if (next_end == end) break;
+
+    // The parent of a vertex is its smallest neighbor in the previous level.
+    OMP(omp parallel for schedule(dynamic, 64))
+    for (vid_t i = end; i < next_end; i++) {
+      vid_t w = state->order[i];
+      vid_t parent = INFINITE;
+      for (eid_t e = graph->vertices[w]; e < graph->vertices[w + 1]; e++) {
+        vid_t u = graph->edges[e];
+        if (state->level[u] == depth && u < parent) parent = u;
+      }
+      state->parent[w] = parent;
+    }
+    state->segments[state->segment_count++] = end;
+    begin = end;
+  }
+}
+
+/**
+ * Computes the size of the subtree of each vertex bottom-up, and then the
+ * preorder number of each vertex top-down. The vertices of a component occupy
+ * a contiguous range of the BFS order starting at its root, hence the
+ * preorder number of a root is its position in the BFS order.
+ */
+PRIVATE void bcc_number(const graph_t* graph, bcc_state_t* state) {
+  for (vid_t s = state->segment_count; s > 0; s--) {
+    OMP(omp parallel for schedule(static))
+    for (vid_t i = state->segments[s - 1]; i < state->segments[s]; i++) {
+      vid_t v = state->order[i];
+      if (state->parent[v] != v) {
+        __sync_fetch_and_add(&state->size[state->parent[v]], state->size[v]);
+      }
+    }
+  }
+  for (vid_t s = 0; s < state->segment_count; s++) {
+    OMP(omp parallel for schedule(dynamic, 64))
+    for (vid_t i = state->segments[s]; i < state->segments[s + 1]; i++) {
+      vid_t v = state->order[i];
+      if (state->parent[v] == v) state->pre[v] = i;
+      // Only the thread of the parent writes the numbers of its children.
+      vid_t next = state->pre[v] + 1;
+      for (eid_t e = graph->vertices[v]; e < graph->vertices[v + 1]; e++) {
+        vid_t w = graph->edges[e];
+        if (w != v && state->parent[w] == v && state->pre[w] == INFINITE) {
+          state->pre[w] = next;
+          next += state->size[w];
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Computes low and high of each vertex. Only one entry of the edge to the
+ * parent is skipped; hence, a parallel edge to the parent counts as a non-tree
+ * edge.
+ */
+PRIVATE void bcc_low_high(const graph_t* graph, bcc_state_t* state) {
+  OMP(omp parallel for schedule(dynamic, 256))
+  for (vid_t v = 0; v < graph->vertex_count; v++) {
+    vid_t low = state->pre[v];
+    vid_t high = state->pre[v];
+    bool skip_parent = (state->parent[v] != v);
+    for (eid_t e = graph->vertices[v]; e < graph->vertices[v + 1]; e++) {
+      vid_t w = graph->edges[e];
+      if (w == v) continue;
+      if (skip_parent && w == state->parent[v]) {
+        skip_parent = false;
+        continue;
+      }
+      if (state->pre[w] < low) low = state->pre[w];
+      if (state->pre[w] > high) high = state->pre[w];
+    }
+    state->low[v] = low;
+    state->high[v] = high;
+  }
+  for (vid_t s = state->segment_count; s > 0; s--) {
+    OMP(omp parallel for schedule(static))
+    for (vid_t i = state->segments[s - 1]; i < state->segments[s]; i++) {
+      vid_t v = state->order[i];
+      vid_t parent = state->parent[v];
+      if (parent == v) continue;
+      __sync_fetch_and_min_uint32(&state->low[parent], state->low[v]);
+      __sync_fetch_and_max_uint32(&state->high[parent], state->high[v]);
+    }
+  }
+}
+
+/**
+ * Returns the root of the set of a tree edge, halving the path on the way.
+ */
+inline PRIVATE vid_t bcc_find(vid_t* link, vid_t v) {
+  while (link[v] != v) {
+    vid_t parent = link[v];
+    vid_t grandparent = link[parent];
+    if (parent != grandparent) {
+      __sync_bool_compare_and_swap(&link[v], parent, grandparent);
+    }
+    v = grandparent;
+  }
+  return v;
+}
+
+/**
+ * Merges the sets of two tree edges. The root with the larger id is linked to
+ * the other one, hence the root of a set is its smallest member regardless of
+ * the order of the merges.
+ */
+inline PRIVATE void bcc_union(vid_t* link, vid_t a, vid_t b) {
+  while (true) {
+    a = bcc_find(link, a);
+    b = bcc_find(link, b);
+    if (a == b) return;
+    if (a < b) {
+      vid_t tmp = a;
+      a = b;
+      b = tmp;
+    }
+    if (__sync_bool_compare_and_swap(&link[a], a, b)) return;
+  }
+}
+
+/**
+ * Groups the tree edges into blocks by applying the two Tarjan-Vishkin rules.
+ */
+PRIVATE void bcc_group(const graph_t* graph, bcc_state_t* state) {
+  OMP(omp parallel for schedule(dynamic, 256))
+  for (vid_t v = 0; v < graph->vertex_count; v++) {
+    // A non-tree edge whose endpoints are unrelated closes a cycle through
+    // the tree edges of both endpoints.
+    for (eid_t e = graph->vertices[v]; e < graph->vertices[v + 1]; e++) {
+      vid_t w = graph->edges[e];
+      if (state->pre[w] < state->pre[v] &&
+          state->pre[v] >= state->pre[w] + state->size[w]) {
+        bcc_union(state->link, v, w);
+      }
+    }
+    // The tree edge (parent, v) is in the block of the tree edge of its parent
+    // if the subtree of v reaches out of the subtree of the parent.
+    vid_t parent = state->parent[v];
+    if (parent == v || state->parent[parent] == parent) continue;
+    if (state->low[v] < state->pre[parent] ||
+        state->high[v] >= state->pre[parent] + state->size[parent]) {
+      bcc_union(state->link, v, parent);
+    }
+  }
+}
+
+error_t biconnected_components_cpu(const graph_t* graph, vid_t** block,
+                                   vid_t* block_count, bool** articulation,
+                                   bool** bridge) {
+  if ((graph == NULL) || (graph->vertex_count == 0) ||
+      (graph->directed && graph->edge_count != 0) || (block == NULL) ||
+      (block_count == NULL) || (articulation == NULL) || (bridge == NULL)) {
+    return FAILURE;
+  }
+  const vid_t vcount = graph->vertex_count;
+  const eid_t ecount = graph->edge_count;
+  *block = NULL;
+  *bridge = NULL;
+  *block_count = 0;
+  CALL_SAFE(totem_malloc(vcount * sizeof(bool), TOTEM_MEM_HOST_PINNED,
+                         reinterpret_cast<void**>(articulation)));
+  memset(*articulation, 0, vcount * sizeof(bool));
+  if (ecount == 0) return SUCCESS;
+
+  bcc_state_t state;
+  vid_t** arrays[] = {&state.level, &state.parent, &state.order, &state.size,
+                      &state.pre, &state.low, &state.high, &state.link};
+  for (size_t i = 0; i < sizeof(arrays) / sizeof(*arrays); i++) {
+    CALL_SAFE(totem_malloc(vcount * sizeof(vid_t), TOTEM_MEM_HOST,
+                           reinterpret_cast<void**>(arrays[i])));
+  }
+  CALL_SAFE(totem_malloc((vcount + 1) * sizeof(vid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state.segments)));
+  OMP(omp parallel for schedule(static))
+  for (vid_t v = 0; v < vcount; v++) {
+    state.level[v] = INFINITE;
+    state.pre[v] = INFINITE;
+    state.size[v] = 1;
+    state.link[v] = v;
+  }
+
+  // Build the spanning forest, one component at a time.
+  state.segment_count = 0;
+  vid_t order_count = 0;
+  for (vid_t v = 0; v < vcount; v++) {
+    if (state.level[v] == INFINITE) bcc_bfs(graph, v, &state, &order_count);
+  }
+  assert(order_count == vcount);
+  state.segments[state.segment_count] = order_count;
+
+  bcc_number(graph, &state);
+  bcc_low_high(graph, &state);
+  bcc_group(graph, &state);
+
+  // Number the blocks in the order of their smallest tree edge. The level
+  // array is reused to store the number of each block.
+  OMP(omp parallel for schedule(static))
+  for (vid_t v = 0; v < vcount; v++) {
+    state.link[v] = bcc_find(state.link, v);
+  }
+  vid_t count = 0;
+  for (vid_t v = 0; v < vcount; v++) {
+    if (state.parent[v] != v && state.link[v] == v) state.level[v] = count++;
+  }
+  *block_count = count;
+
+  CALL_SAFE(totem_malloc(ecount * sizeof(vid_t), TOTEM_MEM_HOST_PINNED,
+                         reinterpret_cast<void**>(block)));
+  CALL_SAFE(totem_malloc(ecount * sizeof(bool), TOTEM_MEM_HOST_PINNED,
+                         reinterpret_cast<void**>(bridge)));
+  OMP(omp parallel for schedule(dynamic, 256))
+  for (vid_t v = 0; v < vcount; v++) {
+    vid_t first_block = INFINITE;
+    for (eid_t e = graph->vertices[v]; e < graph->vertices[v + 1]; e++) {
+      vid_t w = graph->edges[e];
+      (*bridge)[e] = false;
+      if (w == v) {
+        (*block)[e] = INFINITE;
+        continue;
+      }
+      // An edge is in the block of the tree edge of its endpoint with the
+      // larger preorder number, which is the child if it is a tree edge.
+      vid_t child = state.pre[v] > state.pre[w] ? v : w;
+      vid_t parent = child == v ? w : v;
+      (*block)[e] = state.level[state.link[child]];
+      // A tree edge is a bridge if the subtree of the child does not reach out
+      // of itself; a parallel edge keeps low below the child's number.
+      if (state.parent[child] == parent &&
+          state.low[child] >= state.pre[child] &&
+          state.high[child] < state.pre[child] + state.size[child]) {
+        (*bridge)[e] = true;
+      }
+      // A vertex is an articulation point if its edges span several blocks.
+      if (first_block == INFINITE) {
+        first_block = (*block)[e];
+      } else if (first_block != (*block)[e]) {
+        (*articulation)[v] = true;
+      }
+    }
+  }
+
+  for (size_t i = 0; i < sizeof(arrays) / sizeof(*arrays); i++) {
+    totem_free(*arrays[i], TOTEM_MEM_HOST);
+  }
+  totem_free(state.segments, TOTEM_MEM_HOST);
+  return SUCCESS;
+}
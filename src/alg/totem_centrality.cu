@@ -156,6 +156,20 @@ int centrality_get_number_sample_nodes(vid_t vertex_count, double epsilon) {
   return number_sample_nodes;
 }
 
+void centrality_sample_pivots(vid_t vertex_count, int number_samples,
+                              uint64_t seed, vid_t* pivots) {
+  // A SplitMix64 sequence, whose upper 32 bits are mapped to [0, vertex_count)
+  // by a multiplication rather than a modulo.
+  uint64_t state = seed;
+  for (int i = 0; i < number_samples; i++) {
+    uint64_t x = (state += 0x9e3779b97f4a7c15ULL);
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    pivots[i] = (vid_t)(((x >> 32) * vertex_count) >> 32);
+  }
+}
+
 vid_t* centrality_select_sampling_nodes(const graph_t* graph,
                                         int number_samples) {
   // Array to store the indices of the selected sampling nodes
@@ -33,6 +33,16 @@ int centrality_get_number_sample_nodes(vid_t vertex_count, double epsilon);
 vid_t* centrality_select_sampling_nodes(const graph_t* graph, 
                                         int number_samples);
 
+/**
+ * Draws the pivots of a sampling-based approximation uniformly and
+ * independently (i.e., with replacement) over all the vertices, such that
+ * scaling a sum over the pivots by vertex_count / number_samples gives an
+ * unbiased estimate of the sum over all the vertices. The pivots only depend
+ * on the seed.
+ */
+void centrality_sample_pivots(vid_t vertex_count, int number_samples,
+                              uint64_t seed, vid_t* pivots);
+
 /**
  * Unweighted BFS single source shortest path kernel using a successor stack.
  * Nodes are visited in a BFS order and the shortest paths are held in a list of
@@ -0,0 +1,381 @@
+/**
+ * Defines a fused CPU centrality pass that derives closeness, stress and
+ * betweenness centrality from a single set of traversals.
+ *
+ * For every source vertex, one level-synchronous BFS builds the shortest path
+ * DAG: the distance of each vertex, the number of shortest paths reaching it
+ * (sigma) and the vertices ordered by level. The three metrics are then
+ * derived from that DAG:
+ *   - closeness from the per-level vertex counts of the forward sweep,
+ *   - stress and betweenness from one shared backward sweep over the levels,
+ *     following the accumulation described in [Brandes07].
+ *
+ * The selection mask drives which parts of the sweeps are executed: path
+ * counting and the backward sweep are skipped when only closeness is
+ * requested, and the dependency updates of an unselected metric are skipped.
+ *
+ * Like betweenness_cpu and closeness_cpu, the pass either traverses from every
+ * vertex (CENTRALITY_EXACT) or from a set of sampled pivots.
+ */
+
+// totem includes
+#include "totem_alg.h"
+#include "totem_centrality.h"
+
+/**
+ * Per-source state of the fused centrality pass. The buffers are allocated
+ * once and reused across sources; only the entries touched by a traversal are
+ * reset at its end.
+ */
+typedef struct centrality_state_s {
+  cost_t*   distance;      // BFS distance of each vertex from the source
+  uint32_t* numSPs;        // number of shortest paths from the source
+  score_t*  delta_bc;      // betweenness dependency of each vertex
+  uint64_t* delta_sc;      // stress dependency of each vertex
+  vid_t*    queue;         // visited vertices ordered by level
+  vid_t*    level_offset;  // start of each level in the queue
+  cost_t    depth;         // number of levels of the current traversal
+} centrality_state_t;
+
+/**
+ * Checks for input parameters and special cases. This is invoked at the
+ * beginning of the public interface.
+ */
+PRIVATE
+error_t check_special_cases(const graph_t* graph, uint32_t metrics,
+                            score_t* closeness, score_t* stress,
+                            score_t* betweenness, bool* finished) {
+  *finished = true;
+  if ((graph == NULL) || (graph->vertex_count == 0) ||
+      (metrics == 0) || (metrics & ~CENTRALITY_METRIC_ALL)) {
+    return FAILURE;
+  }
+  if (((metrics & CENTRALITY_METRIC_CLOSENESS) && closeness == NULL) ||
+      ((metrics & CENTRALITY_METRIC_STRESS) && stress == NULL) ||
+      ((metrics & CENTRALITY_METRIC_BETWEENNESS) && betweenness == NULL)) {
+    return FAILURE;
+  }
+
+  // Clear the requested output buffers.
+  if (metrics & CENTRALITY_METRIC_CLOSENESS) {
+    totem_memset(closeness, (score_t)0.0, graph->vertex_count, TOTEM_MEM_HOST);
+  }
+  if (metrics & CENTRALITY_METRIC_STRESS) {
+    totem_memset(stress, (score_t)0.0, graph->vertex_count, TOTEM_MEM_HOST);
+  }
+  if (metrics & CENTRALITY_METRIC_BETWEENNESS) {
+    totem_memset(betweenness, (score_t)0.0, graph->vertex_count,
+                 TOTEM_MEM_HOST);
+  }
+
+  if (graph->edge_count == 0) return SUCCESS;
+  *finished = false;
+  return SUCCESS;
+}
+
+/**
+ * Allocates the per-source state. The dependency buffers are allocated only
+ * when the corresponding metric is requested.
+ */
+PRIVATE void state_init(const graph_t* graph, uint32_t metrics,
+                        centrality_state_t* state) {
+  memset(state, 0, sizeof(centrality_state_t));
+  vid_t vcount = graph->vertex_count;
+  CALL_SAFE(totem_malloc(vcount * sizeof(cost_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state->distance)));
+  CALL_SAFE(totem_malloc(vcount * sizeof(vid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state->queue)));
+  CALL_SAFE(totem_malloc((vcount + 2) * sizeof(vid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state->level_offset)));
+  totem_memset(state->distance, INF_COST, vcount, TOTEM_MEM_HOST);
+  if (metrics & (CENTRALITY_METRIC_STRESS | CENTRALITY_METRIC_BETWEENNESS)) {
+    CALL_SAFE(totem_calloc(vcount * sizeof(uint32_t), TOTEM_MEM_HOST,
+                           reinterpret_cast<void**>(&state->numSPs)));
+  }
+  if (metrics & CENTRALITY_METRIC_BETWEENNESS) {
+    CALL_SAFE(totem_malloc(vcount * sizeof(score_t), TOTEM_MEM_HOST,
+                           reinterpret_cast<void**>(&state->delta_bc)));
+  }
+  if (metrics & CENTRALITY_METRIC_STRESS) {
+    CALL_SAFE(totem_malloc(vcount * sizeof(uint64_t), TOTEM_MEM_HOST,
+                           reinterpret_cast<void**>(&state->delta_sc)));
+  }
+}
+
+/**
+ * Frees the per-source state.
+ */
+PRIVATE void state_finalize(centrality_state_t* state) {
+  totem_free(state->distance, TOTEM_MEM_HOST);
+  totem_free(state->queue, TOTEM_MEM_HOST);
+  totem_free(state->level_offset, TOTEM_MEM_HOST);
+  if (state->numSPs) totem_free(state->numSPs, TOTEM_MEM_HOST);
+  if (state->delta_bc) totem_free(state->delta_bc, TOTEM_MEM_HOST);
+  if (state->delta_sc) totem_free(state->delta_sc, TOTEM_MEM_HOST);
+}
+
+/**
+ * Builds the shortest path DAG rooted at the source. The vertices of each
+ * level are appended to the queue while the previous level is being expanded,
+ * hence each level costs time proportional to the edges of its vertices.
+ * Path counting is skipped when numSPs is not allocated.
+ */
+PRIVATE void centrality_forward(const graph_t* graph, vid_t source,
+                                centrality_state_t* state) {
+  cost_t* distance = state->distance;
+  uint32_t* numSPs = state->numSPs;
+  vid_t* queue = state->queue;
+  vid_t* level_offset = state->level_offset;
+
+  distance[source] = 0;
+  if (numSPs) numSPs[source] = 1;
+  queue[0] = source;
+  level_offset[0] = 0;
+  level_offset[1] = 1;
+
+  cost_t level = 0;
+  vid_t tail = 1;
+  while (level_offset[level] != level_offset[level + 1]) {
+    const cost_t next = level + 1;
+    OMP(omp parallel for schedule(dynamic, 64))
+    for (vid_t i = level_offset[level]; i < level_offset[level + 1]; i++) {
+      vid_t v = queue[i];
+      for (eid_t e = graph->vertices[v]; e < graph->vertices[v + 1]; e++) {
+        vid_t w = graph->edges[e];
+        if (distance[w] == INF_COST &&
+            __sync_bool_compare_and_swap(&distance[w], INF_COST, next)) {
+          queue[__sync_fetch_and_add(&tail, 1)] = w;
+        }
+        if (numSPs && distance[w] == next) {
+          __sync_fetch_and_add(&numSPs[w], numSPs[v]);
+        }
+      }
+    }
+    level++;
+    level_offset[level + 1] = tail;
+  }
+  // Levels [0, depth) are not empty.
+  state->depth = level;
+}
+
+/**
+ * Computes the closeness score of a vertex given the number of vertices it is
+ * connected to (including itself) and the sum of the distances to them. It
+ * uses the same normalization as closeness_unweighted_cpu.
+ */
+PRIVATE inline score_t centrality_closeness_score(vid_t vertex_count,
+                                                  double connected,
+                                                  double sum) {
+  if ((connected <= 1) || (sum <= 0)) return (score_t)0.0;
+  return (score_t)(((connected - 1) * (connected - 1)) /
+                   ((double)(vertex_count - 1) * sum));
+}
+
+/**
+ * Derives the closeness of the source from the level sizes of the forward
+ * sweep.
+ */
+PRIVATE void centrality_closeness(const graph_t* graph, vid_t source,
+                                  const centrality_state_t* state,
+                                  score_t* closeness) {
+  uint64_t sum = 0;
+  for (cost_t level = 1; level < state->depth; level++) {
+    sum += (uint64_t)level *
+        (state->level_offset[level + 1] - state->level_offset[level]);
+  }
+  vid_t connected = state->level_offset[state->depth];
+  closeness[source] = centrality_closeness_score(graph->vertex_count,
+                                                 connected, sum);
+}
+
+/**
+ * Adds the distances from the pivot of the last forward sweep to the sampled
+ * distance sums of the vertices it reached.
+ */
+PRIVATE void centrality_closeness_sample(const centrality_state_t* state,
+                                         uint64_t* sum, vid_t* reached) {
+  vid_t visited = state->level_offset[state->depth];
+  OMP(omp parallel for schedule(static))
+  for (vid_t i = 0; i < visited; i++) {
+    vid_t v = state->queue[i];
+    sum[v] += state->distance[v];
+    reached[v]++;
+  }
+}
+
+/**
+ * Accumulates the stress and betweenness dependencies by replaying the levels
+ * of the forward sweep in reverse. A vertex at level l reads the dependencies
+ * of its successors at level l + 1 only, hence the vertices of a level are
+ * processed in parallel without atomics.
+ */
+PRIVATE void centrality_backward(const graph_t* graph,
+                                 centrality_state_t* state, score_t* stress,
+                                 score_t* betweenness) {
+  const cost_t* distance = state->distance;
+  const uint32_t* numSPs = state->numSPs;
+  const vid_t* queue = state->queue;
+  const vid_t* level_offset = state->level_offset;
+  score_t* delta_bc = state->delta_bc;
+  uint64_t* delta_sc = state->delta_sc;
+
+  // Vertices at the deepest level have no successors.
+  cost_t last = state->depth - 1;
+  OMP(omp parallel for schedule(static))
+  for (vid_t i = level_offset[last]; i < level_offset[last + 1]; i++) {
+    if (delta_bc) delta_bc[queue[i]] = 0;
+    if (delta_sc) delta_sc[queue[i]] = 0;
+  }
+
+  // The source (level 0) does not accumulate a dependency.
+  for (int level = (int)last - 1; level >= 1; level--) {
+    const cost_t next = (cost_t)(level + 1);
+    OMP(omp parallel for schedule(dynamic, 64))
+    for (vid_t i = level_offset[level]; i < level_offset[level + 1]; i++) {
+      vid_t v = queue[i];
+      score_t dbc = 0;
+      uint64_t dsc = 0;
+      for (eid_t e = graph->vertices[v]; e < graph->vertices[v + 1]; e++) {
+        vid_t w = graph->edges[e];
+        if (distance[w] != next) continue;
+        if (delta_bc) {
+          dbc += ((score_t)numSPs[v] / (score_t)numSPs[w]) *
+              (1 + delta_bc[w]);
+        }
+        if (delta_sc) dsc += 1 + delta_sc[w];
+      }
+      if (delta_bc) {
+        delta_bc[v] = dbc;
+        betweenness[v] += dbc;
+      }
+      if (delta_sc) {
+        delta_sc[v] = dsc;
+        stress[v] += (score_t)((double)numSPs[v] * dsc);
+      }
+    }
+  }
+}
+
+/**
+ * Resets the entries touched by the last traversal, which keeps the per-source
+ * overhead proportional to the size of the reached component.
+ */
+PRIVATE void centrality_reset(const centrality_state_t* state) {
+  vid_t visited = state->level_offset[state->depth];
+  OMP(omp parallel for schedule(static))
+  for (vid_t i = 0; i < visited; i++) {
+    vid_t v = state->queue[i];
+    state->distance[v] = INF_COST;
+    if (state->numSPs) state->numSPs[v] = 0;
+  }
+}
+
+/**
+ * Runs the fused pass from every vertex.
+ */
+PRIVATE void centrality_exact_cpu(const graph_t* graph, uint32_t metrics,
+                                  centrality_state_t* state,
+                                  score_t* closeness, score_t* stress,
+                                  score_t* betweenness) {
+  bool backward =
+      metrics & (CENTRALITY_METRIC_STRESS | CENTRALITY_METRIC_BETWEENNESS);
+  for (vid_t source = 0; source < graph->vertex_count; source++) {
+    centrality_forward(graph, source, state);
+    if (metrics & CENTRALITY_METRIC_CLOSENESS) {
+      centrality_closeness(graph, source, state, closeness);
+    }
+    if (backward) {
+      centrality_backward(graph, state, stress, betweenness);
+    }
+    centrality_reset(state);
+  }
+}
+
+/**
+ * Runs the fused pass from the sampled pivots. The stress and betweenness
+ * dependencies are scaled by (|V| / number of pivots), as in betweenness_cpu.
+ * Closeness is estimated from the distances to the pivots as in closeness_cpu,
+ * and is computed exactly for the vertices that no pivot reaches.
+ */
+PRIVATE void centrality_sampled_cpu(const graph_t* graph, uint32_t metrics,
+                                    int num_samples, centrality_state_t* state,
+                                    score_t* closeness, score_t* stress,
+                                    score_t* betweenness) {
+  vid_t* pivots = reinterpret_cast<vid_t*>(malloc(num_samples *
+                                                  sizeof(vid_t)));
+  assert(pivots);
+  centrality_sample_pivots(graph->vertex_count, num_samples, GLOBAL_SEED,
+                           pivots);
+  uint64_t* sum = NULL;
+  vid_t* reached = NULL;
+  if (metrics & CENTRALITY_METRIC_CLOSENESS) {
+    CALL_SAFE(totem_calloc(graph->vertex_count * sizeof(uint64_t),
+                           TOTEM_MEM_HOST, reinterpret_cast<void**>(&sum)));
+    CALL_SAFE(totem_calloc(graph->vertex_count * sizeof(vid_t),
+                           TOTEM_MEM_HOST, reinterpret_cast<void**>(&reached)));
+  }
+  bool backward =
+      metrics & (CENTRALITY_METRIC_STRESS | CENTRALITY_METRIC_BETWEENNESS);
+
+  for (int p = 0; p < num_samples; p++) {
+    centrality_forward(graph, pivots[p], state);
+    if (sum) centrality_closeness_sample(state, sum, reached);
+    if (backward) centrality_backward(graph, state, stress, betweenness);
+    centrality_reset(state);
+  }
+
+  double scale = (double)graph->vertex_count / num_samples;
+  OMP(omp parallel for schedule(static))
+  for (vid_t v = 0; v < graph->vertex_count; v++) {
+    if (metrics & CENTRALITY_METRIC_STRESS) stress[v] *= (score_t)scale;
+    if (metrics & CENTRALITY_METRIC_BETWEENNESS) {
+      betweenness[v] *= (score_t)scale;
+    }
+    if (sum && reached[v]) {
+      closeness[v] = centrality_closeness_score(
+          graph->vertex_count, scale * reached[v], scale * sum[v]);
+    }
+  }
+
+  if (sum) {
+    // Vertices missed by all pivots belong to small components.
+    for (vid_t v = 0; v < graph->vertex_count; v++) {
+      if (reached[v]) continue;
+      centrality_forward(graph, v, state);
+      centrality_closeness(graph, v, state, closeness);
+      centrality_reset(state);
+    }
+    totem_free(sum, TOTEM_MEM_HOST);
+    totem_free(reached, TOTEM_MEM_HOST);
+  }
+  free(pivots);
+}
+
+error_t centrality_cpu(const graph_t* graph, double epsilon, uint32_t metrics,
+                       score_t* closeness, score_t* stress,
+                       score_t* betweenness) {
+  bool finished = true;
+  error_t rc = check_special_cases(graph, metrics, closeness, stress,
+                                   betweenness, &finished);
+  if (finished) return rc;
+
+  int num_samples = (epsilon == CENTRALITY_EXACT) ? graph->vertex_count :
+      centrality_get_number_sample_nodes(graph->vertex_count, epsilon);
+  bool exact = (vid_t)num_samples >= graph->vertex_count || num_samples <= 0;
+  // The closeness estimator relies on d(pivot, v) = d(v, pivot).
+  if (!exact && graph->directed && (metrics & CENTRALITY_METRIC_CLOSENESS)) {
+    return FAILURE;
+  }
+
+  centrality_state_t state;
+  state_init(graph, metrics, &state);
+  if (exact) {
+    centrality_exact_cpu(graph, metrics, &state, closeness, stress,
+                         betweenness);
+  } else {
+    centrality_sampled_cpu(graph, metrics, num_samples, &state, closeness,
+                           stress, betweenness);
+  }
+  state_finalize(&state);
+  return SUCCESS;
+}
@@ -254,3 +254,400 @@ error_t closeness_unweighted_cpu(const graph_t* graph,
   *centrality_score = closeness_centrality;
   return SUCCESS;
 }
+
+/**
+ * Computes the closeness score of a vertex given the number of vertices it is
+ * connected to (including itself) and the sum of the distances to them. It
+ * uses the same normalization as calculate_closeness.
+ */
+PRIVATE inline score_t closeness_score(vid_t vertex_count, double connected,
+                                       double sum) {
+  if ((connected <= 1) || (sum <= 0)) return (score_t)0.0;
+  return (score_t)(((connected - 1) * (connected - 1)) /
+                   ((double)(vertex_count - 1) * sum));
+}
+
+/**
+ * An upper bound on the closeness of a vertex whose BFS has visited "visited"
+ * vertices with a distance sum of "sum", and at most "left" other vertices
+ * could still be reached, each at a distance of at least "level". The score is
+ * a convex function of the number of vertices still to be reached, hence the
+ * bound is the largest of the two extremes (none or all of them reached).
+ */
+PRIVATE inline score_t closeness_upper_bound(vid_t vertex_count, vid_t visited,
+                                             uint64_t sum, cost_t level,
+                                             vid_t left) {
+  score_t none = closeness_score(vertex_count, visited, sum);
+  score_t all = closeness_score(vertex_count, (double)visited + left,
+                                (double)sum + (double)level * left);
+  return none > all ? none : all;
+}
+
+/**
+ * A sequential BFS used by the sampling and top-k closeness algorithms, which
+ * run many independent traversals in parallel. The visited vertices are left
+ * in the queue in BFS order, so the caller can reset only their distances.
+ *
+ * If threshold is not NULL, the traversal is cut as soon as an upper bound
+ * on the closeness of the source falls below *threshold. The bound relies on
+ * the fact that a vertex not yet visited is at least one level deeper than the
+ * deepest visited one, and that at most reach - visited vertices are left.
+ * @return false if the traversal was cut, true otherwise
+ */
+PRIVATE bool closeness_bfs(const graph_t* graph, vid_t source, vid_t reach,
+                           const score_t* threshold, cost_t* dist,
+                           vid_t* queue, vid_t* visited, uint64_t* sum) {
+  dist[source] = 0;
+  queue[0] = source;
+  vid_t head = 0;
+  vid_t tail = 1;
+  vid_t level_end = 1;
+  cost_t level = 0;
+  *sum = 0;
+  while (head < tail) {
+    vid_t v = queue[head++];
+    for (eid_t e = graph->vertices[v]; e < graph->vertices[v + 1]; e++) {
+      vid_t w = graph->edges[e];
+      if (dist[w] == INF_COST) {
+        dist[w] = dist[v] + 1;
+        *sum += dist[w];
+        queue[tail++] = w;
+      }
+    }
+    if (head == level_end) {
+      level++;
+      level_end = tail;
+      if (threshold && head < tail) {
+        score_t current;
+        OMP(omp atomic read)
+        current = *threshold;
+        if (closeness_upper_bound(graph->vertex_count, tail, *sum, level + 1,
+                                  reach - tail) < current) {
+          *visited = tail;
+          return false;
+        }
+      }
+    }
+  }
+  *visited = tail;
+  return true;
+}
+
+/**
+ * Resets the distances of the vertices visited by closeness_bfs.
+ */
+PRIVATE inline void closeness_bfs_reset(cost_t* dist, const vid_t* queue,
+                                        vid_t visited) {
+  for (vid_t i = 0; i < visited; i++) {
+    dist[queue[i]] = INF_COST;
+  }
+}
+
+/**
+ * Computes the exact closeness of every vertex. Traversals from different
+ * sources run in parallel, each thread with its own distance and queue
+ * buffers. Only the vertices flagged in "todo" (if not NULL) are processed.
+ */
+PRIVATE void closeness_exact_cpu(const graph_t* graph, const bool* todo,
+                                 score_t* centrality_score) {
+  OMP(omp parallel)
+  {
+    cost_t* dist = NULL;
+    vid_t* queue = NULL;
+    CALL_SAFE(totem_malloc(graph->vertex_count * sizeof(cost_t),
+                           TOTEM_MEM_HOST, (void**)&dist));
+    CALL_SAFE(totem_malloc(graph->vertex_count * sizeof(vid_t),
+                           TOTEM_MEM_HOST, (void**)&queue));
+    for (vid_t v = 0; v < graph->vertex_count; v++) dist[v] = INF_COST;
+
+    OMP(omp for schedule(dynamic, 16))
+    for (vid_t source = 0; source < graph->vertex_count; source++) {
+      if (todo && !todo[source]) continue;
+      vid_t visited = 0;
+      uint64_t sum = 0;
+      closeness_bfs(graph, source, graph->vertex_count, NULL, dist, queue,
+                    &visited, &sum);
+      centrality_score[source] =
+          closeness_score(graph->vertex_count, visited, sum);
+      closeness_bfs_reset(dist, queue, visited);
+    }
+
+    totem_free(dist, TOTEM_MEM_HOST);
+    totem_free(queue, TOTEM_MEM_HOST);
+  }
+}
+
+/**
+ * Implements the sampling-based closeness centrality approximation described
+ * in "Fast Approximation of Centrality" [Eppstein04]. A BFS is run from k
+ * pivots drawn uniformly with replacement over all the n vertices, and the
+ * distance sum of every vertex is estimated as (n / k) times the sum of its
+ * distances to the pivots, which is unbiased for such pivots. The size of the
+ * component of a vertex is estimated in the same way from the number of
+ * pivots that reach it. With k = log(n) / epsilon^2 pivots (as returned by
+ * centrality_get_number_sample_nodes), the estimated average distance of each
+ * vertex is within epsilon times the diameter of the exact one with high
+ * probability. Vertices that are not reached by any pivot belong to small
+ * components, and their closeness is computed exactly.
+ */
+error_t closeness_cpu(const graph_t* graph, double epsilon,
+                      score_t* centrality_score) {
+  if ((graph == NULL) || (graph->vertex_count == 0) ||
+      (centrality_score == NULL)) {
+    return FAILURE;
+  }
+  totem_memset(centrality_score, (score_t)0.0, graph->vertex_count,
+               TOTEM_MEM_HOST);
+  if (graph->edge_count == 0) return SUCCESS;
+
+  int num_samples = (epsilon == CENTRALITY_EXACT) ? graph->vertex_count :
+      centrality_get_number_sample_nodes(graph->vertex_count, epsilon);
+  if ((vid_t)num_samples >= graph->vertex_count || num_samples <= 0) {
+    closeness_exact_cpu(graph, NULL, centrality_score);
+    return SUCCESS;
+  }
+
+  // The estimator relies on d(pivot, v) = d(v, pivot).
+  if (graph->directed) return FAILURE;
+
+  vid_t* pivots = reinterpret_cast<vid_t*>(malloc(num_samples *
+                                                  sizeof(vid_t)));
+  assert(pivots);
+  centrality_sample_pivots(graph->vertex_count, num_samples, GLOBAL_SEED,
+                           pivots);
+  uint64_t* sum = NULL;
+  vid_t* reached = NULL;
+  CALL_SAFE(totem_calloc(graph->vertex_count * sizeof(uint64_t),
+                         TOTEM_MEM_HOST, (void**)&sum));
+  CALL_SAFE(totem_calloc(graph->vertex_count * sizeof(vid_t), TOTEM_MEM_HOST,
+                         (void**)&reached));
+
+  OMP(omp parallel)
+  {
+    cost_t* dist = NULL;
+    vid_t* queue = NULL;
+    CALL_SAFE(totem_malloc(graph->vertex_count * sizeof(cost_t),
+                           TOTEM_MEM_HOST, (void**)&dist));
+    CALL_SAFE(totem_malloc(graph->vertex_count * sizeof(vid_t),
+                           TOTEM_MEM_HOST, (void**)&queue));
+    for (vid_t v = 0; v < graph->vertex_count; v++) dist[v] = INF_COST;
+
+    OMP(omp for schedule(dynamic, 1))
+    for (int p = 0; p < num_samples; p++) {
+      vid_t visited = 0;
+      uint64_t pivot_sum = 0;
+      closeness_bfs(graph, pivots[p], graph->vertex_count, NULL, dist, queue,
+                    &visited, &pivot_sum);
+      for (vid_t i = 0; i < visited; i++) {
+        vid_t v = queue[i];
+        __sync_fetch_and_add(&sum[v], (uint64_t)dist[v]);
+        __sync_fetch_and_add(&reached[v], 1);
+      }
+      closeness_bfs_reset(dist, queue, visited);
+    }
+
+    totem_free(dist, TOTEM_MEM_HOST);
+    totem_free(queue, TOTEM_MEM_HOST);
+  }
+
+  // Scale the sampled sums, and flag the vertices missed by all pivots.
+  bool* todo = NULL;
+  CALL_SAFE(totem_calloc(graph->vertex_count * sizeof(bool), TOTEM_MEM_HOST,
+                         (void**)&todo));
+  bool missed = false;
+  double scale = (double)graph->vertex_count / num_samples;
+  OMP(omp parallel for reduction(|| : missed))
+  for (vid_t v = 0; v < graph->vertex_count; v++) {
+    if (reached[v] == 0) {
+      todo[v] = true;
+      missed = true;
+      continue;
+    }
+    centrality_score[v] = closeness_score(graph->vertex_count,
+                                          scale * reached[v], scale * sum[v]);
+  }
+  if (missed) closeness_exact_cpu(graph, todo, centrality_score);
+
+  totem_free(todo, TOTEM_MEM_HOST);
+  totem_free(sum, TOTEM_MEM_HOST);
+  totem_free(reached, TOTEM_MEM_HOST);
+  free(pivots);
+  return SUCCESS;
+}
+
+/**
+ * A candidate in the top-k closeness heap.
+ */
+typedef struct closeness_candidate_s {
+  score_t score;
+  vid_t   vertex;
+} closeness_candidate_t;
+
+/**
+ * Orders the candidates such that a binary heap built with it keeps the
+ * weakest candidate (lowest score, then highest id) at its root.
+ */
+PRIVATE inline bool closeness_weaker(const closeness_candidate_t& a,
+                                     const closeness_candidate_t& b) {
+  return (a.score < b.score) ||
+      ((a.score == b.score) && (a.vertex > b.vertex));
+}
+
+/**
+ * Restores the heap property of the top-k heap starting from its root.
+ */
+PRIVATE void closeness_heap_sift_down(closeness_candidate_t* heap, vid_t k) {
+  vid_t i = 0;
+  while (true) {
+    vid_t weakest = i;
+    vid_t left = 2 * i + 1;
+    vid_t right = 2 * i + 2;
+    if (left < k && closeness_weaker(heap[left], heap[weakest])) {
+      weakest = left;
+    }
+    if (right < k && closeness_weaker(heap[right], heap[weakest])) {
+      weakest = right;
+    }
+    if (weakest == i) return;
+    closeness_candidate_t tmp = heap[i];
+    heap[i] = heap[weakest];
+    heap[weakest] = tmp;
+    i = weakest;
+  }
+}
+
+/**
+ * Orders vertices by decreasing degree, breaking ties by id.
+ */
+PRIVATE bool closeness_compare_degrees_dsc(const vdegree_t& a,
+                                           const vdegree_t& b) {
+  if (a.degree == b.degree) { return (a.id < b.id); }
+  return (a.degree > b.degree);
+}
+
+/**
+ * Computes the vertex ids of the k vertices with the highest closeness, and
+ * their exact scores, without computing the closeness of every vertex. It
+ * follows the pruned BFS approach described in "Computing Top-k Closeness
+ * Centrality Faster in Unweighted Graphs" [Bergamini16]: vertices are
+ * processed in decreasing order of degree, and the BFS of a vertex is cut as
+ * soon as an upper bound on its closeness drops below the k-th best score found
+ * so far. For undirected graphs, the bound uses the size of the connected
+ * component of the vertex.
+ */
+error_t closeness_topk_cpu(const graph_t* graph, vid_t k, vid_t* top_vertices,
+                           score_t* top_scores) {
+  if ((graph == NULL) || (graph->vertex_count == 0) || (k == 0) ||
+      (k > graph->vertex_count) || (top_vertices == NULL) ||
+      (top_scores == NULL)) {
+    return FAILURE;
+  }
+  vid_t vcount = graph->vertex_count;
+
+  // The number of vertices each vertex can reach at most.
+  vid_t* reach = NULL;
+  CALL_SAFE(totem_malloc(vcount * sizeof(vid_t), TOTEM_MEM_HOST,
+                         (void**)&reach));
+  totem_memset(reach, vcount, vcount, TOTEM_MEM_HOST);
+  cost_t* dist = NULL;
+  vid_t* queue = NULL;
+  CALL_SAFE(totem_malloc(vcount * sizeof(cost_t), TOTEM_MEM_HOST,
+                         (void**)&dist));
+  CALL_SAFE(totem_malloc(vcount * sizeof(vid_t), TOTEM_MEM_HOST,
+                         (void**)&queue));
+  totem_memset(dist, INF_COST, vcount, TOTEM_MEM_HOST);
+  if (!graph->directed) {
+    // Label the connected components; each vertex is visited once.
+    for (vid_t v = 0; v < vcount; v++) {
+      if (dist[v] != INF_COST) continue;
+      vid_t visited = 0;
+      uint64_t sum = 0;
+      closeness_bfs(graph, v, vcount, NULL, dist, queue, &visited, &sum);
+      for (vid_t i = 0; i < visited; i++) reach[queue[i]] = visited;
+    }
+  }
+  totem_free(dist, TOTEM_MEM_HOST);
+  totem_free(queue, TOTEM_MEM_HOST);
+
+  // Process the vertices in decreasing order of degree; high degree vertices
+  // tend to be central, which raises the pruning threshold early.
+  vdegree_t* order = NULL;
+  CALL_SAFE(totem_malloc(vcount * sizeof(vdegree_t), TOTEM_MEM_HOST,
+                         (void**)&order));
+  OMP(omp parallel for)
+  for (vid_t v = 0; v < vcount; v++) {
+    order[v].id = v;
+    order[v].degree = graph->vertices[v + 1] - graph->vertices[v];
+  }
+  tbb::parallel_sort(order, order + vcount, closeness_compare_degrees_dsc);
+
+  // A heap of the best k candidates found so far, and the k-th best score,
+  // which becomes the pruning threshold once the heap is full.
+  closeness_candidate_t* heap = (closeness_candidate_t*)
+      malloc(k * sizeof(closeness_candidate_t));
+  vid_t heap_size = 0;
+  score_t threshold = -1.0;
+
+  OMP(omp parallel)
+  {
+    cost_t* dist = NULL;
+    vid_t* queue = NULL;
+    CALL_SAFE(totem_malloc(vcount * sizeof(cost_t), TOTEM_MEM_HOST,
+                           (void**)&dist));
+    CALL_SAFE(totem_malloc(vcount * sizeof(vid_t), TOTEM_MEM_HOST,
+                           (void**)&queue));
+    for (vid_t v = 0; v < vcount; v++) dist[v] = INF_COST;
+
+    OMP(omp for schedule(dynamic, 1))
+    for (vid_t i = 0; i < vcount; i++) {
+      vid_t source = order[i].id;
+      vid_t visited = 0;
+      uint64_t sum = 0;
+      bool complete = closeness_bfs(graph, source, reach[source], &threshold,
+                                    dist, queue, &visited, &sum);
+      closeness_bfs_reset(dist, queue, visited);
+      if (!complete) continue;
+
+      closeness_candidate_t candidate;
+      candidate.score = closeness_score(vcount, visited, sum);
+      candidate.vertex = source;
+      OMP(omp critical)
+      {
+        if (heap_size < k) {
+          // Sift the new candidate up.
+          vid_t c = heap_size++;
+          heap[c] = candidate;
+          while (c > 0 && closeness_weaker(heap[c], heap[(c - 1) / 2])) {
+            closeness_candidate_t tmp = heap[c];
+            heap[c] = heap[(c - 1) / 2];
+            heap[(c - 1) / 2] = tmp;
+            c = (c - 1) / 2;
+          }
+        } else if (closeness_weaker(heap[0], candidate)) {
+          heap[0] = candidate;
+          closeness_heap_sift_down(heap, k);
+        }
+        if (heap_size == k) {
+          OMP(omp atomic write)
+          threshold = heap[0].score;
+        }
+      }
+    }
+
+    totem_free(dist, TOTEM_MEM_HOST);
+    totem_free(queue, TOTEM_MEM_HOST);
+  }
+
+  // Emit the candidates from the strongest to the weakest.
+  for (vid_t i = k; i > 0; i--) {
+    top_vertices[i - 1] = heap[0].vertex;
+    top_scores[i - 1] = heap[0].score;
+    heap[0] = heap[i - 1];
+    closeness_heap_sift_down(heap, i - 1);
+  }
+
+  free(heap);
+  totem_free(order, TOTEM_MEM_HOST);
+  totem_free(reach, TOTEM_MEM_HOST);
+  return SUCCESS;
+}
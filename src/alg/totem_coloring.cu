@@ -0,0 +1,297 @@
+/**
+ * Implements parallel vertex coloring and maximal independent set for CPU.
+ *
+ * The coloring follows the Jones-Plassmann algorithm with largest-degree-first
+ * priorities [Jones93] M. T. Jones, P. E. Plassmann, "A Parallel Graph
+ * Coloring Heuristic", SIAM Journal on Scientific Computing 14(3), 1993. The
+ * independent set follows the random priority variant of Luby's algorithm
+ * [Luby86] M. Luby, "A Simple Parallel Algorithm for the Maximal Independent
+ * Set Problem", SIAM Journal on Computing 15(4), 1986.
+ *
+ * Both algorithms work in rounds over a list of the vertices that are still
+ * undecided, which is compacted at the end of each round, hence the work of a
+ * round is proportional to the remaining vertices and their edges. Each round
+ * first decides which vertices to settle by only reading the state of the
+ * graph, and then settles them; therefore, the result does not depend on the
+ * number of threads or on their interleaving.
+ */
+
+// system includes
+#include <algorithm>
+
+// totem includes
+#include "totem_alg.h"
+
+// Marks an uncolored vertex, or a vertex whose membership in the independent
+// set is not decided yet.
+#define COLORING_UNDECIDED ((uint32_t)-1)
+
+// The membership states of the vertices in the independent set.
+#define MIS_IN  ((uint32_t)1)
+#define MIS_OUT ((uint32_t)0)
+
+/**
+ * A bijective hash of a vertex id, which gives the vertices a random, yet
+ * reproducible, order. It is the finalizer of MurmurHash3.
+ */
+inline PRIVATE uint32_t coloring_hash(vid_t v) {
+  uint32_t h = v;
+  h ^= h >> 16;
+  h *= 0x85ebca6b;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35;
+  h ^= h >> 16;
+  return h;
+}
+
+/**
+ * Computes the priority of each vertex. The hash breaks the ties between the
+ * vertices; since it is a bijection, no two vertices have the same priority.
+ * If by_degree is set, vertices with higher degree have higher priority.
+ */
+PRIVATE void coloring_priorities(const graph_t* graph, bool by_degree,
+                                 uint64_t* priority) {
+  OMP(omp parallel for schedule(static))
+  for (vid_t v = 0; v < graph->vertex_count; v++) {
+    uint64_t degree = 0;
+    if (by_degree) {
+      degree = graph->vertices[v + 1] - graph->vertices[v];
+      if (degree > UINT32_MAX) degree = UINT32_MAX;
+    }
+    priority[v] = (degree << 32) | coloring_hash(v);
+  }
+}
+
+/**
+ * Returns true if no undecided neighbor of a vertex has a higher priority.
+ * Self loops are ignored.
+ */
+inline PRIVATE bool coloring_is_local_max(const graph_t* graph,
+                                          const uint64_t* priority,
+                                          const uint32_t* state, vid_t v) {
+  for (eid_t e = graph->vertices[v]; e < graph->vertices[v + 1]; e++) {
+    vid_t nbr = graph->edges[e];
+    if (nbr != v && state[nbr] == COLORING_UNDECIDED &&
+        priority[nbr] > priority[v]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Copies the vertices of the list that are still undecided to next, in order.
+ * Each thread compacts a contiguous chunk of the list, and the offsets of the
+ * chunks in next are the prefix sum of the per-thread counts.
+ */
+PRIVATE vid_t coloring_compact(const vid_t* list, vid_t count,
+                               const uint32_t* state, vid_t* offsets,
+                               vid_t* next) {
+  vid_t next_count = 0;
+  OMP(omp parallel)
+  {
+    int thread_count = omp_get_num_threads();
+    int tid = omp_get_thread_num();
+    vid_t chunk = (count + thread_count - 1) / thread_count;
+    vid_t begin = std::min(count, (vid_t)tid * chunk);
+    vid_t end = std::min(count, begin + chunk);
+    vid_t kept = 0;
+    for (vid_t i = begin; i < end; i++) {
+      kept += (state[list[i]] == COLORING_UNDECIDED);
+    }
+    offsets[tid] = kept;
+    OMP(omp barrier)
+    OMP(omp single)
+    {
+      for (int t = 0; t < thread_count; t++) {
+        vid_t tmp = offsets[t];
+        offsets[t] = next_count;
+        next_count += tmp;
+      }
+    }
+    vid_t index = offsets[tid];
+    for (vid_t i = begin; i < end; i++) {
+      if (state[list[i]] == COLORING_UNDECIDED) next[index++] = list[i];
+    }
+  }
+  return next_count;
+}
+
+/**
+ * Checks the input parameters, and allocates the per-vertex state and the
+ * working lists shared by the two algorithms.
+ */
+PRIVATE error_t coloring_init(const graph_t* graph, bool by_degree,
+                              uint64_t** priority, vid_t** list,
+                              vid_t** next, bool** ready, vid_t** offsets) {
+  if ((graph == NULL) || (graph->vertex_count == 0) ||
+      (graph->directed && graph->edge_count != 0)) {
+    return FAILURE;
+  }
+  const vid_t vcount = graph->vertex_count;
+  CALL_SAFE(totem_malloc(vcount * sizeof(uint64_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(priority)));
+  CALL_SAFE(totem_malloc(vcount * sizeof(vid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(list)));
+  CALL_SAFE(totem_malloc(vcount * sizeof(vid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(next)));
+  CALL_SAFE(totem_malloc(vcount * sizeof(bool), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(ready)));
+  CALL_SAFE(totem_malloc(omp_get_max_threads() * sizeof(vid_t),
+                         TOTEM_MEM_HOST, reinterpret_cast<void**>(offsets)));
+  coloring_priorities(graph, by_degree, *priority);
+  OMP(omp parallel for schedule(static))
+  for (vid_t v = 0; v < vcount; v++) {
+    (*list)[v] = v;
+  }
+  return SUCCESS;
+}
+
+PRIVATE void coloring_finalize(uint64_t* priority, vid_t* list, vid_t* next,
+                               bool* ready, vid_t* offsets) {
+  totem_free(priority, TOTEM_MEM_HOST);
+  totem_free(list, TOTEM_MEM_HOST);
+  totem_free(next, TOTEM_MEM_HOST);
+  totem_free(ready, TOTEM_MEM_HOST);
+  totem_free(offsets, TOTEM_MEM_HOST);
+}
+
+error_t coloring_cpu(const graph_t* graph, uint32_t** colors,
+                     uint32_t* color_count, uint32_t* rounds) {
+  if ((colors == NULL) || (color_count == NULL) || (rounds == NULL)) {
+    return FAILURE;
+  }
+  uint64_t* priority = NULL;
+  vid_t* list = NULL;
+  vid_t* next = NULL;
+  bool* ready = NULL;
+  vid_t* offsets = NULL;
+  if (coloring_init(graph, true, &priority, &list, &next, &ready, &offsets)
+      != SUCCESS) {
+    return FAILURE;
+  }
+  const vid_t vcount = graph->vertex_count;
+  CALL_SAFE(totem_malloc(vcount * sizeof(uint32_t), TOTEM_MEM_HOST_PINNED,
+                         reinterpret_cast<void**>(colors)));
+  vid_t max_degree = 0;
+  OMP(omp parallel for schedule(static) reduction(max : max_degree))
+  for (vid_t v = 0; v < vcount; v++) {
+    (*colors)[v] = COLORING_UNDECIDED;
+    vid_t degree = graph->vertices[v + 1] - graph->vertices[v];
+    if (degree > max_degree) max_degree = degree;
+  }
+
+  // Each thread marks the colors used by the neighbors of the vertex it colors
+  // with the id of that vertex, hence the marks never have to be cleared.
+  int thread_count = omp_get_max_threads();
+  vid_t* forbidden = NULL;
+  CALL_SAFE(totem_malloc((size_t)thread_count * (max_degree + 1) *
+                         sizeof(vid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&forbidden)));
+  totem_memset(forbidden, (vid_t)-1, (size_t)thread_count * (max_degree + 1),
+               TOTEM_MEM_HOST);
+
+  vid_t count = vcount;
+  uint32_t round_count = 0;
+  uint32_t max_color = 0;
+  while (count > 0) {
+    // A vertex is colored once all its neighbors with higher priority are.
+    OMP(omp parallel for schedule(dynamic, 256))
+    for (vid_t i = 0; i < count; i++) {
+      ready[i] = coloring_is_local_max(graph, priority, *colors, list[i]);
+    }
+    // The vertices colored in a round are independent, hence each of them
+    // only reads the colors assigned in previous rounds.
+    OMP(omp parallel reduction(max : max_color))
+    {
+      vid_t* used = &forbidden[omp_get_thread_num() * (max_degree + 1)];
+      OMP(omp for schedule(dynamic, 256))
+      for (vid_t i = 0; i < count; i++) {
+        if (!ready[i]) continue;
+        vid_t v = list[i];
+        for (eid_t e = graph->vertices[v]; e < graph->vertices[v + 1]; e++) {
+          uint32_t color = (*colors)[graph->edges[e]];
+          if (color <= max_degree) used[color] = v;
+        }
+        uint32_t color = 0;
+        while (used[color] == v) color++;
+        (*colors)[v] = color;
+        if (color > max_color) max_color = color;
+      }
+    }
+    count = coloring_compact(list, count, *colors, offsets, next);
+    std::swap(list, next);
+    round_count++;
+  }
+  *color_count = max_color + 1;
+  *rounds = round_count;
+
+  totem_free(forbidden, TOTEM_MEM_HOST);
+  coloring_finalize(priority, list, next, ready, offsets);
+  return SUCCESS;
+}
+
+error_t mis_cpu(const graph_t* graph, bool** in_set, vid_t* set_size,
+                uint32_t* rounds) {
+  if ((in_set == NULL) || (set_size == NULL) || (rounds == NULL)) {
+    return FAILURE;
+  }
+  uint64_t* priority = NULL;
+  vid_t* list = NULL;
+  vid_t* next = NULL;
+  bool* ready = NULL;
+  vid_t* offsets = NULL;
+  if (coloring_init(graph, false, &priority, &list, &next, &ready, &offsets)
+      != SUCCESS) {
+    return FAILURE;
+  }
+  const vid_t vcount = graph->vertex_count;
+  uint32_t* state = NULL;
+  CALL_SAFE(totem_malloc(vcount * sizeof(uint32_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state)));
+  totem_memset(state, COLORING_UNDECIDED, vcount, TOTEM_MEM_HOST);
+
+  vid_t count = vcount;
+  uint32_t round_count = 0;
+  while (count > 0) {
+    // The undecided vertices that are local maxima join the set, and then
+    // their undecided neighbors leave it.
+    OMP(omp parallel for schedule(dynamic, 256))
+    for (vid_t i = 0; i < count; i++) {
+      ready[i] = coloring_is_local_max(graph, priority, state, list[i]);
+    }
+    OMP(omp parallel for schedule(static))
+    for (vid_t i = 0; i < count; i++) {
+      if (ready[i]) state[list[i]] = MIS_IN;
+    }
+    OMP(omp parallel for schedule(dynamic, 256))
+    for (vid_t i = 0; i < count; i++) {
+      vid_t v = list[i];
+      if (state[v] != COLORING_UNDECIDED) continue;
+      for (eid_t e = graph->vertices[v]; e < graph->vertices[v + 1]; e++) {
+        if (state[graph->edges[e]] == MIS_IN) {
+          state[v] = MIS_OUT;
+          break;
+        }
+      }
+    }
+    count = coloring_compact(list, count, state, offsets, next);
+    std::swap(list, next);
+    round_count++;
+  }
+
+  CALL_SAFE(totem_malloc(vcount * sizeof(bool), TOTEM_MEM_HOST_PINNED,
+                         reinterpret_cast<void**>(in_set)));
+  vid_t size = 0;
+  OMP(omp parallel for schedule(static) reduction(+ : size))
+  for (vid_t v = 0; v < vcount; v++) {
+    (*in_set)[v] = (state[v] == MIS_IN);
+    size += (*in_set)[v];
+  }
+  *set_size = size;
+  *rounds = round_count;
+
+  totem_free(state, TOTEM_MEM_HOST);
+  coloring_finalize(priority, list, next, ready, offsets);
+  return SUCCESS;
+}
@@ -0,0 +1,375 @@
+/**
+ * Implements the repair of the BFS and SSSP distances from a source after a
+ * batch of edge updates, instead of recomputing them from scratch. It follows
+ * the dynamic shortest paths algorithm of
+ * [Ramalingam96] G. Ramalingam, T. Reps, "An incremental algorithm for a
+ * generalization of the shortest-path problem", Journal of Algorithms 21(2),
+ * 1996.
+ *
+ * The repair has three steps:
+ * 1. Invalidation: the end points of deleted edges (and of edges whose weight
+ *    increased) are checked in the order of their distance, along with those
+ *    of the inserted edges, whose weight may have changed. A vertex keeps its
+ *    distance if one of its incoming edges still supports it, i.e., comes from
+ *    a valid vertex at a strictly smaller distance that adds up to it.
+ *    Otherwise, the vertex is invalidated, and its out-neighbors that were at
+ *    its distance plus the edge weight are checked in turn. Hence, only the
+ *    subtrees that lost their support are visited.
+ * 2. Re-derivation: each invalidated vertex takes the best distance via its
+ *    incoming edges from the valid vertices.
+ * 3. Relaxation: starting from the re-derived vertices and the end points of
+ *    inserted edges (and of edges whose weight decreased), the distances are
+ *    relaxed forward in parallel rounds until they are stable.
+ *
+ * The state of the engine is tagged with the id of the repair or of the round
+ * that last wrote it, hence a repair does not pay for clearing it.
+ */
+
+// system includes
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+// totem includes
+#include "totem_alg.h"
+
+// The states of a vertex during the invalidation, stored in the two low bits
+// of its status; the other bits hold the repair that set the state. A vertex
+// whose status is from an older repair is valid.
+const uint32_t REPAIR_PENDING = 1;
+const uint32_t REPAIR_INVALID = 2;
+const uint32_t REPAIR_VALID = 3;
+const uint32_t REPAIR_STATE_BITS = 2;
+
+/**
+ * Distance traits of the two kinds of repair: hop counts for BFS, and edge
+ * weights for SSSP.
+ */
+class BfsRepairTraits {
+ public:
+  typedef cost_t distance_t;
+  static distance_t infinite() { return INF_COST; }
+  static uint64_t weight(const graph_t*, eid_t) { return 1; }
+  static uint64_t weight(const edge_t&) { return 1; }
+};
+
+class SsspRepairTraits {
+ public:
+  typedef weight_t distance_t;
+  static distance_t infinite() { return WEIGHT_MAX; }
+  static uint64_t weight(const graph_t* graph, eid_t edge) {
+    return graph->weights[edge];
+  }
+  static uint64_t weight(const edge_t& edge) { return edge.weight; }
+};
+
+typedef std::pair<uint64_t, vid_t> repair_entry_t;
+typedef std::priority_queue<repair_entry_t, std::vector<repair_entry_t>,
+                            std::greater<repair_entry_t> > repair_queue_t;
+
+inline PRIVATE uint32_t repair_state(const distance_repair_t* engine,
+                                     vid_t v) {
+  uint32_t status = engine->status[v];
+  return (status >> REPAIR_STATE_BITS) == engine->repair ?
+      (status & ((1 << REPAIR_STATE_BITS) - 1)) : REPAIR_VALID;
+}
+
+inline PRIVATE void repair_set_state(distance_repair_t* engine, vid_t v,
+                                     uint32_t state) {
+  engine->status[v] = (engine->repair << REPAIR_STATE_BITS) | state;
+}
+
+inline PRIVATE bool repair_touched(const distance_repair_t* engine, vid_t v) {
+  return (engine->status[v] >> REPAIR_STATE_BITS) == engine->repair;
+}
+
+// Atomically lowers a distance, and returns true if it was lowered.
+template<typename distance_t>
+inline PRIVATE bool repair_atomic_min(distance_t* address, distance_t value) {
+  distance_t old = *address;
+  while (value < old) {
+    distance_t assumed = old;
+    old = __sync_val_compare_and_swap(address, assumed, value);
+    if (old == assumed) return true;
+  }
+  return false;
+}
+
+// Adds a vertex to the next frontier, unless it has been added in this round.
+inline PRIVATE void repair_activate(distance_repair_t* engine, vid_t v) {
+  uint32_t last = engine->round[v];
+  if (last != engine->current_round &&
+      __sync_bool_compare_and_swap(&engine->round[v], last,
+                                   engine->current_round)) {
+    engine->next[__sync_fetch_and_add(&engine->next_count, 1)] = v;
+  }
+}
+
+// Lowers the distance of v via an edge from u, and activates v if it was
+// lowered.
+template<typename traits_t>
+inline PRIVATE void repair_relax(distance_repair_t* engine,
+                                 typename traits_t::distance_t* distance,
+                                 vid_t u, vid_t v, uint64_t weight) {
+  typedef typename traits_t::distance_t distance_t;
+  if (distance[u] == traits_t::infinite()) return;
+  uint64_t candidate = (uint64_t)distance[u] + weight;
+  if (candidate >= traits_t::infinite()) return;
+  if (repair_atomic_min(&distance[v], (distance_t)candidate)) {
+    repair_activate(engine, v);
+  }
+}
+
+// Checks if the distance of a pending vertex is supported by an incoming edge
+// from a valid vertex at a strictly smaller distance. Such a vertex has been
+// settled already, as the pending vertices are checked in the order of their
+// distance.
+template<typename traits_t>
+PRIVATE bool repair_supported(const distance_repair_t* engine,
+                              const graph_t* incoming,
+                              const typename traits_t::distance_t* distance,
+                              vid_t v) {
+  for (eid_t e = incoming->vertices[v]; e < incoming->vertices[v + 1]; e++) {
+    vid_t x = incoming->edges[e];
+    uint64_t weight = traits_t::weight(incoming, e);
+    if (weight == 0 || distance[x] == traits_t::infinite()) continue;
+    if ((uint64_t)distance[x] + weight == distance[v] &&
+        repair_state(engine, x) != REPAIR_INVALID) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Marks a vertex as pending, unless it has been reached by this repair.
+template<typename traits_t>
+inline PRIVATE void repair_check(distance_repair_t* engine,
+                                 const typename traits_t::distance_t* distance,
+                                 vid_t source, vid_t v,
+                                 repair_queue_t* queue) {
+  if (v == source || distance[v] == traits_t::infinite() ||
+      repair_touched(engine, v)) {
+    return;
+  }
+  repair_set_state(engine, v, REPAIR_PENDING);
+  queue->push(repair_entry_t(distance[v], v));
+}
+
+// Marks the end points of a batch of edges as pending.
+template<typename traits_t>
+PRIVATE void repair_check_edges(distance_repair_t* engine,
+                                const graph_t* graph,
+                                const typename traits_t::distance_t* distance,
+                                vid_t source, const edge_t* edges,
+                                eid_t edge_count, repair_queue_t* queue) {
+  for (eid_t i = 0; i < edge_count; i++) {
+    repair_check<traits_t>(engine, distance, source, edges[i].dst, queue);
+    if (!graph->directed) {
+      repair_check<traits_t>(engine, distance, source, edges[i].src, queue);
+    }
+  }
+}
+
+// Checks the pending vertices in the order of their distance, invalidates the
+// ones that lost their support, and returns their number.
+template<typename traits_t>
+PRIVATE vid_t repair_invalidate(distance_repair_t* engine,
+                                const graph_t* graph, const graph_t* incoming,
+                                vid_t source,
+                                typename traits_t::distance_t* distance,
+                                repair_queue_t* queue) {
+  vid_t invalid_count = 0;
+  while (!queue->empty()) {
+    vid_t v = queue->top().second;
+    queue->pop();
+    if (repair_supported<traits_t>(engine, incoming, distance, v)) {
+      repair_set_state(engine, v, REPAIR_VALID);
+      continue;
+    }
+    repair_set_state(engine, v, REPAIR_INVALID);
+    engine->invalid[invalid_count++] = v;
+    for (eid_t e = graph->vertices[v]; e < graph->vertices[v + 1]; e++) {
+      vid_t w = graph->edges[e];
+      if ((uint64_t)distance[v] + traits_t::weight(graph, e) == distance[w]) {
+        repair_check<traits_t>(engine, distance, source, w, queue);
+      }
+    }
+  }
+  return invalid_count;
+}
+
+// Starts a new round of activations; the rounds are shared by all repairs.
+PRIVATE void repair_next_round(distance_repair_t* engine) {
+  engine->current_round++;
+  if (engine->current_round == 0) {
+    memset(engine->round, 0, engine->vertex_count * sizeof(uint32_t));
+    engine->current_round = 1;
+  }
+}
+
+template<typename traits_t>
+PRIVATE error_t distance_repair_cpu(distance_repair_t* engine,
+                                    const graph_t* graph,
+                                    const graph_t* incoming, vid_t source,
+                                    const edge_t* inserted,
+                                    eid_t inserted_count,
+                                    const edge_t* deleted,
+                                    eid_t deleted_count,
+                                    typename traits_t::distance_t* distance) {
+  if (engine == NULL || graph == NULL || distance == NULL ||
+      graph->vertex_count != engine->vertex_count ||
+      source >= graph->vertex_count ||
+      (inserted == NULL && inserted_count != 0) ||
+      (deleted == NULL && deleted_count != 0) ||
+      (incoming != NULL && incoming->vertex_count != graph->vertex_count)) {
+    return FAILURE;
+  }
+  for (eid_t i = 0; i < inserted_count; i++) {
+    if (inserted[i].src >= graph->vertex_count ||
+        inserted[i].dst >= graph->vertex_count) {
+      return FAILURE;
+    }
+  }
+  for (eid_t i = 0; i < deleted_count; i++) {
+    if (deleted[i].src >= graph->vertex_count ||
+        deleted[i].dst >= graph->vertex_count) {
+      return FAILURE;
+    }
+  }
+
+  // The incoming edges are only needed to handle deletions. The transpose of
+  // a directed graph is built if it is not given, which costs a pass over the
+  // edges.
+  graph_t* transpose = NULL;
+  if (graph->directed && incoming == NULL && deleted_count != 0) {
+    CALL_SAFE(graph_create_transpose(graph, &transpose));
+    incoming = transpose;
+  } else if (!graph->directed) {
+    incoming = graph;
+  }
+
+  engine->repair++;
+  if (engine->repair >> (32 - REPAIR_STATE_BITS)) {
+    memset(engine->status, 0, engine->vertex_count * sizeof(uint32_t));
+    engine->repair = 1;
+  }
+  // The end points of the inserted edges are checked along with those of the
+  // deleted ones: an edge whose weight decreased may have been part of a
+  // subtree that gets invalidated, yet it does not add up to the old distance
+  // of its end point anymore.
+  repair_queue_t queue;
+  vid_t invalid_count = 0;
+  if (deleted_count != 0) {
+    repair_check_edges<traits_t>(engine, graph, distance, source, deleted,
+                                 deleted_count, &queue);
+    repair_check_edges<traits_t>(engine, graph, distance, source, inserted,
+                                 inserted_count, &queue);
+    invalid_count = repair_invalidate<traits_t>(engine, graph, incoming,
+                                                source, distance, &queue);
+  }
+  OMP(omp parallel for schedule(static))
+  for (vid_t i = 0; i < invalid_count; i++) {
+    distance[engine->invalid[i]] = traits_t::infinite();
+  }
+
+  // Re-derive the invalidated vertices from their valid in-neighbors, and
+  // relax the inserted edges; both seed the first frontier.
+  repair_next_round(engine);
+  engine->next_count = 0;
+  OMP(omp parallel for schedule(dynamic, 64))
+  for (vid_t i = 0; i < invalid_count; i++) {
+    vid_t v = engine->invalid[i];
+    for (eid_t e = incoming->vertices[v]; e < incoming->vertices[v + 1];
+         e++) {
+      vid_t x = incoming->edges[e];
+      if (repair_state(engine, x) == REPAIR_INVALID) continue;
+      repair_relax<traits_t>(engine, distance, x, v,
+                             traits_t::weight(incoming, e));
+    }
+  }
+  OMP(omp parallel for schedule(static))
+  for (eid_t i = 0; i < inserted_count; i++) {
+    const edge_t& edge = inserted[i];
+    repair_relax<traits_t>(engine, distance, edge.src, edge.dst,
+                           traits_t::weight(edge));
+    if (!graph->directed) {
+      repair_relax<traits_t>(engine, distance, edge.dst, edge.src,
+                             traits_t::weight(edge));
+    }
+  }
+
+  // Relax forward from the seeds until the distances are stable.
+  while (engine->next_count > 0) {
+    vid_t count = engine->next_count;
+    vid_t* frontier = engine->next;
+    engine->next = engine->frontier;
+    engine->frontier = frontier;
+    engine->next_count = 0;
+    repair_next_round(engine);
+    OMP(omp parallel for schedule(dynamic, 64))
+    for (vid_t i = 0; i < count; i++) {
+      vid_t u = frontier[i];
+      for (eid_t e = graph->vertices[u]; e < graph->vertices[u + 1]; e++) {
+        repair_relax<traits_t>(engine, distance, u, graph->edges[e],
+                               traits_t::weight(graph, e));
+      }
+    }
+  }
+
+  if (transpose) graph_finalize(transpose);
+  return SUCCESS;
+}
+
+error_t distance_repair_initialize(vid_t vertex_count,
+                                   distance_repair_t** engine_ret) {
+  if (vertex_count == 0 || engine_ret == NULL) return FAILURE;
+  distance_repair_t* engine = reinterpret_cast<distance_repair_t*>(
+      calloc(1, sizeof(distance_repair_t)));
+  assert(engine);
+  engine->vertex_count = vertex_count;
+  CALL_SAFE(totem_calloc(vertex_count * sizeof(uint32_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&engine->status)));
+  CALL_SAFE(totem_calloc(vertex_count * sizeof(uint32_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&engine->round)));
+  CALL_SAFE(totem_malloc(vertex_count * sizeof(vid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&engine->frontier)));
+  CALL_SAFE(totem_malloc(vertex_count * sizeof(vid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&engine->next)));
+  CALL_SAFE(totem_malloc(vertex_count * sizeof(vid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&engine->invalid)));
+  *engine_ret = engine;
+  return SUCCESS;
+}
+
+error_t distance_repair_finalize(distance_repair_t* engine) {
+  if (engine == NULL) return FAILURE;
+  totem_free(engine->status, TOTEM_MEM_HOST);
+  totem_free(engine->round, TOTEM_MEM_HOST);
+  totem_free(engine->frontier, TOTEM_MEM_HOST);
+  totem_free(engine->next, TOTEM_MEM_HOST);
+  totem_free(engine->invalid, TOTEM_MEM_HOST);
+  free(engine);
+  return SUCCESS;
+}
+
+error_t bfs_repair_cpu(distance_repair_t* engine, const graph_t* graph,
+                       const graph_t* incoming, vid_t source,
+                       const edge_t* inserted, eid_t inserted_count,
+                       const edge_t* deleted, eid_t deleted_count,
+                       cost_t* cost) {
+  return distance_repair_cpu<BfsRepairTraits>(
+      engine, graph, incoming, source, inserted, inserted_count, deleted,
+      deleted_count, cost);
+}
+
+error_t sssp_repair_cpu(distance_repair_t* engine, const graph_t* graph,
+                        const graph_t* incoming, vid_t source,
+                        const edge_t* decreased, eid_t decreased_count,
+                        const edge_t* increased, eid_t increased_count,
+                        weight_t* distance) {
+  if (graph != NULL && !graph->weighted) return FAILURE;
+  return distance_repair_cpu<SsspRepairTraits>(
+      engine, graph, incoming, source, decreased, decreased_count, increased,
+      increased_count, distance);
+}
@@ -0,0 +1,261 @@
+/**
+ * Implements the HyperANF algorithm for CPU, which estimates the neighborhood
+ * function of a graph, that is, the number of pairs of vertices within
+ * distance t for each t, as described in [Boldi11] P. Boldi, M. Rosa,
+ * S. Vigna, "HyperANF: Approximating the Neighbourhood Function of Very Large
+ * Graphs on a Budget", WWW 2011.
+ *
+ * Each vertex holds a HyperLogLog counter [Flajolet07] of the set of vertices
+ * within distance t of it. Initially, the counter of a vertex holds the vertex
+ * itself; in iteration t, the counter of a vertex is the union of its own
+ * counter and the counters of its neighbors from iteration t - 1. The union of
+ * two counters is the register-wise maximum, which is computed eight
+ * registers at a time: the registers are bytes packed in 64-bit words, and a
+ * register never exceeds 127, hence the high bit of each byte is free to
+ * compare all the bytes of two words with a single subtraction.
+ *
+ * A counter only changes if the counter of one of its neighbors changed in
+ * the previous iteration, hence only the changed neighbors are merged, and the
+ * algorithm stops once no counter changes. The number of iterations is the
+ * diameter of the graph, plus one.
+ */
+
+// system includes
+#include <algorithm>
+
+// totem includes
+#include "totem_alg.h"
+
+// The seed of the hash function that maps the vertices to the registers.
+const uint64_t HYPERANF_SEED = 0x5bd1e9955bd1e995ULL;
+
+// The high bit of each byte of a word.
+const uint64_t HYPERANF_HIGH_BITS = 0x8080808080808080ULL;
+
+// The fraction of the reachable pairs that defines the effective diameter.
+const double HYPERANF_EFFECTIVE_FRACTION = 0.9;
+
+/**
+ * State of the algorithm. The counter of a vertex is a sequence of words,
+ * each packing eight one-byte registers.
+ */
+typedef struct {
+  const graph_t* graph;
+  uint32_t       log2_registers;
+  uint32_t       words;      // the number of words per counter
+  uint64_t*      current;    // the counters of the previous iteration
+  uint64_t*      next;       // the counters of the current iteration
+  bool*          changed;    // whether each counter changed in the previous
+                             // iteration
+  bool*          changed_next;
+  double*        sum;        // the sum of 2^-register of each counter
+  vid_t*         zeros;      // the number of zero registers of each counter
+} hyperanf_state_t;
+
+/**
+ * Returns the register-wise maximum of two words of registers.
+ */
+inline PRIVATE uint64_t hyperanf_max(uint64_t x, uint64_t y) {
+  // The high bit of a byte of diff is set if the byte of x is not smaller
+  // than that of y.
+  uint64_t diff = ((x | HYPERANF_HIGH_BITS) - y) & HYPERANF_HIGH_BITS;
+  uint64_t mask = (diff >> 7) * 0xff;
+  return (x & mask) | (y & ~mask);
+}
+
+/**
+ * Returns the 64-bit hash of a vertex. It is the finalizer of SplitMix64.
+ */
+inline PRIVATE uint64_t hyperanf_hash(vid_t v) {
+  uint64_t x = HYPERANF_SEED + v * 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+/**
+ * Returns the estimated size of a counter from the sum of 2^-register over
+ * its registers and its number of zero registers, with the small range
+ * correction of HyperLogLog.
+ */
+inline PRIVATE double hyperanf_estimate(uint32_t log2_registers, double sum,
+                                        vid_t zeros) {
+  const double m = (double)(1 << log2_registers);
+  double alpha = m == 16 ? 0.673 : m == 32 ? 0.697 : m == 64 ? 0.709 :
+      0.7213 / (1 + 1.079 / m);
+  double estimate = alpha * m * m / sum;
+  if (estimate <= 2.5 * m && zeros > 0) estimate = m * log(m / zeros);
+  return estimate;
+}
+
+/**
+ * Initializes the counter of each vertex to hold the vertex itself.
+ */
+PRIVATE void hyperanf_init(hyperanf_state_t* state) {
+  const uint32_t b = state->log2_registers;
+  OMP(omp parallel for schedule(static))
+  for (vid_t v = 0; v < state->graph->vertex_count; v++) {
+    uint64_t* counter = &state->current[(size_t)v * state->words];
+    memset(counter, 0, state->words * sizeof(uint64_t));
+    uint64_t hash = hyperanf_hash(v);
+    uint32_t index = hash & ((1 << b) - 1);
+    // The rank is the position of the first set bit of the remaining bits.
+    uint64_t rest = hash >> b;
+    uint8_t rank = 1;
+    while (rank <= 64 - b && !(rest & 1)) {
+      rest >>= 1;
+      rank++;
+    }
+    reinterpret_cast<uint8_t*>(counter)[index] = rank;
+    state->changed[v] = true;
+    state->sum[v] = (1 << b) - 1 + ldexp(1.0, -rank);
+    state->zeros[v] = (1 << b) - 1;
+  }
+}
+
+/**
+ * Performs an iteration, and returns the estimated number of pairs within the
+ * new distance, and whether any counter changed. The sum and the number of
+ * zeros of a counter are updated only for the registers that change, hence
+ * the estimates do not require scanning the counters.
+ */
+PRIVATE double hyperanf_iteration(hyperanf_state_t* state, bool* changed) {
+  const graph_t* graph = state->graph;
+  const uint32_t words = state->words;
+  double pairs = 0;
+  bool any_changed = false;
+  OMP(omp parallel for schedule(dynamic, 64) reduction(+ : pairs) \
+      reduction(| : any_changed))
+  for (vid_t v = 0; v < graph->vertex_count; v++) {
+    uint64_t* next = &state->next[(size_t)v * words];
+    memcpy(next, &state->current[(size_t)v * words],
+           words * sizeof(uint64_t));
+    bool modified = false;
+    double sum = state->sum[v];
+    vid_t zeros = state->zeros[v];
+    for (eid_t e = graph->vertices[v]; e < graph->vertices[v + 1]; e++) {
+      vid_t nbr = graph->edges[e];
+      if (!state->changed[nbr] || nbr == v) continue;
+      const uint64_t* counter = &state->current[(size_t)nbr * words];
+      for (uint32_t i = 0; i < words; i++) {
+        uint64_t merged = hyperanf_max(next[i], counter[i]);
+        if (merged == next[i]) continue;
+        for (uint32_t byte = 0; byte < sizeof(uint64_t); byte++) {
+          uint8_t before = (next[i] >> (8 * byte)) & 0xff;
+          uint8_t after = (merged >> (8 * byte)) & 0xff;
+          if (before == after) continue;
+          sum += ldexp(1.0, -after) - ldexp(1.0, -before);
+          zeros -= (before == 0);
+        }
+        next[i] = merged;
+        modified = true;
+      }
+    }
+    state->sum[v] = sum;
+    state->zeros[v] = zeros;
+    state->changed_next[v] = modified;
+    any_changed |= modified;
+    pairs += hyperanf_estimate(state->log2_registers, sum, zeros);
+  }
+  std::swap(state->current, state->next);
+  std::swap(state->changed, state->changed_next);
+  *changed = any_changed;
+  return pairs;
+}
+
+/**
+ * Computes the effective diameter and the average distance from the
+ * neighborhood function. The effective diameter is interpolated between the
+ * two distances that enclose HYPERANF_EFFECTIVE_FRACTION of the pairs.
+ */
+PRIVATE void hyperanf_statistics(const double* neighborhood, uint32_t count,
+                                 double* effective_diameter,
+                                 double* average_distance) {
+  const double total = neighborhood[count - 1];
+  const double threshold = HYPERANF_EFFECTIVE_FRACTION * total;
+  *effective_diameter = 0;
+  for (uint32_t t = 1; t < count; t++) {
+    if (neighborhood[t] < threshold) continue;
+    double delta = neighborhood[t] - neighborhood[t - 1];
+    *effective_diameter = t - 1 + (delta > 0 ?
+        (threshold - neighborhood[t - 1]) / delta : 1);
+    if (*effective_diameter < 0) *effective_diameter = 0;
+    break;
+  }
+  double weighted = 0;
+  for (uint32_t t = 1; t < count; t++) {
+    weighted += t * (neighborhood[t] - neighborhood[t - 1]);
+  }
+  double reachable = total - neighborhood[0];
+  *average_distance = reachable > 0 ? weighted / reachable : 0;
+}
+
+error_t hyperanf_cpu(const graph_t* graph, uint32_t log2_registers,
+                     uint32_t max_distance, double** neighborhood,
+                     uint32_t* distance_count, double* effective_diameter,
+                     double* average_distance) {
+  if ((graph == NULL) || (graph->vertex_count == 0) ||
+      (log2_registers < 4) || (log2_registers > 16) ||
+      (neighborhood == NULL) || (distance_count == NULL) ||
+      (effective_diameter == NULL) || (average_distance == NULL)) {
+    return FAILURE;
+  }
+  const vid_t vcount = graph->vertex_count;
+  hyperanf_state_t state;
+  state.graph = graph;
+  state.log2_registers = log2_registers;
+  state.words = (1 << log2_registers) / sizeof(uint64_t);
+  const size_t counters_size = (size_t)vcount * state.words * sizeof(uint64_t);
+  CALL_SAFE(totem_malloc(counters_size, TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state.current)));
+  CALL_SAFE(totem_malloc(counters_size, TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state.next)));
+  CALL_SAFE(totem_malloc(vcount * sizeof(bool), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state.changed)));
+  CALL_SAFE(totem_malloc(vcount * sizeof(bool), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state.changed_next)));
+  CALL_SAFE(totem_malloc(vcount * sizeof(double), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state.sum)));
+  CALL_SAFE(totem_malloc(vcount * sizeof(vid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state.zeros)));
+  hyperanf_init(&state);
+
+  // The neighborhood function is collected in a growing buffer, as its
+  // length is the diameter of the graph, which is not known in advance.
+  uint32_t capacity = 64;
+  double* function = reinterpret_cast<double*>(
+      malloc(capacity * sizeof(double)));
+  assert(function);
+  function[0] = vcount;
+  uint32_t count = 1;
+  bool changed = graph->edge_count > 0;
+  while (changed && (max_distance == 0 || count <= max_distance)) {
+    double pairs = hyperanf_iteration(&state, &changed);
+    if (!changed) break;
+    if (count == capacity) {
+      capacity *= 2;
+      function = reinterpret_cast<double*>(
+          realloc(function, capacity * sizeof(double)));
+      assert(function);
+    }
+    // The counters are estimates; the exact function is non-decreasing.
+    function[count] = pairs > function[count - 1] ? pairs :
+        function[count - 1];
+    count++;
+  }
+
+  CALL_SAFE(totem_malloc(count * sizeof(double), TOTEM_MEM_HOST_PINNED,
+                         reinterpret_cast<void**>(neighborhood)));
+  memcpy(*neighborhood, function, count * sizeof(double));
+  *distance_count = count;
+  hyperanf_statistics(function, count, effective_diameter, average_distance);
+
+  free(function);
+  totem_free(state.current, TOTEM_MEM_HOST);
+  totem_free(state.next, TOTEM_MEM_HOST);
+  totem_free(state.changed, TOTEM_MEM_HOST);
+  totem_free(state.changed_next, TOTEM_MEM_HOST);
+  totem_free(state.sum, TOTEM_MEM_HOST);
+  totem_free(state.zeros, TOTEM_MEM_HOST);
+  return SUCCESS;
+}
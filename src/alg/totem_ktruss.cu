@@ -0,0 +1,324 @@
+/**
+ * Implements a parallel k-truss decomposition for CPU. The k-truss of a graph
+ * is its largest subgraph in which every edge is part of at least k - 2
+ * triangles, and the trussness of an edge is the largest k such that the edge
+ * belongs to the k-truss.
+ *
+ * The decomposition follows the PKT algorithm described in [Kabir17]
+ * H. Kabir, K. Madduri, "Parallel k-truss decomposition on multicore
+ * systems", HPEC 2017. First, the support of each edge (the number of
+ * triangles it closes) is computed by intersecting the sorted neighbor lists
+ * of its endpoints. Then, the edges are peeled level by level in increasing
+ * order of support: removing an edge decrements, via atomics, the support of
+ * the other two edges of each of its remaining triangles, and an edge whose
+ * support drops to the current level is peeled within the same level.
+ *
+ * An undirected edge appears twice in the CSR, once in the neighbor list of
+ * each endpoint. The state of the edge is kept in its canonical entry, the one
+ * stored in the neighbor list of its smaller endpoint. All the state is
+ * indexed by the CSR edge index, hence the memory footprint is O(E).
+ */
+
+// system includes
+#include <algorithm>
+
+// totem includes
+#include "totem_alg.h"
+
+// The peeling state of a canonical edge.
+#define KTRUSS_ACTIVE    0  // not peeled yet
+#define KTRUSS_FRONTIER  1  // being peeled in the current sub-level
+#define KTRUSS_PEELED    2  // peeled in a previous sub-level
+
+/**
+ * State of the peeling engine.
+ */
+typedef struct {
+  const graph_t* graph;
+  eid_t*    reverse;          // the entry of the opposite direction of an edge
+  uint32_t* support;          // support of each canonical entry
+  uint8_t*  state;            // peeling state of each canonical entry
+  eid_t*    remaining;        // the canonical entries not peeled yet
+  eid_t     remaining_count;
+  eid_t*    frontier;         // the entries peeled in the current sub-level
+  eid_t     frontier_count;
+  eid_t*    next;             // the entries peeled in the next sub-level
+  eid_t     next_count;
+} ktruss_state_t;
+
+/**
+ * Returns the source vertex of a CSR entry.
+ */
+inline PRIVATE vid_t ktruss_source(const graph_t* graph, eid_t e) {
+  return (vid_t)(std::upper_bound(graph->vertices,
+                                  graph->vertices + graph->vertex_count + 1,
+                                  e) - graph->vertices - 1);
+}
+
+/**
+ * Returns the canonical entry of an edge, given the entry (u, w) stored in
+ * the neighbor list of u.
+ */
+inline PRIVATE eid_t ktruss_canonical(const ktruss_state_t* state, vid_t u,
+                                      eid_t e) {
+  return u < state->graph->edges[e] ? e : state->reverse[e];
+}
+
+/**
+ * Checks that the graph is undirected, that the neighbor lists are sorted,
+ * and finds the reverse entry of every edge via a binary search in the
+ * neighbor list of its destination.
+ */
+PRIVATE error_t ktruss_reverse(const graph_t* graph, eid_t* reverse) {
+  bool valid = true;
+  OMP(omp parallel for schedule(dynamic, 1024) reduction(&& : valid))
+  for (vid_t u = 0; u < graph->vertex_count; u++) {
+    for (eid_t e = graph->vertices[u]; e < graph->vertices[u + 1]; e++) {
+      vid_t w = graph->edges[e];
+      if (e > graph->vertices[u] && graph->edges[e - 1] >= w) valid = false;
+      const vid_t* begin = &graph->edges[graph->vertices[w]];
+      const vid_t* end = &graph->edges[graph->vertices[w + 1]];
+      const vid_t* found = std::lower_bound(begin, end, u);
+      if (found == end || *found != u) {
+        valid = false;
+        continue;
+      }
+      reverse[e] = found - graph->edges;
+    }
+  }
+  return valid ? SUCCESS : FAILURE;
+}
+
+/**
+ * Computes the support of each canonical entry. Only the common neighbors
+ * larger than both endpoints are intersected, hence each triangle is found
+ * once, from its edge between the two smallest vertices, which then credits
+ * all three of its edges.
+ */
+PRIVATE void ktruss_support(ktruss_state_t* state) {
+  const graph_t* graph = state->graph;
+  totem_memset(state->support, (uint32_t)0, graph->edge_count,
+               TOTEM_MEM_HOST);
+  OMP(omp parallel for schedule(dynamic, 64))
+  for (vid_t u = 0; u < graph->vertex_count; u++) {
+    for (eid_t e = graph->vertices[u]; e < graph->vertices[u + 1]; e++) {
+      vid_t v = graph->edges[e];
+      if (v <= u) continue;
+      eid_t i = e + 1;
+      eid_t j = graph->vertices[v];
+      while (j < graph->vertices[v + 1] && graph->edges[j] <= v) j++;
+      while (i < graph->vertices[u + 1] && j < graph->vertices[v + 1]) {
+        if (graph->edges[i] < graph->edges[j]) {
+          i++;
+        } else if (graph->edges[i] > graph->edges[j]) {
+          j++;
+        } else {
+          // The entries i and j are canonical, as w > v > u.
+          __sync_fetch_and_add(&state->support[e], 1);
+          __sync_fetch_and_add(&state->support[i], 1);
+          __sync_fetch_and_add(&state->support[j], 1);
+          i++;
+          j++;
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Decrements the support of an edge that is still above the current level.
+ * An edge whose support reaches the level joins the next sub-level, while a
+ * decrement that would take it below the level (due to a concurrent one) is
+ * undone.
+ */
+inline PRIVATE void ktruss_decrement(ktruss_state_t* state, eid_t e,
+                                     uint32_t level) {
+  uint32_t old = __sync_fetch_and_sub(&state->support[e], 1);
+  if (old == level + 1) {
+    state->next[__sync_fetch_and_add(&state->next_count, 1)] = e;
+  } else if (old <= level) {
+    __sync_fetch_and_add(&state->support[e], 1);
+  }
+}
+
+/**
+ * Removes the triangles of a frontier edge (u, v) that are still present.
+ * When two edges of a triangle are in the frontier, only the one with the
+ * smaller index decrements the third edge.
+ */
+PRIVATE void ktruss_peel_edge(ktruss_state_t* state, eid_t e,
+                              uint32_t level) {
+  const graph_t* graph = state->graph;
+  vid_t u = ktruss_source(graph, e);
+  vid_t v = graph->edges[e];
+  eid_t i = graph->vertices[u];
+  eid_t j = graph->vertices[v];
+  while (i < graph->vertices[u + 1] && j < graph->vertices[v + 1]) {
+    vid_t wi = graph->edges[i];
+    vid_t wj = graph->edges[j];
+    if (wi < wj) {
+      i++;
+      continue;
+    }
+    if (wi > wj) {
+      j++;
+      continue;
+    }
+    eid_t e1 = ktruss_canonical(state, u, i++);
+    eid_t e2 = ktruss_canonical(state, v, j++);
+    if (wi == u || wi == v) continue;
+    if (state->state[e1] == KTRUSS_PEELED ||
+        state->state[e2] == KTRUSS_PEELED) {
+      continue;
+    }
+    bool above1 = state->support[e1] > level;
+    bool above2 = state->support[e2] > level;
+    if (above1 && above2) {
+      ktruss_decrement(state, e1, level);
+      ktruss_decrement(state, e2, level);
+    } else if (above1) {
+      if (state->state[e2] != KTRUSS_FRONTIER || e < e2) {
+        ktruss_decrement(state, e1, level);
+      }
+    } else if (above2) {
+      if (state->state[e1] != KTRUSS_FRONTIER || e < e1) {
+        ktruss_decrement(state, e2, level);
+      }
+    }
+  }
+}
+
+/**
+ * Drops the peeled entries from the list of remaining ones, and returns the
+ * lowest support among those left, which is the next level to peel.
+ */
+PRIVATE uint32_t ktruss_compact(ktruss_state_t* state) {
+  eid_t count = 0;
+  uint32_t level = UINT32_MAX;
+  OMP(omp parallel for schedule(static) reduction(min : level))
+  for (eid_t i = 0; i < state->remaining_count; i++) {
+    eid_t e = state->remaining[i];
+    if (state->state[e] != KTRUSS_ACTIVE) continue;
+    state->next[__sync_fetch_and_add(&count, 1)] = e;
+    if (state->support[e] < level) level = state->support[e];
+  }
+  eid_t* remaining = state->remaining;
+  state->remaining = state->next;
+  state->next = remaining;
+  state->remaining_count = count;
+  return level;
+}
+
+/**
+ * Peels all the edges whose support drops to the given level.
+ */
+PRIVATE void ktruss_peel_level(ktruss_state_t* state, uint32_t level) {
+  state->frontier_count = 0;
+  OMP(omp parallel for schedule(static))
+  for (eid_t i = 0; i < state->remaining_count; i++) {
+    eid_t e = state->remaining[i];
+    if (state->support[e] == level) {
+      state->frontier[__sync_fetch_and_add(&state->frontier_count, 1)] = e;
+    }
+  }
+  while (state->frontier_count > 0) {
+    OMP(omp parallel for schedule(static))
+    for (eid_t i = 0; i < state->frontier_count; i++) {
+      state->state[state->frontier[i]] = KTRUSS_FRONTIER;
+    }
+    state->next_count = 0;
+    OMP(omp parallel for schedule(dynamic, 16))
+    for (eid_t i = 0; i < state->frontier_count; i++) {
+      ktruss_peel_edge(state, state->frontier[i], level);
+    }
+    OMP(omp parallel for schedule(static))
+    for (eid_t i = 0; i < state->frontier_count; i++) {
+      state->state[state->frontier[i]] = KTRUSS_PEELED;
+    }
+    eid_t* frontier = state->frontier;
+    state->frontier = state->next;
+    state->next = frontier;
+    state->frontier_count = state->next_count;
+  }
+}
+
+error_t ktruss_cpu(const graph_t* graph, uint32_t** truss) {
+  // Graphs without edges are accepted even if flagged as directed.
+  if ((graph == NULL) || (graph->vertex_count == 0) ||
+      (graph->directed && graph->edge_count != 0) || (truss == NULL)) {
+    return FAILURE;
+  }
+  *truss = NULL;
+  if (graph->edge_count == 0) return SUCCESS;
+
+  ktruss_state_t state;
+  memset(&state, 0, sizeof(ktruss_state_t));
+  state.graph = graph;
+  const eid_t ecount = graph->edge_count;
+  CALL_SAFE(totem_malloc(ecount * sizeof(eid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state.reverse)));
+  if (ktruss_reverse(graph, state.reverse) != SUCCESS) {
+    totem_free(state.reverse, TOTEM_MEM_HOST);
+    return FAILURE;
+  }
+
+  // Each of the lists holds canonical entries only, which are at most half
+  // of the entries.
+  const eid_t list_size = ecount / 2 + 1;
+  CALL_SAFE(totem_malloc(ecount * sizeof(uint32_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state.support)));
+  CALL_SAFE(totem_malloc(ecount * sizeof(uint8_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state.state)));
+  CALL_SAFE(totem_malloc(list_size * sizeof(eid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state.remaining)));
+  CALL_SAFE(totem_malloc(list_size * sizeof(eid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state.frontier)));
+  CALL_SAFE(totem_malloc(list_size * sizeof(eid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state.next)));
+  ktruss_support(&state);
+
+  // Only the canonical entries take part in the peeling. Self loops have no
+  // canonical entry, and are marked as peeled from the start.
+  OMP(omp parallel for schedule(dynamic, 1024))
+  for (vid_t u = 0; u < graph->vertex_count; u++) {
+    for (eid_t e = graph->vertices[u]; e < graph->vertices[u + 1]; e++) {
+      vid_t v = graph->edges[e];
+      state.state[e] = KTRUSS_PEELED;
+      if (v <= u) continue;
+      state.state[e] = KTRUSS_ACTIVE;
+      state.remaining[__sync_fetch_and_add(&state.remaining_count, 1)] = e;
+    }
+  }
+
+  // The levels are visited in increasing order of support, skipping the
+  // levels no remaining edge belongs to.
+  while (state.remaining_count > 0) {
+    uint32_t level = ktruss_compact(&state);
+    if (state.remaining_count == 0) break;
+    ktruss_peel_level(&state, level);
+  }
+
+  // An edge peeled at level l is in l triangles of the (l + 2)-truss. The
+  // trussness is copied to both entries of an edge; self loops are set to 0.
+  CALL_SAFE(totem_malloc(ecount * sizeof(uint32_t), TOTEM_MEM_HOST_PINNED,
+                         reinterpret_cast<void**>(truss)));
+  OMP(omp parallel for schedule(dynamic, 1024))
+  for (vid_t u = 0; u < graph->vertex_count; u++) {
+    for (eid_t e = graph->vertices[u]; e < graph->vertices[u + 1]; e++) {
+      vid_t v = graph->edges[e];
+      if (v == u) {
+        (*truss)[e] = 0;
+      } else {
+        (*truss)[e] = state.support[ktruss_canonical(&state, u, e)] + 2;
+      }
+    }
+  }
+
+  totem_free(state.reverse, TOTEM_MEM_HOST);
+  totem_free(state.support, TOTEM_MEM_HOST);
+  totem_free(state.state, TOTEM_MEM_HOST);
+  totem_free(state.remaining, TOTEM_MEM_HOST);
+  totem_free(state.frontier, TOTEM_MEM_HOST);
+  totem_free(state.next, TOTEM_MEM_HOST);
+  return SUCCESS;
+}
@@ -1,11 +1,9 @@
 /**
  *
- * Implements Label Propagation algorithm for CPU. It follows a version
- * of the  algorithm described in [Xie 2013]. Jierui Xie; Szymanski, B.K.,
- * "LabelRank: A stabilized label propagation algorithm for community detection
- * in networks," Network Science Workshop (NSW), 2013 IEEE 2nd , vol., no.,
- * pp.138,143, April 29 2013-May 1 2013.
- * doi: 10.1109/NSW.2013.6609210
+ * Implements Label Propagation algorithm for CPU. It follows the asynchronous
+ * version of the algorithm described in [Raghavan 2007]. U. N. Raghavan,
+ * R. Albert, S. Kumara, "Near linear time algorithm to detect community
+ * structures in large-scale networks," Physical Review E 76, 036106, 2007.
  *
  * Created on: 2014-08-08
  * Author: Tanuj Kr Aasawat
@@ -14,8 +12,30 @@
 // totem includes
 #include "totem_alg.h"
 
-const int LABEL_PROPAGATION_MAX_ITERATIONS = 25;
-const int LABEL_PROPAGATION_MAX_LABEL_NOT_CHANGED_COUNT = 5;
+const int LABEL_PROPAGATION_MAX_ITERATIONS = 100;
+
+// The minimum capacity of the per-thread label counters.
+const vid_t LABEL_PROPAGATION_MIN_COUNTER_CAPACITY = 16;
+
+// Seed of the random order in which the vertices are visited.
+const uint64_t LABEL_PROPAGATION_SEED = 1985;
+
+// Marks an empty slot in a label counter.
+#define LABEL_PROPAGATION_EMPTY_SLOT ((vid_t)-1)
+
+/**
+ * A small open addressing hash map that counts the frequency (or the total
+ * edge weight, for weighted graphs) of the labels of the neighbors of a
+ * vertex. Each thread owns one, sized to twice the maximum degree, and only
+ * the slots used by a vertex are cleared after it is processed.
+ */
+typedef struct label_counter_s {
+  vid_t*    labels;    // the label stored in each slot
+  uint64_t* counts;    // the frequency of the label in each slot
+  vid_t*    used;      // the slots used by the current vertex
+  vid_t     used_count;
+  vid_t     mask;      // capacity - 1, the capacity is a power of two
+} label_counter_t;
 
 // Checks for input parameters and special cases. This is invoked at the
 // beginning of public interfaces (CPU and GPU).
@@ -47,171 +67,196 @@ PRIVATE error_t check_special_cases(const graph_t* graph, bool* finished,
   return SUCCESS;
 }
 
-/**
- * Implements a version of the Label Propagation algorithm described in
- * [Xie 2013] for CPU.
- *
- * This algorithm simulates the propagation of labels in the network. Here, we
- * use vertex IDs as labels. Therefore, the number of unique labels is equal
- * to the number of vertices. Initially, each vertex in the graph is assigned
- * a unique numeric label (its own vertex ID). The algorithm consists of
- * three main steps. In the initialization step, based on its neighbours, each
- * vertex computes the probability of receiving each label. An n x m matrix P,
- * where n is the number of vertices in the graph and m is the number of
- * labels, holds current probability of vertices observing different labels.
- * In the propagation step, each vertex broadcasts the probability distribution
- * of all the labels to its neighbours. Based on received distribution, each
- * vertex computes the new distribution of each label (sum of received
- * distributions normalized by its vertex degree). This operation increases
- * probability of labels that were assigned high probability during propagation
- * at the cost of labels that in propagation received low probabilities. At any
- * given time, the label with the highest probability becomes the label of a
- * vertex. The propagation phase does not always converge to a state in which
- * all vertices have the same label in successive iteration. To ensure that the
- * propagation phase terminates, we verify if the labels are being updated in
- * successive iterations. For all vertices in the graph, if their labels do not
- * change for a predefined successive number of iterations, the algorithm stops
- * propagating labels and terminates. Please note that this algorithm can only
- * detect disjoint communities.
- *
- * @param[in] graph an instance of the graph structure
- * @param[out] labels the computed labels of each vertex
- * @return generic success or failure
- *
- */
-PRIVATE void label_probability_initialisation(vid_t knumLabels, const graph_t*
-                  graph, float** ProbMatrix, vid_t*
-                  max_prb_label_not_changed_count) {
-  // TODO(tanuj): Declare data types label_t and probability_t.
-  OMP(omp parallel for schedule(runtime))
-  for (vid_t v = 0; v < graph->vertex_count; v++) {
-    max_prb_label_not_changed_count[v] = 0;
-    vid_t num_of_neighbours = graph->vertices[v+1] - graph->vertices[v];
-    for (vid_t l = 0; l < knumLabels; l++) {  // iterate over each label
-      ProbMatrix[v][l] = (v == l) ? 1.0 : 0.0;
-      for (eid_t e = graph->vertices[v]; e < graph->vertices[v+1]; e++) {
-        vid_t nbr = graph->edges[e];
-        ProbMatrix[v][nbr] = 1.0 / (float)num_of_neighbours;
-      }  // for
-    }  // for
-  }  // for
+PRIVATE void label_counter_init(vid_t max_degree, label_counter_t* counter) {
+  vid_t capacity = LABEL_PROPAGATION_MIN_COUNTER_CAPACITY;
+  while (capacity < 2 * max_degree) capacity <<= 1;
+  counter->mask = capacity - 1;
+  counter->used_count = 0;
+  CALL_SAFE(totem_malloc(capacity * sizeof(vid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&counter->labels)));
+  CALL_SAFE(totem_malloc(capacity * sizeof(uint64_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&counter->counts)));
+  CALL_SAFE(totem_malloc(capacity * sizeof(vid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&counter->used)));
+  totem_memset(counter->labels, LABEL_PROPAGATION_EMPTY_SLOT, capacity,
+               TOTEM_MEM_HOST);
 }
 
-PRIVATE void label_propagation(const graph_t* graph, float** ProbMatrix,
-                               float** ProbMatrix_new, vid_t*
-                               max_prb_label_not_changed_count, vid_t
-                               knumLabels) {
-  OMP(omp parallel for schedule(runtime))
-  for (vid_t v = 0; v < graph->vertex_count; v++) {
-    vid_t num_of_neighbours = graph->vertices[v+1] - graph->vertices[v];
-    for (vid_t l = 0; l < knumLabels; l++) {  // iterate over each label
-      float prb_l = 0.0;
-      for (vid_t e = graph->vertices[v]; e < graph->vertices[v+1]; e++) {
-        vid_t nbr = graph->edges[e];
-        prb_l+= ProbMatrix[nbr][l];  //  ProbMatrix[nbr][l] is the probability
-                                     //  from the previous round
-      }  //  for
-      //  normalize sum of probabilities of a label by number of neighbours
-      ProbMatrix_new[v][l] = prb_l / (float)num_of_neighbours;
-    }  //  for
-  }  //  for
+PRIVATE void label_counter_finalize(label_counter_t* counter) {
+  totem_free(counter->labels, TOTEM_MEM_HOST);
+  totem_free(counter->counts, TOTEM_MEM_HOST);
+  totem_free(counter->used, TOTEM_MEM_HOST);
 }
 
-PRIVATE void update_labels(const graph_t* graph, vid_t* labels, float**
-                          ProbMatrix, float** ProbMatrix_new, vid_t*
-                          max_prb_label_not_changed_count, vid_t knumLabels) {
-  OMP(omp parallel for schedule(runtime))
-  for (vid_t v = 0; v < graph->vertex_count; v++) {
-    float max_prb = 0.0;
-    int max_label = 0;
-    for (vid_t l = 0; l < knumLabels; l++) {  // iterate over each label
-      ProbMatrix[v][l] = ProbMatrix_new[v][l];
-      if (ProbMatrix[v][l] > max_prb) {
-        max_prb = ProbMatrix[v][l];
-        max_label = l;
-      }
-    }  // for
-    vid_t old_label = labels[v];
-    vid_t new_label = max_label;
-    if (old_label == new_label) {
-    // label has not changed since last iteration so increase the counter
-      max_prb_label_not_changed_count[v]++;
-    } else {
-    // label has changed; so, reset the counter
-      max_prb_label_not_changed_count[v] = 0;
+/**
+ * Adds the given weight to the frequency of a label.
+ */
+inline PRIVATE void label_counter_add(label_counter_t* counter, vid_t label,
+                                      uint64_t weight) {
+  vid_t slot = (vid_t)(label * 2654435761u) & counter->mask;
+  while (counter->labels[slot] != label) {
+    if (counter->labels[slot] == LABEL_PROPAGATION_EMPTY_SLOT) {
+      counter->labels[slot] = label;
+      counter->counts[slot] = 0;
+      counter->used[counter->used_count++] = slot;
+      break;
+    }
+    slot = (slot + 1) & counter->mask;
+  }
+  counter->counts[slot] += weight;
+}
+
+/**
+ * Returns the most frequent label, and clears the counter. Ties are broken in
+ * favor of the current label of the vertex, and then of the smallest label,
+ * which keeps the result independent of the layout of the hash map.
+ */
+PRIVATE vid_t label_counter_select(label_counter_t* counter,
+                                   vid_t current_label) {
+  vid_t best_label = current_label;
+  uint64_t best_count = 0;
+  for (vid_t i = 0; i < counter->used_count; i++) {
+    vid_t slot = counter->used[i];
+    if (counter->labels[slot] == current_label) {
+      best_count = counter->counts[slot];
+      break;
+    }
+  }
+  for (vid_t i = 0; i < counter->used_count; i++) {
+    vid_t slot = counter->used[i];
+    vid_t label = counter->labels[slot];
+    uint64_t count = counter->counts[slot];
+    if (count > best_count ||
+        (count == best_count && label < best_label &&
+         best_label != current_label)) {
+      best_label = label;
+      best_count = count;
     }
-    labels[v] = max_label;
-  }  // for
+    counter->labels[slot] = LABEL_PROPAGATION_EMPTY_SLOT;
+  }
+  counter->used_count = 0;
+  return best_label;
 }
 
-PRIVATE bool convergence_termination_checking(const graph_t* graph, vid_t*
-                          max_prb_label_not_changed_count, bool finished) {
-  OMP(omp parallel for schedule(runtime) reduction(& : finished))
+/**
+ * Builds a random order of the vertices via a Fisher-Yates shuffle driven by
+ * a fixed seed, hence the order is the same across runs.
+ */
+PRIVATE void label_propagation_order(const graph_t* graph, vid_t* order) {
+  OMP(omp parallel for schedule(static))
   for (vid_t v = 0; v < graph->vertex_count; v++) {
-    if (max_prb_label_not_changed_count[v] <
-      LABEL_PROPAGATION_MAX_LABEL_NOT_CHANGED_COUNT) {
-      finished = false;
-    }  // for
+    order[v] = v;
+  }
+  uint64_t state = LABEL_PROPAGATION_SEED;
+  for (vid_t i = graph->vertex_count - 1; i > 0; i--) {
+    // xorshift64
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    vid_t j = state % (i + 1);
+    vid_t tmp = order[i];
+    order[i] = order[j];
+    order[j] = tmp;
   }
-  return finished;
 }
 
+/**
+ * Implements the asynchronous version of the Label Propagation algorithm
+ * described in [Raghavan 2007] for CPU.
+ *
+ * Initially, each vertex is assigned a unique label (its own vertex ID). In
+ * each iteration, the vertices are visited in a random order, and each vertex
+ * adopts the label that is the most frequent among its neighbors (weighted by
+ * the edge weights for weighted graphs). Updates are asynchronous: a vertex
+ * observes the labels its neighbors adopted earlier in the same iteration,
+ * which avoids the label oscillations of the synchronous version on
+ * bipartite-like structures.
+ *
+ * Only active vertices are visited. A vertex becomes inactive once visited,
+ * and is activated again when the label of one of its neighbors changes,
+ * hence converged regions of the graph are skipped. The algorithm terminates
+ * when no vertex is active or after LABEL_PROPAGATION_MAX_ITERATIONS. Each
+ * vertex holds a single label, hence the state is O(V), and an iteration costs
+ * O(E) at most. Please note that this algorithm can only detect disjoint
+ * communities, and that the result of a parallel run may depend on the
+ * interleaving of the threads.
+ *
+ * @param[in] graph an instance of the graph structure
+ * @param[out] labels the computed labels of each vertex
+ * @return generic success or failure
+ *
+ */
 error_t label_propagation_cpu(const graph_t* graph, vid_t* labels) {
   // Check for special cases
   bool finished = false;
   error_t rc = check_special_cases(graph, &finished, labels);
   if (finished) return rc;
 
-  // Initialize the labels
-  OMP(omp parallel for schedule(runtime))
+  // Initialize the labels, and activate all the vertices.
+  vid_t max_degree = 0;
+  OMP(omp parallel for schedule(static) reduction(max : max_degree))
   for (vid_t vertex_id = 0; vertex_id < graph->vertex_count; vertex_id++) {
     labels[vertex_id] = vertex_id;
+    vid_t degree = graph->vertices[vertex_id + 1] - graph->vertices[vertex_id];
+    if (degree > max_degree) max_degree = degree;
   }
+  bitmap_t active = bitmap_init_cpu(graph->vertex_count);
+  OMP(omp parallel for schedule(static))
+  for (vid_t vertex_id = 0; vertex_id < graph->vertex_count; vertex_id++) {
+    bitmap_set_cpu(active, vertex_id);
+  }
+
+  vid_t* order = NULL;
+  CALL_SAFE(totem_malloc(graph->vertex_count * sizeof(vid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&order)));
+  label_propagation_order(graph, order);
 
-  const vid_t knumLabels = graph->vertex_count;
+  int thread_count = omp_get_max_threads();
+  label_counter_t* counters = reinterpret_cast<label_counter_t*>
+      (calloc(thread_count, sizeof(label_counter_t)));
+  assert(counters);
+  for (int t = 0; t < thread_count; t++) {
+    label_counter_init(max_degree, &counters[t]);
+  }
 
-  // P is a n x m matrix, where n is the number of vertices in the graph and
-  // m is the number of labels
+  for (int iteration = 0; iteration < LABEL_PROPAGATION_MAX_ITERATIONS;
+       iteration++) {
+    bool changed = false;
+    OMP(omp parallel reduction(| : changed))
+    {
+      label_counter_t* counter = &counters[omp_get_thread_num()];
+      OMP(omp for schedule(dynamic, 256))
+      for (vid_t i = 0; i < graph->vertex_count; i++) {
+        vid_t v = order[i];
+        if (!bitmap_is_set(active, v)) continue;
+        bitmap_unset_cpu(active, v);
+        if (graph->vertices[v] == graph->vertices[v + 1]) continue;
 
-  float **ProbMatrix = reinterpret_cast<float**>(malloc(
-                                    graph->vertex_count * sizeof(float*)));
-  float **ProbMatrix_new = reinterpret_cast<float**>
-                             (malloc(graph->vertex_count * sizeof(float*)));
+        // Count the labels of the neighbors.
+        for (eid_t e = graph->vertices[v]; e < graph->vertices[v + 1]; e++) {
+          vid_t nbr = graph->edges[e];
+          uint64_t weight = graph->weighted ? graph->weights[e] : 1;
+          label_counter_add(counter, labels[nbr], weight);
+        }
+        vid_t label = label_counter_select(counter, labels[v]);
+        if (label == labels[v]) continue;
 
-  for (vid_t vertex_id = 0; vertex_id < graph->vertex_count; vertex_id++) {
-    ProbMatrix[vertex_id] = reinterpret_cast<float *>
-                             (malloc(graph->vertex_count * sizeof(float)));
-    ProbMatrix_new[vertex_id] = reinterpret_cast<float *>
-                             (malloc(graph->vertex_count * sizeof(float)));
+        // The label changed, hence the neighbors have to reconsider theirs.
+        labels[v] = label;
+        changed = true;
+        for (eid_t e = graph->vertices[v]; e < graph->vertices[v + 1]; e++) {
+          bitmap_set_cpu(active, graph->edges[e]);
+        }
+      }
+    }
+    if (!changed) break;
   }
 
-  // ProbMatrix_new contains the updated probabilities
-  vid_t *max_prb_label_not_changed_count = reinterpret_cast<vid_t*>
-                             (malloc(graph->vertex_count * sizeof(vid_t)));
-  // Initialize label probabilities
-  label_probability_initialisation(knumLabels, graph, ProbMatrix,
-                                            max_prb_label_not_changed_count);
-
-  vid_t iteration_count = 0;
-  finished = false;
-  while (!finished) {
-    finished = true;
-
-    // Label propagation
-    label_propagation(graph, ProbMatrix, ProbMatrix_new,
-                                max_prb_label_not_changed_count, knumLabels);
-
-    // Update lable propability and label selection
-    update_labels(graph, labels, ProbMatrix, ProbMatrix_new,
-                                max_prb_label_not_changed_count, knumLabels);
-
-    // Verify convergence and termination criterion
-    finished = convergence_termination_checking(graph,
-                                 max_prb_label_not_changed_count, &finished);
-    iteration_count++;
-    if (iteration_count >= LABEL_PROPAGATION_MAX_ITERATIONS) {
-      finished = true;
-    }
-  }  // while
+  for (int t = 0; t < thread_count; t++) {
+    label_counter_finalize(&counters[t]);
+  }
+  free(counters);
+  totem_free(order, TOTEM_MEM_HOST);
+  bitmap_finalize_cpu(active);
   return SUCCESS;
 }
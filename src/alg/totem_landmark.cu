@@ -0,0 +1,542 @@
+/**
+ * Implements a landmark distance oracle for CPU, which answers distance
+ * queries via the triangle inequality over the precomputed distances from and
+ * to a small set of landmarks, as described in [Goldberg05] A. Goldberg,
+ * C. Harrelson, "Computing the Shortest Path: A* Search Meets Graph Theory",
+ * SODA 2005.
+ *
+ * For a landmark L, the distance from s to t is at least d(L, t) - d(L, s) and
+ * d(s, L) - d(t, L), and at most d(s, L) + d(L, t). The bounds are instant
+ * approximate answers, and the lower bound is the potential of the A* search
+ * of point_to_point_alt_cpu (see totem_point_to_point.cu).
+ *
+ * The landmarks are either the vertices with the highest degree, or are picked
+ * one at a time as the vertex farthest from the landmarks picked so far. The
+ * distances of a batch of landmarks are computed in a single sweep over the
+ * graph: unweighted graphs use a bit-parallel BFS, where the frontier of each
+ * vertex is a 64-bit mask of the landmarks that reached it in the last level
+ * [Then14]; weighted graphs use a label-correcting sweep that relaxes an edge
+ * for every landmark of the batch at once. The distances are stored vertex
+ * major, so the distances of a vertex to all the landmarks are contiguous,
+ * and in 16 bits when the largest of them fits.
+ *
+ * [Then14] M. Then et al., "The More the Merrier: Efficient Multi-Source Graph
+ * Traversal", VLDB 2014.
+ */
+
+// system includes
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// totem includes
+#include "totem_alg.h"
+
+// The number of landmarks of a bit-parallel BFS sweep.
+const uint32_t LANDMARK_BFS_BATCH = 64;
+
+// The unreachable distance in the 16-bit tables.
+const uint16_t LANDMARK_COMPACT_INFINITE = UINT16_MAX;
+
+// Identifies an index file, and the version of its layout.
+const uint64_t LANDMARK_FILE_MAGIC = 0x4b524d444e414c54ULL;  // "TLANDMRK"
+const uint32_t LANDMARK_FILE_VERSION = 1;
+
+// The flags of an index file.
+const uint32_t LANDMARK_FILE_COMPACT = 1;
+const uint32_t LANDMARK_FILE_WEIGHTED = 2;
+const uint32_t LANDMARK_FILE_SHARED = 4;
+
+/**
+ * The header of an index file. It is followed by the landmarks, the distances
+ * from the landmarks, and the distances to the landmarks unless they are
+ * shared, each starting at a multiple of eight bytes.
+ */
+typedef struct {
+  uint64_t magic;
+  uint32_t version;
+  uint32_t flags;
+  uint32_t vertex_count;
+  uint32_t landmark_count;
+} landmark_file_header_t;
+
+inline PRIVATE size_t landmark_align(size_t offset) {
+  return (offset + 7) & ~(size_t)7;
+}
+
+/**
+ * Returns the distance between vertex v and landmark i in a table, INFINITE
+ * if they are not connected.
+ */
+inline PRIVATE weight_t landmark_distance(const landmark_index_t* index,
+                                          const void* table, vid_t v,
+                                          uint32_t i) {
+  size_t slot = (size_t)v * index->landmark_count + i;
+  if (index->compact) {
+    uint16_t distance = reinterpret_cast<const uint16_t*>(table)[slot];
+    return distance == LANDMARK_COMPACT_INFINITE ? INFINITE : distance;
+  }
+  return reinterpret_cast<const weight_t*>(table)[slot];
+}
+
+/**
+ * Computes the distances of the landmarks [first, first + count) of an
+ * unweighted graph via bit-parallel BFS sweeps of up to LANDMARK_BFS_BATCH
+ * landmarks each.
+ */
+PRIVATE void landmark_sweep_hops(const graph_t* graph, const vid_t* landmarks,
+                                 uint32_t landmark_count, uint32_t first,
+                                 uint32_t count, weight_t* table) {
+  const vid_t vcount = graph->vertex_count;
+  uint64_t* seen = NULL;
+  uint64_t* frontier = NULL;
+  uint64_t* next = NULL;
+  CALL_SAFE(totem_malloc(vcount * sizeof(uint64_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&seen)));
+  CALL_SAFE(totem_malloc(vcount * sizeof(uint64_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&frontier)));
+  CALL_SAFE(totem_malloc(vcount * sizeof(uint64_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&next)));
+  for (uint32_t batch = first; batch < first + count;
+       batch += LANDMARK_BFS_BATCH) {
+    uint32_t batch_count = std::min(LANDMARK_BFS_BATCH, first + count - batch);
+    memset(seen, 0, vcount * sizeof(uint64_t));
+    memset(frontier, 0, vcount * sizeof(uint64_t));
+    memset(next, 0, vcount * sizeof(uint64_t));
+    for (uint32_t j = 0; j < batch_count; j++) {
+      vid_t landmark = landmarks[batch + j];
+      seen[landmark] |= (uint64_t)1 << j;
+      frontier[landmark] |= (uint64_t)1 << j;
+      table[(size_t)landmark * landmark_count + batch + j] = 0;
+    }
+    bool active = true;
+    for (weight_t level = 1; active; level++) {
+      OMP(omp parallel for schedule(dynamic, 256))
+      for (vid_t u = 0; u < vcount; u++) {
+        uint64_t bits = frontier[u];
+        if (bits == 0) continue;
+        for (eid_t e = graph->vertices[u]; e < graph->vertices[u + 1]; e++) {
+          vid_t v = graph->edges[e];
+          // The seen masks do not change in this phase.
+          if ((bits & ~seen[v] & ~next[v]) != 0) {
+            __sync_fetch_and_or(&next[v], bits);
+          }
+        }
+      }
+      active = false;
+      OMP(omp parallel for schedule(static) reduction(| : active))
+      for (vid_t v = 0; v < vcount; v++) {
+        uint64_t reached = next[v] & ~seen[v];
+        next[v] = 0;
+        frontier[v] = reached;
+        if (reached == 0) continue;
+        seen[v] |= reached;
+        active = true;
+        weight_t* distances = &table[(size_t)v * landmark_count + batch];
+        while (reached) {
+          distances[__builtin_ctzll(reached)] = level;
+          reached &= reached - 1;
+        }
+      }
+    }
+  }
+  totem_free(seen, TOTEM_MEM_HOST);
+  totem_free(frontier, TOTEM_MEM_HOST);
+  totem_free(next, TOTEM_MEM_HOST);
+}
+
+/**
+ * Computes the distances of the landmarks [first, first + count) of a weighted
+ * graph via a single label-correcting sweep: an active vertex relaxes each of
+ * its edges for all the landmarks at once, and a vertex becomes active when
+ * the distance of any landmark to it improves.
+ */
+PRIVATE void landmark_sweep_weighted(const graph_t* graph,
+                                     const vid_t* landmarks,
+                                     uint32_t landmark_count, uint32_t first,
+                                     uint32_t count, weight_t* table) {
+  const vid_t vcount = graph->vertex_count;
+  bool* active = NULL;
+  bool* next = NULL;
+  CALL_SAFE(totem_malloc(vcount * sizeof(bool), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&active)));
+  CALL_SAFE(totem_malloc(vcount * sizeof(bool), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&next)));
+  memset(active, 0, vcount * sizeof(bool));
+  memset(next, 0, vcount * sizeof(bool));
+  for (uint32_t i = first; i < first + count; i++) {
+    table[(size_t)landmarks[i] * landmark_count + i] = 0;
+    active[landmarks[i]] = true;
+  }
+  bool any_active = true;
+  while (any_active) {
+    any_active = false;
+    OMP(omp parallel for schedule(dynamic, 64) reduction(| : any_active))
+    for (vid_t u = 0; u < vcount; u++) {
+      if (!active[u]) continue;
+      active[u] = false;
+      const weight_t* source = &table[(size_t)u * landmark_count];
+      for (eid_t e = graph->vertices[u]; e < graph->vertices[u + 1]; e++) {
+        weight_t* target = &table[(size_t)graph->edges[e] * landmark_count];
+        for (uint32_t i = first; i < first + count; i++) {
+          uint64_t distance = (uint64_t)source[i] + graph->weights[e];
+          if (distance >= INFINITE || distance >= target[i]) continue;
+          if (distance < __sync_fetch_and_min_uint32(&target[i],
+                                                     distance)) {
+            next[graph->edges[e]] = true;
+            any_active = true;
+          }
+        }
+      }
+    }
+    std::swap(active, next);
+  }
+  totem_free(active, TOTEM_MEM_HOST);
+  totem_free(next, TOTEM_MEM_HOST);
+}
+
+PRIVATE void landmark_sweep(const graph_t* graph, const vid_t* landmarks,
+                            uint32_t landmark_count, uint32_t first,
+                            uint32_t count, weight_t* table) {
+  if (graph->weighted) {
+    landmark_sweep_weighted(graph, landmarks, landmark_count, first, count,
+                            table);
+  } else {
+    landmark_sweep_hops(graph, landmarks, landmark_count, first, count,
+                        table);
+  }
+}
+
+inline PRIVATE eid_t landmark_degree(const graph_t* graph, vid_t v) {
+  return graph->vertices[v + 1] - graph->vertices[v];
+}
+
+/**
+ * Orders vertices by decreasing degree, and by increasing id for equal
+ * degrees.
+ */
+class LandmarkDegreeOrder {
+ public:
+  explicit LandmarkDegreeOrder(const graph_t* graph) : graph_(graph) {}
+  bool operator()(vid_t a, vid_t b) const {
+    eid_t degree_a = landmark_degree(graph_, a);
+    eid_t degree_b = landmark_degree(graph_, b);
+    return degree_a > degree_b || (degree_a == degree_b && a < b);
+  }
+ private:
+  const graph_t* graph_;
+};
+
+/**
+ * Picks the landmarks with the highest degree.
+ */
+PRIVATE void landmark_select_degree(const graph_t* graph, uint32_t count,
+                                    vid_t* landmarks) {
+  vid_t* order = NULL;
+  CALL_SAFE(totem_malloc(graph->vertex_count * sizeof(vid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&order)));
+  for (vid_t v = 0; v < graph->vertex_count; v++) order[v] = v;
+  std::partial_sort(order, order + count, order + graph->vertex_count,
+                    LandmarkDegreeOrder(graph));
+  memcpy(landmarks, order, count * sizeof(vid_t));
+  totem_free(order, TOTEM_MEM_HOST);
+}
+
+/**
+ * Picks the landmarks one at a time, and computes their distances in the
+ * process. The first landmark is the vertex with the highest degree; each next
+ * one is the vertex farthest from the landmarks picked so far, where vertices
+ * not reached by any of them come first, by decreasing degree. Once every
+ * vertex is at distance zero from a landmark (which zero-weight edges allow),
+ * the remaining landmarks are the vertices not picked yet, by decreasing
+ * degree.
+ */
+PRIVATE void landmark_select_farthest(const graph_t* graph, uint32_t count,
+                                      vid_t* landmarks, weight_t* table) {
+  const vid_t vcount = graph->vertex_count;
+  weight_t* nearest = NULL;
+  bool* picked = NULL;
+  CALL_SAFE(totem_malloc(vcount * sizeof(weight_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&nearest)));
+  CALL_SAFE(totem_calloc(vcount * sizeof(bool), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&picked)));
+  totem_memset(nearest, INFINITE, vcount, TOTEM_MEM_HOST);
+  LandmarkDegreeOrder order(graph);
+  for (uint32_t i = 0; i < count; i++) {
+    vid_t best = INFINITE;
+    for (vid_t v = 0; v < vcount; v++) {
+      if (nearest[v] == 0) continue;
+      if (best == INFINITE || nearest[v] > nearest[best] ||
+          (nearest[v] == nearest[best] && nearest[v] == INFINITE &&
+           order(v, best))) {
+        best = v;
+      }
+    }
+    if (best == INFINITE) {
+      for (vid_t v = 0; v < vcount; v++) {
+        if (!picked[v] && (best == INFINITE || order(v, best))) best = v;
+      }
+    }
+    picked[best] = true;
+    landmarks[i] = best;
+    landmark_sweep(graph, landmarks, count, i, 1, table);
+    OMP(omp parallel for schedule(static))
+    for (vid_t v = 0; v < vcount; v++) {
+      nearest[v] = std::min(nearest[v], table[(size_t)v * count + i]);
+    }
+  }
+  totem_free(picked, TOTEM_MEM_HOST);
+  totem_free(nearest, TOTEM_MEM_HOST);
+}
+
+/**
+ * Returns the largest finite distance of a table.
+ */
+PRIVATE weight_t landmark_max_distance(const weight_t* table, size_t size) {
+  weight_t max_distance = 0;
+  OMP(omp parallel for schedule(static) reduction(max : max_distance))
+  for (size_t i = 0; i < size; i++) {
+    if (table[i] != INFINITE && table[i] > max_distance) {
+      max_distance = table[i];
+    }
+  }
+  return max_distance;
+}
+
+/**
+ * Replaces a table by its 16-bit version.
+ */
+PRIVATE void* landmark_compact(weight_t* table, size_t size) {
+  uint16_t* compact = NULL;
+  CALL_SAFE(totem_malloc(size * sizeof(uint16_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&compact)));
+  OMP(omp parallel for schedule(static))
+  for (size_t i = 0; i < size; i++) {
+    compact[i] = table[i] == INFINITE ? LANDMARK_COMPACT_INFINITE :
+        (uint16_t)table[i];
+  }
+  totem_free(table, TOTEM_MEM_HOST);
+  return compact;
+}
+
+error_t landmark_index_build_cpu(const graph_t* graph,
+                                 uint32_t landmark_count,
+                                 landmark_selection_t selection,
+                                 landmark_index_t** index) {
+  if ((graph == NULL) || (index == NULL) || (landmark_count == 0) ||
+      (landmark_count > graph->vertex_count) ||
+      ((selection != LANDMARK_SELECTION_DEGREE) &&
+       (selection != LANDMARK_SELECTION_FARTHEST))) {
+    return FAILURE;
+  }
+  const size_t size = (size_t)graph->vertex_count * landmark_count;
+  vid_t* landmarks = NULL;
+  weight_t* from = NULL;
+  CALL_SAFE(totem_malloc(landmark_count * sizeof(vid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&landmarks)));
+  CALL_SAFE(totem_malloc(size * sizeof(weight_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&from)));
+  totem_memset(from, INFINITE, size, TOTEM_MEM_HOST);
+  if (selection == LANDMARK_SELECTION_DEGREE) {
+    landmark_select_degree(graph, landmark_count, landmarks);
+    landmark_sweep(graph, landmarks, landmark_count, 0, landmark_count, from);
+  } else {
+    landmark_select_farthest(graph, landmark_count, landmarks, from);
+  }
+
+  // The distances to the landmarks are the distances from them in the
+  // transpose. As in the point-to-point engine, only unweighted undirected
+  // graphs are their own transpose.
+  weight_t* to = from;
+  if (graph->directed || graph->weighted) {
+    graph_t* transpose = NULL;
+    CALL_SAFE(graph_create_transpose(graph, &transpose));
+    CALL_SAFE(totem_malloc(size * sizeof(weight_t), TOTEM_MEM_HOST,
+                           reinterpret_cast<void**>(&to)));
+    totem_memset(to, INFINITE, size, TOTEM_MEM_HOST);
+    landmark_sweep(transpose, landmarks, landmark_count, 0, landmark_count,
+                   to);
+    graph_finalize(transpose);
+  }
+
+  landmark_index_t* result = reinterpret_cast<landmark_index_t*>(
+      calloc(1, sizeof(landmark_index_t)));
+  assert(result);
+  result->graph = graph;
+  result->landmark_count = landmark_count;
+  result->landmarks = landmarks;
+  result->weighted = graph->weighted;
+  weight_t max_distance = std::max(landmark_max_distance(from, size),
+                                   landmark_max_distance(to, size));
+  result->compact = max_distance < LANDMARK_COMPACT_INFINITE;
+  if (result->compact) {
+    result->from = landmark_compact(from, size);
+    result->to = to == from ? result->from : landmark_compact(to, size);
+  } else {
+    result->from = from;
+    result->to = to;
+  }
+  *index = result;
+  return SUCCESS;
+}
+
+error_t landmark_index_finalize(landmark_index_t* index) {
+  if (index == NULL) return FAILURE;
+  if (index->mapping) {
+    munmap(index->mapping, index->mapping_length);
+  } else {
+    if (index->to != index->from) {
+      totem_free(const_cast<void*>(index->to), TOTEM_MEM_HOST);
+    }
+    totem_free(const_cast<void*>(index->from), TOTEM_MEM_HOST);
+    totem_free(const_cast<vid_t*>(index->landmarks), TOTEM_MEM_HOST);
+  }
+  free(index);
+  return SUCCESS;
+}
+
+/**
+ * Writes a section of an index file, padded to a multiple of eight bytes.
+ */
+PRIVATE bool landmark_write(FILE* file, const void* data, size_t length) {
+  const uint64_t padding = 0;
+  size_t pad = landmark_align(length) - length;
+  return fwrite(data, 1, length, file) == length &&
+      fwrite(&padding, 1, pad, file) == pad;
+}
+
+error_t landmark_index_store(const landmark_index_t* index,
+                             const char* file_path) {
+  if ((index == NULL) || (file_path == NULL)) return FAILURE;
+  FILE* file = fopen(file_path, "wb");
+  if (file == NULL) return FAILURE;
+  landmark_file_header_t header;
+  memset(&header, 0, sizeof(header));
+  header.magic = LANDMARK_FILE_MAGIC;
+  header.version = LANDMARK_FILE_VERSION;
+  header.flags = (index->compact ? LANDMARK_FILE_COMPACT : 0) |
+      (index->weighted ? LANDMARK_FILE_WEIGHTED : 0) |
+      (index->to == index->from ? LANDMARK_FILE_SHARED : 0);
+  header.vertex_count = index->graph->vertex_count;
+  header.landmark_count = index->landmark_count;
+  const size_t table_length = (size_t)header.vertex_count *
+      header.landmark_count * (index->compact ? sizeof(uint16_t) :
+                               sizeof(weight_t));
+  bool ok = landmark_write(file, &header, sizeof(header)) &&
+      landmark_write(file, index->landmarks,
+                     index->landmark_count * sizeof(vid_t)) &&
+      landmark_write(file, index->from, table_length);
+  if (ok && index->to != index->from) {
+    ok = landmark_write(file, index->to, table_length);
+  }
+  if (fclose(file) != 0) ok = false;
+  return ok ? SUCCESS : FAILURE;
+}
+
+error_t landmark_index_load(const graph_t* graph, const char* file_path,
+                            landmark_index_t** index) {
+  if ((graph == NULL) || (file_path == NULL) || (index == NULL)) {
+    return FAILURE;
+  }
+  int fd = open(file_path, O_RDONLY);
+  if (fd < 0) return FAILURE;
+  struct stat status;
+  if (fstat(fd, &status) != 0 ||
+      (size_t)status.st_size < sizeof(landmark_file_header_t)) {
+    close(fd);
+    return FAILURE;
+  }
+  size_t length = status.st_size;
+  void* mapping = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) return FAILURE;
+
+  // Validate the header against the graph, and the length of the file against
+  // the header.
+  const char* base = reinterpret_cast<const char*>(mapping);
+  const landmark_file_header_t* header =
+      reinterpret_cast<const landmark_file_header_t*>(base);
+  bool compact = header->flags & LANDMARK_FILE_COMPACT;
+  bool shared = header->flags & LANDMARK_FILE_SHARED;
+  size_t landmarks_offset = landmark_align(sizeof(landmark_file_header_t));
+  size_t from_offset = landmarks_offset +
+      landmark_align(header->landmark_count * sizeof(vid_t));
+  size_t table_length = landmark_align(
+      (size_t)header->vertex_count * header->landmark_count *
+      (compact ? sizeof(uint16_t) : sizeof(weight_t)));
+  size_t to_offset = shared ? from_offset : from_offset + table_length;
+  if ((header->magic != LANDMARK_FILE_MAGIC) ||
+      (header->version != LANDMARK_FILE_VERSION) ||
+      (header->vertex_count != graph->vertex_count) ||
+      (header->landmark_count == 0) ||
+      (((header->flags & LANDMARK_FILE_WEIGHTED) != 0) != graph->weighted) ||
+      (length != to_offset + table_length)) {
+    munmap(mapping, length);
+    return FAILURE;
+  }
+
+  landmark_index_t* result = reinterpret_cast<landmark_index_t*>(
+      calloc(1, sizeof(landmark_index_t)));
+  assert(result);
+  result->graph = graph;
+  result->landmark_count = header->landmark_count;
+  result->landmarks = reinterpret_cast<const vid_t*>(base + landmarks_offset);
+  result->weighted = graph->weighted;
+  result->compact = compact;
+  result->from = base + from_offset;
+  result->to = base + to_offset;
+  result->mapping = mapping;
+  result->mapping_length = length;
+  *index = result;
+  return SUCCESS;
+}
+
+weight_t landmark_lower_bound(const landmark_index_t* index, vid_t source,
+                              vid_t target) {
+  weight_t bound = 0;
+  for (uint32_t i = 0; i < index->landmark_count; i++) {
+    weight_t from_source = landmark_distance(index, index->from, source, i);
+    weight_t from_target = landmark_distance(index, index->from, target, i);
+    weight_t to_source = landmark_distance(index, index->to, source, i);
+    weight_t to_target = landmark_distance(index, index->to, target, i);
+    // If the landmark reaches the source but not the target, or the target
+    // reaches the landmark but the source does not, there is no path.
+    if ((from_source != INFINITE && from_target == INFINITE) ||
+        (to_target != INFINITE && to_source == INFINITE)) {
+      return INFINITE;
+    }
+    if (from_source != INFINITE && from_target > from_source) {
+      bound = std::max(bound, from_target - from_source);
+    }
+    if (to_target != INFINITE && to_source > to_target) {
+      bound = std::max(bound, to_source - to_target);
+    }
+  }
+  return bound;
+}
+
+error_t landmark_estimate(const landmark_index_t* index, vid_t source,
+                          vid_t target, weight_t* lower, weight_t* upper) {
+  if ((index == NULL) || (lower == NULL) || (upper == NULL) ||
+      (source >= index->graph->vertex_count) ||
+      (target >= index->graph->vertex_count)) {
+    return FAILURE;
+  }
+  *lower = source == target ? 0 : landmark_lower_bound(index, source, target);
+  *upper = INFINITE;
+  if (source == target) {
+    *upper = 0;
+    return SUCCESS;
+  }
+  if (*lower == INFINITE) return SUCCESS;
+  for (uint32_t i = 0; i < index->landmark_count; i++) {
+    uint64_t to_landmark = landmark_distance(index, index->to, source, i);
+    uint64_t from_landmark = landmark_distance(index, index->from, target, i);
+    if (to_landmark == INFINITE || from_landmark == INFINITE) continue;
+    if (to_landmark + from_landmark < *upper) {
+      *upper = to_landmark + from_landmark;
+    }
+  }
+  return SUCCESS;
+}
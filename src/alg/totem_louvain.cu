@@ -0,0 +1,415 @@
+/**
+ * Implements a parallel version of the Louvain modularity optimization
+ * algorithm described in [Blondel08] V. D. Blondel, J.-L. Guillaume,
+ * R. Lambiotte, E. Lefebvre, "Fast unfolding of communities in large
+ * networks", Journal of Statistical Mechanics, 2008. The parallelization of
+ * the local moving phase follows [Lu15] H. Lu, M. Halappanavar,
+ * A. Kalyanaraman, "Parallel heuristics for scalable community detection",
+ * Parallel Computing, 2015.
+ *
+ * Each level alternates two phases:
+ *   - local moving: vertices are visited in parallel, and each moves to the
+ *     neighboring community that yields the largest modularity gain, until a
+ *     pass improves the modularity by less than LOUVAIN_MIN_GAIN. A pass that
+ *     does not improve the modularity at all is reverted.
+ *   - aggregation: each community becomes a vertex of a coarse graph, whose
+ *     edge weights are the sums of the weights of the edges between the
+ *     communities, and whose self loops hold the weight inside them.
+ * The levels stop once the local moving phase does not improve the modularity
+ * of the level, in which case the partitioning of the previous level is kept.
+ *
+ * Each coarse graph is allocated with its own vertex and edge counts once its
+ * degrees are known, and freed once the next level is built from it. The
+ * per-vertex buffers are allocated once with the size of the input graph.
+ */
+
+// totem includes
+#include "totem_accumulator.h"
+#include "totem_alg.h"
+
+// Maximum number of levels, and of local moving passes per level.
+const int LOUVAIN_MAX_LEVELS = 32;
+const int LOUVAIN_MAX_PASSES = 32;
+
+// A local moving pass that improves the modularity by less than this value
+// ends the phase.
+const double LOUVAIN_MIN_GAIN = 1e-6;
+
+// A map that accumulates edge weights per community.
+typedef accumulator_t<uint64_t> louvain_map_t;
+
+/**
+ * State of the algorithm, allocated once for the size of the input graph.
+ */
+typedef struct louvain_state_s {
+  vid_t*         community;      // community of each vertex of the level
+  uint64_t*      degree;         // weighted degree of each vertex
+  uint64_t*      total;          // sum of the degrees of each community
+  vid_t*         size;           // number of vertices of each community
+  vid_t*         renumber;       // dense id of each non-empty community
+  vid_t*         member;         // vertices of the level grouped by community
+  eid_t*         member_offset;  // start of each community in member
+  eid_t*         coarse_degree;  // degree of each vertex of the coarse graph
+  louvain_map_t* maps;           // one community map per thread
+  int            thread_count;
+} louvain_state_t;
+
+/**
+ * Returns the weight of an edge of a level. The edges of unweighted input
+ * graphs have weight one, while the coarse graphs are always weighted.
+ */
+inline PRIVATE uint64_t louvain_weight(const graph_t* graph, eid_t e) {
+  return graph->weighted ? graph->weights[e] : 1;
+}
+
+PRIVATE void louvain_init(const graph_t* graph, louvain_state_t* state) {
+  memset(state, 0, sizeof(louvain_state_t));
+  vid_t n = graph->vertex_count;
+  CALL_SAFE(totem_malloc(n * sizeof(vid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state->community)));
+  CALL_SAFE(totem_malloc(n * sizeof(uint64_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state->degree)));
+  CALL_SAFE(totem_malloc(n * sizeof(uint64_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state->total)));
+  CALL_SAFE(totem_malloc(n * sizeof(vid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state->size)));
+  CALL_SAFE(totem_malloc(n * sizeof(vid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state->renumber)));
+  CALL_SAFE(totem_malloc(n * sizeof(vid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state->member)));
+  CALL_SAFE(totem_malloc((n + 1) * sizeof(eid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state->member_offset)));
+  CALL_SAFE(totem_malloc((n + 1) * sizeof(eid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state->coarse_degree)));
+  state->thread_count = omp_get_max_threads();
+  state->maps = reinterpret_cast<louvain_map_t*>
+      (calloc(state->thread_count, sizeof(louvain_map_t)));
+  assert(state->maps);
+}
+
+PRIVATE void louvain_finalize(louvain_state_t* state) {
+  totem_free(state->community, TOTEM_MEM_HOST);
+  totem_free(state->degree, TOTEM_MEM_HOST);
+  totem_free(state->total, TOTEM_MEM_HOST);
+  totem_free(state->size, TOTEM_MEM_HOST);
+  totem_free(state->renumber, TOTEM_MEM_HOST);
+  totem_free(state->member, TOTEM_MEM_HOST);
+  totem_free(state->member_offset, TOTEM_MEM_HOST);
+  totem_free(state->coarse_degree, TOTEM_MEM_HOST);
+  for (int t = 0; t < state->thread_count; t++) {
+    accumulator_finalize(&state->maps[t]);
+  }
+  free(state->maps);
+}
+
+/**
+ * Computes the modularity of a partitioning of a level:
+ *   Q = sum_c (in_c / 2m - (total_c / 2m)^2)
+ * where in_c is the weight of the edges inside community c (each edge counted
+ * in both directions), total_c the sum of the degrees of its vertices, and 2m
+ * the sum of all degrees. The total array is recomputed from the communities.
+ */
+PRIVATE double louvain_modularity(const graph_t* graph, const vid_t* community,
+                                  const uint64_t* degree, uint64_t* total,
+                                  double two_m) {
+  const vid_t n = graph->vertex_count;
+  totem_memset(total, (uint64_t)0, n, TOTEM_MEM_HOST);
+  uint64_t inside = 0;
+  OMP(omp parallel for schedule(dynamic, 1024) reduction(+ : inside))
+  for (vid_t v = 0; v < n; v++) {
+    __sync_fetch_and_add(&total[community[v]], degree[v]);
+    for (eid_t e = graph->vertices[v]; e < graph->vertices[v + 1]; e++) {
+      if (community[graph->edges[e]] == community[v]) {
+        inside += louvain_weight(graph, e);
+      }
+    }
+  }
+  double expected = 0;
+  OMP(omp parallel for schedule(static) reduction(+ : expected))
+  for (vid_t c = 0; c < n; c++) {
+    double fraction = total[c] / two_m;
+    expected += fraction * fraction;
+  }
+  return inside / two_m - expected;
+}
+
+/**
+ * Moves a vertex to the neighboring community with the largest modularity
+ * gain. The gain of moving vertex v of degree k_v into community c is
+ * proportional to k_v,c - total_c * k_v / 2m, where k_v,c is the weight of the
+ * edges from v to c. Returns true if the vertex moved.
+ */
+PRIVATE bool louvain_move(const graph_t* graph, vid_t v, double two_m,
+                          louvain_state_t* state, louvain_map_t* map) {
+  vid_t own = state->community[v];
+  for (eid_t e = graph->vertices[v]; e < graph->vertices[v + 1]; e++) {
+    vid_t nbr = graph->edges[e];
+    if (nbr == v) continue;
+    accumulator_add(map, state->community[nbr], louvain_weight(graph, e));
+  }
+  if (map->used_count == 0) return false;
+
+  const double kv = (double)state->degree[v];
+  double own_weight = 0;
+  for (uint64_t i = 0; i < map->used_count; i++) {
+    if (map->keys[map->used[i]] == own) {
+      own_weight = (double)map->values[map->used[i]];
+      break;
+    }
+  }
+  vid_t best = own;
+  double best_gain = own_weight - (state->total[own] - kv) * kv / two_m;
+  for (uint64_t i = 0; i < map->used_count; i++) {
+    vid_t c = map->keys[map->used[i]];
+    if (c == own) continue;
+    double gain = (double)map->values[map->used[i]] -
+        state->total[c] * kv / two_m;
+    if (gain > best_gain || (gain == best_gain && best != own && c < best)) {
+      best = c;
+      best_gain = gain;
+    }
+  }
+  accumulator_clear(map);
+
+  // Two singleton vertices may otherwise swap communities forever; only the
+  // move towards the smaller community id is allowed [Lu15].
+  if (best == own ||
+      (state->size[own] == 1 && state->size[best] == 1 && best > own)) {
+    return false;
+  }
+  __sync_fetch_and_sub(&state->total[own], state->degree[v]);
+  __sync_fetch_and_add(&state->total[best], state->degree[v]);
+  __sync_fetch_and_sub(&state->size[own], 1);
+  __sync_fetch_and_add(&state->size[best], 1);
+  state->community[v] = best;
+  return true;
+}
+
+/**
+ * The local moving phase of a level. Returns true if it improved the
+ * modularity of the level.
+ */
+PRIVATE bool louvain_local_moving(const graph_t* graph, double two_m,
+                                  louvain_state_t* state) {
+  const vid_t n = graph->vertex_count;
+  eid_t max_degree = 0;
+  OMP(omp parallel for schedule(static) reduction(max : max_degree))
+  for (vid_t v = 0; v < n; v++) {
+    state->community[v] = v;
+    state->size[v] = 1;
+    uint64_t degree = 0;
+    for (eid_t e = graph->vertices[v]; e < graph->vertices[v + 1]; e++) {
+      degree += louvain_weight(graph, e);
+    }
+    state->degree[v] = degree;
+    eid_t count = graph->vertices[v + 1] - graph->vertices[v];
+    if (count > max_degree) max_degree = count;
+  }
+  for (int t = 0; t < state->thread_count; t++) {
+    accumulator_reserve(&state->maps[t], max_degree);
+  }
+
+  double modularity = louvain_modularity(graph, state->community,
+                                         state->degree, state->total, two_m);
+  const double initial = modularity;
+  for (int pass = 0; pass < LOUVAIN_MAX_PASSES; pass++) {
+    // The renumber array is free until the grouping of the level, hence it
+    // keeps the communities before the pass.
+    memcpy(state->renumber, state->community, n * sizeof(vid_t));
+    vid_t moves = 0;
+    OMP(omp parallel reduction(+ : moves))
+    {
+      louvain_map_t* map = &state->maps[omp_get_thread_num()];
+      OMP(omp for schedule(dynamic, 256))
+      for (vid_t v = 0; v < n; v++) {
+        if (louvain_move(graph, v, two_m, state, map)) moves++;
+      }
+    }
+    if (moves == 0) break;
+    // The moves are decided concurrently against slightly stale totals,
+    // hence the totals are recomputed along with the modularity. A pass whose
+    // concurrent moves lowered the modularity is reverted.
+    double next = louvain_modularity(graph, state->community, state->degree,
+                                     state->total, two_m);
+    if (next <= modularity) {
+      memcpy(state->community, state->renumber, n * sizeof(vid_t));
+      break;
+    }
+    bool converged = next - modularity < LOUVAIN_MIN_GAIN;
+    modularity = next;
+    if (converged) break;
+  }
+  return modularity > initial;
+}
+
+/**
+ * Renumbers the non-empty communities densely, and groups the vertices of the
+ * level by community. Returns the number of communities.
+ */
+PRIVATE vid_t louvain_group(const graph_t* graph, louvain_state_t* state) {
+  const vid_t n = graph->vertex_count;
+  totem_memset(state->size, (vid_t)0, n, TOTEM_MEM_HOST);
+  OMP(omp parallel for schedule(static))
+  for (vid_t v = 0; v < n; v++) {
+    __sync_fetch_and_add(&state->size[state->community[v]], 1);
+  }
+  vid_t count = 0;
+  state->member_offset[0] = 0;
+  for (vid_t c = 0; c < n; c++) {
+    if (state->size[c] == 0) continue;
+    state->renumber[c] = count;
+    state->member_offset[count + 1] = state->member_offset[count] +
+        state->size[c];
+    count++;
+  }
+  // The size array is reused as the insertion cursor of each community.
+  totem_memset(state->size, (vid_t)0, count, TOTEM_MEM_HOST);
+  OMP(omp parallel for schedule(static))
+  for (vid_t v = 0; v < n; v++) {
+    vid_t c = state->renumber[state->community[v]];
+    state->community[v] = c;
+    state->member[state->member_offset[c] +
+                  __sync_fetch_and_add(&state->size[c], 1)] = v;
+  }
+  return count;
+}
+
+/**
+ * Accumulates the edges of the members of a community by neighboring
+ * community.
+ */
+PRIVATE void louvain_collect(const graph_t* graph, const louvain_state_t* state,
+                             vid_t c, louvain_map_t* map) {
+  for (eid_t i = state->member_offset[c]; i < state->member_offset[c + 1];
+       i++) {
+    vid_t v = state->member[i];
+    for (eid_t e = graph->vertices[v]; e < graph->vertices[v + 1]; e++) {
+      accumulator_add(map, state->community[graph->edges[e]],
+                      louvain_weight(graph, e));
+    }
+  }
+}
+
+/**
+ * Builds the coarse graph of a level, where each community becomes a vertex.
+ * The CSR is built in two parallel passes: the first computes the degree of
+ * each coarse vertex, which sizes the coarse graph, and the second fills the
+ * edges at the offsets given by the prefix sum of the degrees.
+ */
+PRIVATE graph_t* louvain_aggregate(const graph_t* graph, vid_t community_count,
+                                   louvain_state_t* state) {
+  eid_t max_edges = 0;
+  OMP(omp parallel for schedule(static) reduction(max : max_edges))
+  for (vid_t c = 0; c < community_count; c++) {
+    eid_t edges = 0;
+    for (eid_t i = state->member_offset[c]; i < state->member_offset[c + 1];
+         i++) {
+      vid_t v = state->member[i];
+      edges += graph->vertices[v + 1] - graph->vertices[v];
+    }
+    if (edges > max_edges) max_edges = edges;
+  }
+  eid_t map_size = max_edges < community_count ? max_edges : community_count;
+  for (int t = 0; t < state->thread_count; t++) {
+    accumulator_reserve(&state->maps[t], map_size);
+  }
+
+  OMP(omp parallel)
+  {
+    louvain_map_t* map = &state->maps[omp_get_thread_num()];
+    OMP(omp for schedule(dynamic, 64))
+    for (vid_t c = 0; c < community_count; c++) {
+      louvain_collect(graph, state, c, map);
+      state->coarse_degree[c] = map->used_count;
+      accumulator_clear(map);
+    }
+  }
+
+  eid_t edge_count = 0;
+  OMP(omp parallel for schedule(static) reduction(+ : edge_count))
+  for (vid_t c = 0; c < community_count; c++) {
+    edge_count += state->coarse_degree[c];
+  }
+  graph_t* coarse = NULL;
+  graph_allocate(community_count, edge_count, false, true, false, &coarse);
+  coarse->vertices[0] = 0;
+  for (vid_t c = 0; c < community_count; c++) {
+    coarse->vertices[c + 1] = coarse->vertices[c] + state->coarse_degree[c];
+  }
+
+  OMP(omp parallel)
+  {
+    louvain_map_t* map = &state->maps[omp_get_thread_num()];
+    OMP(omp for schedule(dynamic, 64))
+    for (vid_t c = 0; c < community_count; c++) {
+      louvain_collect(graph, state, c, map);
+      eid_t e = coarse->vertices[c];
+      for (uint64_t i = 0; i < map->used_count; i++, e++) {
+        coarse->edges[e] = map->keys[map->used[i]];
+        coarse->weights[e] = (weight_t)map->values[map->used[i]];
+      }
+      accumulator_clear(map);
+    }
+  }
+  return coarse;
+}
+
+error_t louvain_cpu(const graph_t* graph, vid_t* community,
+                    double* modularity) {
+  // Graphs without edges are accepted even if flagged as directed.
+  if ((graph == NULL) || (graph->vertex_count == 0) ||
+      (graph->directed && graph->edge_count != 0) ||
+      (community == NULL) || (modularity == NULL)) {
+    return FAILURE;
+  }
+  OMP(omp parallel for schedule(static))
+  for (vid_t v = 0; v < graph->vertex_count; v++) {
+    community[v] = v;
+  }
+  *modularity = 0;
+  if (graph->edge_count == 0) return SUCCESS;
+
+  louvain_state_t state;
+  louvain_init(graph, &state);
+  uint64_t total_weight = 0;
+  OMP(omp parallel for schedule(static) reduction(+ : total_weight))
+  for (eid_t e = 0; e < graph->edge_count; e++) {
+    total_weight += louvain_weight(graph, e);
+  }
+  const double two_m = (double)total_weight;
+
+  const graph_t* level_graph = graph;
+  graph_t* coarse = NULL;
+  for (int level = 0; level < LOUVAIN_MAX_LEVELS; level++) {
+    if (!louvain_local_moving(level_graph, two_m, &state)) break;
+    vid_t community_count = louvain_group(level_graph, &state);
+
+    // Project the communities of the level onto the input vertices.
+    OMP(omp parallel for schedule(static))
+    for (vid_t v = 0; v < graph->vertex_count; v++) {
+      community[v] = state.community[community[v]];
+    }
+    if (community_count == level_graph->vertex_count) break;
+
+    graph_t* next = louvain_aggregate(level_graph, community_count, &state);
+    if (coarse) graph_finalize(coarse);
+    coarse = next;
+    level_graph = coarse;
+  }
+  if (coarse) graph_finalize(coarse);
+
+  // Compute the modularity of the final partitioning on the input graph.
+  OMP(omp parallel for schedule(static))
+  for (vid_t v = 0; v < graph->vertex_count; v++) {
+    uint64_t degree = 0;
+    for (eid_t e = graph->vertices[v]; e < graph->vertices[v + 1]; e++) {
+      degree += louvain_weight(graph, e);
+    }
+    state.degree[v] = degree;
+  }
+  *modularity = louvain_modularity(graph, community, state.degree,
+                                   state.total, two_m);
+
+  louvain_finalize(&state);
+  return SUCCESS;
+}
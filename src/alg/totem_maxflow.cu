@@ -10,8 +10,12 @@
  *      Author: Greg Redekop
  */
 
+// system includes
+#include <algorithm>
+
 // totem includes
 #include "totem_alg.h"
+#include "totem_vertex_state.h"
 
 // For each stage of the algorithm, a kernel loops over each vertex this many
 // times attempting pushes and relabels. This will also control the frequency
@@ -470,111 +474,556 @@ error_t maxflow_gpu(graph_t* graph, vid_t source_id, vid_t sink_id,
 }
 
 
+// The CPU implementation follows the synchronous parallel push-relabel
+// algorithm of [Baumstark15] N. Baumstark, G. Blelloch, J. Shun, "Efficient
+// Implementation of a Synchronous Parallel Push-Relabel Algorithm", ESA 2015.
+// Each round discharges the active vertices in parallel against the labels of
+// the previous round, and only the active vertices are visited.
+
+// A global relabel is triggered once the work done by relabel operations since
+// the last one exceeds MAXFLOW_GR_ALPHA * V + E. A relabel of a vertex of
+// degree d accounts for d + MAXFLOW_RELABEL_WORK work units.
+#define MAXFLOW_GR_ALPHA     6
+#define MAXFLOW_RELABEL_WORK 12
+
 /**
- * CPU Push-relabel operation
- * On a particular vertex u, attempt a push operation along any of its edges.
- * If the push operation fails, perform a relabel.
+ * The per-vertex state of the CPU implementation, in the default layout of the
+ * container. The discharge of a vertex reads the label and the round stamps of
+ * each neighbor, and adds excess to some of them.
  */
-PRIVATE
-void push_relabel_cpu(graph_t* graph, vid_t u, vid_t source_id, vid_t sink_id,
-                      weight_t* flow, weight_t* excess, uint32_t* height,
-                      eid_t* reverse_indices, bool* finished) {
-  if (excess[u] <= 0 || height[u] >= graph->vertex_count) return;
-
-  weight_t e_prime = excess[u];
-  uint32_t h_prime = INFINITE;
-  eid_t best_edge_id = INFINITE;
-
-  // Find the lowest neighbor connected by a residual edge
-  for (eid_t edge_id = graph->vertices[u]; edge_id < graph->vertices[u + 1];
-       edge_id++) {
-    if (graph->weights[edge_id] <= flow[edge_id]) continue;
-    uint32_t h_pprime = height[graph->edges[edge_id]];
-    if (h_pprime < h_prime) {
-      best_edge_id = edge_id;
-      h_prime = h_pprime;
+typedef struct {
+  weight_t excess;        // excess of the vertex at the start of the round
+  weight_t added_excess;  // excess pushed to the vertex during the round
+  uint32_t height;        // label of the vertex at the start of the round
+  uint32_t new_height;    // label of the vertex at the end of the round
+  uint32_t active_round;  // last round in which the vertex was discharged
+  uint32_t queued_round;  // last round in which the vertex was queued for the
+                          // next round
+} maxflow_fields_t;
+typedef vertex_state_t<maxflow_fields_t, VERTEX_STATE_DEFAULT_LAYOUT>
+    maxflow_vertex_state_t;
+
+// Accessors of the fields of the per-vertex state.
+#define MF_EXCESS(_state, _v)                                   \
+  vertex_state_get((_state), (_v), &maxflow_fields_t::excess)
+#define MF_ADDED_EXCESS(_state, _v)                             \
+  vertex_state_get((_state), (_v), &maxflow_fields_t::added_excess)
+#define MF_HEIGHT(_state, _v)                                   \
+  vertex_state_get((_state), (_v), &maxflow_fields_t::height)
+#define MF_NEW_HEIGHT(_state, _v)                               \
+  vertex_state_get((_state), (_v), &maxflow_fields_t::new_height)
+#define MF_ACTIVE_ROUND(_state, _v)                             \
+  vertex_state_get((_state), (_v), &maxflow_fields_t::active_round)
+#define MF_QUEUED_ROUND(_state, _v)                             \
+  vertex_state_get((_state), (_v), &maxflow_fields_t::queued_round)
+
+/**
+ * State of one invocation of the CPU implementation.
+ */
+typedef struct {
+  const graph_t*         graph;     // the bidirectional residual graph
+  const eid_t*           reverse;   // index of the reverse of each edge
+  weight_t*              residual;  // residual capacity of each edge
+  maxflow_vertex_state_t vstate;    // per-vertex state
+  vid_t*                 count;     // number of vertices with each label
+  vid_t*                 bucket_head;  // a vertex with each label, or
+                                       // MAXFLOW_NO_VERTEX
+  vid_t*                 bucket_next;  // doubly linked lists of the vertices
+  vid_t*                 bucket_prev;  // with the same label below V
+  uint32_t               max_height;   // upper bound of the labels below V
+  vid_t*                 active;    // vertices discharged in this round
+  vid_t                  active_count;
+  vid_t*                 next;      // vertices to discharge in the next round
+  vid_t                  next_count;
+  vid_t*                 frontier;  // buffer of the global relabel BFS
+  vid_t                  source;
+  vid_t                  sink;
+  uint32_t               round;
+} maxflow_cpu_state_t;
+
+// Ends a per-label vertex list.
+#define MAXFLOW_NO_VERTEX ((vid_t)-1)
+
+/**
+ * Adds a vertex to the list of the vertices with the given label.
+ */
+inline PRIVATE void maxflow_bucket_insert(maxflow_cpu_state_t* st, vid_t v,
+                                          uint32_t height) {
+  vid_t head = st->bucket_head[height];
+  st->bucket_prev[v] = MAXFLOW_NO_VERTEX;
+  st->bucket_next[v] = head;
+  if (head != MAXFLOW_NO_VERTEX) st->bucket_prev[head] = v;
+  st->bucket_head[height] = v;
+  if (height > st->max_height) st->max_height = height;
+}
+
+/**
+ * Removes a vertex from the list of the vertices with the given label.
+ */
+inline PRIVATE void maxflow_bucket_remove(maxflow_cpu_state_t* st, vid_t v,
+                                          uint32_t height) {
+  vid_t prev = st->bucket_prev[v];
+  vid_t next = st->bucket_next[v];
+  if (prev != MAXFLOW_NO_VERTEX) {
+    st->bucket_next[prev] = next;
+  } else {
+    st->bucket_head[height] = next;
+  }
+  if (next != MAXFLOW_NO_VERTEX) st->bucket_prev[next] = prev;
+}
+
+/**
+ * Queues a vertex for the next round, once per round.
+ */
+inline PRIVATE void maxflow_enqueue(maxflow_cpu_state_t* st, vid_t v) {
+  uint32_t* queued = &MF_QUEUED_ROUND(st->vstate, v);
+  uint32_t old = *queued;
+  while (old != st->round) {
+    uint32_t prev = __sync_val_compare_and_swap(queued, old, st->round);
+    if (prev == old) {
+      st->next[__sync_fetch_and_add(&st->next_count, 1)] = v;
+      return;
     }
+    old = prev;
   }
+}
 
-  // If a push applies
-  if (height[u] > h_prime) {
-    weight_t push_amt = min(e_prime, graph->weights[best_edge_id] -
-                            flow[best_edge_id]);
-    __sync_fetch_and_add(&flow[best_edge_id], push_amt);
-    __sync_fetch_and_add(&flow[reverse_indices[best_edge_id]], -push_amt);
-    __sync_fetch_and_add(&excess[u], -push_amt);
-    __sync_fetch_and_add(&excess[graph->edges[best_edge_id]], push_amt);
-    *finished = false;
+/**
+ * Recomputes the labels as the exact distances to the sink in the residual
+ * graph, via a parallel BFS from the sink over the reverse residual edges.
+ * Vertices that cannot reach the sink get label V, which deactivates them.
+ * It also rebuilds the label counts, the per-label vertex lists and the list
+ * of active vertices.
+ */
+PRIVATE void maxflow_global_relabel(maxflow_cpu_state_t* st) {
+  const graph_t* graph = st->graph;
+  const vid_t n = graph->vertex_count;
+  const maxflow_vertex_state_t& vstate = st->vstate;
+
+  vertex_state_fill(vstate, &maxflow_fields_t::height, (uint32_t)n);
+  totem_memset(st->count, (vid_t)0, n + 1, TOTEM_MEM_HOST);
+  MF_HEIGHT(vstate, st->sink) = 0;
+  st->frontier[0] = st->sink;
+  vid_t level_start = 0;
+  vid_t level_end = 1;
+  vid_t tail = 1;
+  uint32_t level = 0;
+  while (level_start < level_end) {
+    OMP(omp parallel for schedule(dynamic, 64))
+    for (vid_t i = level_start; i < level_end; i++) {
+      vid_t x = st->frontier[i];
+      for (eid_t e = graph->vertices[x]; e < graph->vertices[x + 1]; e++) {
+        // y can reach x if the reverse edge (y, x) has residual capacity.
+        vid_t y = graph->edges[e];
+        if (y == st->source || st->residual[st->reverse[e]] == 0) continue;
+        if (MF_HEIGHT(vstate, y) == n &&
+            __sync_bool_compare_and_swap(&MF_HEIGHT(vstate, y), n,
+                                         level + 1)) {
+          st->frontier[__sync_fetch_and_add(&tail, 1)] = y;
+        }
+      }
+    }
+    st->count[level] = level_end - level_start;
+    level_start = level_end;
+    level_end = tail;
+    level++;
   }
-  // Otherwise perform a relabel
-  else if (h_prime != INFINITE) {
-    height[u] = h_prime + 1;
-    *finished = false;
+
+  // The BFS visits every vertex with a label below V.
+  totem_memset(st->bucket_head, MAXFLOW_NO_VERTEX, n + 1, TOTEM_MEM_HOST);
+  st->max_height = 0;
+  for (vid_t i = 0; i < tail; i++) {
+    vid_t v = st->frontier[i];
+    maxflow_bucket_insert(st, v, MF_HEIGHT(vstate, v));
+  }
+
+  // The active vertices are the ones with excess that can reach the sink.
+  st->active_count = 0;
+  OMP(omp parallel for schedule(static))
+  for (vid_t i = 1; i < tail; i++) {
+    vid_t v = st->frontier[i];
+    MF_NEW_HEIGHT(vstate, v) = MF_HEIGHT(vstate, v);
+    if (MF_EXCESS(vstate, v) > 0) {
+      st->active[__sync_fetch_and_add(&st->active_count, 1)] = v;
+    }
   }
 }
 
+/**
+ * Discharges an active vertex against the labels of the previous round, as
+ * per [Baumstark15]. Excess pushed to a neighbor is accumulated in its
+ * added_excess field and applied at the end of the round. When two
+ * neighboring vertices are discharged in the same round, the "win" rule
+ * allows a push in only one direction. Returns the relabel work done.
+ */
+PRIVATE uint64_t maxflow_discharge(maxflow_cpu_state_t* st, vid_t v) {
+  const graph_t* graph = st->graph;
+  const vid_t n = graph->vertex_count;
+  const maxflow_vertex_state_t& vstate = st->vstate;
+  weight_t excess = MF_EXCESS(vstate, v);
+  const uint32_t height = MF_HEIGHT(vstate, v);
+  uint32_t new_height = height;
+  uint64_t work = 0;
 
-error_t maxflow_cpu(graph_t* graph, vid_t source_id, vid_t sink_id,
-                    weight_t* flow_ret) {
-  error_t rc = check_special_cases(graph, source_id, sink_id);
-  if (rc != SUCCESS) return rc;
+  while (excess > 0) {
+    uint32_t label = n;
+    bool skipped = false;
+    for (eid_t e = graph->vertices[v]; e < graph->vertices[v + 1]; e++) {
+      if (excess == 0) break;
+      weight_t residual = st->residual[e];
+      if (residual == 0) continue;
+      vid_t w = graph->edges[e];
+      uint32_t w_height = MF_HEIGHT(vstate, w);
+      bool admissible = (new_height == w_height + 1);
+      if (admissible && MF_ACTIVE_ROUND(vstate, w) == st->round) {
+        bool win = (height == w_height + 1) || (height + 1 < w_height) ||
+            (height == w_height && v < w);
+        if (!win) {
+          skipped = true;
+          continue;
+        }
+      }
+      if (admissible) {
+        // Only v decreases the residual of its own edges, hence the residual
+        // read above is a lower bound of the current one.
+        weight_t delta = min(residual, excess);
+        __sync_fetch_and_sub(&st->residual[e], delta);
+        __sync_fetch_and_add(&st->residual[st->reverse[e]], delta);
+        __sync_fetch_and_add(&MF_ADDED_EXCESS(vstate, w), delta);
+        if (w != st->sink) maxflow_enqueue(st, w);
+        excess -= delta;
+        residual -= delta;
+      }
+      if (residual > 0 && w_height >= new_height) {
+        label = min(label, w_height + 1);
+      }
+    }
+    if (excess == 0 || skipped) break;
+    // Relabel.
+    work += MAXFLOW_RELABEL_WORK + graph->vertices[v + 1] -
+        graph->vertices[v];
+    new_height = label;
+    if (new_height >= n) {
+      new_height = n;
+      break;
+    }
+  }
 
-  // Setup residual edges. This creates a new graph and updates the graph
-  // pointer to point to this new graph. Thus, we have to do this step before
-  // any other allocations/initialization.
-  eid_t* reverse_indices = NULL;
-  graph_t* local_graph = graph_create_bidirectional(graph, &reverse_indices);
+  MF_EXCESS(vstate, v) = excess;
+  MF_NEW_HEIGHT(vstate, v) = new_height;
+  if (excess > 0 && new_height < n) maxflow_enqueue(st, v);
+  return work;
+}
 
-  weight_t* excess = NULL;
-  CALL_SAFE(totem_calloc(local_graph->vertex_count * sizeof(weight_t),
-                         TOTEM_MEM_HOST, (void**)&excess));
-  uint32_t* height = NULL;
-  CALL_SAFE(totem_calloc(local_graph->vertex_count * sizeof(uint32_t),
-                         TOTEM_MEM_HOST, (void**)&height));
-  weight_t* flow = NULL;
-  CALL_SAFE(totem_calloc(local_graph->edge_count * sizeof(weight_t),
-                         TOTEM_MEM_HOST, (void**)&flow));
-
-  // Initialize source's height to the vertex count
-  height[source_id] = (uint32_t) local_graph->vertex_count;
-
-  // Initialize preflow
-  for (eid_t edge_id = local_graph->vertices[source_id];
-       edge_id < local_graph->vertices[source_id + 1]; edge_id++) {
-    // Don't setup preflow on residual edges
-    if (local_graph->weights[edge_id] == 0) continue;
-    flow[edge_id] = local_graph->weights[edge_id];
-    flow[reverse_indices[edge_id]] = -local_graph->weights[edge_id];
-    excess[local_graph->edges[edge_id]] = local_graph->weights[edge_id];
-    excess[source_id] -= local_graph->weights[edge_id];
+/**
+ * Applies the labels computed in the round, and the gap heuristic: if no
+ * vertex is left with some label below V, the vertices above that label
+ * cannot reach the sink anymore, and are deactivated by raising their label
+ * to V. Counts are incremented before they are decremented, so a label that
+ * is only transiently empty is not mistaken for a gap. The vertices above the
+ * gap are found through the per-label lists, hence the gap costs time
+ * proportional to the number of labels and vertices above it rather than V.
+ * The lists are updated sequentially; that is constant work per relabeled
+ * vertex, next to the parallel discharge of its edges.
+ */
+PRIVATE void maxflow_apply_labels(maxflow_cpu_state_t* st) {
+  const vid_t n = st->graph->vertex_count;
+  const maxflow_vertex_state_t& vstate = st->vstate;
+  OMP(omp parallel for schedule(static))
+  for (vid_t i = 0; i < st->active_count; i++) {
+    vid_t v = st->active[i];
+    uint32_t new_height = MF_NEW_HEIGHT(vstate, v);
+    if (new_height != MF_HEIGHT(vstate, v) && new_height < n) {
+      __sync_fetch_and_add(&st->count[new_height], 1);
+    }
+  }
+  for (vid_t i = 0; i < st->active_count; i++) {
+    vid_t v = st->active[i];
+    uint32_t height = MF_HEIGHT(vstate, v);
+    uint32_t new_height = MF_NEW_HEIGHT(vstate, v);
+    if (new_height == height) continue;
+    maxflow_bucket_remove(st, v, height);
+    if (new_height < n) maxflow_bucket_insert(st, v, new_height);
+  }
+  uint32_t gap = n;
+  OMP(omp parallel for schedule(static))
+  for (vid_t i = 0; i < st->active_count; i++) {
+    vid_t v = st->active[i];
+    uint32_t height = MF_HEIGHT(vstate, v);
+    uint32_t new_height = MF_NEW_HEIGHT(vstate, v);
+    if (new_height == height) continue;
+    if (__sync_sub_and_fetch(&st->count[height], 1) == 0) {
+      __sync_fetch_and_min_uint32(&gap, height);
+    }
+    MF_HEIGHT(vstate, v) = new_height;
   }
+  if (gap == n) return;
 
-  // While there exists an applicable push or relabel operation, perform it
-  bool finished = false;
-  while (!finished) {
-    finished = true;
-    int count = KERNEL_CYCLES;
-    while(count--) {
-      OMP(omp parallel for)
-      for (vid_t u = 0; u < local_graph->vertex_count; u++) {
-        if (u == sink_id || u == source_id) continue;
-        // Perform a push/relabel operation
-        push_relabel_cpu(local_graph, u, source_id, sink_id, flow, excess,
-                         height, reverse_indices, &finished);
+  for (uint32_t height = gap + 1; height <= st->max_height; height++) {
+    for (vid_t v = st->bucket_head[height]; v != MAXFLOW_NO_VERTEX;
+         v = st->bucket_next[v]) {
+      MF_HEIGHT(vstate, v) = n;
+      MF_NEW_HEIGHT(vstate, v) = n;
+    }
+    st->bucket_head[height] = MAXFLOW_NO_VERTEX;
+    st->count[height] = 0;
+  }
+  st->max_height = gap;
+}
+
+/**
+ * Moves the excess pushed during the round into the excess of the queued
+ * vertices, and keeps the ones that are still active as the next worklist.
+ */
+PRIVATE void maxflow_next_round(maxflow_cpu_state_t* st) {
+  const vid_t n = st->graph->vertex_count;
+  const maxflow_vertex_state_t& vstate = st->vstate;
+  vid_t count = 0;
+  OMP(omp parallel for schedule(static))
+  for (vid_t i = 0; i < st->next_count; i++) {
+    vid_t v = st->next[i];
+    MF_EXCESS(vstate, v) += MF_ADDED_EXCESS(vstate, v);
+    MF_ADDED_EXCESS(vstate, v) = 0;
+    if (MF_HEIGHT(vstate, v) < n) {
+      st->active[__sync_fetch_and_add(&count, 1)] = v;
+    }
+  }
+  st->active_count = count;
+  st->next_count = 0;
+}
+
+/**
+ * An edge of the residual graph under construction.
+ */
+typedef struct {
+  vid_t    neighbor;
+  weight_t capacity;
+} maxflow_residual_edge_t;
+
+PRIVATE bool maxflow_residual_edge_less(const maxflow_residual_edge_t& a,
+                                        const maxflow_residual_edge_t& b) {
+  return a.neighbor < b.neighbor;
+}
+
+error_t maxflow_residual_initialize(graph_t* graph,
+                                    maxflow_residual_t** residual) {
+  if ((graph == NULL) || (residual == NULL) || (graph->vertex_count == 0) ||
+      (!graph->weighted) || (!graph->directed)) {
+    return FAILURE;
+  }
+  const vid_t n = graph->vertex_count;
+
+  // Collect the outgoing edges of each vertex with their capacity, and the
+  // incoming ones with capacity zero. Unlike graph_create_bidirectional, the
+  // edges to the same neighbor are then merged, which pairs every edge with
+  // exactly one reverse edge even if the network has antiparallel or
+  // parallel edges.
+  eid_t* offset = NULL;
+  CALL_SAFE(totem_calloc((n + 1) * sizeof(eid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&offset)));
+  for (vid_t u = 0; u < n; u++) {
+    offset[u + 1] += graph->vertices[u + 1] - graph->vertices[u];
+    for (eid_t e = graph->vertices[u]; e < graph->vertices[u + 1]; e++) {
+      offset[graph->edges[e] + 1]++;
+    }
+  }
+  for (vid_t u = 0; u < n; u++) offset[u + 1] += offset[u];
+  maxflow_residual_edge_t* edges = NULL;
+  CALL_SAFE(totem_malloc(offset[n] * sizeof(maxflow_residual_edge_t),
+                         TOTEM_MEM_HOST, reinterpret_cast<void**>(&edges)));
+  eid_t* tail = NULL;
+  CALL_SAFE(totem_malloc(n * sizeof(eid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&tail)));
+  memcpy(tail, offset, n * sizeof(eid_t));
+  for (vid_t u = 0; u < n; u++) {
+    for (eid_t e = graph->vertices[u]; e < graph->vertices[u + 1]; e++) {
+      vid_t v = graph->edges[e];
+      if (u == v) continue;  // self loops carry no flow
+      edges[tail[u]].neighbor = v;
+      edges[tail[u]++].capacity = graph->weights[e];
+      edges[tail[v]].neighbor = u;
+      edges[tail[v]++].capacity = 0;
+    }
+  }
+
+  // Sort the edges of each vertex by neighbor and merge the duplicates in
+  // place. tail[u] ends up as the merged degree of u.
+  OMP(omp parallel for schedule(dynamic, 64))
+  for (vid_t u = 0; u < n; u++) {
+    maxflow_residual_edge_t* first = &edges[offset[u]];
+    std::sort(first, &edges[tail[u]], maxflow_residual_edge_less);
+    eid_t degree = 0;
+    for (eid_t i = 0; i < tail[u] - offset[u]; i++) {
+      if (degree > 0 && first[degree - 1].neighbor == first[i].neighbor) {
+        first[degree - 1].capacity += first[i].capacity;
+      } else {
+        first[degree++] = first[i];
       }
     }
+    tail[u] = degree;
+  }
+
+  eid_t edge_count = 0;
+  for (vid_t u = 0; u < n; u++) edge_count += tail[u];
+  graph_t* rgraph = NULL;
+  graph_allocate(n, edge_count, true, true, false, &rgraph);
+  rgraph->vertices[0] = 0;
+  for (vid_t u = 0; u < n; u++) {
+    rgraph->vertices[u + 1] = rgraph->vertices[u] + tail[u];
+  }
+  OMP(omp parallel for schedule(dynamic, 64))
+  for (vid_t u = 0; u < n; u++) {
+    for (eid_t i = 0; i < tail[u]; i++) {
+      rgraph->edges[rgraph->vertices[u] + i] = edges[offset[u] + i].neighbor;
+      rgraph->weights[rgraph->vertices[u] + i] = edges[offset[u] + i].capacity;
+    }
+  }
+  totem_free(offset, TOTEM_MEM_HOST);
+  totem_free(edges, TOTEM_MEM_HOST);
+  totem_free(tail, TOTEM_MEM_HOST);
+
+  // The neighbors of each vertex are sorted, hence the reverse of an edge is
+  // found by a binary search over the neighbors of its destination.
+  eid_t* reverse = NULL;
+  if (edge_count > 0) {
+    CALL_SAFE(totem_malloc(edge_count * sizeof(eid_t), TOTEM_MEM_HOST,
+                           reinterpret_cast<void**>(&reverse)));
+  }
+  OMP(omp parallel for schedule(dynamic, 64))
+  for (vid_t u = 0; u < n; u++) {
+    for (eid_t e = rgraph->vertices[u]; e < rgraph->vertices[u + 1]; e++) {
+      vid_t v = rgraph->edges[e];
+      vid_t* rev = std::lower_bound(&rgraph->edges[rgraph->vertices[v]],
+                                    &rgraph->edges[rgraph->vertices[v + 1]],
+                                    u);
+      reverse[e] = rev - rgraph->edges;
+    }
+  }
+
+  *residual = reinterpret_cast<maxflow_residual_t*>
+      (calloc(1, sizeof(maxflow_residual_t)));
+  assert(*residual);
+  (*residual)->original = graph;
+  (*residual)->graph = rgraph;
+  (*residual)->reverse = reverse;
+  return SUCCESS;
+}
+
+error_t maxflow_residual_finalize(maxflow_residual_t* residual) {
+  if (residual == NULL) return FAILURE;
+  if (residual->reverse) totem_free(residual->reverse, TOTEM_MEM_HOST);
+  graph_finalize(residual->graph);
+  free(residual);
+  return SUCCESS;
+}
+
+error_t maxflow_residual_cpu(const maxflow_residual_t* residual,
+                             vid_t source_id, vid_t sink_id,
+                             weight_t* flow_ret) {
+  if (residual == NULL) return FAILURE;
+  error_t rc = check_special_cases(residual->original, source_id, sink_id);
+  if (rc != SUCCESS) return rc;
+
+  const graph_t* graph = residual->graph;
+  const vid_t n = graph->vertex_count;
+  if (graph->edge_count == 0) {
+    *flow_ret = 0;
+    return SUCCESS;
+  }
+  maxflow_cpu_state_t st;
+  memset(&st, 0, sizeof(st));
+  st.graph = graph;
+  st.reverse = residual->reverse;
+  st.source = source_id;
+  st.sink = sink_id;
+  CALL_SAFE(vertex_state_initialize(n, TOTEM_MEM_HOST, &st.vstate));
+  CALL_SAFE(totem_malloc(graph->edge_count * sizeof(weight_t), TOTEM_MEM_HOST,
+                         (void**)&st.residual));
+  CALL_SAFE(totem_malloc((n + 1) * sizeof(vid_t), TOTEM_MEM_HOST,
+                         (void**)&st.count));
+  CALL_SAFE(totem_malloc((n + 1) * sizeof(vid_t), TOTEM_MEM_HOST,
+                         (void**)&st.bucket_head));
+  CALL_SAFE(totem_malloc(n * sizeof(vid_t), TOTEM_MEM_HOST,
+                         (void**)&st.bucket_next));
+  CALL_SAFE(totem_malloc(n * sizeof(vid_t), TOTEM_MEM_HOST,
+                         (void**)&st.bucket_prev));
+  CALL_SAFE(totem_malloc(n * sizeof(vid_t), TOTEM_MEM_HOST,
+                         (void**)&st.active));
+  CALL_SAFE(totem_malloc(n * sizeof(vid_t), TOTEM_MEM_HOST,
+                         (void**)&st.next));
+  CALL_SAFE(totem_malloc(n * sizeof(vid_t), TOTEM_MEM_HOST,
+                         (void**)&st.frontier));
+  // The residual capacity of an edge starts at its capacity.
+  OMP(omp parallel for schedule(static))
+  for (eid_t e = 0; e < graph->edge_count; e++) {
+    st.residual[e] = graph->weights[e];
+  }
+
+  // Initialize preflow by saturating the edges of the source.
+  for (eid_t e = graph->vertices[source_id]; e < graph->vertices[source_id + 1];
+       e++) {
+    weight_t delta = st.residual[e];
+    if (delta == 0) continue;
+    st.residual[e] = 0;
+    st.residual[st.reverse[e]] += delta;
+    MF_EXCESS(st.vstate, graph->edges[e]) += delta;
+  }
+
+  // Alternate rounds of parallel discharges with global relabels. The source
+  // keeps label V throughout, and the sink is never discharged.
+  uint64_t work = (uint64_t)MAXFLOW_GR_ALPHA * n + graph->edge_count + 1;
+  while (true) {
+    if (work > (uint64_t)MAXFLOW_GR_ALPHA * n + graph->edge_count) {
+      maxflow_global_relabel(&st);
+      MF_HEIGHT(st.vstate, source_id) = n;
+      MF_NEW_HEIGHT(st.vstate, source_id) = n;
+      work = 0;
+    }
+    if (st.active_count == 0) break;
+
+    st.round++;
+    OMP(omp parallel for schedule(static))
+    for (vid_t i = 0; i < st.active_count; i++) {
+      MF_ACTIVE_ROUND(st.vstate, st.active[i]) = st.round;
+    }
+    uint64_t round_work = 0;
+    OMP(omp parallel for schedule(dynamic, 16) reduction(+ : round_work))
+    for (vid_t i = 0; i < st.active_count; i++) {
+      round_work += maxflow_discharge(&st, st.active[i]);
+    }
+    work += round_work;
+    maxflow_apply_labels(&st);
+    maxflow_next_round(&st);
   }
 
   // The final flow is the sum of all flows into the sink (ie, the excess
   // value at the sink node)
-  *flow_ret = excess[sink_id];
-
-  totem_free(reverse_indices, TOTEM_MEM_HOST);
-  totem_free(excess, TOTEM_MEM_HOST);
-  totem_free(height, TOTEM_MEM_HOST);
-  totem_free(flow, TOTEM_MEM_HOST);
-  // Free our modified new graph
-  graph_finalize(local_graph);
+  *flow_ret = MF_EXCESS(st.vstate, sink_id) +
+      MF_ADDED_EXCESS(st.vstate, sink_id);
 
+  vertex_state_finalize(&st.vstate);
+  totem_free(st.residual, TOTEM_MEM_HOST);
+  totem_free(st.count, TOTEM_MEM_HOST);
+  totem_free(st.bucket_head, TOTEM_MEM_HOST);
+  totem_free(st.bucket_next, TOTEM_MEM_HOST);
+  totem_free(st.bucket_prev, TOTEM_MEM_HOST);
+  totem_free(st.active, TOTEM_MEM_HOST);
+  totem_free(st.next, TOTEM_MEM_HOST);
+  totem_free(st.frontier, TOTEM_MEM_HOST);
   return SUCCESS;
 }
+
+error_t maxflow_cpu(graph_t* graph, vid_t source_id, vid_t sink_id,
+                    weight_t* flow_ret) {
+  error_t rc = check_special_cases(graph, source_id, sink_id);
+  if (rc != SUCCESS) return rc;
+
+  // Setup residual edges. This creates a new graph, hence callers that run
+  // several flow computations on the same network should create the residual
+  // graph once via maxflow_residual_initialize.
+  maxflow_residual_t* residual = NULL;
+  CALL_SAFE(maxflow_residual_initialize(graph, &residual));
+  rc = maxflow_residual_cpu(residual, source_id, sink_id, flow_ret);
+  maxflow_residual_finalize(residual);
+  return rc;
+}
@@ -0,0 +1,323 @@
+/**
+ * Implements a parallel version of Boruvka's minimum spanning forest
+ * algorithm for CPU, in the style of the edge-list based implementations
+ * described in [Chung96] S. Chung, A. Condon, "Parallel Implementation of
+ * Boruvka's Minimum Spanning Tree Algorithm", IPPS 1996.
+ *
+ * Each round performs three steps on the list of the edges that are still
+ * between two different components:
+ *   - selection: every component selects its lightest incident edge via an
+ *     atomic minimum over the (weight, edge id) order. Since the order is
+ *     total, the selected edges form no cycle other than two components that
+ *     select each other.
+ *   - contraction: every component hooks onto the component at the other end
+ *     of its selected edge, and the resulting trees are flattened via pointer
+ *     jumping, such that every vertex points to the root of its component.
+ *   - filtering: the endpoints of the edges are relabeled to their roots, and
+ *     the edges that became self loops are dropped from the list.
+ * The number of components at least halves in every round, hence there are
+ * at most log(V) rounds.
+ */
+
+// system includes
+#include <algorithm>
+
+// totem includes
+#include "totem_alg.h"
+
+// Marks a component that has not selected an edge.
+#define MSF_NONE ((eid_t)-1)
+
+/**
+ * State of the algorithm. Each undirected edge is kept once in the edge list,
+ * whose endpoints are the roots of the components they belong to.
+ */
+typedef struct {
+  vid_t*    parent;       // the component (root) of each vertex
+  eid_t*    best;         // the selected edge of each component
+  vid_t*    roots;        // the roots of the active components
+  vid_t     root_count;
+  vid_t*    src;          // the first endpoint of each edge
+  vid_t*    dst;          // the second endpoint of each edge
+  weight_t* weight;       // the weight of each edge
+  eid_t*    id;           // the index of each edge in the graph
+  eid_t     edge_count;   // the number of edges in the list
+  vid_t*    next_roots;   // buffers the lists above are compacted into
+  vid_t*    next_src;
+  vid_t*    next_dst;
+  weight_t* next_weight;
+  eid_t*    next_id;
+  eid_t*    offsets;      // per-thread offsets of the compaction
+  eid_t*    forest;       // the edges of the forest, as indices in the graph
+  vid_t     forest_count;
+} msf_state_t;
+
+/**
+ * Returns true if edge a precedes edge b in the (weight, edge id) order.
+ */
+inline PRIVATE bool msf_lighter(const msf_state_t* state, eid_t a, eid_t b) {
+  return state->weight[a] < state->weight[b] ||
+      (state->weight[a] == state->weight[b] && state->id[a] < state->id[b]);
+}
+
+/**
+ * Atomically selects an edge for a component if it precedes the edge the
+ * component selected so far.
+ */
+inline PRIVATE void msf_select(msf_state_t* state, vid_t component, eid_t e) {
+  eid_t old = state->best[component];
+  while (old == MSF_NONE || msf_lighter(state, e, old)) {
+    eid_t assumed = old;
+    old = __sync_val_compare_and_swap(&state->best[component], assumed, e);
+    if (old == assumed) break;
+  }
+}
+
+/**
+ * Builds the initial edge list from the entries of each edge that are stored
+ * in the neighbor list of its smaller endpoint. Self loops are dropped.
+ */
+PRIVATE void msf_init_edges(const graph_t* graph, msf_state_t* state) {
+  state->edge_count = 0;
+  OMP(omp parallel for schedule(guided))
+  for (vid_t u = 0; u < graph->vertex_count; u++) {
+    for (eid_t e = graph->vertices[u]; e < graph->vertices[u + 1]; e++) {
+      vid_t v = graph->edges[e];
+      if (v <= u) continue;
+      eid_t i = __sync_fetch_and_add(&state->edge_count, 1);
+      state->src[i] = u;
+      state->dst[i] = v;
+      state->weight[i] = graph->weighted ? graph->weights[e] :
+          DEFAULT_EDGE_WEIGHT;
+      state->id[i] = e;
+    }
+  }
+}
+
+/**
+ * Hooks each component onto the other end of its selected edge, and adds the
+ * edge to the forest. When two components select each other, the one with the
+ * smaller id stays a root, and the edge is added once.
+ */
+PRIVATE void msf_hook(msf_state_t* state) {
+  OMP(omp parallel for schedule(static))
+  for (vid_t i = 0; i < state->root_count; i++) {
+    vid_t c = state->roots[i];
+    eid_t e = state->best[c];
+    if (e == MSF_NONE) continue;
+    vid_t other = state->src[e] == c ? state->dst[e] : state->src[e];
+    if (state->best[other] == e && c < other) continue;
+    state->parent[c] = other;
+    state->forest[__sync_fetch_and_add(&state->forest_count, 1)] =
+        state->id[e];
+  }
+}
+
+/**
+ * Flattens the trees formed by hooking via pointer jumping, such that each
+ * component points to its root. Only the active components are visited, as
+ * the endpoints of the edges in the list are always active components.
+ */
+PRIVATE void msf_pointer_jump(msf_state_t* state) {
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    OMP(omp parallel for schedule(static) reduction(| : changed))
+    for (vid_t i = 0; i < state->root_count; i++) {
+      vid_t c = state->roots[i];
+      vid_t grandparent = state->parent[state->parent[c]];
+      if (grandparent != state->parent[c]) {
+        state->parent[c] = grandparent;
+        changed = true;
+      }
+    }
+  }
+}
+
+/**
+ * Returns the range [begin, end) of a list of count entries that the calling
+ * thread compacts.
+ */
+inline PRIVATE void msf_chunk(eid_t count, eid_t* begin, eid_t* end) {
+  int thread_count = omp_get_num_threads();
+  eid_t chunk = (count + thread_count - 1) / thread_count;
+  *begin = std::min(count, (eid_t)omp_get_thread_num() * chunk);
+  *end = std::min(count, *begin + chunk);
+}
+
+/**
+ * Turns the per-thread counts in offsets into the offsets of the threads in
+ * the compacted list, and returns the size of that list. It must be called by
+ * a single thread after all the threads stored their count.
+ */
+inline PRIVATE eid_t msf_offsets(eid_t* offsets) {
+  eid_t total = 0;
+  for (int t = 0; t < omp_get_num_threads(); t++) {
+    eid_t count = offsets[t];
+    offsets[t] = total;
+    total += count;
+  }
+  return total;
+}
+
+/**
+ * Relabels the endpoints of the edges to their roots, drops the edges that
+ * became self loops, and keeps only the roots in the list of active
+ * components. Each thread compacts a contiguous chunk of a list into the
+ * other buffer, at an offset given by the prefix sum of the per-thread counts.
+ * Hence the lists keep their order, and the result does not depend on the
+ * interleaving of the threads.
+ */
+PRIVATE void msf_filter(msf_state_t* state) {
+  eid_t edge_count = 0;
+  eid_t root_count = 0;
+  OMP(omp parallel)
+  {
+    eid_t begin, end;
+    msf_chunk(state->edge_count, &begin, &end);
+    eid_t kept = 0;
+    for (eid_t e = begin; e < end; e++) {
+      state->src[e] = state->parent[state->src[e]];
+      state->dst[e] = state->parent[state->dst[e]];
+      kept += (state->src[e] != state->dst[e]);
+    }
+    state->offsets[omp_get_thread_num()] = kept;
+    OMP(omp barrier)
+    OMP(omp single)
+    edge_count = msf_offsets(state->offsets);
+    eid_t index = state->offsets[omp_get_thread_num()];
+    for (eid_t e = begin; e < end; e++) {
+      if (state->src[e] == state->dst[e]) continue;
+      state->next_src[index] = state->src[e];
+      state->next_dst[index] = state->dst[e];
+      state->next_weight[index] = state->weight[e];
+      state->next_id[index] = state->id[e];
+      index++;
+    }
+    OMP(omp barrier)
+
+    msf_chunk(state->root_count, &begin, &end);
+    kept = 0;
+    for (eid_t i = begin; i < end; i++) {
+      vid_t c = state->roots[i];
+      kept += (state->parent[c] == c);
+    }
+    state->offsets[omp_get_thread_num()] = kept;
+    OMP(omp barrier)
+    OMP(omp single)
+    root_count = msf_offsets(state->offsets);
+    index = state->offsets[omp_get_thread_num()];
+    for (eid_t i = begin; i < end; i++) {
+      vid_t c = state->roots[i];
+      if (state->parent[c] == c) state->next_roots[index++] = c;
+    }
+  }
+  std::swap(state->src, state->next_src);
+  std::swap(state->dst, state->next_dst);
+  std::swap(state->weight, state->next_weight);
+  std::swap(state->id, state->next_id);
+  std::swap(state->roots, state->next_roots);
+  state->edge_count = edge_count;
+  state->root_count = (vid_t)root_count;
+}
+
+error_t msf_cpu(const graph_t* graph, eid_t** forest, vid_t* forest_count,
+                uint64_t* total_weight) {
+  if ((graph == NULL) || (graph->vertex_count == 0) ||
+      (graph->directed && graph->edge_count != 0) || (forest == NULL) ||
+      (forest_count == NULL) || (total_weight == NULL)) {
+    return FAILURE;
+  }
+  *forest = NULL;
+  *forest_count = 0;
+  *total_weight = 0;
+  if (graph->edge_count == 0) return SUCCESS;
+
+  msf_state_t state;
+  memset(&state, 0, sizeof(msf_state_t));
+  const vid_t vcount = graph->vertex_count;
+  const eid_t ecount = graph->edge_count;
+  CALL_SAFE(totem_malloc(vcount * sizeof(vid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state.parent)));
+  CALL_SAFE(totem_malloc(vcount * sizeof(eid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state.best)));
+  CALL_SAFE(totem_malloc(vcount * sizeof(vid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state.roots)));
+  CALL_SAFE(totem_malloc(vcount * sizeof(eid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state.forest)));
+  CALL_SAFE(totem_malloc(ecount * sizeof(vid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state.src)));
+  CALL_SAFE(totem_malloc(ecount * sizeof(vid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state.dst)));
+  CALL_SAFE(totem_malloc(ecount * sizeof(weight_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state.weight)));
+  CALL_SAFE(totem_malloc(ecount * sizeof(eid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state.id)));
+  CALL_SAFE(totem_malloc(vcount * sizeof(vid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state.next_roots)));
+  CALL_SAFE(totem_malloc(ecount * sizeof(vid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state.next_src)));
+  CALL_SAFE(totem_malloc(ecount * sizeof(vid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state.next_dst)));
+  CALL_SAFE(totem_malloc(ecount * sizeof(weight_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state.next_weight)));
+  CALL_SAFE(totem_malloc(ecount * sizeof(eid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state.next_id)));
+  CALL_SAFE(totem_malloc(omp_get_max_threads() * sizeof(eid_t),
+                         TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state.offsets)));
+
+  OMP(omp parallel for schedule(static))
+  for (vid_t v = 0; v < vcount; v++) {
+    state.parent[v] = v;
+    state.roots[v] = v;
+  }
+  state.root_count = vcount;
+  msf_init_edges(graph, &state);
+
+  while (state.edge_count > 0) {
+    OMP(omp parallel for schedule(static))
+    for (vid_t i = 0; i < state.root_count; i++) {
+      state.best[state.roots[i]] = MSF_NONE;
+    }
+    OMP(omp parallel for schedule(static))
+    for (eid_t e = 0; e < state.edge_count; e++) {
+      msf_select(&state, state.src[e], e);
+      msf_select(&state, state.dst[e], e);
+    }
+    msf_hook(&state);
+    msf_pointer_jump(&state);
+    msf_filter(&state);
+  }
+
+  // Sort the forest edges, which makes the result independent of the order
+  // in which the components hooked.
+  tbb::parallel_sort(state.forest, state.forest + state.forest_count);
+  CALL_SAFE(totem_malloc(vcount * sizeof(eid_t), TOTEM_MEM_HOST_PINNED,
+                         reinterpret_cast<void**>(forest)));
+  uint64_t sum = 0;
+  OMP(omp parallel for schedule(static) reduction(+ : sum))
+  for (vid_t i = 0; i < state.forest_count; i++) {
+    eid_t e = state.forest[i];
+    (*forest)[i] = e;
+    sum += graph->weighted ? graph->weights[e] : DEFAULT_EDGE_WEIGHT;
+  }
+  *forest_count = state.forest_count;
+  *total_weight = sum;
+
+  totem_free(state.parent, TOTEM_MEM_HOST);
+  totem_free(state.best, TOTEM_MEM_HOST);
+  totem_free(state.roots, TOTEM_MEM_HOST);
+  totem_free(state.forest, TOTEM_MEM_HOST);
+  totem_free(state.src, TOTEM_MEM_HOST);
+  totem_free(state.dst, TOTEM_MEM_HOST);
+  totem_free(state.weight, TOTEM_MEM_HOST);
+  totem_free(state.id, TOTEM_MEM_HOST);
+  totem_free(state.next_roots, TOTEM_MEM_HOST);
+  totem_free(state.next_src, TOTEM_MEM_HOST);
+  totem_free(state.next_dst, TOTEM_MEM_HOST);
+  totem_free(state.next_weight, TOTEM_MEM_HOST);
+  totem_free(state.next_id, TOTEM_MEM_HOST);
+  totem_free(state.offsets, TOTEM_MEM_HOST);
+  return SUCCESS;
+}
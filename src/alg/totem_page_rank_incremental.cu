@@ -0,0 +1,315 @@
+/**
+ * Implements an incremental version of the PageRank formulation of
+ * totem_page_rank.cu, which updates the ranks of a graph after a batch of edge
+ * insertions and deletions instead of recomputing them from scratch. It is
+ * based on the push algorithm for PageRank described in
+ * [Zhang16] H. Zhang, P. Lofgren, A. Goel, "Approximate Personalized PageRank
+ * on Dynamic Graphs", KDD 2016.
+ *
+ * The ranks are the fixed point of
+ *   rank(v) = (1 - DAMPING_FACTOR) / vertex_count +
+ *             DAMPING_FACTOR * sum(rank(u) / out_degree(u)) over edges (u, v).
+ * Each vertex has an estimate and a residual, such that the exact ranks are
+ * the estimates plus the ranks that the residuals would produce if they were
+ * the teleport terms. Pushing a vertex moves its residual to its estimate, and
+ * spreads DAMPING_FACTOR times the residual to the residuals of its
+ * out-neighbors; the vertices whose residual exceeds the tolerance are pushed
+ * in rounds until none is left.
+ *
+ * Given the ranks of the graph before a batch, only the vertices whose
+ * incoming contributions changed have a residual: the edges of a source whose
+ * out-degree changed carry a different share of its rank, and inserted and
+ * deleted edges gain and lose a share. Hence, the work is proportional to the
+ * region affected by the batch rather than to the size of the graph.
+ *
+ * The per-vertex state lives in an engine that is kept across batches, so that
+ * a batch does not allocate or clear arrays of the size of the graph. The
+ * residuals left within the tolerance at the end of a batch stay in the
+ * engine, and the next batch adds its changes to them: the estimates and the
+ * residuals together remain exact, hence the error of the ranks stays within
+ * the bound of a single batch however many batches are applied, and a carried
+ * residual is pushed once later changes make it exceed the tolerance. The
+ * ranks are updated in place. The activation rounds are tagged with ids that
+ * keep increasing across batches, hence a stale tag never matches the current
+ * round.
+ */
+
+// system includes
+#include <algorithm>
+#include <cmath>
+
+// totem includes
+#include "totem_alg.h"
+
+/**
+ * An edge of a batch, with the sign of its change: one for an insertion, and
+ * minus one for a deletion.
+ */
+typedef struct {
+  vid_t src;
+  vid_t dst;
+  int   sign;
+} page_rank_update_t;
+
+/**
+ * Orders the updates of a batch by source.
+ */
+class PageRankUpdateCompare {
+ public:
+  bool operator()(const page_rank_update_t& a,
+                  const page_rank_update_t& b) const {
+    return a.src < b.src;
+  }
+};
+
+// Adds a vertex to the next frontier, unless it has been added in this round.
+inline PRIVATE void page_rank_activate(page_rank_incremental_t* engine,
+                                       vid_t v) {
+  uint32_t last = engine->round[v];
+  if (last != engine->current_round &&
+      __sync_bool_compare_and_swap(&engine->round[v], last,
+                                   engine->current_round)) {
+    engine->next[__sync_fetch_and_add(&engine->next_count, 1)] = v;
+  }
+}
+
+// Adds a change to the residual of a vertex, and activates the vertex if the
+// residual exceeds the tolerance.
+inline PRIVATE void page_rank_add_residual(page_rank_incremental_t* engine,
+                                           vid_t v, rank_t value) {
+  rank_t residual = __sync_fetch_and_add_float(&engine->residual[v], value) +
+      value;
+  if (fabs(residual) > engine->tolerance) page_rank_activate(engine, v);
+}
+
+// Starts a new round of activations; the rounds are shared by all batches.
+PRIVATE void page_rank_next_round(page_rank_incremental_t* engine) {
+  engine->current_round++;
+  if (engine->current_round == 0) {
+    memset(engine->round, 0, engine->vertex_count * sizeof(uint32_t));
+    engine->current_round = 1;
+  }
+}
+
+// Returns the out-degree of the source of a group of updates before the
+// batch, which is negative if the batch deletes more edges than it had.
+inline PRIVATE int64_t page_rank_old_degree(const graph_t* graph,
+                                            const page_rank_update_t* updates,
+                                            eid_t begin, eid_t end) {
+  const vid_t u = updates[begin].src;
+  int64_t degree = graph->vertices[u + 1] - graph->vertices[u];
+  for (eid_t i = begin; i < end; i++) degree -= updates[i].sign;
+  return degree;
+}
+
+// Seeds the residuals with the change of the contributions of each source of
+// the batch. The updates are sorted by source, and group_starts delimits the
+// updates of each source.
+PRIVATE void page_rank_seed(page_rank_incremental_t* engine,
+                            const rank_t* rank,
+                            const page_rank_update_t* updates,
+                            const eid_t* group_starts, eid_t group_count) {
+  const graph_t* graph = engine->graph;
+  OMP(omp parallel for schedule(dynamic))
+  for (eid_t g = 0; g < group_count; g++) {
+    const vid_t u = updates[group_starts[g]].src;
+    const eid_t degree = graph->vertices[u + 1] - graph->vertices[u];
+    int64_t old_degree = page_rank_old_degree(graph, updates, group_starts[g],
+                                              group_starts[g + 1]);
+    // Each current edge gains the new share and loses the old one; inserted
+    // edges did not have the old share, and deleted edges have lost it.
+    rank_t share = degree ? PAGE_RANK_DAMPING_FACTOR * rank[u] / degree : 0;
+    rank_t old_share = old_degree ?
+        PAGE_RANK_DAMPING_FACTOR * rank[u] / old_degree : 0;
+    if (share != old_share) {
+      for (eid_t e = graph->vertices[u]; e < graph->vertices[u + 1]; e++) {
+        page_rank_add_residual(engine, graph->edges[e], share - old_share);
+      }
+    }
+    for (eid_t i = group_starts[g]; i < group_starts[g + 1]; i++) {
+      page_rank_add_residual(engine, updates[i].dst,
+                             updates[i].sign * old_share);
+    }
+  }
+}
+
+// Pushes the residuals of the frontier in rounds until none exceeds the
+// tolerance.
+PRIVATE void page_rank_push_rounds(page_rank_incremental_t* engine,
+                                   rank_t* rank) {
+  const graph_t* graph = engine->graph;
+  while (engine->next_count > 0) {
+    vid_t count = engine->next_count;
+    std::swap(engine->frontier, engine->next);
+    engine->next_count = 0;
+    page_rank_next_round(engine);
+
+    // Move the residuals of the frontier to the estimates. This is done
+    // before the pushes of the round, which may add to the same residuals.
+    OMP(omp parallel for schedule(static))
+    for (vid_t i = 0; i < count; i++) {
+      vid_t v = engine->frontier[i];
+      rank_t residual = engine->residual[v];
+      // The residual may have been cancelled since the vertex was activated.
+      if (fabs(residual) <= engine->tolerance) residual = 0;
+      engine->residual[v] -= residual;
+      engine->delta[i] = residual;
+      rank[v] += residual;
+    }
+
+    // The residual of a vertex without out-edges is not spread, as in the
+    // formulation of totem_page_rank.cu.
+    OMP(omp parallel for schedule(dynamic, 64))
+    for (vid_t i = 0; i < count; i++) {
+      vid_t v = engine->frontier[i];
+      eid_t degree = graph->vertices[v + 1] - graph->vertices[v];
+      if (engine->delta[i] == 0 || degree == 0) continue;
+      rank_t share = PAGE_RANK_DAMPING_FACTOR * engine->delta[i] / degree;
+      for (eid_t e = graph->vertices[v]; e < graph->vertices[v + 1]; e++) {
+        page_rank_add_residual(engine, graph->edges[e], share);
+      }
+    }
+  }
+}
+
+// Collects the updates of a batch, with the reverse of each edge of an
+// undirected graph, and checks their end points.
+PRIVATE bool page_rank_collect(const graph_t* graph, const edge_t* edges,
+                               eid_t count, int sign,
+                               page_rank_update_t* updates,
+                               eid_t* update_count) {
+  for (eid_t i = 0; i < count; i++) {
+    if (edges[i].src >= graph->vertex_count ||
+        edges[i].dst >= graph->vertex_count) {
+      return false;
+    }
+    page_rank_update_t update = {edges[i].src, edges[i].dst, sign};
+    updates[(*update_count)++] = update;
+    if (!graph->directed && edges[i].src != edges[i].dst) {
+      page_rank_update_t reverse = {edges[i].dst, edges[i].src, sign};
+      updates[(*update_count)++] = reverse;
+    }
+  }
+  return true;
+}
+
+error_t page_rank_incremental_initialize(
+    vid_t vertex_count, page_rank_incremental_t** engine_ret) {
+  if (vertex_count == 0 || engine_ret == NULL) return FAILURE;
+  page_rank_incremental_t* engine = reinterpret_cast<page_rank_incremental_t*>(
+      calloc(1, sizeof(page_rank_incremental_t)));
+  assert(engine);
+  engine->vertex_count = vertex_count;
+  CALL_SAFE(totem_calloc(vertex_count * sizeof(rank_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&engine->residual)));
+  CALL_SAFE(totem_malloc(vertex_count * sizeof(rank_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&engine->delta)));
+  CALL_SAFE(totem_calloc(vertex_count * sizeof(uint32_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&engine->round)));
+  CALL_SAFE(totem_malloc(vertex_count * sizeof(vid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&engine->frontier)));
+  CALL_SAFE(totem_malloc(vertex_count * sizeof(vid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&engine->next)));
+  *engine_ret = engine;
+  return SUCCESS;
+}
+
+error_t page_rank_incremental_finalize(page_rank_incremental_t* engine) {
+  if (engine == NULL) return FAILURE;
+  totem_free(engine->residual, TOTEM_MEM_HOST);
+  totem_free(engine->delta, TOTEM_MEM_HOST);
+  totem_free(engine->round, TOTEM_MEM_HOST);
+  totem_free(engine->frontier, TOTEM_MEM_HOST);
+  totem_free(engine->next, TOTEM_MEM_HOST);
+  free(engine);
+  return SUCCESS;
+}
+
+error_t page_rank_incremental_cpu(page_rank_incremental_t* engine,
+                                  const graph_t* graph,
+                                  const edge_t* inserted,
+                                  eid_t inserted_count,
+                                  const edge_t* deleted, eid_t deleted_count,
+                                  rank_t tolerance, rank_t* rank) {
+  if (engine == NULL || graph == NULL ||
+      graph->vertex_count != engine->vertex_count || rank == NULL ||
+      !(tolerance > 0) || (inserted == NULL && inserted_count != 0) ||
+      (deleted == NULL && deleted_count != 0)) {
+    return FAILURE;
+  }
+  engine->graph = graph;
+  engine->next_count = 0;
+  page_rank_next_round(engine);
+
+  if (!engine->ranked) {
+    engine->tolerance = tolerance;
+    // Without previous ranks, every vertex starts with the teleport term as
+    // its residual.
+    rank_t teleport = (1 - PAGE_RANK_DAMPING_FACTOR) / graph->vertex_count;
+    totem_memset(rank, (rank_t)0, graph->vertex_count, TOTEM_MEM_HOST);
+    totem_memset(engine->residual, teleport, graph->vertex_count,
+                 TOTEM_MEM_HOST);
+    OMP(omp parallel for schedule(static))
+    for (vid_t v = 0; v < graph->vertex_count; v++) {
+      engine->round[v] = engine->current_round;
+      engine->next[v] = v;
+    }
+    engine->next_count = graph->vertex_count;
+    page_rank_push_rounds(engine, rank);
+    engine->ranked = true;
+    return SUCCESS;
+  }
+
+  // Collect the batch, sorted by source, and check it before any residual is
+  // changed, hence a rejected batch leaves the ranks and the residuals intact.
+  page_rank_update_t* updates = reinterpret_cast<page_rank_update_t*>(
+      malloc((2 * (inserted_count + deleted_count) + 1) *
+             sizeof(page_rank_update_t)));
+  assert(updates);
+  eid_t update_count = 0;
+  if (!page_rank_collect(graph, inserted, inserted_count, 1, updates,
+                         &update_count) ||
+      !page_rank_collect(graph, deleted, deleted_count, -1, updates,
+                         &update_count)) {
+    free(updates);
+    return FAILURE;
+  }
+  std::sort(updates, updates + update_count, PageRankUpdateCompare());
+  eid_t* group_starts = reinterpret_cast<eid_t*>(malloc((update_count + 1) *
+                                                        sizeof(eid_t)));
+  assert(group_starts);
+  eid_t group_count = 0;
+  for (eid_t i = 0; i < update_count; i++) {
+    if (i == 0 || updates[i].src != updates[i - 1].src) {
+      group_starts[group_count++] = i;
+    }
+  }
+  group_starts[group_count] = update_count;
+  error_t rc = SUCCESS;
+  for (eid_t g = 0; g < group_count; g++) {
+    if (page_rank_old_degree(graph, updates, group_starts[g],
+                             group_starts[g + 1]) < 0) {
+      rc = FAILURE;
+      break;
+    }
+  }
+
+  if (rc == SUCCESS) {
+    // The residuals carried from the previous batches are within their
+    // tolerance; a tighter one activates those that exceed it.
+    if (tolerance < engine->tolerance) {
+      OMP(omp parallel for schedule(static))
+      for (vid_t v = 0; v < graph->vertex_count; v++) {
+        if (fabs(engine->residual[v]) > tolerance) {
+          page_rank_activate(engine, v);
+        }
+      }
+    }
+    engine->tolerance = tolerance;
+    page_rank_seed(engine, rank, updates, group_starts, group_count);
+    page_rank_push_rounds(engine, rank);
+  }
+  free(updates);
+  free(group_starts);
+  return rc;
+}
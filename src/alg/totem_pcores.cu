@@ -27,6 +27,14 @@
 #define OVERALL_INDEX 0
 #define ROUND_INDEX   1
 
+// number of buckets the CPU peeling engine keeps open at a time. Vertices
+// whose bucket is beyond the open window are kept in an overflow list, which
+// is scanned only when the window is exhausted.
+#define PCORE_OPEN_BUCKETS 128
+
+// marks the end of a bucket list
+#define PCORE_NIL ((eid_t)-1)
+
 /**
  * Set the initial state of the algorithm. The weights_sum array is initalized
  * with the sum of edge weights each vertex is connected to. The round array is
@@ -209,8 +217,8 @@ error_t pcore_gpu(const graph_t* graph, uint32_t start, uint32_t step,
   return FAILURE;
 }
 
-error_t pcore_cpu(const graph_t* graph, uint32_t start, uint32_t step,
-                  uint32_t** round_out) {
+error_t pcore_sweep_cpu(const graph_t* graph, uint32_t start, uint32_t step,
+                        uint32_t** round_out) {
   totem_mem_t mem_type = TOTEM_MEM_HOST_PINNED;
   CHK_SUCCESS(verify_input(graph, start, step), err);
 
@@ -302,3 +310,257 @@ error_t pcore_cpu(const graph_t* graph, uint32_t start, uint32_t step,
   *round_out = NULL;
   return FAILURE;
 }
+
+/**
+ * State of the bucket-based peeling engine used by the CPU implementations,
+ * following the bucketing structure of [Dhulipala17] L. Dhulipala, G. Blelloch,
+ * J. Shun, "Julienne: A Framework for Parallel Graph Algorithms using
+ * Work-efficient Bucketing".
+ *
+ * A vertex with current weight sum w belongs to bucket b(w), the first round
+ * whose threshold (start + b * step) is at least w. The open buckets are
+ * lock-free singly linked lists of nodes drawn from a pool. Since the weight
+ * sums only decrease, a vertex moved to a lower bucket is simply pushed to the
+ * new list; its stale entries are filtered out when their bucket is extracted.
+ */
+typedef struct {
+  const graph_t* graph;
+  bool      unweighted;      // if set, every edge counts as one
+  uint32_t  start;           // threshold of round zero
+  uint32_t  step;            // threshold increment of each round
+  int64_t*  weights_sum;     // current weight sum of each vertex
+  uint32_t* round;           // round of each vertex, or ACTIVE_FLAG
+  uint64_t  base;            // first bucket of the open window
+  eid_t     head[PCORE_OPEN_BUCKETS];  // first node of each open bucket
+  vid_t*    node_vertex;     // vertex of each node
+  eid_t*    node_next;       // next node in the same bucket
+  eid_t     node_count;      // number of nodes in use
+  eid_t     node_capacity;   // size of the node pool
+  vid_t*    frontier;        // vertices removed in the current iteration
+  vid_t     frontier_count;
+  vid_t*    next;            // vertices removed in the next iteration
+  vid_t     next_count;
+  vid_t*    overflow;        // vertices past the open window
+  vid_t     overflow_count;
+} pcore_peel_t;
+
+/**
+ * Returns the bucket of a weight sum, i.e., the first round in which a vertex
+ * with that weight sum is peeled.
+ */
+inline PRIVATE uint64_t pcore_bucket(const pcore_peel_t* peel, int64_t sum) {
+  if (sum <= (int64_t)peel->start) return 0;
+  return (sum - peel->start + peel->step - 1) / peel->step;
+}
+
+/**
+ * Pushes a vertex to an open bucket. It is safe to call concurrently.
+ */
+inline PRIVATE void pcore_push(pcore_peel_t* peel, uint64_t bucket, vid_t v) {
+  eid_t node = __sync_fetch_and_add(&peel->node_count, 1);
+  assert(node < peel->node_capacity);
+  peel->node_vertex[node] = v;
+  eid_t* head = &peel->head[bucket - peel->base];
+  eid_t old;
+  do {
+    old = *head;
+    peel->node_next[node] = old;
+  } while (!__sync_bool_compare_and_swap(head, old, node));
+}
+
+/**
+ * Opens the next window of buckets, which starts at the lowest bucket of the
+ * vertices that are still active. Only the overflow list is scanned: the
+ * vertices that got peeled since it was built are dropped from it, the ones
+ * that fall in the new window are pushed to their buckets, and only the ones
+ * past the window are carried to the next overflow list. Hence a vertex is
+ * scanned once per window it is past of, and never after it is pushed to an
+ * open bucket. Returns false if no active vertex is left.
+ */
+PRIVATE bool pcore_open_window(pcore_peel_t* peel) {
+  uint64_t base = UINT64_MAX;
+  OMP(omp parallel)
+  {
+    uint64_t local_base = UINT64_MAX;
+    OMP(omp for schedule(static))
+    for (vid_t i = 0; i < peel->overflow_count; i++) {
+      vid_t v = peel->overflow[i];
+      if (peel->round[v] != ACTIVE_FLAG) continue;
+      local_base = min(local_base, pcore_bucket(peel, peel->weights_sum[v]));
+    }
+    OMP(omp critical)
+    base = min(base, local_base);
+  }
+  if (base == UINT64_MAX) return false;
+
+  peel->base = base;
+  peel->node_count = 0;
+  for (int i = 0; i < PCORE_OPEN_BUCKETS; i++) peel->head[i] = PCORE_NIL;
+  vid_t count = 0;
+  OMP(omp parallel for schedule(static))
+  for (vid_t i = 0; i < peel->overflow_count; i++) {
+    vid_t v = peel->overflow[i];
+    if (peel->round[v] != ACTIVE_FLAG) continue;
+    uint64_t bucket = pcore_bucket(peel, peel->weights_sum[v]);
+    if (bucket < base + PCORE_OPEN_BUCKETS) {
+      pcore_push(peel, bucket, v);
+    } else {
+      peel->next[__sync_fetch_and_add(&count, 1)] = v;
+    }
+  }
+  vid_t* overflow = peel->overflow;
+  peel->overflow = peel->next;
+  peel->next = overflow;
+  peel->overflow_count = count;
+  return true;
+}
+
+/**
+ * Peels the vertices of one open bucket. The valid entries of the bucket form
+ * the first frontier. Removing a frontier decrements the weight sums of its
+ * active neighbors: a neighbor whose bucket drops to the current one joins the
+ * next frontier, while one whose bucket drops but stays above the current one
+ * is pushed to its new bucket. The atomic decrement returns the exact sum
+ * before it, hence exactly one thread observes each bucket change.
+ */
+PRIVATE void pcore_peel_bucket(pcore_peel_t* peel, uint64_t bucket) {
+  const graph_t* graph = peel->graph;
+  peel->frontier_count = 0;
+  for (eid_t node = peel->head[bucket - peel->base]; node != PCORE_NIL;
+       node = peel->node_next[node]) {
+    vid_t v = peel->node_vertex[node];
+    if (peel->round[v] == ACTIVE_FLAG &&
+        pcore_bucket(peel, peel->weights_sum[v]) == bucket) {
+      peel->frontier[peel->frontier_count++] = v;
+    }
+  }
+
+  const uint64_t window_end = peel->base + PCORE_OPEN_BUCKETS;
+  while (peel->frontier_count > 0) {
+    OMP(omp parallel for schedule(static))
+    for (vid_t i = 0; i < peel->frontier_count; i++) {
+      peel->round[peel->frontier[i]] = (uint32_t)bucket;
+    }
+    peel->next_count = 0;
+    OMP(omp parallel for schedule(dynamic, 64))
+    for (vid_t i = 0; i < peel->frontier_count; i++) {
+      vid_t v = peel->frontier[i];
+      for (eid_t e = graph->vertices[v]; e < graph->vertices[v + 1]; e++) {
+        vid_t u = graph->edges[e];
+        if (peel->round[u] != ACTIVE_FLAG) continue;
+        int64_t weight = peel->unweighted ? 1 : (int64_t)graph->weights[e];
+        int64_t old_sum = __sync_fetch_and_sub(&peel->weights_sum[u], weight);
+        uint64_t old_bucket = pcore_bucket(peel, old_sum);
+        uint64_t new_bucket = pcore_bucket(peel, old_sum - weight);
+        if (old_bucket > bucket && new_bucket <= bucket) {
+          peel->next[__sync_fetch_and_add(&peel->next_count, 1)] = u;
+        } else if (new_bucket > bucket && new_bucket != old_bucket &&
+                   new_bucket < window_end) {
+          pcore_push(peel, new_bucket, u);
+        }
+      }
+    }
+    vid_t* frontier = peel->frontier;
+    peel->frontier = peel->next;
+    peel->next = frontier;
+    peel->frontier_count = peel->next_count;
+  }
+}
+
+/**
+ * Computes the round of each vertex via bucket-based peeling. Every vertex is
+ * peeled once and every edge is visited once, while the buckets of a window
+ * are visited in order without scanning the vertices; hence the work is
+ * O(V + E) plus one scan per window of the vertices past the previous one.
+ */
+PRIVATE void pcore_peel(const graph_t* graph, uint32_t start, uint32_t step,
+                        bool unweighted, uint32_t* round) {
+  const vid_t vcount = graph->vertex_count;
+  pcore_peel_t peel;
+  memset(&peel, 0, sizeof(pcore_peel_t));
+  peel.graph = graph;
+  peel.unweighted = unweighted;
+  peel.start = start;
+  peel.step = step;
+  peel.round = round;
+  // A window holds at most one initial node per vertex, plus one node per
+  // decrement of a weight sum, which is bounded by the number of edges.
+  peel.node_capacity = vcount + graph->edge_count;
+  CALL_SAFE(totem_malloc(vcount * sizeof(int64_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&peel.weights_sum)));
+  CALL_SAFE(totem_malloc(peel.node_capacity * sizeof(vid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&peel.node_vertex)));
+  CALL_SAFE(totem_malloc(peel.node_capacity * sizeof(eid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&peel.node_next)));
+  CALL_SAFE(totem_malloc(vcount * sizeof(vid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&peel.frontier)));
+  CALL_SAFE(totem_malloc(vcount * sizeof(vid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&peel.next)));
+  CALL_SAFE(totem_malloc(vcount * sizeof(vid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&peel.overflow)));
+
+  OMP(omp parallel for schedule(static))
+  for (vid_t v = 0; v < vcount; v++) {
+    round[v] = ACTIVE_FLAG;
+    peel.overflow[v] = v;
+    int64_t sum = 0;
+    if (unweighted) {
+      sum = graph->vertices[v + 1] - graph->vertices[v];
+    } else {
+      for (eid_t e = graph->vertices[v]; e < graph->vertices[v + 1]; e++) {
+        sum += graph->weights[e];
+      }
+    }
+    peel.weights_sum[v] = sum;
+  }
+  peel.overflow_count = vcount;
+
+  while (pcore_open_window(&peel)) {
+    for (int i = 0; i < PCORE_OPEN_BUCKETS; i++) {
+      if (peel.head[i] == PCORE_NIL) continue;
+      pcore_peel_bucket(&peel, peel.base + i);
+    }
+  }
+
+  totem_free(peel.weights_sum, TOTEM_MEM_HOST);
+  totem_free(peel.node_vertex, TOTEM_MEM_HOST);
+  totem_free(peel.node_next, TOTEM_MEM_HOST);
+  totem_free(peel.frontier, TOTEM_MEM_HOST);
+  totem_free(peel.next, TOTEM_MEM_HOST);
+  totem_free(peel.overflow, TOTEM_MEM_HOST);
+}
+
+error_t pcore_cpu(const graph_t* graph, uint32_t start, uint32_t step,
+                  uint32_t** round_out) {
+  totem_mem_t mem_type = TOTEM_MEM_HOST_PINNED;
+  CHK_SUCCESS(verify_input(graph, start, step), err);
+
+  // simple optimization for a single node graph
+  if (graph->vertex_count == 1) {
+    CALL_SAFE(totem_malloc(sizeof(uint32_t), mem_type, (void**)round_out));
+    (*round_out)[0] = graph->edge_count;
+    return SUCCESS;
+  }
+
+  CALL_SAFE(totem_malloc(graph->vertex_count * sizeof(uint32_t), mem_type,
+                         (void**)round_out));
+  pcore_peel(graph, start, step, false, *round_out);
+  return SUCCESS;
+
+ err:
+  *round_out = NULL;
+  return FAILURE;
+}
+
+error_t kcore_cpu(const graph_t* graph, uint32_t** core_out) {
+  if (!graph || graph->directed || !graph->vertex_count) {
+    *core_out = NULL;
+    return FAILURE;
+  }
+  CALL_SAFE(totem_malloc(graph->vertex_count * sizeof(uint32_t),
+                         TOTEM_MEM_HOST_PINNED, (void**)core_out));
+  // The core number of a vertex is the last round it survives when peeling
+  // with threshold k in round k.
+  pcore_peel(graph, 0, 1, true, *core_out);
+  return SUCCESS;
+}
@@ -0,0 +1,465 @@
+/**
+ * Implements point-to-point shortest path queries for CPU: a bidirectional BFS
+ * for hop distances, and a bidirectional Dijkstra for weighted distances.
+ * Both grow a search from the source along the outgoing edges, and one from
+ * the target along the incoming edges, until the two meet. Nearby pairs are
+ * answered after visiting a small ball around each end point, instead of the
+ * whole graph.
+ *
+ * The BFS expands one full level of the side with the smaller frontier at a
+ * time, and stops after the first level that reaches a vertex of the other
+ * side: every path of the same length passes via an edge between the two
+ * explored balls, hence the shortest meeting edge of that level is optimal.
+ *
+ * The Dijkstra settles the vertex with the smallest tentative distance of the
+ * side whose queue has the smaller minimum, and records the best path found
+ * via an edge relaxed towards a vertex reached by the other side. It stops
+ * once the sum of the two queue minima is not smaller than the best path,
+ * as described in [Goldberg05] A. Goldberg, C. Harrelson, "Computing the
+ * Shortest Path: A* Search Meets Graph Theory", SODA 2005.
+ *
+ * The ALT search is a unidirectional A* whose potential is the lower bound of
+ * a landmark index towards the target (see totem_landmark.cu). The bound is
+ * consistent, hence every vertex is settled once, as in Dijkstra. The search
+ * keeps the distances in the arrays of the forward side, and the priorities
+ * (distance plus potential) in those of the backward side, whose queue it
+ * uses.
+ *
+ * The per-vertex state of a query is tagged with the id of the query that
+ * wrote it, hence it does not need to be cleared between queries, and the
+ * cost of a query only depends on the part of the graph it visits.
+ */
+
+// system includes
+#include <algorithm>
+
+// totem includes
+#include "totem_alg.h"
+
+/**
+ * The forward side searches from the source, and the backward side from the
+ * target.
+ */
+typedef enum {
+  P2P_FORWARD = 0,
+  P2P_BACKWARD,
+  P2P_SIDES
+} p2p_side_t;
+
+/**
+ * Returns true if a vertex was reached by a side in the current query.
+ */
+inline PRIVATE bool p2p_reached(const point_to_point_t* engine, int side,
+                                vid_t v) {
+  return engine->stamp[side][v] == engine->query;
+}
+
+inline PRIVATE void p2p_reach(point_to_point_t* engine, int side, vid_t v,
+                              weight_t distance, vid_t parent) {
+  engine->stamp[side][v] = engine->query;
+  engine->distance[side][v] = distance;
+  engine->parent[side][v] = parent;
+  engine->position[side][v] = INFINITE;
+}
+
+/**
+ * Starts a new query. The query id tags the valid per-vertex state; when it
+ * wraps around, the tags are reset.
+ */
+PRIVATE void p2p_start_query(point_to_point_t* engine) {
+  engine->query++;
+  if (engine->query == 0) {
+    for (int side = 0; side < P2P_SIDES; side++) {
+      memset(engine->stamp[side], 0,
+             engine->graph->vertex_count * sizeof(uint32_t));
+    }
+    engine->query = 1;
+  }
+}
+
+/**
+ * Stores the path that passes via the edge (u, x), where u was reached by the
+ * forward side and x by the backward side, and returns its number of vertices.
+ */
+PRIVATE vid_t p2p_path(const point_to_point_t* engine, vid_t u, vid_t x,
+                       vid_t* path) {
+  vid_t length = 0;
+  for (vid_t v = u; v != INFINITE; v = engine->parent[P2P_FORWARD][v]) {
+    path[length++] = v;
+  }
+  for (vid_t i = 0; i < length / 2; i++) {
+    vid_t tmp = path[i];
+    path[i] = path[length - 1 - i];
+    path[length - 1 - i] = tmp;
+  }
+  if (x != u) {
+    for (vid_t v = x; v != INFINITE; v = engine->parent[P2P_BACKWARD][v]) {
+      path[length++] = v;
+    }
+  }
+  return length;
+}
+
+PRIVATE void p2p_heap_swap(point_to_point_t* engine, int side, vid_t i,
+                           vid_t j) {
+  vid_t* heap = engine->heap[side];
+  vid_t tmp = heap[i];
+  heap[i] = heap[j];
+  heap[j] = tmp;
+  engine->position[side][heap[i]] = i;
+  engine->position[side][heap[j]] = j;
+}
+
+inline PRIVATE weight_t p2p_heap_key(const point_to_point_t* engine, int side,
+                                     vid_t i) {
+  return engine->distance[side][engine->heap[side][i]];
+}
+
+PRIVATE void p2p_heap_up(point_to_point_t* engine, int side, vid_t i) {
+  while (i > 0 && p2p_heap_key(engine, side, i) <
+         p2p_heap_key(engine, side, (i - 1) / 2)) {
+    p2p_heap_swap(engine, side, i, (i - 1) / 2);
+    i = (i - 1) / 2;
+  }
+}
+
+/**
+ * Inserts a vertex into the queue of a side, or moves it up after its distance
+ * decreased.
+ */
+PRIVATE void p2p_heap_push(point_to_point_t* engine, int side, vid_t v) {
+  vid_t i = engine->position[side][v];
+  if (i == INFINITE) {
+    i = engine->heap_size[side]++;
+    engine->heap[side][i] = v;
+    engine->position[side][v] = i;
+  }
+  p2p_heap_up(engine, side, i);
+}
+
+/**
+ * Removes the vertex with the smallest distance from the queue of a side. A
+ * removed vertex is settled, and its position is set to the queue capacity.
+ */
+PRIVATE vid_t p2p_heap_pop(point_to_point_t* engine, int side) {
+  vid_t top = engine->heap[side][0];
+  vid_t size = --engine->heap_size[side];
+  if (size > 0) p2p_heap_swap(engine, side, 0, size);
+  engine->position[side][top] = engine->graph->vertex_count;
+  vid_t i = 0;
+  while (true) {
+    vid_t child = 2 * i + 1;
+    if (child >= size) break;
+    if (child + 1 < size && p2p_heap_key(engine, side, child + 1) <
+        p2p_heap_key(engine, side, child)) {
+      child++;
+    }
+    if (p2p_heap_key(engine, side, i) <= p2p_heap_key(engine, side, child)) {
+      break;
+    }
+    p2p_heap_swap(engine, side, i, child);
+    i = child;
+  }
+  return top;
+}
+
+error_t point_to_point_initialize(const graph_t* graph,
+                                  point_to_point_t** engine) {
+  if ((graph == NULL) || (graph->vertex_count == 0) || (engine == NULL)) {
+    return FAILURE;
+  }
+  point_to_point_t* result = reinterpret_cast<point_to_point_t*>(
+      calloc(1, sizeof(point_to_point_t)));
+  assert(result);
+  result->graph = graph;
+  // The backward side follows the incoming edges, which are the outgoing
+  // edges of the transpose. The two directions of an undirected edge may have
+  // different weights, hence only unweighted undirected graphs are their own
+  // transpose.
+  result->incoming = graph;
+  if (graph->directed || graph->weighted) {
+    graph_t* transpose = NULL;
+    CALL_SAFE(graph_create_transpose(graph, &transpose));
+    result->incoming = transpose;
+  }
+  const vid_t vcount = graph->vertex_count;
+  for (int side = 0; side < P2P_SIDES; side++) {
+    CALL_SAFE(totem_malloc(vcount * sizeof(weight_t), TOTEM_MEM_HOST,
+                           reinterpret_cast<void**>(&result->distance[side])));
+    CALL_SAFE(totem_malloc(vcount * sizeof(vid_t), TOTEM_MEM_HOST,
+                           reinterpret_cast<void**>(&result->parent[side])));
+    CALL_SAFE(totem_malloc(vcount * sizeof(vid_t), TOTEM_MEM_HOST,
+                           reinterpret_cast<void**>(&result->position[side])));
+    CALL_SAFE(totem_malloc(vcount * sizeof(vid_t), TOTEM_MEM_HOST,
+                           reinterpret_cast<void**>(&result->heap[side])));
+    CALL_SAFE(totem_malloc(vcount * sizeof(uint32_t), TOTEM_MEM_HOST,
+                           reinterpret_cast<void**>(&result->stamp[side])));
+    memset(result->stamp[side], 0, vcount * sizeof(uint32_t));
+  }
+  result->query = 0;
+  *engine = result;
+  return SUCCESS;
+}
+
+error_t point_to_point_finalize(point_to_point_t* engine) {
+  if (engine == NULL) return FAILURE;
+  if (engine->incoming != engine->graph) {
+    graph_finalize(const_cast<graph_t*>(engine->incoming));
+  }
+  for (int side = 0; side < P2P_SIDES; side++) {
+    totem_free(engine->distance[side], TOTEM_MEM_HOST);
+    totem_free(engine->parent[side], TOTEM_MEM_HOST);
+    totem_free(engine->position[side], TOTEM_MEM_HOST);
+    totem_free(engine->heap[side], TOTEM_MEM_HOST);
+    totem_free(engine->stamp[side], TOTEM_MEM_HOST);
+  }
+  free(engine);
+  return SUCCESS;
+}
+
+/**
+ * Checks the parameters of a query, and answers the query of a vertex to
+ * itself. Returns true if the query is answered.
+ */
+PRIVATE bool p2p_trivial_query(const point_to_point_t* engine, vid_t source,
+                               vid_t target, vid_t* path,
+                               vid_t* path_length, error_t* rc) {
+  *rc = FAILURE;
+  if ((engine == NULL) || (source >= engine->graph->vertex_count) ||
+      (target >= engine->graph->vertex_count) ||
+      ((path != NULL) && (path_length == NULL))) {
+    return true;
+  }
+  *rc = SUCCESS;
+  if (path_length) *path_length = 0;
+  if (source != target) return false;
+  if (path) {
+    path[0] = source;
+    *path_length = 1;
+  }
+  return true;
+}
+
+error_t point_to_point_bfs_cpu(point_to_point_t* engine, vid_t source,
+                               vid_t target, vid_t* distance, vid_t* path,
+                               vid_t* path_length) {
+  error_t rc;
+  if (distance == NULL) return FAILURE;
+  if (p2p_trivial_query(engine, source, target, path, path_length, &rc)) {
+    *distance = 0;
+    return rc;
+  }
+  *distance = INFINITE;
+  p2p_start_query(engine);
+  const graph_t* graphs[P2P_SIDES] = {engine->graph, engine->incoming};
+  // The queue of a side holds the vertices in the order they were reached;
+  // its current frontier is [head, tail).
+  vid_t head[P2P_SIDES] = {0, 0};
+  vid_t tail[P2P_SIDES] = {1, 1};
+  eid_t frontier_edges[P2P_SIDES];
+  vid_t level[P2P_SIDES] = {0, 0};
+  engine->heap[P2P_FORWARD][0] = source;
+  engine->heap[P2P_BACKWARD][0] = target;
+  p2p_reach(engine, P2P_FORWARD, source, 0, INFINITE);
+  p2p_reach(engine, P2P_BACKWARD, target, 0, INFINITE);
+  for (int side = 0; side < P2P_SIDES; side++) {
+    vid_t v = engine->heap[side][0];
+    frontier_edges[side] = graphs[side]->vertices[v + 1] -
+        graphs[side]->vertices[v];
+  }
+
+  vid_t best = INFINITE;
+  vid_t meet_forward = INFINITE, meet_backward = INFINITE;
+  while (best == INFINITE && head[P2P_FORWARD] < tail[P2P_FORWARD] &&
+         head[P2P_BACKWARD] < tail[P2P_BACKWARD]) {
+    // Expand the side whose frontier has fewer edges to scan.
+    int side = frontier_edges[P2P_FORWARD] <= frontier_edges[P2P_BACKWARD] ?
+        P2P_FORWARD : P2P_BACKWARD;
+    int other = 1 - side;
+    const graph_t* graph = graphs[side];
+    vid_t* queue = engine->heap[side];
+    const vid_t end = tail[side];
+    eid_t next_edges = 0;
+    level[side]++;
+    for (vid_t i = head[side]; i < end; i++) {
+      vid_t u = queue[i];
+      for (eid_t e = graph->vertices[u]; e < graph->vertices[u + 1]; e++) {
+        vid_t x = graph->edges[e];
+        if (p2p_reached(engine, other, x)) {
+          vid_t length = level[side] + engine->distance[other][x];
+          if (length < best) {
+            best = length;
+            meet_forward = side == P2P_FORWARD ? u : x;
+            meet_backward = side == P2P_FORWARD ? x : u;
+          }
+        }
+        if (p2p_reached(engine, side, x)) continue;
+        p2p_reach(engine, side, x, level[side], u);
+        queue[tail[side]++] = x;
+        next_edges += graph->vertices[x + 1] - graph->vertices[x];
+      }
+    }
+    head[side] = end;
+    frontier_edges[side] = next_edges;
+  }
+
+  if (best == INFINITE) return SUCCESS;
+  *distance = best;
+  if (path) *path_length = p2p_path(engine, meet_forward, meet_backward, path);
+  return SUCCESS;
+}
+
+error_t point_to_point_dijkstra_cpu(point_to_point_t* engine, vid_t source,
+                                    vid_t target, weight_t* distance,
+                                    vid_t* path, vid_t* path_length) {
+  error_t rc;
+  if ((distance == NULL) || ((engine != NULL) && !engine->graph->weighted)) {
+    return FAILURE;
+  }
+  if (p2p_trivial_query(engine, source, target, path, path_length, &rc)) {
+    *distance = 0;
+    return rc;
+  }
+  *distance = WEIGHT_MAX;
+  p2p_start_query(engine);
+  const graph_t* graphs[P2P_SIDES] = {engine->graph, engine->incoming};
+  p2p_reach(engine, P2P_FORWARD, source, 0, INFINITE);
+  p2p_reach(engine, P2P_BACKWARD, target, 0, INFINITE);
+  engine->heap_size[P2P_FORWARD] = 0;
+  engine->heap_size[P2P_BACKWARD] = 0;
+  p2p_heap_push(engine, P2P_FORWARD, source);
+  p2p_heap_push(engine, P2P_BACKWARD, target);
+
+  // The distances are summed in 64 bits, as the sum of two distances may
+  // overflow a weight.
+  uint64_t best = UINT64_MAX;
+  vid_t meet_forward = INFINITE, meet_backward = INFINITE;
+  while (engine->heap_size[P2P_FORWARD] > 0 &&
+         engine->heap_size[P2P_BACKWARD] > 0) {
+    uint64_t top[P2P_SIDES];
+    for (int side = 0; side < P2P_SIDES; side++) {
+      top[side] = p2p_heap_key(engine, side, 0);
+    }
+    if (top[P2P_FORWARD] + top[P2P_BACKWARD] >= best) break;
+    int side = top[P2P_FORWARD] <= top[P2P_BACKWARD] ? P2P_FORWARD :
+        P2P_BACKWARD;
+    int other = 1 - side;
+    const graph_t* graph = graphs[side];
+    vid_t u = p2p_heap_pop(engine, side);
+    weight_t du = engine->distance[side][u];
+    for (eid_t e = graph->vertices[u]; e < graph->vertices[u + 1]; e++) {
+      vid_t x = graph->edges[e];
+      uint64_t dx = (uint64_t)du + graph->weights[e];
+      if (p2p_reached(engine, other, x) &&
+          dx + engine->distance[other][x] < best) {
+        best = dx + engine->distance[other][x];
+        meet_forward = side == P2P_FORWARD ? u : x;
+        meet_backward = side == P2P_FORWARD ? x : u;
+      }
+      if (dx >= WEIGHT_MAX) continue;
+      if (!p2p_reached(engine, side, x)) {
+        p2p_reach(engine, side, x, dx, u);
+        p2p_heap_push(engine, side, x);
+      } else if (dx < engine->distance[side][x]) {
+        // A settled vertex is never improved, as the weights are not negative.
+        engine->distance[side][x] = dx;
+        engine->parent[side][x] = u;
+        p2p_heap_push(engine, side, x);
+      }
+    }
+  }
+
+  if (best >= WEIGHT_MAX) return SUCCESS;
+  *distance = (weight_t)best;
+  if (path) *path_length = p2p_path(engine, meet_forward, meet_backward, path);
+  return SUCCESS;
+}
+
+error_t point_to_point_alt_cpu(point_to_point_t* engine,
+                               const landmark_index_t* index, vid_t source,
+                               vid_t target, weight_t* distance, vid_t* path,
+                               vid_t* path_length) {
+  error_t rc;
+  if ((distance == NULL) || ((engine != NULL) &&
+      ((index == NULL) ||
+       (index->graph->vertex_count != engine->graph->vertex_count) ||
+       (index->weighted != engine->graph->weighted)))) {
+    return FAILURE;
+  }
+  if (p2p_trivial_query(engine, source, target, path, path_length, &rc)) {
+    *distance = 0;
+    return rc;
+  }
+  *distance = INFINITE;
+  weight_t potential = landmark_lower_bound(index, source, target);
+  if (potential == INFINITE) return SUCCESS;
+  p2p_start_query(engine);
+  const graph_t* graph = engine->graph;
+  const vid_t settled = graph->vertex_count;
+  engine->heap_size[P2P_BACKWARD] = 0;
+  p2p_reach(engine, P2P_FORWARD, source, 0, INFINITE);
+  p2p_reach(engine, P2P_BACKWARD, source, potential, INFINITE);
+  p2p_heap_push(engine, P2P_BACKWARD, source);
+
+  bool found = false;
+  while (engine->heap_size[P2P_BACKWARD] > 0) {
+    vid_t u = p2p_heap_pop(engine, P2P_BACKWARD);
+    if (u == target) {
+      found = true;
+      break;
+    }
+    weight_t du = engine->distance[P2P_FORWARD][u];
+    for (eid_t e = graph->vertices[u]; e < graph->vertices[u + 1]; e++) {
+      vid_t x = graph->edges[e];
+      uint64_t dx = (uint64_t)du + (graph->weighted ? graph->weights[e] : 1);
+      if (dx >= INFINITE) continue;
+      if (!p2p_reached(engine, P2P_FORWARD, x)) {
+        potential = x == target ? 0 : landmark_lower_bound(index, x, target);
+        p2p_reach(engine, P2P_FORWARD, x, dx, u);
+        p2p_reach(engine, P2P_BACKWARD, x,
+                  std::min(dx + potential, (uint64_t)INFINITE - 1), u);
+        if (potential == INFINITE) {
+          // The target is not reachable from x; it is never queued.
+          engine->position[P2P_BACKWARD][x] = settled;
+        } else {
+          p2p_heap_push(engine, P2P_BACKWARD, x);
+        }
+      } else if (engine->position[P2P_BACKWARD][x] != settled &&
+                 dx < engine->distance[P2P_FORWARD][x]) {
+        potential = engine->distance[P2P_BACKWARD][x] -
+            engine->distance[P2P_FORWARD][x];
+        engine->distance[P2P_FORWARD][x] = dx;
+        engine->parent[P2P_FORWARD][x] = u;
+        engine->distance[P2P_BACKWARD][x] =
+            std::min(dx + potential, (uint64_t)INFINITE - 1);
+        p2p_heap_push(engine, P2P_BACKWARD, x);
+      }
+    }
+  }
+
+  if (!found) return SUCCESS;
+  *distance = engine->distance[P2P_FORWARD][target];
+  if (path) *path_length = p2p_path(engine, target, target, path);
+  return SUCCESS;
+}
+
+error_t stcon_cpu(const graph_t* graph, vid_t source_id, vid_t destination_id,
+                  bool* connected) {
+  if ((graph == NULL) || (connected == NULL) ||
+      (source_id >= graph->vertex_count) ||
+      (destination_id >= graph->vertex_count)) {
+    return FAILURE;
+  }
+  point_to_point_t* engine = NULL;
+  CHK_SUCCESS(point_to_point_initialize(graph, &engine), err);
+  vid_t distance;
+  CHK_SUCCESS(point_to_point_bfs_cpu(engine, source_id, destination_id,
+                                     &distance, NULL, NULL), err_free);
+  *connected = distance != INFINITE;
+  return point_to_point_finalize(engine);
+
+ err_free:
+  point_to_point_finalize(engine);
+ err:
+  return FAILURE;
+}
@@ -0,0 +1,322 @@
+/**
+ * Implements a random walk engine for CPU, which generates the walks used to
+ * train vertex embeddings, such as DeepWalk [Perozzi14] B. Perozzi, R. Al-Rfou,
+ * S. Skiena, "DeepWalk: Online Learning of Social Representations", KDD 2014,
+ * and node2vec [Grover16] A. Grover, J. Leskovec, "node2vec: Scalable Feature
+ * Learning for Networks", KDD 2016.
+ *
+ * Walks are independent, hence each thread advances its own walkers. The
+ * random numbers of a walk are drawn from a counter-based generator keyed by
+ * the seed, the id of the walk, the step and the draw within the step; hence
+ * a walk is the same regardless of the thread that runs it, the number of
+ * threads, or the batch it is generated in.
+ *
+ * Weighted transitions are sampled in constant time from per-vertex alias
+ * tables [Vose91] M. D. Vose, "A Linear Algorithm for Generating Random
+ * Numbers with a Given Distribution", IEEE TSE 17(9), 1991. The second order
+ * biases of node2vec are applied via rejection sampling as in [Yang19] K. Yang
+ * et al., "KnightKing: A Fast Distributed Graph Random Walk Engine", SOSP
+ * 2019: a candidate is drawn from the first order distribution, and accepted
+ * with a probability proportional to its bias. Whether the candidate is a
+ * neighbor of the previous vertex is tested via binary search in the sorted
+ * neighbor list of the previous vertex, hence no per-edge state is needed.
+ */
+
+// system includes
+#include <algorithm>
+
+// totem includes
+#include "totem_alg.h"
+
+// The number of walks generated per batch when the walks are streamed to a
+// file.
+const uint64_t RANDOM_WALK_BATCH_WALKS = 1 << 16;
+
+// The number of entries of the work list each thread keeps to build the alias
+// tables; the vertices of larger degree allocate their own.
+const eid_t RANDOM_WALK_ALIAS_WORK = 4096;
+
+/**
+ * Returns the random number of the given draw within a step of a walk. The
+ * generator is the finalizer of SplitMix64 applied to a mix of the counters.
+ */
+inline PRIVATE uint64_t random_walk_rand(uint64_t seed, uint64_t walk,
+                                         uint32_t step, uint32_t draw) {
+  uint64_t x = seed + walk * 0x9e3779b97f4a7c15ULL;
+  x ^= ((uint64_t)step << 32 | draw) * 0xd1b54a32d192ed03ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+/**
+ * Returns a random number in [0, 1) from the 53 high bits of a draw.
+ */
+inline PRIVATE double random_walk_uniform(uint64_t random) {
+  return (random >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/**
+ * Builds the alias table of each vertex. The probability and the alias of an
+ * entry are stored at the index of the corresponding edge. Each thread keeps a
+ * work list of RANDOM_WALK_ALIAS_WORK entries, and a vertex of larger degree
+ * allocates a list of its degree, hence a few high-degree vertices do not
+ * size the lists of all the threads.
+ */
+PRIVATE void random_walk_build_alias(random_walk_sampler_t* sampler) {
+  const graph_t* graph = sampler->graph;
+  OMP(omp parallel)
+  {
+    eid_t* work = NULL;
+    CALL_SAFE(totem_malloc(RANDOM_WALK_ALIAS_WORK * sizeof(eid_t),
+                           TOTEM_MEM_HOST, reinterpret_cast<void**>(&work)));
+    OMP(omp for schedule(dynamic, 256))
+    for (vid_t v = 0; v < graph->vertex_count; v++) {
+      const eid_t begin = graph->vertices[v];
+      const eid_t degree = graph->vertices[v + 1] - begin;
+      // The small entries grow from the front of the work list, and the large
+      // ones from its back.
+      eid_t* list = work;
+      if (degree > RANDOM_WALK_ALIAS_WORK) {
+        CALL_SAFE(totem_malloc(degree * sizeof(eid_t), TOTEM_MEM_HOST,
+                               reinterpret_cast<void**>(&list)));
+      }
+      float* prob = &sampler->alias_prob[begin];
+      eid_t* alias = &sampler->alias[begin];
+      double total = 0;
+      for (eid_t i = 0; i < degree; i++) total += graph->weights[begin + i];
+      eid_t small = 0;
+      eid_t large = degree;
+      for (eid_t i = 0; i < degree; i++) {
+        alias[i] = i;
+        prob[i] = total > 0 ? graph->weights[begin + i] * degree / total : 1;
+        if (prob[i] < 1) {
+          list[small++] = i;
+        } else {
+          list[--large] = i;
+        }
+      }
+      while (small > 0 && large < degree) {
+        eid_t s = list[--small];
+        eid_t l = list[large];
+        alias[s] = l;
+        prob[l] -= 1 - prob[s];
+        if (prob[l] < 1) {
+          large++;
+          list[small++] = l;
+        }
+      }
+      // The entries left in either list are full, up to rounding errors.
+      while (small > 0) prob[list[--small]] = 1;
+      while (large < degree) prob[list[large++]] = 1;
+      if (list != work) totem_free(list, TOTEM_MEM_HOST);
+    }
+    totem_free(work, TOTEM_MEM_HOST);
+  }
+}
+
+error_t random_walk_sampler_initialize(const graph_t* graph,
+                                       const random_walk_config_t* config,
+                                       random_walk_sampler_t** sampler_ret) {
+  if ((graph == NULL) || (graph->vertex_count == 0) || (config == NULL) ||
+      (sampler_ret == NULL) || (config->walk_length == 0) ||
+      (config->weighted && !graph->weighted) ||
+      !(config->return_param > 0) || !(config->inout_param > 0)) {
+    return FAILURE;
+  }
+  bool second_order = (config->return_param != 1 ||
+                       config->inout_param != 1);
+  if (second_order) {
+    // The neighbor test requires sorted neighbor lists.
+    bool sorted = true;
+    OMP(omp parallel for schedule(dynamic, 256) reduction(& : sorted))
+    for (vid_t v = 0; v < graph->vertex_count; v++) {
+      for (eid_t e = graph->vertices[v] + 1; e < graph->vertices[v + 1];
+           e++) {
+        if (graph->edges[e - 1] > graph->edges[e]) sorted = false;
+      }
+    }
+    if (!sorted) return FAILURE;
+  }
+
+  random_walk_sampler_t* sampler = reinterpret_cast<random_walk_sampler_t*>(
+      calloc(1, sizeof(random_walk_sampler_t)));
+  assert(sampler);
+  sampler->graph = graph;
+  sampler->config = *config;
+  sampler->second_order = second_order;
+  sampler->max_bias = std::max(1.0, std::max(1.0 / config->return_param,
+                                             1.0 / config->inout_param));
+  if (config->weighted && graph->edge_count > 0) {
+    CALL_SAFE(totem_malloc(graph->edge_count * sizeof(float), TOTEM_MEM_HOST,
+                           reinterpret_cast<void**>(&sampler->alias_prob)));
+    CALL_SAFE(totem_malloc(graph->edge_count * sizeof(eid_t), TOTEM_MEM_HOST,
+                           reinterpret_cast<void**>(&sampler->alias)));
+    random_walk_build_alias(sampler);
+  }
+  *sampler_ret = sampler;
+  return SUCCESS;
+}
+
+error_t random_walk_sampler_finalize(random_walk_sampler_t* sampler) {
+  if (sampler == NULL) return FAILURE;
+  if (sampler->alias_prob) totem_free(sampler->alias_prob, TOTEM_MEM_HOST);
+  if (sampler->alias) totem_free(sampler->alias, TOTEM_MEM_HOST);
+  free(sampler);
+  return SUCCESS;
+}
+
+/**
+ * Returns true if there is an edge from u to v, via binary search in the
+ * sorted neighbor list of u.
+ */
+inline PRIVATE bool random_walk_is_neighbor(const graph_t* graph, vid_t u,
+                                            vid_t v) {
+  eid_t low = graph->vertices[u];
+  eid_t high = graph->vertices[u + 1];
+  while (low < high) {
+    eid_t mid = low + (high - low) / 2;
+    if (graph->edges[mid] < v) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low < graph->vertices[u + 1] && graph->edges[low] == v;
+}
+
+/**
+ * Draws the next vertex of a walk from the first order distribution of the
+ * current vertex, which must have at least one neighbor. It uses the draws
+ * draw and draw + 1 of the step.
+ */
+inline PRIVATE vid_t random_walk_first_order(
+    const random_walk_sampler_t* sampler, vid_t current, uint64_t walk,
+    uint32_t step, uint32_t draw) {
+  const graph_t* graph = sampler->graph;
+  const eid_t begin = graph->vertices[current];
+  const eid_t degree = graph->vertices[current + 1] - begin;
+  uint64_t random = random_walk_rand(sampler->config.seed, walk, step, draw);
+  eid_t i = (eid_t)(random_walk_uniform(random) * degree);
+  if (i >= degree) i = degree - 1;
+  if (sampler->alias_prob) {
+    // A second draw picks between the entry and its alias.
+    random = random_walk_rand(sampler->config.seed, walk, step, draw + 1);
+    if (random_walk_uniform(random) >= sampler->alias_prob[begin + i]) {
+      i = sampler->alias[begin + i];
+    }
+  }
+  return graph->edges[begin + i];
+}
+
+/**
+ * Generates a single walk, and returns the number of steps it took.
+ */
+PRIVATE uint32_t random_walk_one(const random_walk_sampler_t* sampler,
+                                 uint64_t walk, vid_t* path) {
+  const graph_t* graph = sampler->graph;
+  const random_walk_config_t* config = &sampler->config;
+  vid_t previous = INFINITE;
+  vid_t current = (vid_t)(walk % graph->vertex_count);
+  path[0] = current;
+  uint32_t step = 1;
+  for (; step < config->walk_length; step++) {
+    if (graph->vertices[current] == graph->vertices[current + 1]) break;
+    vid_t next = INFINITE;
+    // Each attempt uses three draws: two for the candidate, and one to
+    // accept it.
+    for (uint32_t draw = 0; next == INFINITE; draw += 3) {
+      vid_t candidate = random_walk_first_order(sampler, current, walk, step,
+                                                draw);
+      if (!sampler->second_order || previous == INFINITE) {
+        next = candidate;
+        break;
+      }
+      double bias = 1.0 / config->inout_param;
+      if (candidate == previous) {
+        bias = 1.0 / config->return_param;
+      } else if (random_walk_is_neighbor(graph, previous, candidate)) {
+        bias = 1;
+      }
+      uint64_t random = random_walk_rand(config->seed, walk, step, draw + 2);
+      if (random_walk_uniform(random) * sampler->max_bias < bias) {
+        next = candidate;
+      }
+    }
+    previous = current;
+    current = next;
+    path[step] = current;
+  }
+  uint32_t steps = step - 1;
+  // A walk that reaches a vertex without neighbors stops early.
+  for (; step < config->walk_length; step++) path[step] = INFINITE;
+  return steps;
+}
+
+error_t random_walk_cpu(const random_walk_sampler_t* sampler,
+                        uint64_t first_walk, uint64_t walk_count,
+                        vid_t* walks, random_walk_stats_t* stats) {
+  if ((sampler == NULL) || (walk_count > 0 && walks == NULL)) {
+    return FAILURE;
+  }
+  stopwatch_t stopwatch;
+  stopwatch_start(&stopwatch);
+  const uint32_t length = sampler->config.walk_length;
+  uint64_t steps = 0;
+  OMP(omp parallel for schedule(dynamic, 64) reduction(+ : steps))
+  for (uint64_t i = 0; i < walk_count; i++) {
+    steps += random_walk_one(sampler, first_walk + i, &walks[i * length]);
+  }
+  if (stats) {
+    stats->walks = walk_count;
+    stats->steps = steps;
+    stats->time = stopwatch_elapsed(&stopwatch);
+    stats->steps_per_second = stats->time > 0 ?
+        steps / (stats->time / 1000.0) : 0;
+  }
+  return SUCCESS;
+}
+
+error_t random_walk_file_cpu(const random_walk_sampler_t* sampler,
+                             const char* file_path,
+                             random_walk_stats_t* stats) {
+  if ((sampler == NULL) || (file_path == NULL)) return FAILURE;
+  FILE* file = fopen(file_path, "wb");
+  if (file == NULL) return FAILURE;
+
+  stopwatch_t stopwatch;
+  stopwatch_start(&stopwatch);
+  const uint32_t length = sampler->config.walk_length;
+  const uint64_t walk_count = (uint64_t)sampler->graph->vertex_count *
+      sampler->config.walks_per_vertex;
+  vid_t* buffer = NULL;
+  CALL_SAFE(totem_malloc(std::min(walk_count, RANDOM_WALK_BATCH_WALKS) *
+                         length * sizeof(vid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&buffer)));
+  error_t rc = FAILURE;
+  uint64_t steps = 0;
+  for (uint64_t first = 0; first < walk_count;
+       first += RANDOM_WALK_BATCH_WALKS) {
+    uint64_t count = std::min(RANDOM_WALK_BATCH_WALKS, walk_count - first);
+    random_walk_stats_t batch;
+    CHK_SUCCESS(random_walk_cpu(sampler, first, count, buffer, &batch),
+                err_free);
+    steps += batch.steps;
+    CHK(fwrite(buffer, sizeof(vid_t), count * length, file) == count * length,
+        err_free);
+  }
+  rc = SUCCESS;
+
+ err_free:
+  totem_free(buffer, TOTEM_MEM_HOST);
+  if (fclose(file) != 0) rc = FAILURE;
+
+  if (stats) {
+    stats->walks = walk_count;
+    stats->steps = steps;
+    stats->time = stopwatch_elapsed(&stopwatch);
+    stats->steps_per_second = stats->time > 0 ?
+        steps / (stats->time / 1000.0) : 0;
+  }
+  return rc;
+}
@@ -0,0 +1,328 @@
+/**
+ * Implements a vertex similarity engine for CPU, which finds for each vertex
+ * the k most similar vertices within two hops, as used for link prediction
+ * [Liben-Nowell07] D. Liben-Nowell, J. Kleinberg, "The Link-Prediction
+ * Problem for Social Networks", JASIST 58(7), 2007.
+ *
+ * The candidates of a vertex v are found by enumerating the wedges v - u - w:
+ * each intermediate vertex u adds its contribution to the score of w in a
+ * per-thread hash accumulator. Intermediates whose degree exceeds the hub
+ * threshold are skipped, as they contribute many wedges but little
+ * information; hence, the accumulated scores of a vertex that has such
+ * neighbors are partial, and the score of each of its candidates is computed
+ * exactly via the intersection of the sorted neighbor lists of the pair.
+ * Finally, the best k candidates are selected via a bounded heap.
+ *
+ * The results are written in place: a first pass counts the results of each
+ * vertex from its candidates, which only costs the wedges, and sizes the
+ * output; a second pass scores the candidates, and writes the top k of each
+ * vertex at its offset.
+ */
+
+// system includes
+#include <algorithm>
+
+// totem includes
+#include "totem_accumulator.h"
+#include "totem_alg.h"
+
+// The ratio of the lengths of two neighbor lists above which the shorter list
+// is searched in the longer one, instead of merging them.
+const eid_t SIMILARITY_GALLOP_RATIO = 32;
+
+// A map that accumulates the scores of the candidates of a vertex.
+typedef accumulator_t<double> similarity_map_t;
+
+/**
+ * An entry of the top-k heap of a vertex.
+ */
+typedef struct {
+  double score;
+  vid_t  vertex;
+} similarity_entry_t;
+
+inline PRIVATE eid_t similarity_degree(const graph_t* graph, vid_t v) {
+  return graph->vertices[v + 1] - graph->vertices[v];
+}
+
+/**
+ * Returns the contribution of a common neighbor to the score of a pair. The
+ * Jaccard coefficient counts the common neighbors, and is normalized once the
+ * count is final.
+ */
+inline PRIVATE double similarity_contribution(const graph_t* graph,
+                                              similarity_metric_t metric,
+                                              vid_t common) {
+  if (metric != SIMILARITY_ADAMIC_ADAR) return 1;
+  eid_t degree = similarity_degree(graph, common);
+  return degree > 1 ? 1.0 / log((double)degree) : 0;
+}
+
+/**
+ * Returns the first index in [low, high) whose neighbor is not smaller than
+ * the given vertex.
+ */
+inline PRIVATE eid_t similarity_lower_bound(const graph_t* graph, eid_t low,
+                                            eid_t high, vid_t vertex) {
+  while (low < high) {
+    eid_t mid = low + (high - low) / 2;
+    if (graph->edges[mid] < vertex) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+inline PRIVATE bool similarity_is_neighbor(const graph_t* graph, vid_t v,
+                                           vid_t w) {
+  eid_t e = similarity_lower_bound(graph, graph->vertices[v],
+                                   graph->vertices[v + 1], w);
+  return e < graph->vertices[v + 1] && graph->edges[e] == w;
+}
+
+/**
+ * Returns the exact (unnormalized) score of a pair of vertices, via the
+ * intersection of their sorted neighbor lists. Lists of similar lengths are
+ * merged; otherwise, each neighbor of the shorter list is searched in the
+ * remaining part of the longer one.
+ */
+PRIVATE double similarity_intersect(const graph_t* graph,
+                                    similarity_metric_t metric, vid_t v,
+                                    vid_t w) {
+  if (similarity_degree(graph, v) > similarity_degree(graph, w)) {
+    std::swap(v, w);
+  }
+  eid_t i = graph->vertices[v];
+  const eid_t i_end = graph->vertices[v + 1];
+  eid_t j = graph->vertices[w];
+  const eid_t j_end = graph->vertices[w + 1];
+  double score = 0;
+  if ((j_end - j) > SIMILARITY_GALLOP_RATIO * (i_end - i)) {
+    for (; i < i_end && j < j_end; i++) {
+      vid_t common = graph->edges[i];
+      j = similarity_lower_bound(graph, j, j_end, common);
+      if (j < j_end && graph->edges[j] == common) {
+        score += similarity_contribution(graph, metric, common);
+      }
+    }
+    return score;
+  }
+  while (i < i_end && j < j_end) {
+    vid_t a = graph->edges[i];
+    vid_t b = graph->edges[j];
+    if (a == b) score += similarity_contribution(graph, metric, a);
+    i += (a <= b);
+    j += (b <= a);
+  }
+  return score;
+}
+
+/**
+ * Returns true if entry a is worse than entry b: it has a lower score, or the
+ * same score and a larger vertex id.
+ */
+inline PRIVATE bool similarity_worse(const similarity_entry_t& a,
+                                     const similarity_entry_t& b) {
+  return a.score < b.score || (a.score == b.score && a.vertex > b.vertex);
+}
+
+/**
+ * Offers an entry to a bounded min-heap of the k best entries, whose root is
+ * the worst of them.
+ */
+PRIVATE void similarity_heap_offer(similarity_entry_t* heap, uint32_t* size,
+                                   uint32_t k, similarity_entry_t entry) {
+  uint32_t i;
+  if (*size < k) {
+    // Sift up from a new leaf.
+    i = (*size)++;
+    while (i > 0 && similarity_worse(entry, heap[(i - 1) / 2])) {
+      heap[i] = heap[(i - 1) / 2];
+      i = (i - 1) / 2;
+    }
+    heap[i] = entry;
+    return;
+  }
+  if (!similarity_worse(heap[0], entry)) return;
+  // Replace the root, and sift down.
+  i = 0;
+  while (true) {
+    uint32_t child = 2 * i + 1;
+    if (child >= k) break;
+    if (child + 1 < k && similarity_worse(heap[child + 1], heap[child])) {
+      child++;
+    }
+    if (!similarity_worse(heap[child], entry)) break;
+    heap[i] = heap[child];
+    i = child;
+  }
+  heap[i] = entry;
+}
+
+/**
+ * Orders entries from the best to the worst.
+ */
+PRIVATE bool similarity_better(const similarity_entry_t& a,
+                               const similarity_entry_t& b) {
+  return similarity_worse(b, a);
+}
+
+/**
+ * Accumulates the wedge scores of the candidates of a vertex. Returns true if
+ * the scores are partial, as the vertex has a hub or itself as a neighbor.
+ */
+PRIVATE bool similarity_candidates(const graph_t* graph,
+                                   const similarity_config_t* config,
+                                   vid_t v, similarity_map_t* map) {
+  const eid_t hub = config->hub_threshold;
+  // Bound the number of candidates, to size the accumulator.
+  uint64_t wedges = 0;
+  bool partial = false;
+  for (eid_t e = graph->vertices[v]; e < graph->vertices[v + 1]; e++) {
+    vid_t u = graph->edges[e];
+    eid_t degree = similarity_degree(graph, u);
+    // A self loop is a common neighbor that is not enumerated as a wedge.
+    if (u == v || (hub && degree > hub)) {
+      partial = true;
+    } else {
+      wedges += degree;
+    }
+  }
+  accumulator_reserve(map, wedges);
+
+  for (eid_t e = graph->vertices[v]; e < graph->vertices[v + 1]; e++) {
+    vid_t u = graph->edges[e];
+    if (u == v || (hub && similarity_degree(graph, u) > hub)) continue;
+    double contribution = similarity_contribution(graph, config->metric, u);
+    for (eid_t f = graph->vertices[u]; f < graph->vertices[u + 1]; f++) {
+      vid_t w = graph->edges[f];
+      if (w != v) accumulator_add(map, w, contribution);
+    }
+  }
+  return partial;
+}
+
+/**
+ * Returns the number of results of a vertex: its candidates, less the
+ * excluded ones, up to k.
+ */
+PRIVATE uint32_t similarity_count(const graph_t* graph,
+                                  const similarity_config_t* config,
+                                  vid_t v, similarity_map_t* map) {
+  similarity_candidates(graph, config, v, map);
+  uint64_t count = map->used_count;
+  if (config->exclude_neighbors) {
+    for (uint64_t i = 0; i < map->used_count; i++) {
+      count -= similarity_is_neighbor(graph, v, map->keys[map->used[i]]);
+    }
+  }
+  accumulator_clear(map);
+  return (uint32_t)std::min(count, (uint64_t)config->k);
+}
+
+/**
+ * Finds the top-k candidates of a vertex, and stores them in order in
+ * result. Returns their number.
+ */
+PRIVATE uint32_t similarity_vertex(const graph_t* graph,
+                                   const similarity_config_t* config,
+                                   vid_t v, similarity_map_t* map,
+                                   similarity_entry_t* result) {
+  bool partial = similarity_candidates(graph, config, v, map);
+  uint32_t size = 0;
+  const eid_t v_degree = similarity_degree(graph, v);
+  for (uint64_t i = 0; i < map->used_count; i++) {
+    uint64_t slot = map->used[i];
+    similarity_entry_t entry;
+    entry.vertex = map->keys[slot];
+    entry.score = map->values[slot];
+    if (config->exclude_neighbors &&
+        similarity_is_neighbor(graph, v, entry.vertex)) {
+      continue;
+    }
+    if (partial) {
+      entry.score = similarity_intersect(graph, config->metric, v,
+                                         entry.vertex);
+    }
+    if (config->metric == SIMILARITY_JACCARD) {
+      double union_size = v_degree + similarity_degree(graph, entry.vertex) -
+          entry.score;
+      entry.score = union_size > 0 ? entry.score / union_size : 0;
+    }
+    similarity_heap_offer(result, &size, config->k, entry);
+  }
+  accumulator_clear(map);
+  std::sort(result, result + size, similarity_better);
+  return size;
+}
+
+error_t similarity_topk_cpu(const graph_t* graph,
+                            const similarity_config_t* config,
+                            eid_t** offsets, vid_t** neighbors,
+                            float** scores) {
+  if ((graph == NULL) || (graph->vertex_count == 0) || (config == NULL) ||
+      (config->k == 0) || (offsets == NULL) || (neighbors == NULL) ||
+      (scores == NULL)) {
+    return FAILURE;
+  }
+  // The wedges of a directed graph do not match the common neighbors.
+  if (graph->directed && graph->edge_count != 0) return FAILURE;
+  // The exact scores require sorted neighbor lists.
+  bool sorted = true;
+  OMP(omp parallel for schedule(dynamic, 256) reduction(& : sorted))
+  for (vid_t v = 0; v < graph->vertex_count; v++) {
+    for (eid_t e = graph->vertices[v] + 1; e < graph->vertices[v + 1]; e++) {
+      if (graph->edges[e - 1] > graph->edges[e]) sorted = false;
+    }
+  }
+  if (!sorted) return FAILURE;
+
+  const vid_t vcount = graph->vertex_count;
+  CALL_SAFE(totem_malloc((vcount + 1) * sizeof(eid_t), TOTEM_MEM_HOST_PINNED,
+                         reinterpret_cast<void**>(offsets)));
+  OMP(omp parallel)
+  {
+    similarity_map_t map;
+    memset(&map, 0, sizeof(map));
+    OMP(omp for schedule(dynamic, 64))
+    for (vid_t v = 0; v < vcount; v++) {
+      (*offsets)[v + 1] = similarity_count(graph, config, v, &map);
+    }
+    accumulator_finalize(&map);
+  }
+  (*offsets)[0] = 0;
+  for (vid_t v = 0; v < vcount; v++) {
+    (*offsets)[v + 1] += (*offsets)[v];
+  }
+
+  const eid_t count = (*offsets)[vcount];
+  *neighbors = NULL;
+  *scores = NULL;
+  if (count == 0) return SUCCESS;
+  CALL_SAFE(totem_malloc(count * sizeof(vid_t), TOTEM_MEM_HOST_PINNED,
+                         reinterpret_cast<void**>(neighbors)));
+  CALL_SAFE(totem_malloc(count * sizeof(float), TOTEM_MEM_HOST_PINNED,
+                         reinterpret_cast<void**>(scores)));
+  OMP(omp parallel)
+  {
+    similarity_map_t map;
+    memset(&map, 0, sizeof(map));
+    similarity_entry_t* top = NULL;
+    CALL_SAFE(totem_malloc(config->k * sizeof(similarity_entry_t),
+                           TOTEM_MEM_HOST, reinterpret_cast<void**>(&top)));
+    OMP(omp for schedule(dynamic, 64))
+    for (vid_t v = 0; v < vcount; v++) {
+      uint32_t size = similarity_vertex(graph, config, v, &map, top);
+      assert((*offsets)[v] + size == (*offsets)[v + 1]);
+      for (uint32_t i = 0; i < size; i++) {
+        (*neighbors)[(*offsets)[v] + i] = top[i].vertex;
+        (*scores)[(*offsets)[v] + i] = top[i].score;
+      }
+    }
+    accumulator_finalize(&map);
+    totem_free(top, TOTEM_MEM_HOST);
+  }
+  return SUCCESS;
+}
@@ -24,6 +24,10 @@ typedef enum {
   BENCHMARK_BFS_STEPWISE,
   BENCHMARK_GRAPH500_STEPWISE,
   BENCHMARK_CC,
+  BENCHMARK_PCORE,
+  BENCHMARK_KTRUSS,
+  BENCHMARK_RANDOM_WALK,
+  BENCHMARK_PCORE_SWEEP,
   BENCHMARK_MAX
 } benchmark_t;
 
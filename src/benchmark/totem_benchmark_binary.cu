@@ -22,6 +22,11 @@ PRIVATE void benchmark_bfs_stepwise(graph_t* graph, void* cost,
 PRIVATE void benchmark_graph500_stepwise(graph_t* graph, void* tree,
                                          totem_attr_t* attr);
 PRIVATE void benchmark_cc(graph_t* graph, void* label, totem_attr_t* attr);
+PRIVATE void benchmark_pcore(graph_t* graph, void* round, totem_attr_t* attr);
+PRIVATE void benchmark_ktruss(graph_t* graph, void*, totem_attr_t* attr);
+PRIVATE void benchmark_random_walk(graph_t* graph, void*, totem_attr_t* attr);
+PRIVATE void benchmark_pcore_sweep(graph_t* graph, void* round,
+                                   totem_attr_t* attr);
 const benchmark_attr_t BENCHMARKS[] = {
   {
     benchmark_bfs,
@@ -122,6 +127,50 @@ const benchmark_attr_t BENCHMARKS[] = {
     NULL,
     NULL
   },
+  {
+    benchmark_pcore,
+    "PCORE",
+    sizeof(uint32_t),
+    false,
+    false,
+    MSG_SIZE_ZERO,
+    MSG_SIZE_ZERO,
+    NULL,
+    NULL
+  },
+  {
+    benchmark_ktruss,
+    "KTRUSS",
+    0,
+    false,
+    false,
+    MSG_SIZE_ZERO,
+    MSG_SIZE_ZERO,
+    NULL,
+    NULL
+  },
+  {
+    benchmark_random_walk,
+    "RANDOM_WALK",
+    0,
+    false,
+    false,
+    MSG_SIZE_ZERO,
+    MSG_SIZE_ZERO,
+    NULL,
+    NULL
+  },
+  {
+    benchmark_pcore_sweep,
+    "PCORE_SWEEP",
+    sizeof(uint32_t),
+    false,
+    false,
+    MSG_SIZE_ZERO,
+    MSG_SIZE_ZERO,
+    NULL,
+    NULL
+  },
 };
 
 
@@ -251,13 +300,82 @@ PRIVATE void benchmark_clustering_coefficient(
   }
 }
 
+// Runs p-core benchmark, which peels the graph with p starting from zero and
+// incremented by one in each round.
+PRIVATE void benchmark_pcore(graph_t* graph, void* round, totem_attr_t* attr) {
+  uint32_t* pcore_round = NULL;
+  if (options->platform == PLATFORM_CPU) {
+    CALL_SAFE(pcore_cpu(graph, 0, 1, &pcore_round));
+  } else if (options->platform == PLATFORM_GPU && options->gpu_count == 1) {
+    CALL_SAFE(pcore_gpu(graph, 0, 1, &pcore_round));
+  } else {
+    assert(false);
+  }
+  memcpy(round, pcore_round, graph->vertex_count * sizeof(uint32_t));
+  totem_free(pcore_round, TOTEM_MEM_HOST_PINNED);
+}
+
+// Runs the reference sweep implementation of p-core with the same parameters
+// as benchmark_pcore, to time the bucket-based engine against.
+PRIVATE void benchmark_pcore_sweep(graph_t* graph, void* round,
+                                   totem_attr_t* attr) {
+  uint32_t* pcore_round = NULL;
+  assert(options->platform == PLATFORM_CPU);
+  CALL_SAFE(pcore_sweep_cpu(graph, 0, 1, &pcore_round));
+  memcpy(round, pcore_round, graph->vertex_count * sizeof(uint32_t));
+  totem_free(pcore_round, TOTEM_MEM_HOST_PINNED);
+}
+
+// Runs k-truss benchmark. As ktruss_cpu requires, the graph must be undirected
+// with sorted neighbor lists, like the input of the clustering coefficient
+// benchmark it is compared against. The output is per edge, hence it is not
+// kept in the per-vertex benchmark state.
+PRIVATE void benchmark_ktruss(graph_t* graph, void*, totem_attr_t* attr) {
+  uint32_t* truss = NULL;
+  if (options->platform == PLATFORM_CPU) {
+    CALL_SAFE(ktruss_cpu(graph, &truss));
+  } else {
+    assert(false);
+  }
+  if (truss) totem_free(truss, TOTEM_MEM_HOST_PINNED);
+}
+
+// Runs random walk benchmark: one DeepWalk-style walk of 80 vertices per
+// vertex, generated in batches that are discarded.
+PRIVATE void benchmark_random_walk(graph_t* graph, void*, totem_attr_t* attr) {
+  const uint64_t batch_walks = 1 << 16;
+  random_walk_config_t config;
+  config.walk_length = 80;
+  config.walks_per_vertex = 1;
+  config.weighted = false;
+  config.return_param = 1;
+  config.inout_param = 1;
+  config.seed = 1985;
+  assert(options->platform == PLATFORM_CPU);
+  random_walk_sampler_t* sampler = NULL;
+  CALL_SAFE(random_walk_sampler_initialize(graph, &config, &sampler));
+  vid_t* walks = NULL;
+  CALL_SAFE(totem_malloc(batch_walks * config.walk_length * sizeof(vid_t),
+                         TOTEM_MEM_HOST, reinterpret_cast<void**>(&walks)));
+  for (uint64_t first = 0; first < graph->vertex_count;
+       first += batch_walks) {
+    uint64_t count = graph->vertex_count - first;
+    if (count > batch_walks) count = batch_walks;
+    CALL_SAFE(random_walk_cpu(sampler, first, count, walks, NULL));
+  }
+  totem_free(walks, TOTEM_MEM_HOST);
+  CALL_SAFE(random_walk_sampler_finalize(sampler));
+}
+
 // The main execution loop of the benchmark.
 PRIVATE void benchmark_run() {
   assert(options);
 
   graph_t* graph = NULL;
   CALL_SAFE(graph_initialize(options->graph_file,
-                             (options->benchmark == BENCHMARK_SSSP),
+                             (options->benchmark == BENCHMARK_SSSP ||
+                              options->benchmark == BENCHMARK_PCORE ||
+                              options->benchmark == BENCHMARK_PCORE_SWEEP),
                              &graph));
   print_config(graph, options, BENCHMARKS[options->benchmark].name);
 
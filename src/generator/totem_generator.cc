@@ -6,9 +6,13 @@
  */
 
 // system includes
+#include <algorithm>
+#include <fstream>
 #include <map>
 #include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 
 // totem includes
 #include "totem_graph.h"
@@ -20,9 +24,45 @@ const int kMaxVertexScale = sizeof(vid_t) * 8;
 // The maximum log of the number of edges.
 const eid_t kMaxEdgeScale =  sizeof(eid_t) * 8;
 
+// The first word of a graph file in Totem's binary format.
+const uint32_t kBinaryMagicWord = 0x10102048;
+
+// The streams of random numbers, one per use, such that the numbers drawn for
+// different uses are independent.
+enum {
+  kPermutationStream = 1,
+  kRmatStream = 2,
+  kUniformStream = 3,
+  kWeightStream = 4
+};
+
+// The finalizer of SplitMix64.
+inline PRIVATE uint64_t generator_mix(uint64_t x) {
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+// Returns the draw-th number of a SplitMix64 sequence seeded by the stream and
+// an index. A parallel loop that draws the numbers of each iteration with the
+// iteration's index produces the same result for any number of threads.
+inline PRIVATE uint64_t generator_random(uint32_t stream, uint64_t index,
+                                         uint32_t draw) {
+  uint64_t seed = (((uint64_t)stream << 32) | GLOBAL_SEED) ^
+      generator_mix(index);
+  return generator_mix(seed + ((uint64_t)draw + 1) * 0x9e3779b97f4a7c15ULL);
+}
+
+// Same as generator_random, but returns a number in the range [0, 1).
+inline PRIVATE double generator_random_double(uint32_t stream, uint64_t index,
+                                              uint32_t draw) {
+  return (generator_random(stream, index, draw) >> 11) *
+      (1.0 / ((uint64_t)1 << 53));
+}
+
 PRIVATE error_t create_init(generator_config_t* config, vid_t* vertex_count,
-                            eid_t* edge_count, vid_t** src, vid_t** dst) {
-  assert(config->scale > 0 && config->edge_factor > 0 && src && dst);
+                            eid_t* edge_count) {
+  assert(config->scale > 0 && config->edge_factor > 0);
 
   CHK(config->scale < kMaxVertexScale, err_overflow);
   // A -2 is necessary to avoid overflow and reserve space for the last "fake"
@@ -32,17 +72,6 @@ PRIVATE error_t create_init(generator_config_t* config, vid_t* vertex_count,
   CHK(ceil(log2(config->edge_factor)) + config->scale <= kMaxEdgeScale,
       err_overflow);
   *edge_count = ((eid_t)config->edge_factor) * (*vertex_count);
-
-  // The src and dst arrays form the edge list that will be produced by the
-  // graph generation algorithm.
-  *src = reinterpret_cast<vid_t*>(calloc(*edge_count, sizeof(vid_t)));
-  *dst = reinterpret_cast<vid_t*>(calloc(*edge_count, sizeof(vid_t)));
-  assert(*src && *dst);
-
-  // Seed the random number generator, which will be used by the graph
-  // generation algorithm.
-  srand48(GLOBAL_SEED);
-
   return SUCCESS;
 
 err_overflow:
@@ -89,72 +118,293 @@ PRIVATE void load_graph(
   printf("done.\n"); fflush(stdout);
 }
 
-PRIVATE void edgelist_to_graph(
-    vid_t* src, vid_t* dst, vid_t vertex_count, eid_t edge_count, bool weighted,
-    bool directed, graph_t** graph_ret) {
-  // Third, compute the degree of each vertex.
-  eid_t* degree = reinterpret_cast<eid_t*>(calloc(vertex_count, sizeof(eid_t)));
+// Checks whether a graph file stores edge weights. A binary file has a flag in
+// its header, while the edges of a weighted text file have a third column.
+PRIVATE bool graph_file_weighted(const std::string& graph_path) {
+  FILE* fh = fopen(graph_path.c_str(), "rb");
+  if (fh == NULL) { return false; }
+  uint32_t header[3];
+  vid_t vertex_count;
+  eid_t edge_count;
+  bool flags[2];
+  bool binary = fread(header, sizeof(uint32_t), 3, fh) == 3 &&
+      fread(&vertex_count, sizeof(vid_t), 1, fh) == 1 &&
+      fread(&edge_count, sizeof(eid_t), 1, fh) == 1 &&
+      fread(flags, sizeof(bool), 2, fh) == 2;
+  fclose(fh);
+  // The header of a binary file starts with the magic word, followed by the
+  // sizes of the ids, the counts, the valued flag and the weighted flag.
+  if (binary && header[0] == kBinaryMagicWord) { return flags[1]; }
+
+  // Skip the metadata lines, and the vertex list if any, which has a line per
+  // vertex.
+  std::ifstream file(graph_path.c_str());
+  std::string line;
+  uint64_t vertex_lines = 0;
+  while (std::getline(file, line) && !line.empty() && line[0] == '#') {
+    std::replace(line.begin(), line.end(), ':', ' ');
+    std::istringstream stream(line.substr(1));
+    std::string keyword;
+    uint64_t count = 0;
+    std::string list;
+    stream >> keyword;
+    std::transform(keyword.begin(), keyword.end(), keyword.begin(), ::toupper);
+    if (keyword == "NODES" && (stream >> count >> list) &&
+        ::tolower(list[0]) == 'y') {
+      vertex_lines = count;
+    }
+  }
+  while (vertex_lines-- > 0 && std::getline(file, line)) {}
+  if (!file) { return false; }
+  std::istringstream stream(line);
+  std::string src, dst, weight;
+  return static_cast<bool>(stream >> src >> dst >> weight);
+}
+
+// Builds a graph from the edges of a source, which produces the end points of
+// an edge given its index. The source is invoked twice per edge, first to
+// compute the degrees and then to place the edges, hence a source that draws
+// the edges on demand avoids materializing an edge list. The vertices are
+// relabelled by map, if any. The neighbours of each vertex are sorted by id,
+// which makes the graph independent of the order in which the edges are
+// placed.
+template<typename EdgeSource>
+PRIVATE void edges_to_graph(
+    const EdgeSource& source, vid_t vertex_count, eid_t edge_count,
+    const vid_t* map, bool weighted, bool directed, graph_t** graph_ret) {
+  // First, compute the degree of each vertex.
+  eid_t* degree = reinterpret_cast<eid_t*>(calloc(vertex_count + 1,
+                                                  sizeof(eid_t)));
   assert(degree);
+  OMP(omp parallel for schedule(static))
   for (eid_t i = 0; i < edge_count; i++) {
-    degree[src[i]]++;
+    vid_t u, v;
+    source(i, &u, &v);
+    if (map) { u = map[u]; }
+    __sync_fetch_and_add(&degree[u], 1);
   }
 
-  // Fourth, setup the graph's data structure.
+  // Second, setup the graph's data structure.
   graph_t* graph;
   graph_allocate(vertex_count, edge_count, directed, weighted,
                  false /* No values associated with the vertices */ , &graph);
-  graph->vertices[0] = 0;
-  for (vid_t i = 1; i <= vertex_count; i++) {
-    graph->vertices[i] = graph->vertices[i - 1] + degree[i - 1];
-  }
-
+  eid_t total = graph_exclusive_scan(degree, vertex_count);
+  assert(total == edge_count);
+  degree[vertex_count] = total;
+  memcpy(graph->vertices, degree, (vertex_count + 1) * sizeof(eid_t));
+
+  // Third, place the edges, using the degree array as the next free position
+  // of each vertex.
+  OMP(omp parallel for schedule(static))
   for (eid_t i = 0; i < edge_count; i++) {
-    vid_t u = src[i];
-    vid_t v = dst[i];
-    eid_t pos = degree[u]--;
-    eid_t eid = graph->vertices[u] + pos - 1;
-    graph->edges[eid] = v;
-    if (weighted) {
-      // Assign random weights to the edges. For no particular reason, the
-      // weights are chosen from the range [0, vertex_count].
-      graph->weights[eid] = drand48() * vertex_count;
+    vid_t u, v;
+    source(i, &u, &v);
+    if (map) {
+      u = map[u];
+      v = map[v];
     }
+    graph->edges[__sync_fetch_and_add(&degree[u], 1)] = v;
   }
   free(degree);
+  graph_sort_nbrs(graph);
+
+  if (weighted) {
+    // Assign random weights to the edges. For no particular reason, the
+    // weights are chosen from the range [0, vertex_count].
+    OMP(omp parallel for schedule(static))
+    for (eid_t e = 0; e < edge_count; e++) {
+      graph->weights[e] = generator_random_double(kWeightStream, e, 0) *
+          vertex_count;
+    }
+  }
   *graph_ret = graph;
 }
 
-PRIVATE void graph_to_edgelist(const graph_t* graph, vid_t** src, vid_t** dst) {
-  *src = reinterpret_cast<vid_t*>(calloc(graph->edge_count, sizeof(vid_t)));
-  *dst = reinterpret_cast<vid_t*>(calloc(graph->edge_count, sizeof(vid_t)));
-  assert(*src && *dst);
-  vid_t index = 0;
+// Sorts the neighbours of each vertex by id, moving their weights along. As
+// the edges are grouped by source, this is a segmented sort of all the edges
+// by source and destination. If dedup is set, the repeated edges and the self
+// edges are removed as well, keeping the lowest weight of the repeated edges,
+// and the graph is replaced by a new one.
+PRIVATE void sort_nbrs(graph_t* graph, bool dedup, graph_t** sorted_graph) {
+  eid_t* degree = NULL;
+  if (dedup) {
+    degree = reinterpret_cast<eid_t*>(calloc(graph->vertex_count + 1,
+                                             sizeof(eid_t)));
+    assert(degree);
+  }
+  OMP(omp parallel)
+  {
+    std::vector<std::pair<vid_t, weight_t> > nbrs;
+    OMP(omp for schedule(guided))
+    for (vid_t v = 0; v < graph->vertex_count; v++) {
+      vid_t* edges = &graph->edges[graph->vertices[v]];
+      weight_t* weights = graph->weighted ?
+          &graph->weights[graph->vertices[v]] : NULL;
+      eid_t count = graph->vertices[v + 1] - graph->vertices[v];
+      if (weights) {
+        nbrs.resize(count);
+        for (eid_t i = 0; i < count; i++) {
+          nbrs[i] = std::make_pair(edges[i], weights[i]);
+        }
+        std::sort(nbrs.begin(), nbrs.end());
+        for (eid_t i = 0; i < count; i++) {
+          edges[i] = nbrs[i].first;
+          weights[i] = nbrs[i].second;
+        }
+      } else {
+        std::sort(edges, edges + count);
+      }
+      if (!dedup) { continue; }
+
+      // Compact the remaining neighbours at the beginning of the list.
+      eid_t kept = 0;
+      for (eid_t i = 0; i < count; i++) {
+        if (edges[i] == v || (kept > 0 && edges[kept - 1] == edges[i])) {
+          continue;
+        }
+        edges[kept] = edges[i];
+        if (weights) { weights[kept] = weights[i]; }
+        kept++;
+      }
+      degree[v] = kept;
+    }
+  }
+  if (!dedup) {
+    *sorted_graph = graph;
+    return;
+  }
+
+  eid_t edge_count = graph_exclusive_scan(degree, graph->vertex_count);
+  degree[graph->vertex_count] = edge_count;
+  graph_t* result = NULL;
+  graph_allocate(graph->vertex_count, edge_count, graph->directed,
+                 graph->weighted, graph->valued, &result);
+  memcpy(result->vertices, degree, (graph->vertex_count + 1) * sizeof(eid_t));
+  if (graph->valued) {
+    memcpy(result->values, graph->values,
+           graph->vertex_count * sizeof(weight_t));
+  }
+  OMP(omp parallel for schedule(guided))
+  for (vid_t v = 0; v < graph->vertex_count; v++) {
+    eid_t count = result->vertices[v + 1] - result->vertices[v];
+    memcpy(&result->edges[result->vertices[v]],
+           &graph->edges[graph->vertices[v]], count * sizeof(vid_t));
+    if (graph->weighted) {
+      memcpy(&result->weights[result->vertices[v]],
+             &graph->weights[graph->vertices[v]], count * sizeof(weight_t));
+    }
+  }
+  printf("Removed %llu repeated and self edges.\n",
+         (uint64_t)(graph->edge_count - edge_count));
+  free(degree);
+  graph_finalize(graph);
+  *sorted_graph = result;
+}
+
+// Creates a new graph in which each vertex v of the given one is renamed to
+// map[v], along with its value and the weights of its edges. The given graph
+// is de-allocated.
+PRIVATE void relabel_graph(graph_t* graph, const vid_t* map,
+                           graph_t** relabelled_graph) {
+  eid_t* offsets = reinterpret_cast<eid_t*>(calloc(graph->vertex_count + 1,
+                                                   sizeof(eid_t)));
+  assert(offsets);
+  OMP(omp parallel for schedule(static))
   for (vid_t v = 0; v < graph->vertex_count; v++) {
-    for (eid_t e = graph->vertices[v]; e < graph->vertices[v+1]; e++) {
-      (*src)[index] = v;
-      (*dst)[index] = graph->edges[e];
-      index++;
+    offsets[map[v]] = graph->vertices[v + 1] - graph->vertices[v];
+  }
+  offsets[graph->vertex_count] =
+      graph_exclusive_scan(offsets, graph->vertex_count);
+
+  graph_t* result = NULL;
+  graph_allocate(graph->vertex_count, graph->edge_count, graph->directed,
+                 graph->weighted, graph->valued, &result);
+  memcpy(result->vertices, offsets, (graph->vertex_count + 1) * sizeof(eid_t));
+  free(offsets);
+  OMP(omp parallel for schedule(guided))
+  for (vid_t v = 0; v < graph->vertex_count; v++) {
+    eid_t index = result->vertices[map[v]];
+    if (graph->valued) { result->values[map[v]] = graph->values[v]; }
+    for (eid_t e = graph->vertices[v]; e < graph->vertices[v + 1];
+         e++, index++) {
+      result->edges[index] = map[graph->edges[e]];
+      if (graph->weighted) { result->weights[index] = graph->weights[e]; }
     }
   }
+  graph_finalize(graph);
+  sort_nbrs(result, false /* Keep all the edges */, relabelled_graph);
 }
 
-// Permutates the vertices so that one can't know the characteristics of the
-// vertex from its vertex id.
-PRIVATE void permute_edgelist(
-    vid_t* src, vid_t* dst, vid_t vertex_count, eid_t edge_count) {
-  vid_t* p = reinterpret_cast<vid_t*>(calloc(vertex_count, sizeof(vid_t)));
-  for (vid_t i = 0; i < vertex_count; i++) { p[i] = i; }
-  for (vid_t i = 0; i < vertex_count; i++) {
-    vid_t j = vertex_count * drand48();
-    vid_t temp = p[j];
-    p[j] = p[i];
-    p[i] = temp;
+// Creates a new undirected graph that has for each edge (u, v) of the given
+// one both (u, v) and (v, u), with the weight of the edge. The neighbours of a
+// vertex are its out-neighbours followed by its in-neighbours, which are the
+// neighbours in the transpose of the given graph, before they are sorted. The
+// given graph is de-allocated.
+PRIVATE void symmetrize_graph(graph_t* graph, graph_t** undirected_graph) {
+  graph_t* transpose = NULL;
+  CALL_SAFE(graph_create_transpose(graph, &transpose));
+  eid_t* offsets = reinterpret_cast<eid_t*>(calloc(graph->vertex_count + 1,
+                                                   sizeof(eid_t)));
+  assert(offsets);
+  OMP(omp parallel for schedule(static))
+  for (vid_t v = 0; v < graph->vertex_count; v++) {
+    offsets[v] = (graph->vertices[v + 1] - graph->vertices[v]) +
+        (transpose->vertices[v + 1] - transpose->vertices[v]);
   }
-  for (eid_t i = 0; i < edge_count; i++) {
-    src[i] = p[src[i]];
-    dst[i] = p[dst[i]];
+  offsets[graph->vertex_count] =
+      graph_exclusive_scan(offsets, graph->vertex_count);
+
+  graph_t* result = NULL;
+  graph_allocate(graph->vertex_count, graph->edge_count * 2,
+                 false /* Undirected graph */, graph->weighted, graph->valued,
+                 &result);
+  memcpy(result->vertices, offsets, (graph->vertex_count + 1) * sizeof(eid_t));
+  free(offsets);
+  if (graph->valued) {
+    memcpy(result->values, graph->values,
+           graph->vertex_count * sizeof(weight_t));
+  }
+  OMP(omp parallel for schedule(guided))
+  for (vid_t v = 0; v < graph->vertex_count; v++) {
+    eid_t index = result->vertices[v];
+    const graph_t* sources[] = {graph, transpose};
+    for (int i = 0; i < 2; i++) {
+      const graph_t* source = sources[i];
+      for (eid_t e = source->vertices[v]; e < source->vertices[v + 1];
+           e++, index++) {
+        result->edges[index] = source->edges[e];
+        if (graph->weighted) { result->weights[index] = source->weights[e]; }
+      }
+    }
   }
-  free(p);
+  graph_finalize(transpose);
+  graph_finalize(graph);
+  sort_nbrs(result, false /* Keep all the edges */, undirected_graph);
+}
+
+// Creates a random permutation of the vertex ids, by sorting the vertices by a
+// random key drawn for each of them.
+PRIVATE void get_permutation_map(vid_t vertex_count, vid_t** map) {
+  typedef struct { uint64_t key; vid_t id; } vertex_key_t;
+  vertex_key_t* keys = reinterpret_cast<vertex_key_t*>(calloc(
+      vertex_count, sizeof(vertex_key_t)));
+  assert(keys);
+  OMP(omp parallel for schedule(static))
+  for (vid_t v = 0; v < vertex_count; v++) {
+    keys[v].key = generator_random(kPermutationStream, v, 0);
+    keys[v].id = v;
+  }
+  tbb::parallel_sort(keys, keys + vertex_count,
+                     [] (const vertex_key_t& k1, const vertex_key_t& k2) {
+                       return k1.key < k2.key ||
+                           (k1.key == k2.key && k1.id < k2.id);
+                     });
+
+  *map = reinterpret_cast<vid_t*>(calloc(vertex_count, sizeof(vid_t)));
+  assert(*map);
+  OMP(omp parallel for schedule(static))
+  for (vid_t v = 0; v < vertex_count; v++) { (*map)[keys[v].id] = v; }
+  free(keys);
 }
 
 // Checks that the number of edges is correct.
@@ -374,96 +624,116 @@ PRIVATE void count_singletons_and_leafs(
   free(mask);
 }
 
-// The implementation of the following RMAT generation algorithm is based on the
-// one available in the SNAP library.
-PRIVATE error_t create_rmat_handler(
-    generator_config_t* config, graph_t** graph_ret) {
-  const double kA = 0.57;
-  const double kB = 0.19;
-  const double kC = 0.19;
-  const double kD = 1 - (kA + kB + kC);
-
-  vid_t vertex_count = 0;
-  eid_t edge_count = 0;
-  vid_t* src = NULL;
-  vid_t* dst = NULL;
-  if (create_init(config, &vertex_count, &edge_count, &src, &dst) != SUCCESS) {
-    return FAILURE;
-  }
-
-  printf("Generating an RMAT graph with %llu vertices and %llu edges.\n",
-         (uint64_t)vertex_count, (uint64_t)edge_count);
-
-  // First, generate the edges.
-  for (eid_t i = 0; i < edge_count; i++) {
-    vid_t u = 1;
-    vid_t v = 1;
-    vid_t step = vertex_count / 2;
-    double av = kA;
-    double bv = kB;
-    double cv = kC;
-    double dv = kD;
-    double p = drand48();
-    if (p < av) {
-    } else if (p < (av + bv)) {
-      v += step;
-    } else if (p < (av + bv + cv)) {
-      u += step;
-    } else {
-      v += step;
-      u += step;
-    }
-
-    for (int j = 1; j < config->scale; j++) {
-      step = step / 2;
-      double var = 0.1;
-      av *= 0.95 + var * drand48();
-      bv *= 0.95 + var * drand48();
-      cv *= 0.95 + var * drand48();
-      dv *= 0.95 + var * drand48();
-
-      double s = av + bv + cv + dv;
-      av = av / s;
-      bv = bv / s;
-      cv = cv / s;
-      dv = dv / s;
-
-      // Choose partition.
-      p = drand48();
+// Draws the edges of an RMAT graph. The implementation of the RMAT generation
+// algorithm is based on the one available in the SNAP library. The numbers of
+// each edge are drawn from its own sequence, and a self edge is redrawn from
+// the rest of the sequence.
+class RmatEdgeSource {
+ public:
+  RmatEdgeSource(int scale, vid_t vertex_count)
+      : scale_(scale), vertex_count_(vertex_count) {}
+  void operator()(eid_t index, vid_t* src, vid_t* dst) const {
+    const double kA = 0.57;
+    const double kB = 0.19;
+    const double kC = 0.19;
+    const double kD = 1 - (kA + kB + kC);
+    uint32_t draw = 0;
+    vid_t u, v;
+    do {
+      u = 1;
+      v = 1;
+      vid_t step = vertex_count_ / 2;
+      double av = kA;
+      double bv = kB;
+      double cv = kC;
+      double dv = kD;
+      double p = generator_random_double(kRmatStream, index, draw++);
       if (p < av) {
-        // Do nothing.
       } else if (p < (av + bv)) {
         v += step;
-      } else if (p < (av+bv+cv)) {
+      } else if (p < (av + bv + cv)) {
         u += step;
       } else {
         v += step;
         u += step;
       }
-    }
-    src[i] = u - 1;
-    dst[i] = v - 1;
 
-    // Avoid self edges.
-    if (src[i] == dst[i]) { i = i - 1; continue; }
+      for (int j = 1; j < scale_; j++) {
+        step = step / 2;
+        double var = 0.1;
+        av *= 0.95 + var * generator_random_double(kRmatStream, index, draw++);
+        bv *= 0.95 + var * generator_random_double(kRmatStream, index, draw++);
+        cv *= 0.95 + var * generator_random_double(kRmatStream, index, draw++);
+        dv *= 0.95 + var * generator_random_double(kRmatStream, index, draw++);
+
+        double s = av + bv + cv + dv;
+        av = av / s;
+        bv = bv / s;
+        cv = cv / s;
+        dv = dv / s;
+
+        // Choose partition.
+        p = generator_random_double(kRmatStream, index, draw++);
+        if (p < av) {
+          // Do nothing.
+        } else if (p < (av + bv)) {
+          v += step;
+        } else if (p < (av+bv+cv)) {
+          u += step;
+        } else {
+          v += step;
+          u += step;
+        }
+      }
+    } while (u == v);  // Avoid self edges.
+    *src = u - 1;
+    *dst = v - 1;
+  }
+ private:
+  int   scale_;
+  vid_t vertex_count_;
+};
+
+// Draws the edges of a uniform graph. Like RmatEdgeSource, a self edge is
+// redrawn from the rest of the sequence of the edge.
+class UniformEdgeSource {
+ public:
+  explicit UniformEdgeSource(vid_t vertex_count)
+      : vertex_count_(vertex_count) {}
+  void operator()(eid_t index, vid_t* src, vid_t* dst) const {
+    uint32_t draw = 0;
+    do {
+      *src = generator_random(kUniformStream, index, draw++) % vertex_count_;
+      *dst = generator_random(kUniformStream, index, draw++) % vertex_count_;
+    } while (*src == *dst);
+  }
+ private:
+  vid_t vertex_count_;
+};
 
-    // Print out progress so far.
-    if (i % (1024 * 1024) == 0) {
-      printf("%dM edges created\n", i / (1024*1024));
-      fflush(stdout);
-    }
+// The edges are drawn on demand while the graph is built, hence the edge list
+// is never materialized, and the graph is the same for any number of threads.
+PRIVATE error_t create_rmat_handler(
+    generator_config_t* config, graph_t** graph_ret) {
+  vid_t vertex_count = 0;
+  eid_t edge_count = 0;
+  if (create_init(config, &vertex_count, &edge_count) != SUCCESS) {
+    return FAILURE;
   }
 
-  // Second, permutate the vertices so that one can't know what are the
-  // high-degree edges from the vertex id.
-  permute_edgelist(src, dst, vertex_count, edge_count);
+  printf("Generating an RMAT graph with %llu vertices and %llu edges.\n",
+         (uint64_t)vertex_count, (uint64_t)edge_count);
 
-  // Third, create the totem graph.
-  edgelist_to_graph(src, dst, vertex_count, edge_count, config->weighted,
-                    true /* Directed graph */, graph_ret);
+  // Permutate the vertices so that one can't know what are the high-degree
+  // edges from the vertex id.
+  vid_t* map = NULL;
+  get_permutation_map(vertex_count, &map);
 
-  free(src);
-  free(dst);
+  edges_to_graph(RmatEdgeSource(config->scale, vertex_count), vertex_count,
+                 edge_count, map, config->weighted, true /* Directed graph */,
+                 graph_ret);
+
+  free(map);
   return SUCCESS;
 }
 
@@ -471,26 +741,16 @@ PRIVATE error_t create_uniform_handler(
     generator_config_t* config, graph_t** graph_ret) {
   vid_t vertex_count = 0;
   eid_t edge_count = 0;
-  vid_t* src = NULL;
-  vid_t* dst = NULL;
-  if (create_init(config, &vertex_count, &edge_count, &src, &dst) != SUCCESS) {
+  if (create_init(config, &vertex_count, &edge_count) != SUCCESS) {
     return FAILURE;
   }
 
   printf("Generating a uniform graph with %llu vertices and %llu edges.\n",
          (uint64_t)vertex_count, (uint64_t)edge_count);
 
-  for (eid_t i = 0; i < edge_count; i++) {
-    src[i] = ((vid_t)mrand48()) % vertex_count;
-    dst[i] = ((vid_t)mrand48()) % vertex_count;
-    if (src[i] == dst[i]) { i = i - 1; continue; }
-  }
-
-  edgelist_to_graph(src, dst, vertex_count, edge_count, config->weighted,
-                    true /* Directed graph */, graph_ret);
-
-  free(src);
-  free(dst);
+  edges_to_graph(UniformEdgeSource(vertex_count), vertex_count, edge_count,
+                 NULL /* Keep the vertex ids */, config->weighted,
+                 true /* Directed graph */, graph_ret);
   return SUCCESS;
 }
 
@@ -572,85 +832,29 @@ PRIVATE void analyze_degree_distribution_handler(generator_config_t* config) {
 
 // Creates a new graph from an existing one after permuting the ids of its
 // vertices.
-// TODO(abdullah): Take weights into consideration.
 PRIVATE error_t alter_permute_handler(
     generator_config_t* config, graph_t* graph, graph_t** permuted_graph) {
-  vid_t* src = NULL;
-  vid_t* dst = NULL;
-  graph_to_edgelist(graph, &src, &dst);
-  vid_t vertex_count = graph->vertex_count;
-  eid_t edge_count = graph->edge_count;
-  bool directed = graph->directed;
-  graph_finalize(graph);
-  permute_edgelist(src, dst, vertex_count, edge_count);
-  edgelist_to_graph(src, dst, vertex_count, edge_count,
-                    false /* Ignore weights */, directed, permuted_graph);
-
-  free(src);
-  free(dst);
+  vid_t* map = NULL;
+  get_permutation_map(graph->vertex_count, &map);
+  relabel_graph(graph, map, permuted_graph);
+  free(map);
   return SUCCESS;
 }
 
-PRIVATE void get_reverse_edgelist(
-    const graph_t* graph, vid_t** src, vid_t** dst) {
-  graph_to_edgelist(graph, src, dst);
-  for (eid_t eid = 0; eid < graph->edge_count; eid++) {
-    vid_t tmp = (*src)[eid];
-    (*src)[eid] = (*dst)[eid];
-    (*dst)[eid] = tmp;
-  }
-}
-
 // Creates a new graph from an existing one after reversing the direction of
 // each edge.
-// TODO(abdullah): Take weights into consideration.
 PRIVATE error_t alter_reverse_handler(
     generator_config_t* config, graph_t* graph, graph_t** reversed_graph) {
   if (!graph->directed) {
     printf("The graph is labelled as undirected, nothing to do.\n");
     return FAILURE;
   }
-
-  vid_t* src = NULL;
-  vid_t* dst = NULL;
-  get_reverse_edgelist(graph, &src, &dst);
-
-  vid_t vertex_count = graph->vertex_count;
-  eid_t edge_count = graph->edge_count;
+  CALL_SAFE(graph_create_transpose(graph, reversed_graph));
   graph_finalize(graph);
-  edgelist_to_graph(src, dst, vertex_count, edge_count,
-                    false /* Ignore weights */, true /* Directed graph */,
-                    reversed_graph);
-
-  free(src);
-  free(dst);
   return SUCCESS;
 }
 
-// TODO(abdullah): Take weights into consideration.
-PRIVATE void get_undirected_edgelist(
-    const graph_t* graph, vid_t** src, vid_t** dst) {
-  *src = reinterpret_cast<vid_t*>(
-      calloc((graph->edge_count * 2), sizeof(vid_t)));
-  *dst = reinterpret_cast<vid_t*>(
-      calloc((graph->edge_count * 2), sizeof(vid_t)));
-  assert(*src && *dst);
-
-  eid_t i = 0;
-  for (vid_t v = 0; v < graph->vertex_count; v++) {
-    for (eid_t e = graph->vertices[v];
-         e < graph->vertices[v+1]; e++) {
-      (*src)[i] = v;
-      (*dst)[i] = graph->edges[e];
-      (*src)[i + 1] = graph->edges[e];
-      (*dst)[i + 1] = v;
-      i += 2;
-    }
-  }
-}
-
 // Creates a new undirected graph from an existing directed one.
-// TODO(abdullah): Take weights into consideration.
 PRIVATE error_t alter_undirected_handler(
     generator_config_t* config, graph_t* graph, graph_t** undirected_graph) {
   if (!graph->directed) {
@@ -663,19 +867,7 @@ PRIVATE error_t alter_undirected_handler(
     return FAILURE;
   }
 
-  vid_t* src = NULL;
-  vid_t* dst = NULL;
-  get_undirected_edgelist(graph, &src, &dst);
-
-  vid_t vertex_count = graph->vertex_count;
-  eid_t edge_count = graph->edge_count * 2;
-  graph_finalize(graph);
-  edgelist_to_graph(src, dst, vertex_count, edge_count,
-                    false /* Ignore weights */, false /* Undirected graph */,
-                    undirected_graph);
-
-  free(src);
-  free(dst);
+  symmetrize_graph(graph, undirected_graph);
   return SUCCESS;
 }
 
@@ -705,45 +897,14 @@ PRIVATE void get_sorted_vertices_map(const graph_t* graph, vid_t** map) {
   free(degree);
 }
 
-PRIVATE void get_sorted_vertices_edgelist(
-    const graph_t* graph, vid_t** src, vid_t** dst) {
-  // Create a map of old to new vertex id.
-  vid_t* map;
-  get_sorted_vertices_map(graph, &map);
-
-  *src = reinterpret_cast<vid_t*>(calloc(graph->edge_count, sizeof(vid_t)));
-  *dst = reinterpret_cast<vid_t*>(calloc(graph->edge_count, sizeof(vid_t)));
-  eid_t index = 0;
-  for (vid_t v = 0; v < graph->vertex_count; v++) {
-    for (eid_t e = graph->vertices[v]; e < graph->vertices[v + 1]; e++) {
-      (*src)[index] = map[v];
-      (*dst)[index] = map[graph->edges[e]];
-      index++;
-    }
-  }
-  free(map);
-}
-
 // Creates a new graph from an existing one after permuting the vertex ids such
 // that they are sorted by degree.
-// TODO(abdullah): Take weights into consideration.
 PRIVATE error_t alter_sort_vertices_handler(
     generator_config_t* config, graph_t* graph, graph_t** sorted_graph) {
-
-  // Prepare an edge list of the graph using the new ids.
-  vid_t* src = NULL;
-  vid_t* dst = NULL;
-  get_sorted_vertices_edgelist(graph, &src, &dst);
-
-  vid_t vertex_count = graph->vertex_count;
-  eid_t edge_count = graph->edge_count;
-  bool directed = graph->directed;
-  graph_finalize(graph);
-  edgelist_to_graph(src, dst, vertex_count, edge_count,
-                    false /* Ignore weights */, directed, sorted_graph);
-
-  free(src);
-  free(dst);
+  vid_t* map = NULL;
+  get_sorted_vertices_map(graph, &map);
+  relabel_graph(graph, map, sorted_graph);
+  free(map);
   return SUCCESS;
 }
 
@@ -753,40 +914,57 @@ PRIVATE error_t alter_binary_handler(
   return SUCCESS;
 }
 
-// TODO(abdullah): Take weights into consideration.
 PRIVATE error_t alter_remove_singletons_handler(
     generator_config_t* config, graph_t* graph, graph_t** graph_no_singletons) {
-  error_t err = graph_remove_singletons(graph, graph_no_singletons);
+  if (graph_remove_singletons(graph, graph_no_singletons) != SUCCESS) {
+    return FAILURE;
+  }
   graph_finalize(graph);
-  return err;
+  return SUCCESS;
 }
 
 PRIVATE error_t alter_sort_neighbours_handler(
     generator_config_t* config, graph_t* graph, graph_t** sorted_graph) {
   // TODO(scott): Add an option to the generator to allow descending order here.
-  graph_sort_nbrs(graph, false /* Sort in ascending order. */);
-  *sorted_graph = graph;
+  sort_nbrs(graph, false /* Keep all the edges */, sorted_graph);
+  return SUCCESS;
+}
+
+// Creates a new graph from an existing one after removing the repeated edges
+// and the self edges.
+PRIVATE error_t alter_remove_duplicates_handler(
+    generator_config_t* config, graph_t* graph, graph_t** deduped_graph) {
+  sort_nbrs(graph, true /* Remove repeated and self edges */, deduped_graph);
   return SUCCESS;
 }
 
 PRIVATE error_t alter_random_weights_handler(
     generator_config_t* config, graph_t* graph, graph_t** weighted_graph) {
-  if (graph->weighted) { return FAILURE; }
+  if (graph->weighted) {
+    printf("The graph is already weighted, nothing to do.\n");
+    return FAILURE;
+  }
   graph->weighted = true;
   graph->weights =
       reinterpret_cast<weight_t*>(malloc(graph->edge_count * sizeof(weight_t)));
+  OMP(omp parallel for schedule(static))
   for (eid_t e = 0; e < graph->edge_count; e++) {
     // weights are chosen from the range [0, vertex_count].
-    graph->weights[e] = drand48() * graph->vertex_count;
+    graph->weights[e] = generator_random_double(kWeightStream, e, 0) *
+        graph->vertex_count;
   }
   *weighted_graph = graph;
   return SUCCESS;
 }
 
-// TODO(abdullah): Take weights into consideration.
+// The sub-commands of an invocation are applied in order to the graph, which
+// is loaded and stored once. A handler takes over the graph it is given if it
+// succeeds, and leaves it intact otherwise. The edge weights are loaded, and
+// carried through the sub-commands, if the graph file has them.
 void alter_handler(generator_config_t* config) {
   graph_t* graph;
-  load_graph(config->input_graph_file, false /* Ignore weights */ , &graph);
+  load_graph(config->input_graph_file,
+             graph_file_weighted(config->input_graph_file), &graph);
 
   // Defines the signature of the alert sub-commands handlers.
   typedef error_t(*alter_sub_command_handler_t)
@@ -796,6 +974,7 @@ void alter_handler(generator_config_t* config) {
   const std::map<std::string, alter_sub_command_handler_t> dispatch_map = {
     {kBinarySubCommand, alter_binary_handler},
     {kPermuteSubCommand, alter_permute_handler},
+    {kRemoveDuplicatesSubCommand, alter_remove_duplicates_handler},
     {kRemoveSingletonsSubCommand, alter_remove_singletons_handler},
     {kReverseSubCommand, alter_reverse_handler},
     {kSortNeighboursSubCommand, alter_sort_neighbours_handler},
@@ -809,6 +988,7 @@ void alter_handler(generator_config_t* config) {
   const std::map<std::string, std::string> extensions_map = {
     {kBinarySubCommand, ".tbin"},
     {kPermuteSubCommand, ".permuted"},
+    {kRemoveDuplicatesSubCommand, ".noDuplicates"},
     {kRemoveSingletonsSubCommand, ".noSingletons"},
     {kReverseSubCommand, ".reversed"},
     {kSortNeighboursSubCommand, ".sortedNbrs"},
@@ -817,16 +997,23 @@ void alter_handler(generator_config_t* config) {
     {kRandomWeightsSubCommand, ".randWeights"},
   };
 
-  assert(dispatch_map.find(config->sub_command) != dispatch_map.end());
-  const alter_sub_command_handler_t handler =
-      dispatch_map.find(config->sub_command)->second;
-
-  printf("Invoking %s sub command handler.\n", config->sub_command.c_str());
-  graph_t* altered_graph = NULL;
-  if (handler(config, graph, &altered_graph) == SUCCESS) {
-    const std::string& ext = extensions_map.find(config->sub_command)->second;
-    write_graph_with_extension(config, altered_graph, ext);
+  std::string ext;
+  for (const auto& sub_command : config->sub_commands) {
+    assert(dispatch_map.find(sub_command) != dispatch_map.end());
+    const alter_sub_command_handler_t handler =
+        dispatch_map.find(sub_command)->second;
+
+    printf("Invoking %s sub command handler.\n", sub_command.c_str());
+    graph_t* altered_graph = NULL;
+    if (handler(config, graph, &altered_graph) != SUCCESS) {
+      printf("The %s sub command failed!\n", sub_command.c_str());
+      graph_finalize(graph);
+      exit(EXIT_FAILURE);
+    }
+    graph = altered_graph;
+    ext.append(extensions_map.find(sub_command)->second);
   }
+  write_graph_with_extension(config, graph, ext);
 }
 
 void create_handler(generator_config_t* config) {
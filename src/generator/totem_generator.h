@@ -10,6 +10,7 @@
 
 // system includes
 #include <string>
+#include <vector>
 
 // totem includes
 #include "totem_comdef.h"
@@ -26,6 +27,8 @@ typedef struct generator_config_s {
   bool  weighted;
   bool  check_direction;
   bool  command_help;
+  // The sub-commands of an ALTER invocation, which may chain several of them.
+  std::vector<std::string> sub_commands;
 } generator_config_t;
 
 // Declarations of the constants that defines the set of commands and
@@ -40,6 +43,7 @@ extern const char* kDegreeDistributionSubCommand;
 extern const char* kAlterCommand;
 extern const char* kBinarySubCommand;
 extern const char* kPermuteSubCommand;
+extern const char* kRemoveDuplicatesSubCommand;
 extern const char* kRemoveSingletonsSubCommand;
 extern const char* kReverseSubCommand;
 extern const char* kSortNeighboursSubCommand;
@@ -26,6 +26,7 @@ int main(int argc, char** argv) {
     false,  // Weighted.
     false,  // Do not verify direction.
     false,  // Execute the command rather than showing it's help message.
+    {},     // Sub commands, set by the command line parser.
   };
   parse_command_line(argc, argv, &config);
 
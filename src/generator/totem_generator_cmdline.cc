@@ -8,6 +8,7 @@
 
 // system includes
 #include <set>
+#include <sstream>
 #include <string>
 #include <map>
 
@@ -25,6 +26,7 @@ const char* kDegreeDistributionSubCommand = "DEGREE-DIST";
 const char* kAlterCommand = "ALTER";
 const char* kBinarySubCommand = "BINARY";
 const char* kPermuteSubCommand = "PERMUTE";
+const char* kRemoveDuplicatesSubCommand = "REMOVE-DUPLICATES";
 const char* kReverseSubCommand = "REVERSE";
 const char* kRemoveSingletonsSubCommand = "REMOVE-SINGLETONS";
 const char* kSortNeighboursSubCommand = "SORT-NBRS";
@@ -41,9 +43,9 @@ const char* kUniformSubCommand = "UNIFORM";
 PRIVATE const std::map<std::string, std::set<std::string> > commands = {
   {kAnalyzeCommand, {kSummarySubCommand, kDegreeDistributionSubCommand}},
   {kAlterCommand, {kBinarySubCommand, kPermuteSubCommand, kReverseSubCommand,
-                   kRemoveSingletonsSubCommand, kSortNeighboursSubCommand,
-                   kSortVerticesSubCommand, kUndirectedSubCommand,
-                   kRandomWeightsSubCommand}},
+                   kRemoveDuplicatesSubCommand, kRemoveSingletonsSubCommand,
+                   kSortNeighboursSubCommand, kSortVerticesSubCommand,
+                   kUndirectedSubCommand, kRandomWeightsSubCommand}},
   {kCreateCommand, {kRmatSubCommand, kUniformSubCommand}}
 };
 
@@ -72,6 +74,12 @@ const std::map<std::string, std::string> help_map = {
     "\tGenerates a new graph from the given one after randomly permuting the\n"
     "\tids of its vertices.\n"
   },
+  {
+    kRemoveDuplicatesSubCommand,
+    "\tGenerates a new graph from the given one after removing the repeated\n"
+    "\tedges and the self edges. The neighbours of each vertex are sorted by\n"
+    "\tid.\n"
+  },
   {
     kRemoveSingletonsSubCommand,
     "\tGenerates a new graph from the given one after removing all vertices\n"
@@ -130,7 +138,7 @@ PRIVATE void display_help(char* exe_name, int exit_err,
          "\nCommands:\n"
          "ANALYZE {%s | %s} <graph file>\n"
          "ALTER {%s | %s | %s | %s | %s |\n"
-         "       %s | %s | %s} <graph file>\n"
+         "       %s | %s | %s | %s}[,...] <graph file>\n"
          "CREATE {%s | %s} [options] <graph file>\n"
          "\nOptions (the applicable command is indicated between <>):\n"
          "  -sNUM   <CREATE> Scale of the number of vertices (default 20)\n"
@@ -147,13 +155,19 @@ PRIVATE void display_help(char* exe_name, int exit_err,
          "          help message.\n"
          "Note 2: ALTER and ANALYZE DEGREE-DIST commands require write access\n"
          "        to the directory of the source graph if the -o option is\n"
-         "        not set.\n",
+         "        not set.\n"
+         "Note 3: Several ALTER sub-commands can be chained by separating them\n"
+         "        with commas, e.g., \"ALTER %s,%s <graph file>\". They\n"
+         "        are applied in order, while the graph is loaded and stored\n"
+         "        once.\n",
          exe_basename.c_str(),
          kSummarySubCommand, kDegreeDistributionSubCommand, kBinarySubCommand,
-         kPermuteSubCommand, kRemoveSingletonsSubCommand, kReverseSubCommand,
+         kPermuteSubCommand, kRemoveDuplicatesSubCommand,
+         kRemoveSingletonsSubCommand, kReverseSubCommand,
          kSortNeighboursSubCommand, kSortVerticesSubCommand,
          kUndirectedSubCommand, kRandomWeightsSubCommand, kRmatSubCommand,
-         kUniformSubCommand, exe_basename.c_str());
+         kUniformSubCommand, exe_basename.c_str(), kUndirectedSubCommand,
+         kRemoveDuplicatesSubCommand);
 
   if (exit_err == 0) {
     printf("\n\nDetailed descriptions of commands:\n");
@@ -192,7 +206,19 @@ PRIVATE void parse_command_line_arguments(int argc, char** argv,
     config->sub_command.assign(argv[optind++]);
     std::transform(config->sub_command.begin(), config->sub_command.end(),
                    config->sub_command.begin(), ::toupper);
-    if (sub_commands.find(config->sub_command) == sub_commands.end()) {
+
+    // Only the ALTER sub-commands can be chained.
+    std::istringstream stream(config->sub_command);
+    std::string sub_command;
+    while (std::getline(stream, sub_command, ',')) {
+      if (sub_commands.find(sub_command) == sub_commands.end()) {
+        display_help(argv[0], -1, "Invalid sub-command!\n");
+      }
+      config->sub_commands.push_back(sub_command);
+    }
+    if (config->sub_commands.empty() ||
+        (config->sub_commands.size() > 1 &&
+         config->command != kAlterCommand)) {
       display_help(argv[0], -1, "Invalid sub-command!\n");
     }
   }
@@ -250,12 +276,14 @@ void parse_command_line(int argc, char** argv, generator_config_t* config) {
   parse_command_line_options(argc, argv, config);
   parse_command_line_arguments(argc, argv, config);
   if (config->command_help) {
-    printf("%s %s\n", config->command.c_str(),
-           config->sub_command.c_str());
-    std::string help_msg = config->sub_command.empty() ?
-        help_map.find(config->command)->second :
-        help_map.find(config->sub_command)->second;
-    printf("%s", help_msg.c_str());
+    if (config->sub_commands.empty()) {
+      printf("%s\n%s", config->command.c_str(),
+             help_map.find(config->command)->second.c_str());
+    }
+    for (const auto& sub_command : config->sub_commands) {
+      printf("%s %s\n%s", config->command.c_str(), sub_command.c_str(),
+             help_map.find(sub_command)->second.c_str());
+    }
     exit(0);
   }
 }
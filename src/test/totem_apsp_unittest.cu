@@ -183,9 +183,109 @@ TEST_P(APSPTest, CompleteDiffWeight) {
   }
 }
 
+// Tests APSP on a graph with four disconnected chains: [0-9], [10-19],
+// [20-30] and [31-39].
+TEST_P(APSPTest, DisconnectedChains) {
+  graph_initialize(DATA_FOLDER("chain_4_comp_40_nodes.totem"), true, &graph);
+
+  EXPECT_EQ(SUCCESS, apsp(graph, &distances));
+  EXPECT_FALSE(NULL == distances);
+  vid_t chain[40];
+  for (vid_t v = 0; v < 40; v++) {
+    chain[v] = (v < 10) ? 0 : (v < 20) ? 1 : (v < 31) ? 2 : 3;
+  }
+  for (vid_t src = 0; src < graph->vertex_count; src++) {
+    weight_t* base = &distances[src * graph->vertex_count];
+    for (vid_t dest = 0; dest < graph->vertex_count; dest++) {
+      if (chain[src] == chain[dest]) {
+        EXPECT_EQ((weight_t)(src > dest ? src - dest : dest - src),
+                  base[dest]);
+      } else {
+        EXPECT_EQ((weight_t)WEIGHT_MAX, base[dest]);
+      }
+    }
+  }
+}
+
+// Tests APSP on a weighted grid against SSSP from every vertex.
+TEST_P(APSPTest, GridWeighted) {
+  graph_initialize(DATA_FOLDER("grid_graph_15_nodes_weight.totem"), true,
+                   &graph);
+
+  EXPECT_EQ(SUCCESS, apsp(graph, &distances));
+  EXPECT_FALSE(NULL == distances);
+  weight_t* expected = reinterpret_cast<weight_t*>
+      (calloc(graph->vertex_count, sizeof(weight_t)));
+  for (vid_t src = 0; src < graph->vertex_count; src++) {
+    EXPECT_EQ(SUCCESS, sssp_cpu(graph, src, expected));
+    weight_t* base = &distances[src * graph->vertex_count];
+    for (vid_t dest = 0; dest < graph->vertex_count; dest++) {
+      EXPECT_EQ(expected[dest], base[dest]);
+    }
+  }
+  free(expected);
+}
+
+// Wrappers that force each of the CPU methods.
+error_t apsp_cpu_floyd_warshall(graph_t* graph, weight_t** distances) {
+  return apsp_cpu_config(graph, APSP_METHOD_FLOYD_WARSHALL, NULL, distances);
+}
+error_t apsp_cpu_dijkstra(graph_t* graph, weight_t** distances) {
+  return apsp_cpu_config(graph, APSP_METHOD_DIJKSTRA, NULL, distances);
+}
+
 INSTANTIATE_TEST_CASE_P(APSPGPUAndCPUTest, APSPTest,
                         Values(&apsp_cpu,
-                               &apsp_gpu));
+                               &apsp_gpu,
+                               &apsp_cpu_floyd_warshall,
+                               &apsp_cpu_dijkstra));
+
+// Checks that the distances written to a file match the in-memory ones, for
+// both methods.
+static void CompareFileWithMemory(const char* graph_file) {
+  graph_t* graph = NULL;
+  CALL_SAFE(graph_initialize(graph_file, true, &graph));
+  weight_t* distances = NULL;
+  EXPECT_EQ(SUCCESS, apsp_cpu(graph, &distances));
+  size_t size = (size_t)graph->vertex_count * graph->vertex_count;
+  weight_t* file_distances = reinterpret_cast<weight_t*>
+      (malloc(size * sizeof(weight_t)));
+  char file_path[] = "/tmp/totem_apsp_XXXXXX";
+  int fd = mkstemp(file_path);
+  EXPECT_LE(0, fd);
+  close(fd);
+
+  apsp_method_t methods[] = {APSP_METHOD_FLOYD_WARSHALL, APSP_METHOD_DIJKSTRA};
+  for (int m = 0; m < 2; m++) {
+    weight_t* out = distances;
+    EXPECT_EQ(SUCCESS, apsp_cpu_config(graph, methods[m], file_path, &out));
+    EXPECT_EQ((weight_t*)NULL, out);
+    FILE* file = fopen(file_path, "rb");
+    EXPECT_FALSE(NULL == file);
+    EXPECT_EQ(size, fread(file_distances, sizeof(weight_t), size, file));
+    fclose(file);
+    EXPECT_EQ(0, memcmp(distances, file_distances, size * sizeof(weight_t)));
+  }
+
+  unlink(file_path);
+  free(file_distances);
+  totem_free(distances, TOTEM_MEM_HOST_PINNED);
+  graph_finalize(graph);
+}
+
+// Tests the file output on a star graph.
+TEST(APSPFileTest, MatchesInMemory) {
+  CUDA_CHECK_VERSION();
+  CompareFileWithMemory(DATA_FOLDER("star_1000_nodes_diff_weight.totem"));
+}
+
+// Tests the file output on a graph that spans several panels and row blocks
+// of the out-of-core Floyd-Warshall.
+TEST(APSPFileTest, MatchesInMemoryCompleteGraph) {
+  CUDA_CHECK_VERSION();
+  CompareFileWithMemory(
+      DATA_FOLDER("complete_graph_300_nodes_diff_weight.totem"));
+}
 
 #else
 
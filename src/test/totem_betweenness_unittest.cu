@@ -102,6 +102,26 @@ TEST_P(BetweennessCentralityTest, Chain100Unweighted) {
   free(expected_centrality);
 }
 
+// Tests BetwCentrality on a directed graph with multiple shortest paths and
+// several levels against the vanilla CPU implementation.
+TEST_P(BetweennessCentralityTest, WashingtonRandomUnweighted) {
+  EXPECT_EQ(SUCCESS,
+            graph_initialize(DATA_FOLDER("washington_random.totem"),
+                             false, &_graph));
+
+  EXPECT_EQ(SUCCESS, TestGraph());
+  score_t* expected_centrality =
+      reinterpret_cast<score_t*>(calloc(_graph->vertex_count,
+                                        sizeof(score_t)));
+  EXPECT_EQ(SUCCESS, betweenness_cpu(_graph, CENTRALITY_EXACT,
+                                     expected_centrality));
+  for (vid_t vertex = 0; vertex < _graph->vertex_count; vertex++) {
+    EXPECT_NEAR(expected_centrality[vertex], _betweenness_score[vertex],
+                1e-4 * (expected_centrality[vertex] + 1));
+  }
+  free(expected_centrality);
+}
+
 // Tests BetwCentrality for a complete graph of 300 nodes.
 TEST_P(BetweennessCentralityTest, CompleteGraphUnweighted) {
   EXPECT_EQ(SUCCESS,
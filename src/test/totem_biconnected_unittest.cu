@@ -0,0 +1,253 @@
+/*
+ * Contains unit tests for the biconnected components.
+ */
+
+// system includes
+#include <algorithm>
+#include <map>
+#include <set>
+#include <vector>
+
+// totem includes
+#include "totem_common_unittest.h"
+
+class BiconnectedTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    // Ensure the minimum CUDA architecture is supported
+    CUDA_CHECK_VERSION();
+    _graph = NULL;
+    _block = NULL;
+    _articulation = NULL;
+    _bridge = NULL;
+  }
+  virtual void TearDown() {
+    if (_graph) graph_finalize(_graph);
+    FreeResults();
+  }
+
+  void FreeResults() {
+    if (_block) totem_free(_block, TOTEM_MEM_HOST_PINNED);
+    if (_articulation) totem_free(_articulation, TOTEM_MEM_HOST_PINNED);
+    if (_bridge) totem_free(_bridge, TOTEM_MEM_HOST_PINNED);
+    _block = NULL;
+    _articulation = NULL;
+    _bridge = NULL;
+  }
+
+  error_t Run() {
+    return biconnected_components_cpu(_graph, &_block, &_block_count,
+                                      &_articulation, &_bridge);
+  }
+
+  // Builds an undirected graph from a list of edges, each given once.
+  // Repeated edges become parallel edges.
+  void BuildGraph(vid_t vertex_count, const vid_t (*edge_list)[2],
+                  eid_t edge_count) {
+    std::vector<std::vector<vid_t> > adjacency(vertex_count);
+    for (eid_t i = 0; i < edge_count; i++) {
+      adjacency[edge_list[i][0]].push_back(edge_list[i][1]);
+      adjacency[edge_list[i][1]].push_back(edge_list[i][0]);
+    }
+    AdjacencyToGraph(adjacency, false, false, &_graph);
+  }
+
+  // Computes the blocks via the sequential algorithm of Hopcroft and Tarjan,
+  // using an iterative DFS, and compares them with the returned ones. Parallel
+  // edges are in the same block, hence the reference keys the blocks by pairs
+  // of vertices.
+  void ExpectReferenceBlocks() {
+    const vid_t n = _graph->vertex_count;
+    typedef std::pair<vid_t, vid_t> pair_t;
+    std::map<pair_t, int> pair_block;
+    std::vector<pair_t> edge_stack;
+    std::vector<vid_t> disc(n, INFINITE), low(n), parent(n, INFINITE);
+    std::vector<eid_t> next(n);
+    std::vector<bool> skipped(n, false);
+    vid_t time = 0;
+    int block_count = 0;
+    for (vid_t root = 0; root < n; root++) {
+      if (disc[root] != INFINITE) continue;
+      std::vector<vid_t> stack(1, root);
+      disc[root] = low[root] = time++;
+      next[root] = _graph->vertices[root];
+      while (!stack.empty()) {
+        vid_t v = stack.back();
+        if (next[v] < _graph->vertices[v + 1]) {
+          vid_t w = _graph->edges[next[v]++];
+          if (w == v) continue;
+          if (w == parent[v] && !skipped[v]) {
+            skipped[v] = true;
+            continue;
+          }
+          if (disc[w] == INFINITE) {
+            parent[w] = v;
+            disc[w] = low[w] = time++;
+            next[w] = _graph->vertices[w];
+            edge_stack.push_back(pair_t(v, w));
+            stack.push_back(w);
+          } else if (disc[w] < disc[v]) {
+            low[v] = std::min(low[v], disc[w]);
+            edge_stack.push_back(pair_t(v, w));
+          }
+          continue;
+        }
+        stack.pop_back();
+        if (parent[v] == INFINITE) continue;
+        vid_t p = parent[v];
+        low[p] = std::min(low[p], low[v]);
+        if (low[v] < disc[p]) continue;
+        pair_t edge;
+        do {
+          edge = edge_stack.back();
+          edge_stack.pop_back();
+          pair_block[pair_t(std::min(edge.first, edge.second),
+                            std::max(edge.first, edge.second))] = block_count;
+        } while (edge != pair_t(p, v));
+        block_count++;
+      }
+    }
+    EXPECT_EQ((vid_t)block_count, _block_count);
+
+    // The returned blocks match the reference ones up to renaming.
+    std::vector<int> rename(_block_count, -1);
+    std::vector<eid_t> block_size(block_count, 0);
+    std::vector<std::set<int> > vertex_blocks(n);
+    for (vid_t u = 0; u < n; u++) {
+      for (eid_t e = _graph->vertices[u]; e < _graph->vertices[u + 1]; e++) {
+        vid_t w = _graph->edges[e];
+        if (w == u) {
+          EXPECT_EQ(INFINITE, _block[e]);
+          continue;
+        }
+        int expected = pair_block[pair_t(std::min(u, w), std::max(u, w))];
+        ASSERT_GT(_block_count, _block[e]);
+        if (rename[_block[e]] == -1) rename[_block[e]] = expected;
+        EXPECT_EQ(expected, rename[_block[e]]);
+        block_size[expected]++;
+        vertex_blocks[u].insert(expected);
+      }
+    }
+    // A bridge is an edge that is a block by itself, and an articulation
+    // point is a vertex that is part of several blocks.
+    for (vid_t u = 0; u < n; u++) {
+      EXPECT_EQ(vertex_blocks[u].size() > 1, _articulation[u]);
+      for (eid_t e = _graph->vertices[u]; e < _graph->vertices[u + 1]; e++) {
+        vid_t w = _graph->edges[e];
+        if (w == u) {
+          EXPECT_FALSE(_bridge[e]);
+          continue;
+        }
+        int expected = pair_block[pair_t(std::min(u, w), std::max(u, w))];
+        EXPECT_EQ(block_size[expected] == 2, _bridge[e]);
+      }
+    }
+  }
+
+  graph_t* _graph;
+  vid_t* _block;
+  vid_t _block_count;
+  bool* _articulation;
+  bool* _bridge;
+};
+
+// Tests invalid inputs and graphs without edges.
+TEST_F(BiconnectedTest, Empty) {
+  graph_t graph;
+  graph.directed = false;
+  graph.vertex_count = 0;
+  graph.edge_count = 0;
+  EXPECT_EQ(FAILURE, biconnected_components_cpu(&graph, &_block,
+                                                &_block_count, &_articulation,
+                                                &_bridge));
+
+  EXPECT_EQ(SUCCESS, graph_initialize(DATA_FOLDER("disconnected_1000_nodes"
+                                                  ".totem"), false, &_graph));
+  EXPECT_EQ(SUCCESS, Run());
+  EXPECT_EQ((vid_t)0, _block_count);
+  EXPECT_EQ((vid_t*)NULL, _block);
+  EXPECT_EQ((bool*)NULL, _bridge);
+  for (vid_t v = 0; v < _graph->vertex_count; v++) {
+    EXPECT_FALSE(_articulation[v]);
+  }
+}
+
+// Tests that directed graphs are rejected.
+TEST_F(BiconnectedTest, Directed) {
+  EXPECT_EQ(SUCCESS, graph_initialize(DATA_FOLDER("rmf_100_nodes.totem"),
+                                      false, &_graph));
+  EXPECT_EQ(FAILURE, Run());
+}
+
+// Tests a single vertex with a self loop, which is not part of any block.
+TEST_F(BiconnectedTest, SingleNodeLoop) {
+  EXPECT_EQ(SUCCESS, graph_initialize(DATA_FOLDER("single_node_loop.totem"),
+                                      false, &_graph));
+  _graph->directed = false;
+  EXPECT_EQ(SUCCESS, Run());
+  EXPECT_EQ((vid_t)0, _block_count);
+  EXPECT_EQ(INFINITE, _block[0]);
+  EXPECT_FALSE(_bridge[0]);
+  EXPECT_FALSE(_articulation[0]);
+}
+
+// Tests two triangles that share a vertex, a pendant edge, and a parallel
+// edge, which is not a bridge.
+TEST_F(BiconnectedTest, SharedVertex) {
+  const vid_t edge_list[][2] = {
+    {0, 1}, {1, 2}, {2, 0}, {2, 3}, {3, 4}, {4, 2}, {4, 5}, {5, 6}, {5, 6}
+  };
+  BuildGraph(7, edge_list, sizeof(edge_list) / sizeof(*edge_list));
+  EXPECT_EQ(SUCCESS, Run());
+  EXPECT_EQ((vid_t)4, _block_count);
+  bool articulation[] = {false, false, true, false, true, true, false};
+  for (vid_t v = 0; v < _graph->vertex_count; v++) {
+    EXPECT_EQ(articulation[v], _articulation[v]);
+  }
+  for (vid_t u = 0; u < _graph->vertex_count; u++) {
+    for (eid_t e = _graph->vertices[u]; e < _graph->vertices[u + 1]; e++) {
+      vid_t w = _graph->edges[e];
+      EXPECT_EQ((u == 4 && w == 5) || (u == 5 && w == 4), _bridge[e]);
+    }
+  }
+  ExpectReferenceBlocks();
+}
+
+// Tests graphs against the reference algorithm.
+TEST_F(BiconnectedTest, Reference) {
+  const char* graph_files[] = {
+    DATA_FOLDER("grid_graph_15_nodes_weight.totem"),
+    DATA_FOLDER("chain_1000_nodes_weight.totem"),
+    DATA_FOLDER("chain_4_comp_40_nodes.totem"),
+    DATA_FOLDER("complete_graph_300_nodes.totem"),
+    DATA_FOLDER("star_1000_nodes.totem"),
+    DATA_FOLDER("ring_center_graph_1000_nodes.totem"),
+    DATA_FOLDER("wheel_graph_1000_nodes.totem")
+  };
+  for (size_t i = 0; i < sizeof(graph_files) / sizeof(*graph_files); i++) {
+    EXPECT_EQ(SUCCESS, graph_initialize(graph_files[i], false, &_graph));
+    ASSERT_EQ(SUCCESS, Run());
+    ExpectReferenceBlocks();
+    graph_finalize(_graph);
+    _graph = NULL;
+    FreeResults();
+  }
+}
+
+// Tests a sparse random graph, which has many small blocks hanging off a
+// large one, against the reference algorithm.
+TEST_F(BiconnectedTest, RandomGraph) {
+  const vid_t vertex_count = 500;
+  std::vector<vid_t> edge_list;
+  uint32_t seed = 1985;
+  for (vid_t i = 0; i < 650; i++) {
+    vid_t u = (NextRandom(&seed) >> 16) % vertex_count;
+    vid_t v = (NextRandom(&seed) >> 16) % vertex_count;
+    edge_list.push_back(u);
+    edge_list.push_back(v);
+  }
+  BuildGraph(vertex_count, reinterpret_cast<const vid_t(*)[2]>(&edge_list[0]),
+             edge_list.size() / 2);
+  ASSERT_EQ(SUCCESS, Run());
+  ExpectReferenceBlocks();
+}
@@ -0,0 +1,208 @@
+/*
+ * Contains unit tests for the fused centrality pass.
+ */
+
+// totem includes
+#include "totem_common_unittest.h"
+
+class CentralityFusedTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    // Ensure the minimum CUDA architecture is supported
+    CUDA_CHECK_VERSION();
+    _graph = NULL;
+    _closeness = NULL;
+    _stress = NULL;
+    _betweenness = NULL;
+  }
+
+  virtual void TearDown() {
+    if (_graph) graph_finalize(_graph);
+    free(_closeness);
+    free(_stress);
+    free(_betweenness);
+  }
+
+  error_t TestGraph(const char* graph_file, uint32_t metrics) {
+    CALL_SAFE(graph_initialize(graph_file, false, &_graph));
+    _closeness = reinterpret_cast<score_t*>
+        (calloc(_graph->vertex_count, sizeof(score_t)));
+    _stress = reinterpret_cast<score_t*>
+        (calloc(_graph->vertex_count, sizeof(score_t)));
+    _betweenness = reinterpret_cast<score_t*>
+        (calloc(_graph->vertex_count, sizeof(score_t)));
+    return centrality_cpu(_graph, CENTRALITY_EXACT, metrics, _closeness,
+                          _stress, _betweenness);
+  }
+
+  // Compares the fused scores with the ones of the stand-alone stress and
+  // betweenness implementations.
+  void CompareWithStandalone() {
+    weight_t* stress = NULL;
+    EXPECT_EQ(SUCCESS, stress_unweighted_cpu(_graph, &stress));
+    score_t* betweenness = reinterpret_cast<score_t*>
+        (calloc(_graph->vertex_count, sizeof(score_t)));
+    EXPECT_EQ(SUCCESS, betweenness_cpu(_graph, CENTRALITY_EXACT, betweenness));
+    for (vid_t v = 0; v < _graph->vertex_count; v++) {
+      EXPECT_FLOAT_EQ(stress[v], _stress[v]);
+      EXPECT_NEAR(betweenness[v], _betweenness[v],
+                  1e-4 * (betweenness[v] + 1));
+    }
+    totem_free(stress, TOTEM_MEM_HOST_PINNED);
+    free(betweenness);
+  }
+
+  graph_t* _graph;
+  score_t* _closeness;
+  score_t* _stress;
+  score_t* _betweenness;
+};
+
+// Tests the fused pass for empty graphs and invalid metric selections.
+TEST_F(CentralityFusedTest, Empty) {
+  graph_t empty_graph;
+  empty_graph.directed = false;
+  empty_graph.vertex_count = 0;
+  empty_graph.edge_count = 0;
+  score_t score;
+  EXPECT_EQ(FAILURE, centrality_cpu(&empty_graph, CENTRALITY_EXACT,
+                                    CENTRALITY_METRIC_ALL, &score, &score,
+                                    &score));
+  EXPECT_EQ(FAILURE, TestGraph(DATA_FOLDER("single_node.totem"), 0));
+  EXPECT_EQ(FAILURE, centrality_cpu(_graph, CENTRALITY_EXACT,
+                                    CENTRALITY_METRIC_STRESS, _closeness,
+                                    NULL, NULL));
+}
+
+// Tests the fused pass for single node graphs.
+TEST_F(CentralityFusedTest, SingleNodeUnweighted) {
+  EXPECT_EQ(SUCCESS, TestGraph(DATA_FOLDER("single_node.totem"),
+                               CENTRALITY_METRIC_ALL));
+  EXPECT_EQ((score_t)0.0, _closeness[0]);
+  EXPECT_EQ((score_t)0.0, _stress[0]);
+  EXPECT_EQ((score_t)0.0, _betweenness[0]);
+}
+
+// Tests the fused pass for a chain of 100 nodes.
+TEST_F(CentralityFusedTest, Chain100Unweighted) {
+  EXPECT_EQ(SUCCESS, TestGraph(DATA_FOLDER("chain_100_nodes.totem"),
+                               CENTRALITY_METRIC_ALL));
+  EXPECT_EQ((score_t)0.0, _stress[0]);
+  EXPECT_EQ((score_t)0.0, _betweenness[0]);
+  for (vid_t i = 1; i < 50; i++) {
+    score_t expected = 2 * ((99 * i) - (i * i));
+    EXPECT_FLOAT_EQ(expected, _stress[i]);
+    EXPECT_FLOAT_EQ(expected, _stress[99 - i]);
+    EXPECT_FLOAT_EQ(expected, _betweenness[i]);
+    EXPECT_FLOAT_EQ(expected, _betweenness[99 - i]);
+    EXPECT_FLOAT_EQ(_closeness[i], _closeness[99 - i]);
+    EXPECT_GT(_closeness[i], _closeness[i - 1]);
+  }
+  CompareWithStandalone();
+}
+
+// Tests the fused pass for a star graph.
+TEST_F(CentralityFusedTest, StarGraphUnweighted) {
+  EXPECT_EQ(SUCCESS, TestGraph(DATA_FOLDER("star_1000_nodes.totem"),
+                               CENTRALITY_METRIC_ALL));
+  vid_t n = _graph->vertex_count;
+  EXPECT_FLOAT_EQ(1.0, _closeness[0]);
+  EXPECT_FLOAT_EQ((n - 1) * (n - 2), _betweenness[0]);
+  EXPECT_FLOAT_EQ((n - 1) * (n - 2), _stress[0]);
+  for (vid_t v = 1; v < n; v++) {
+    EXPECT_FLOAT_EQ((score_t)(n - 1) / (2 * n - 3), _closeness[v]);
+    EXPECT_FLOAT_EQ(0.0, _betweenness[v]);
+    EXPECT_FLOAT_EQ(0.0, _stress[v]);
+  }
+}
+
+// Tests the fused pass for a complete graph of 300 nodes.
+TEST_F(CentralityFusedTest, CompleteGraphUnweighted) {
+  EXPECT_EQ(SUCCESS, TestGraph(DATA_FOLDER("complete_graph_300_nodes.totem"),
+                               CENTRALITY_METRIC_ALL));
+  for (vid_t v = 0; v < _graph->vertex_count; v++) {
+    EXPECT_FLOAT_EQ(1.0, _closeness[v]);
+    EXPECT_FLOAT_EQ(0.0, _stress[v]);
+    EXPECT_FLOAT_EQ(0.0, _betweenness[v]);
+  }
+}
+
+// Tests the fused pass on a directed graph with multiple shortest paths.
+TEST_F(CentralityFusedTest, WashingtonRandomUnweighted) {
+  EXPECT_EQ(SUCCESS, TestGraph(DATA_FOLDER("washington_random.totem"),
+                               CENTRALITY_METRIC_ALL));
+  CompareWithStandalone();
+}
+
+// Tests that the metrics not selected are left untouched.
+TEST_F(CentralityFusedTest, MetricSelection) {
+  EXPECT_EQ(SUCCESS, TestGraph(DATA_FOLDER("star_1000_nodes.totem"),
+                               CENTRALITY_METRIC_BETWEENNESS));
+  vid_t n = _graph->vertex_count;
+  EXPECT_FLOAT_EQ((n - 1) * (n - 2), _betweenness[0]);
+  for (vid_t v = 0; v < n; v++) {
+    EXPECT_EQ((score_t)0.0, _closeness[v]);
+    EXPECT_EQ((score_t)0.0, _stress[v]);
+  }
+  EXPECT_EQ(SUCCESS, centrality_cpu(_graph, CENTRALITY_EXACT,
+                                    CENTRALITY_METRIC_CLOSENESS, _closeness,
+                                    NULL, NULL));
+  EXPECT_FLOAT_EQ(1.0, _closeness[0]);
+}
+
+// Tests that sampled closeness matches the stand-alone approximation, which
+// draws the same pivots.
+TEST_F(CentralityFusedTest, ApproximateClosenessMatchesStandalone) {
+  CALL_SAFE(graph_initialize(DATA_FOLDER("chain_100_nodes.totem"), false,
+                             &_graph));
+  vid_t n = _graph->vertex_count;
+  _closeness = reinterpret_cast<score_t*>(calloc(n, sizeof(score_t)));
+  EXPECT_EQ(SUCCESS, centrality_cpu(_graph, CENTRALITY_APPROXIMATE,
+                                    CENTRALITY_METRIC_CLOSENESS, _closeness,
+                                    NULL, NULL));
+  score_t* closeness = reinterpret_cast<score_t*>(calloc(n, sizeof(score_t)));
+  EXPECT_EQ(SUCCESS, closeness_cpu(_graph, CENTRALITY_APPROXIMATE, closeness));
+  for (vid_t v = 0; v < n; v++) {
+    EXPECT_FLOAT_EQ(closeness[v], _closeness[v]);
+  }
+  free(closeness);
+}
+
+// Tests sampled stress and betweenness on a star graph, where every leaf pivot
+// adds n - 2 to the center, hence the scaled estimate is close to the exact
+// score unless the center itself is drawn.
+TEST_F(CentralityFusedTest, ApproximateStarGraph) {
+  CALL_SAFE(graph_initialize(DATA_FOLDER("star_1000_nodes.totem"), false,
+                             &_graph));
+  vid_t n = _graph->vertex_count;
+  _stress = reinterpret_cast<score_t*>(calloc(n, sizeof(score_t)));
+  _betweenness = reinterpret_cast<score_t*>(calloc(n, sizeof(score_t)));
+  EXPECT_EQ(SUCCESS, centrality_cpu(_graph, CENTRALITY_APPROXIMATE,
+                                    CENTRALITY_METRIC_STRESS |
+                                    CENTRALITY_METRIC_BETWEENNESS, NULL,
+                                    _stress, _betweenness));
+  score_t exact = (n - 1) * (n - 2);
+  EXPECT_NEAR(exact, _betweenness[0], 0.01 * exact);
+  EXPECT_FLOAT_EQ(_betweenness[0], _stress[0]);
+  for (vid_t v = 1; v < n; v++) {
+    EXPECT_EQ((score_t)0.0, _betweenness[v]);
+    EXPECT_EQ((score_t)0.0, _stress[v]);
+  }
+}
+
+// Tests that sampled closeness is rejected for directed graphs.
+TEST_F(CentralityFusedTest, ApproximateDirected) {
+  CALL_SAFE(graph_initialize(DATA_FOLDER("washington_random.totem"), false,
+                             &_graph));
+  vid_t n = _graph->vertex_count;
+  _closeness = reinterpret_cast<score_t*>(calloc(n, sizeof(score_t)));
+  _betweenness = reinterpret_cast<score_t*>(calloc(n, sizeof(score_t)));
+  if (_graph->directed) {
+    EXPECT_EQ(FAILURE, centrality_cpu(_graph, CENTRALITY_APPROXIMATE,
+                                      CENTRALITY_METRIC_CLOSENESS,
+                                      _closeness, NULL, NULL));
+  }
+  EXPECT_EQ(SUCCESS, centrality_cpu(_graph, CENTRALITY_APPROXIMATE,
+                                    CENTRALITY_METRIC_BETWEENNESS, NULL, NULL,
+                                    _betweenness));
+}
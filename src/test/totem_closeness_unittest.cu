@@ -0,0 +1,194 @@
+/*
+ * Contains unit tests for the exact, approximate and top-k closeness
+ * centrality CPU implementations.
+ */
+
+// totem includes
+#include "totem_common_unittest.h"
+
+class ClosenessTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    // Ensure the minimum CUDA architecture is supported
+    CUDA_CHECK_VERSION();
+    _graph = NULL;
+    _score = NULL;
+  }
+
+  virtual void TearDown() {
+    if (_graph) graph_finalize(_graph);
+    free(_score);
+  }
+
+  void LoadGraph(const char* graph_file) {
+    CALL_SAFE(graph_initialize(graph_file, false, &_graph));
+    _score = reinterpret_cast<score_t*>
+        (calloc(_graph->vertex_count, sizeof(score_t)));
+  }
+
+  // Checks that the top-k result matches the exact scores.
+  void CompareTopk(vid_t k) {
+    score_t* exact = reinterpret_cast<score_t*>
+        (calloc(_graph->vertex_count, sizeof(score_t)));
+    EXPECT_EQ(SUCCESS, closeness_cpu(_graph, CENTRALITY_EXACT, exact));
+    vid_t* top_vertices = reinterpret_cast<vid_t*>(calloc(k, sizeof(vid_t)));
+    score_t* top_scores = reinterpret_cast<score_t*>
+        (calloc(k, sizeof(score_t)));
+    EXPECT_EQ(SUCCESS, closeness_topk_cpu(_graph, k, top_vertices,
+                                          top_scores));
+    for (vid_t i = 0; i < k; i++) {
+      EXPECT_FLOAT_EQ(exact[top_vertices[i]], top_scores[i]);
+      if (i > 0) EXPECT_LE(top_scores[i], top_scores[i - 1]);
+    }
+    // No vertex outside the top-k has a higher score than the k-th one.
+    for (vid_t v = 0; v < _graph->vertex_count; v++) {
+      EXPECT_LE(exact[v], top_scores[0]);
+      bool in_topk = false;
+      for (vid_t i = 0; i < k; i++) in_topk |= (top_vertices[i] == v);
+      if (!in_topk) EXPECT_LE(exact[v], top_scores[k - 1]);
+    }
+    free(exact);
+    free(top_vertices);
+    free(top_scores);
+  }
+
+  graph_t* _graph;
+  score_t* _score;
+};
+
+// Tests closeness for empty graphs.
+TEST_F(ClosenessTest, Empty) {
+  graph_t empty_graph;
+  empty_graph.directed = false;
+  empty_graph.vertex_count = 0;
+  empty_graph.edge_count = 0;
+  score_t score;
+  vid_t vertex;
+  EXPECT_EQ(FAILURE, closeness_cpu(&empty_graph, CENTRALITY_EXACT, &score));
+  EXPECT_EQ(FAILURE, closeness_topk_cpu(&empty_graph, 1, &vertex, &score));
+}
+
+// Tests closeness for single node graphs.
+TEST_F(ClosenessTest, SingleNodeUnweighted) {
+  LoadGraph(DATA_FOLDER("single_node.totem"));
+  EXPECT_EQ(SUCCESS, closeness_cpu(_graph, CENTRALITY_EXACT, _score));
+  EXPECT_EQ((score_t)0.0, _score[0]);
+  vid_t vertex;
+  score_t score;
+  EXPECT_EQ(SUCCESS, closeness_topk_cpu(_graph, 1, &vertex, &score));
+  EXPECT_EQ((vid_t)0, vertex);
+  EXPECT_EQ((score_t)0.0, score);
+  EXPECT_EQ(FAILURE, closeness_topk_cpu(_graph, 2, &vertex, &score));
+}
+
+// Tests exact closeness against the fused centrality pass.
+TEST_F(ClosenessTest, ExactChain100Unweighted) {
+  LoadGraph(DATA_FOLDER("chain_100_nodes.totem"));
+  EXPECT_EQ(SUCCESS, closeness_cpu(_graph, CENTRALITY_EXACT, _score));
+  score_t* fused = reinterpret_cast<score_t*>
+      (calloc(_graph->vertex_count, sizeof(score_t)));
+  EXPECT_EQ(SUCCESS, centrality_cpu(_graph, CENTRALITY_EXACT,
+                                    CENTRALITY_METRIC_CLOSENESS, fused, NULL,
+                                    NULL));
+  for (vid_t v = 0; v < _graph->vertex_count; v++) {
+    EXPECT_FLOAT_EQ(fused[v], _score[v]);
+  }
+  free(fused);
+}
+
+// Tests approximate closeness on a complete graph, where every pivot sees
+// every other vertex at distance one.
+TEST_F(ClosenessTest, ApproximateCompleteGraphUnweighted) {
+  LoadGraph(DATA_FOLDER("complete_graph_300_nodes.totem"));
+  EXPECT_EQ(SUCCESS, closeness_cpu(_graph, CENTRALITY_APPROXIMATE, _score));
+  // The average distance is estimated within epsilon times the diameter.
+  for (vid_t v = 0; v < _graph->vertex_count; v++) {
+    EXPECT_NEAR(1.0, 1.0 / _score[v], CENTRALITY_APPROXIMATE * 1);
+  }
+}
+
+// Tests that the approximate closeness of a star graph is within the
+// expected error bound.
+TEST_F(ClosenessTest, ApproximateStarGraphUnweighted) {
+  LoadGraph(DATA_FOLDER("star_1000_nodes.totem"));
+  EXPECT_EQ(SUCCESS, closeness_cpu(_graph, 0.5, _score));
+  score_t* exact = reinterpret_cast<score_t*>
+      (calloc(_graph->vertex_count, sizeof(score_t)));
+  EXPECT_EQ(SUCCESS, closeness_cpu(_graph, CENTRALITY_EXACT, exact));
+  // The average distance (the inverse of the score, as all vertices are
+  // connected) is estimated within epsilon times the diameter.
+  for (vid_t v = 0; v < _graph->vertex_count; v++) {
+    EXPECT_NEAR(1.0 / exact[v], 1.0 / _score[v], 0.5 * 2);
+  }
+  free(exact);
+}
+
+// Tests that the approximation is unbiased on a graph where most vertices are
+// isolated: a chain of 200 vertices followed by 800 isolated ones. Pivots
+// drawn from the chain only would make each chain vertex appear to reach all
+// the vertices of the graph.
+TEST_F(ClosenessTest, ApproximateMeanMatchesExact) {
+  const vid_t kChain = 200;
+  graph_allocate(1000, 2 * (kChain - 1), false, false, false, &_graph);
+  eid_t e = 0;
+  for (vid_t v = 0; v < _graph->vertex_count; v++) {
+    _graph->vertices[v] = e;
+    if (v > 0 && v < kChain) _graph->edges[e++] = v - 1;
+    if (v + 1 < kChain) _graph->edges[e++] = v + 1;
+  }
+  _graph->vertices[_graph->vertex_count] = e;
+  _score = reinterpret_cast<score_t*>
+      (calloc(_graph->vertex_count, sizeof(score_t)));
+  score_t* exact = reinterpret_cast<score_t*>
+      (calloc(_graph->vertex_count, sizeof(score_t)));
+  EXPECT_EQ(SUCCESS, closeness_cpu(_graph, CENTRALITY_EXACT, exact));
+  EXPECT_EQ(SUCCESS, closeness_cpu(_graph, 0.3, _score));
+  double exact_mean = 0;
+  double mean = 0;
+  for (vid_t v = 0; v < _graph->vertex_count; v++) {
+    exact_mean += exact[v] / _graph->vertex_count;
+    mean += _score[v] / _graph->vertex_count;
+  }
+  EXPECT_NEAR(exact_mean, mean, 0.15 * exact_mean);
+  free(exact);
+}
+
+// Tests that approximate closeness is rejected for directed graphs.
+TEST_F(ClosenessTest, ApproximateDirected) {
+  LoadGraph(DATA_FOLDER("washington_random.totem"));
+  EXPECT_TRUE(_graph->directed);
+  EXPECT_EQ(FAILURE, closeness_cpu(_graph, CENTRALITY_APPROXIMATE, _score));
+}
+
+// Tests top-k closeness on a star and a chain.
+TEST_F(ClosenessTest, TopkStarAndChain) {
+  LoadGraph(DATA_FOLDER("star_1000_nodes.totem"));
+  vid_t top_vertices[2];
+  score_t top_scores[2];
+  EXPECT_EQ(SUCCESS, closeness_topk_cpu(_graph, 2, top_vertices, top_scores));
+  EXPECT_EQ((vid_t)0, top_vertices[0]);
+  EXPECT_FLOAT_EQ(1.0, top_scores[0]);
+  EXPECT_EQ((vid_t)1, top_vertices[1]);
+  graph_finalize(_graph);
+
+  CALL_SAFE(graph_initialize(DATA_FOLDER("chain_100_nodes.totem"), false,
+                             &_graph));
+  EXPECT_EQ(SUCCESS, closeness_topk_cpu(_graph, 2, top_vertices, top_scores));
+  EXPECT_EQ((vid_t)49, top_vertices[0]);
+  EXPECT_EQ((vid_t)50, top_vertices[1]);
+  EXPECT_FLOAT_EQ(top_scores[0], top_scores[1]);
+}
+
+// Tests top-k closeness against the exact scores.
+TEST_F(ClosenessTest, TopkMatchesExact) {
+  LoadGraph(DATA_FOLDER("chain_4_comp_40_nodes.totem"));
+  CompareTopk(5);
+  graph_finalize(_graph);
+  CALL_SAFE(graph_initialize(DATA_FOLDER("washington_random.totem"), false,
+                             &_graph));
+  CompareTopk(10);
+  graph_finalize(_graph);
+  CALL_SAFE(graph_initialize(DATA_FOLDER("wheel_graph_1000_nodes.totem"),
+                             false, &_graph));
+  CompareTopk(20);
+}
@@ -0,0 +1,162 @@
+/*
+ * Contains unit tests for the vertex coloring and the maximal independent set.
+ */
+
+// totem includes
+#include "totem_common_unittest.h"
+
+class ColoringTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    // Ensure the minimum CUDA architecture is supported
+    CUDA_CHECK_VERSION();
+    _graph = NULL;
+    _colors = NULL;
+    _in_set = NULL;
+  }
+  virtual void TearDown() {
+    if (_graph) graph_finalize(_graph);
+    if (_colors) totem_free(_colors, TOTEM_MEM_HOST_PINNED);
+    if (_in_set) totem_free(_in_set, TOTEM_MEM_HOST_PINNED);
+  }
+
+  // Checks that no two neighbors have the same color, and that the number of
+  // colors is reported correctly and is at most the maximum degree plus one.
+  void ExpectValidColoring() {
+    uint32_t max_color = 0;
+    vid_t max_degree = 0;
+    for (vid_t v = 0; v < _graph->vertex_count; v++) {
+      vid_t degree = _graph->vertices[v + 1] - _graph->vertices[v];
+      if (degree > max_degree) max_degree = degree;
+      if (_colors[v] > max_color) max_color = _colors[v];
+      for (eid_t e = _graph->vertices[v]; e < _graph->vertices[v + 1]; e++) {
+        vid_t nbr = _graph->edges[e];
+        if (nbr != v) EXPECT_NE(_colors[v], _colors[nbr]);
+      }
+    }
+    EXPECT_EQ(max_color + 1, _color_count);
+    EXPECT_GE(max_degree + 1, _color_count);
+  }
+
+  // Checks that no two neighbors are in the set, and that every vertex out of
+  // the set has a neighbor in it.
+  void ExpectMaximalIndependentSet() {
+    vid_t size = 0;
+    for (vid_t v = 0; v < _graph->vertex_count; v++) {
+      size += _in_set[v];
+      bool covered = _in_set[v];
+      for (eid_t e = _graph->vertices[v]; e < _graph->vertices[v + 1]; e++) {
+        vid_t nbr = _graph->edges[e];
+        if (nbr == v) continue;
+        if (_in_set[v]) EXPECT_FALSE(_in_set[nbr]);
+        covered |= _in_set[nbr];
+      }
+      EXPECT_TRUE(covered);
+    }
+    EXPECT_EQ(size, _set_size);
+  }
+
+  graph_t* _graph;
+  uint32_t* _colors;
+  uint32_t _color_count;
+  bool* _in_set;
+  vid_t _set_size;
+  uint32_t _rounds;
+};
+
+// Tests invalid inputs.
+TEST_F(ColoringTest, Invalid) {
+  graph_t graph;
+  graph.directed = false;
+  graph.vertex_count = 0;
+  graph.edge_count = 0;
+  EXPECT_EQ(FAILURE, coloring_cpu(&graph, &_colors, &_color_count, &_rounds));
+  EXPECT_EQ(FAILURE, mis_cpu(&graph, &_in_set, &_set_size, &_rounds));
+
+  EXPECT_EQ(SUCCESS, graph_initialize(DATA_FOLDER("rmf_100_nodes.totem"),
+                                      false, &_graph));
+  EXPECT_EQ(FAILURE, coloring_cpu(_graph, &_colors, &_color_count, &_rounds));
+  EXPECT_EQ(FAILURE, mis_cpu(_graph, &_in_set, &_set_size, &_rounds));
+}
+
+// Tests a graph without edges, which takes a single color and a single round.
+TEST_F(ColoringTest, NoEdges) {
+  EXPECT_EQ(SUCCESS, graph_initialize(DATA_FOLDER("disconnected_1000_nodes"
+                                                  ".totem"), false, &_graph));
+  EXPECT_EQ(SUCCESS, coloring_cpu(_graph, &_colors, &_color_count, &_rounds));
+  EXPECT_EQ((uint32_t)1, _color_count);
+  EXPECT_EQ((uint32_t)1, _rounds);
+  EXPECT_EQ(SUCCESS, mis_cpu(_graph, &_in_set, &_set_size, &_rounds));
+  EXPECT_EQ(_graph->vertex_count, _set_size);
+  EXPECT_EQ((uint32_t)1, _rounds);
+}
+
+// Tests a single vertex with a self loop, which is ignored.
+TEST_F(ColoringTest, SingleNodeLoop) {
+  EXPECT_EQ(SUCCESS, graph_initialize(DATA_FOLDER("single_node_loop.totem"),
+                                      false, &_graph));
+  _graph->directed = false;
+  EXPECT_EQ(SUCCESS, coloring_cpu(_graph, &_colors, &_color_count, &_rounds));
+  EXPECT_EQ((uint32_t)0, _colors[0]);
+  EXPECT_EQ(SUCCESS, mis_cpu(_graph, &_in_set, &_set_size, &_rounds));
+  EXPECT_TRUE(_in_set[0]);
+}
+
+// Tests graphs whose optimal colorings are found by the degree priorities.
+TEST_F(ColoringTest, KnownColorCount) {
+  EXPECT_EQ(SUCCESS, graph_initialize(DATA_FOLDER("complete_graph_300_nodes"
+                                                  ".totem"), false, &_graph));
+  EXPECT_EQ(SUCCESS, coloring_cpu(_graph, &_colors, &_color_count, &_rounds));
+  EXPECT_EQ(_graph->vertex_count, _color_count);
+  ExpectValidColoring();
+  EXPECT_EQ(SUCCESS, mis_cpu(_graph, &_in_set, &_set_size, &_rounds));
+  EXPECT_EQ((vid_t)1, _set_size);
+  graph_finalize(_graph);
+  totem_free(_colors, TOTEM_MEM_HOST_PINNED);
+  totem_free(_in_set, TOTEM_MEM_HOST_PINNED);
+  _colors = NULL;
+  _in_set = NULL;
+
+  // The center of the star is colored first, then all the leaves at once.
+  EXPECT_EQ(SUCCESS, graph_initialize(DATA_FOLDER("star_1000_nodes.totem"),
+                                      false, &_graph));
+  EXPECT_EQ(SUCCESS, coloring_cpu(_graph, &_colors, &_color_count, &_rounds));
+  EXPECT_EQ((uint32_t)2, _color_count);
+  EXPECT_EQ((uint32_t)2, _rounds);
+  ExpectValidColoring();
+}
+
+// Tests that the results are valid and reproducible on various graphs.
+TEST_F(ColoringTest, Reference) {
+  const char* graph_files[] = {
+    DATA_FOLDER("grid_graph_15_nodes_weight.totem"),
+    DATA_FOLDER("chain_1000_nodes_weight.totem"),
+    DATA_FOLDER("chain_4_comp_40_nodes.totem"),
+    DATA_FOLDER("ring_center_graph_1000_nodes.totem"),
+    DATA_FOLDER("wheel_graph_1000_nodes.totem"),
+    DATA_FOLDER("star_1000_nodes.totem")
+  };
+  for (size_t i = 0; i < sizeof(graph_files) / sizeof(*graph_files); i++) {
+    EXPECT_EQ(SUCCESS, graph_initialize(graph_files[i], false, &_graph));
+    ASSERT_EQ(SUCCESS, coloring_cpu(_graph, &_colors, &_color_count,
+                                    &_rounds));
+    ExpectValidColoring();
+    uint32_t* colors = _colors;
+    ASSERT_EQ(SUCCESS, coloring_cpu(_graph, &_colors, &_color_count,
+                                    &_rounds));
+    for (vid_t v = 0; v < _graph->vertex_count; v++) {
+      EXPECT_EQ(colors[v], _colors[v]);
+    }
+    totem_free(colors, TOTEM_MEM_HOST_PINNED);
+
+    ASSERT_EQ(SUCCESS, mis_cpu(_graph, &_in_set, &_set_size, &_rounds));
+    ExpectMaximalIndependentSet();
+
+    graph_finalize(_graph);
+    totem_free(_colors, TOTEM_MEM_HOST_PINNED);
+    totem_free(_in_set, TOTEM_MEM_HOST_PINNED);
+    _graph = NULL;
+    _colors = NULL;
+    _in_set = NULL;
+  }
+}
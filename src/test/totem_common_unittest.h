@@ -9,6 +9,8 @@
 #define TOTEM_COMMON_UNITTEST_H
 
 // system includes
+#include <utility>
+#include <vector>
 #include "gtest/gtest.h"
 
 // totem includes
@@ -246,6 +248,46 @@ PRIVATE totem_attr_t totem_attrs[] = {
 // The number of hybrid configurations in the totem_attr array.
 static const int hybrid_configurations_count = STATIC_ARRAY_COUNT(totem_attrs);
 
+// Advances the linear congruential generator the tests use to build random
+// graphs, and returns its new state. The low-order bits of the state have
+// short periods, hence callers shift them out before taking a modulo.
+inline uint32_t NextRandom(uint32_t* seed) {
+  *seed = *seed * 1103515245 + 12345;
+  return *seed;
+}
+
+// The end point and the weight of a neighbor in the adjacency lists the tests
+// build graphs from, which hold either bare end points or (end point, weight)
+// pairs. Bare end points weigh one.
+inline vid_t NeighborId(vid_t nbr) { return nbr; }
+inline weight_t NeighborWeight(vid_t nbr) { return 1; }
+inline vid_t NeighborId(const std::pair<vid_t, weight_t>& nbr) {
+  return nbr.first;
+}
+inline weight_t NeighborWeight(const std::pair<vid_t, weight_t>& nbr) {
+  return nbr.second;
+}
+
+// Builds a graph whose edges are the adjacency lists of its vertices, in the
+// order of the lists. The lists of an undirected graph must hold each edge in
+// both directions.
+template<typename nbr_t>
+void AdjacencyToGraph(const std::vector<std::vector<nbr_t> >& nbrs,
+                      bool directed, bool weighted, graph_t** graph) {
+  eid_t edge_count = 0;
+  for (size_t u = 0; u < nbrs.size(); u++) edge_count += nbrs[u].size();
+  graph_allocate(nbrs.size(), edge_count, directed, weighted, false, graph);
+  eid_t e = 0;
+  for (size_t u = 0; u < nbrs.size(); u++) {
+    (*graph)->vertices[u] = e;
+    for (size_t i = 0; i < nbrs[u].size(); i++, e++) {
+      (*graph)->edges[e] = NeighborId(nbrs[u][i]);
+      if (weighted) (*graph)->weights[e] = NeighborWeight(nbrs[u][i]);
+    }
+  }
+  (*graph)->vertices[nbrs.size()] = e;
+}
+
 // This is to allow testing the vanilla and the hybrid functions that are
 // based on the Totem framework.
 typedef struct {
@@ -7,6 +7,10 @@
  *      Author: Abdullah Gharaibeh
  */
 
+// system includes
+#include <algorithm>
+#include <vector>
+
 // totem includes
 #include "totem_common_unittest.h"
 
@@ -171,7 +175,320 @@ TEST_P(GetComponentsTest, Star) {
 // Values() receives a list of parameters and the framework will execute the
 // whole set of tests GetComponentsTest for each element of Values()
 INSTANTIATE_TEST_CASE_P(GetComponentsGPUAndCPUTest, GetComponentsTest,
-                        Values(&get_components_cpu));
+                        Values(&get_components_cpu,
+                               &get_strongly_connected_components_cpu));
+
+class StronglyConnectedComponentsTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    // Ensure the minimum CUDA architecture is supported
+    CUDA_CHECK_VERSION();
+    graph = NULL;
+    comp_set = NULL;
+  }
+
+  virtual void TearDown() {
+    if (graph) graph_finalize(graph);
+    if (comp_set) finalize_component_set(comp_set);
+  }
+
+  // Computes the components via Tarjan's algorithm, numbered in the order of
+  // their smallest vertex, and compares them with the returned ones.
+  void ExpectTarjanComponents() {
+    const vid_t n = graph->vertex_count;
+    std::vector<vid_t> index(n, INFINITE), low(n), component(n, INFINITE);
+    std::vector<vid_t> stack;
+    std::vector<std::pair<vid_t, eid_t> > call_stack;
+    std::vector<bool> on_stack(n, false);
+    vid_t next_index = 0;
+    vid_t comp_count = 0;
+    for (vid_t root = 0; root < n; root++) {
+      if (index[root] != INFINITE) continue;
+      call_stack.push_back(std::make_pair(root, graph->vertices[root]));
+      index[root] = low[root] = next_index++;
+      stack.push_back(root);
+      on_stack[root] = true;
+      while (!call_stack.empty()) {
+        vid_t v = call_stack.back().first;
+        eid_t& e = call_stack.back().second;
+        if (e < graph->vertices[v + 1]) {
+          vid_t u = graph->edges[e++];
+          if (index[u] == INFINITE) {
+            index[u] = low[u] = next_index++;
+            stack.push_back(u);
+            on_stack[u] = true;
+            call_stack.push_back(std::make_pair(u, graph->vertices[u]));
+          } else if (on_stack[u]) {
+            low[v] = std::min(low[v], index[u]);
+          }
+          continue;
+        }
+        call_stack.pop_back();
+        if (!call_stack.empty()) {
+          vid_t parent = call_stack.back().first;
+          low[parent] = std::min(low[parent], low[v]);
+        }
+        if (low[v] != index[v]) continue;
+        vid_t u;
+        do {
+          u = stack.back();
+          stack.pop_back();
+          on_stack[u] = false;
+          component[u] = comp_count;
+        } while (u != v);
+        comp_count++;
+      }
+    }
+
+    // Renumber the components in the order of their smallest vertex.
+    std::vector<vid_t> id(comp_count, INFINITE);
+    vid_t count = 0;
+    for (vid_t v = 0; v < n; v++) {
+      if (id[component[v]] == INFINITE) id[component[v]] = count++;
+    }
+    ASSERT_EQ(comp_count, comp_set->count);
+    std::vector<vid_t> vertex_count(comp_count, 0);
+    std::vector<eid_t> edge_count(comp_count, 0);
+    for (vid_t v = 0; v < n; v++) {
+      vid_t comp = id[component[v]];
+      EXPECT_EQ(comp, comp_set->marker[v]);
+      vertex_count[comp]++;
+      for (eid_t e = graph->vertices[v]; e < graph->vertices[v + 1]; e++) {
+        edge_count[comp] += (component[graph->edges[e]] == component[v]);
+      }
+    }
+    for (vid_t comp = 0; comp < comp_count; comp++) {
+      EXPECT_EQ(vertex_count[comp], comp_set->vertex_count[comp]);
+      EXPECT_EQ(edge_count[comp], comp_set->edge_count[comp]);
+      EXPECT_LE(comp_set->vertex_count[comp],
+                comp_set->vertex_count[comp_set->biggest]);
+    }
+  }
+
+  graph_t* graph;
+  component_set_t* comp_set;
+};
+
+// Tests an acyclic graph, where every vertex is a component of its own.
+TEST_F(StronglyConnectedComponentsTest, Acyclic) {
+  graph_initialize(DATA_FOLDER("acyclic_100_nodes.totem"), false, &graph);
+  EXPECT_EQ(SUCCESS, get_strongly_connected_components_cpu(graph, &comp_set));
+  EXPECT_EQ(graph->vertex_count, comp_set->count);
+  ExpectTarjanComponents();
+}
+
+// Tests directed graphs against Tarjan's algorithm.
+TEST_F(StronglyConnectedComponentsTest, Directed) {
+  const char* graph_files[] = {
+    DATA_FOLDER("chain_100_nodes_weight_directed.totem"),
+    DATA_FOLDER("rmf_100_nodes.totem"),
+    DATA_FOLDER("source_sink_maxflow.totem"),
+    DATA_FOLDER("washington_random.totem")
+  };
+  for (size_t i = 0; i < sizeof(graph_files) / sizeof(*graph_files); i++) {
+    graph_initialize(graph_files[i], false, &graph);
+    EXPECT_EQ(SUCCESS, get_strongly_connected_components_cpu(graph,
+                                                             &comp_set));
+    ExpectTarjanComponents();
+    graph_finalize(graph);
+    finalize_component_set(comp_set);
+    graph = NULL;
+    comp_set = NULL;
+  }
+}
+
+// Tests a random directed graph made of many cycles of different lengths
+// that are linked by random edges, which leaves components of every kind for
+// the forward-backward and the coloring steps.
+TEST_F(StronglyConnectedComponentsTest, RandomCycles) {
+  const vid_t vertex_count = 2000;
+  const eid_t random_edges = 1500;
+  std::vector<std::vector<vid_t> > nbrs(vertex_count);
+  uint32_t seed = 1985;
+  for (vid_t start = 0; start < vertex_count; ) {
+    vid_t length = std::min((vid_t)((NextRandom(&seed) >> 16) % 20 + 1),
+                            vertex_count - start);
+    for (vid_t v = start; v < start + length; v++) {
+      nbrs[v].push_back(v + 1 < start + length ? v + 1 : start);
+    }
+    start += length;
+  }
+  for (eid_t e = 0; e < random_edges; e++) {
+    vid_t u = (NextRandom(&seed) >> 8) % vertex_count;
+    vid_t v = (NextRandom(&seed) >> 8) % vertex_count;
+    nbrs[u].push_back(v);
+  }
+  eid_t edge_count = 0;
+  for (vid_t v = 0; v < vertex_count; v++) edge_count += nbrs[v].size();
+  graph_allocate(vertex_count, edge_count, true, false, false, &graph);
+  eid_t e = 0;
+  for (vid_t v = 0; v < vertex_count; v++) {
+    graph->vertices[v] = e;
+    for (size_t i = 0; i < nbrs[v].size(); i++) graph->edges[e++] = nbrs[v][i];
+  }
+  graph->vertices[vertex_count] = e;
+  EXPECT_EQ(SUCCESS, get_strongly_connected_components_cpu(graph, &comp_set));
+  ExpectTarjanComponents();
+}
+
+class ComponentStreamTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    // Ensure the minimum CUDA architecture is supported
+    CUDA_CHECK_VERSION();
+    graph = NULL;
+    comp_set = NULL;
+    stream = NULL;
+  }
+
+  virtual void TearDown() {
+    if (stream) component_stream_finalize(stream);
+    if (comp_set) finalize_component_set(comp_set);
+    if (graph) graph_finalize(graph);
+  }
+
+  void Initialize(const char* graph_file) {
+    graph_initialize(graph_file, false, &graph);
+    ASSERT_EQ(SUCCESS, get_components_cpu(graph, &comp_set));
+    ASSERT_EQ(SUCCESS, component_stream_initialize(comp_set, &stream));
+    nbrs.assign(graph->vertex_count, std::vector<vid_t>());
+    for (vid_t v = 0; v < graph->vertex_count; v++) {
+      nbrs[v].assign(graph->edges + graph->vertices[v],
+                     graph->edges + graph->vertices[v + 1]);
+    }
+  }
+
+  // Inserts a batch of pseudo-random edges into the stream and into the
+  // neighbors lists. Half of the edges are local, to merge nearby components
+  // and to add edges within a component.
+  void InsertBatch(eid_t count, uint32_t* seed) {
+    std::vector<edge_t> edges(count);
+    for (eid_t i = 0; i < count; i++) {
+      edges[i].src = (NextRandom(seed) >> 8) % graph->vertex_count;
+      uint32_t r = NextRandom(seed) >> 8;
+      edges[i].dst = i % 2 ? r % graph->vertex_count :
+          std::min(edges[i].src + r % 4, graph->vertex_count - 1);
+      nbrs[edges[i].src].push_back(edges[i].dst);
+      if (!graph->directed) nbrs[edges[i].dst].push_back(edges[i].src);
+    }
+    EXPECT_EQ(SUCCESS, component_stream_insert(stream, &edges[0], count));
+  }
+
+  // Compares the stream with the components of the graph built from the
+  // neighbors lists. If refreshed, the component set is compared as well.
+  void ExpectReference(bool refreshed) {
+    graph_t* updated;
+    AdjacencyToGraph(nbrs, graph->directed, false, &updated);
+    component_set_t* reference;
+    ASSERT_EQ(SUCCESS, get_components_cpu(updated, &reference));
+
+    // The components must be the same up to their ids.
+    std::vector<vid_t> id(reference->count, INFINITE);
+    std::vector<vid_t> reference_id(graph->vertex_count, INFINITE);
+    for (vid_t v = 0; v < graph->vertex_count; v++) {
+      vid_t comp = refreshed ? comp_set->marker[v] :
+          component_stream_find(stream, v);
+      ASSERT_GT(comp_set->id_count, comp);
+      if (id[reference->marker[v]] == INFINITE) {
+        id[reference->marker[v]] = comp;
+        EXPECT_EQ(INFINITE, reference_id[comp]);
+        reference_id[comp] = reference->marker[v];
+      }
+      EXPECT_EQ(id[reference->marker[v]], comp);
+    }
+    if (refreshed) {
+      ASSERT_EQ(reference->count, comp_set->count);
+      vid_t used = 0;
+      for (vid_t comp = 0; comp < comp_set->id_count; comp++) {
+        used += (comp_set->vertex_count[comp] != 0);
+      }
+      EXPECT_EQ(comp_set->count, used);
+      for (vid_t comp = 0; comp < reference->count; comp++) {
+        EXPECT_EQ(reference->vertex_count[comp],
+                  comp_set->vertex_count[id[comp]]);
+        EXPECT_EQ(reference->edge_count[comp], comp_set->edge_count[id[comp]]);
+      }
+      EXPECT_EQ(reference->vertex_count[reference->biggest],
+                comp_set->vertex_count[comp_set->biggest]);
+    }
+    finalize_component_set(reference);
+    graph_finalize(updated);
+  }
+
+  graph_t* graph;
+  component_set_t* comp_set;
+  component_stream_t* stream;
+  std::vector<std::vector<vid_t> > nbrs;
+};
+
+// Tests invalid inputs.
+TEST_F(ComponentStreamTest, Invalid) {
+  EXPECT_EQ(FAILURE, component_stream_initialize(NULL, &stream));
+  Initialize(DATA_FOLDER("chain_4_comp_40_nodes.totem"));
+  edge_t edge = {0, 40, 1};
+  EXPECT_EQ(FAILURE, component_stream_insert(stream, &edge, 1));
+  EXPECT_EQ(FAILURE, component_stream_insert(stream, NULL, 1));
+  EXPECT_EQ(SUCCESS, component_stream_insert(stream, NULL, 0));
+  EXPECT_EQ(SUCCESS, component_stream_refresh(stream));
+  EXPECT_EQ((vid_t)4, comp_set->count);
+}
+
+// Tests joining the components of a graph one edge at a time. The components
+// are 0-9, 10-19, 20-30 and 31-39, with ids 0 to 3. A merged component takes
+// the id of its largest part, and the ids of the others are left unused.
+TEST_F(ComponentStreamTest, Join) {
+  Initialize(DATA_FOLDER("chain_4_comp_40_nodes.totem"));
+  edge_t edges[] = {{9, 39, 1}, {0, 25, 1}, {15, 20, 1}};
+  EXPECT_EQ(SUCCESS, component_stream_insert(stream, &edges[0], 1));
+  EXPECT_EQ(component_stream_find(stream, 0), component_stream_find(stream, 31));
+  EXPECT_NE(component_stream_find(stream, 0), component_stream_find(stream, 10));
+  EXPECT_EQ(SUCCESS, component_stream_insert(stream, &edges[1], 1));
+  EXPECT_EQ(SUCCESS, component_stream_refresh(stream));
+  EXPECT_EQ((vid_t)2, comp_set->count);
+  EXPECT_EQ((vid_t)30, comp_set->vertex_count[comp_set->biggest]);
+  EXPECT_EQ((eid_t)58, comp_set->edge_count[comp_set->biggest]);
+  EXPECT_EQ(comp_set->biggest, comp_set->marker[39]);
+  EXPECT_NE(comp_set->biggest, comp_set->marker[10]);
+  EXPECT_EQ((vid_t)2, comp_set->biggest);
+  EXPECT_EQ((vid_t)0, comp_set->vertex_count[0]);
+  EXPECT_EQ((vid_t)0, comp_set->vertex_count[3]);
+  EXPECT_EQ(SUCCESS, component_stream_insert(stream, &edges[2], 1));
+  EXPECT_EQ(SUCCESS, component_stream_refresh(stream));
+  EXPECT_EQ((vid_t)1, comp_set->count);
+  EXPECT_EQ((vid_t)4, comp_set->id_count);
+  EXPECT_EQ((vid_t)2, comp_set->biggest);
+  EXPECT_EQ((vid_t)40, comp_set->vertex_count[2]);
+  EXPECT_EQ((eid_t)78, comp_set->edge_count[2]);
+  for (vid_t v = 0; v < graph->vertex_count; v++) {
+    EXPECT_EQ((vid_t)2, comp_set->marker[v]);
+  }
+}
+
+// Tests batches of random insertions against recomputing the components, with
+// queries before each refresh.
+TEST_F(ComponentStreamTest, Batches) {
+  const char* graph_files[] = {
+    DATA_FOLDER("disconnected_1000_nodes.totem"),
+    DATA_FOLDER("chain_4_comp_40_nodes.totem"),
+    DATA_FOLDER("acyclic_100_nodes.totem")
+  };
+  for (size_t i = 0; i < sizeof(graph_files) / sizeof(*graph_files); i++) {
+    Initialize(graph_files[i]);
+    uint32_t seed = 1985;
+    for (int batch = 0; batch < 8; batch++) {
+      InsertBatch(graph->vertex_count / 8, &seed);
+      ExpectReference(false);
+      EXPECT_EQ(SUCCESS, component_stream_refresh(stream));
+      ExpectReference(true);
+    }
+    component_stream_finalize(stream);
+    finalize_component_set(comp_set);
+    graph_finalize(graph);
+    stream = NULL;
+    comp_set = NULL;
+    graph = NULL;
+  }
+}
 
 #else
 
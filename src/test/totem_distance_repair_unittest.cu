@@ -0,0 +1,250 @@
+/*
+ * Contains unit tests for the repair of BFS and SSSP distances after edge
+ * updates.
+ */
+
+// system includes
+#include <utility>
+#include <vector>
+
+// totem includes
+#include "totem_common_unittest.h"
+
+class DistanceRepairTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    // Ensure the minimum CUDA architecture is supported
+    CUDA_CHECK_VERSION();
+    _graph = NULL;
+    _engine = NULL;
+  }
+  virtual void TearDown() {
+    if (_engine) distance_repair_finalize(_engine);
+    if (_graph) graph_finalize(_graph);
+  }
+
+  void Initialize(const char* graph_file, bool weighted) {
+    ASSERT_EQ(SUCCESS, graph_initialize(graph_file, weighted, &_graph));
+    ASSERT_EQ(SUCCESS, distance_repair_initialize(_graph->vertex_count,
+                                                  &_engine));
+    _nbrs.assign(_graph->vertex_count, std::vector<nbr_t>());
+    for (vid_t u = 0; u < _graph->vertex_count; u++) {
+      for (eid_t e = _graph->vertices[u]; e < _graph->vertices[u + 1]; e++) {
+        _nbrs[u].push_back(nbr_t(_graph->edges[e], weighted ?
+                                 _graph->weights[e] : DEFAULT_EDGE_WEIGHT));
+      }
+    }
+  }
+
+  // Replaces the graph with the one built from the neighbors lists.
+  void Rebuild() {
+    graph_t* graph;
+    AdjacencyToGraph(_nbrs, _graph->directed, _graph->weighted, &graph);
+    graph_finalize(_graph);
+    _graph = graph;
+  }
+
+  // Sets the weight of the first edge from u to v, or removes it if the weight
+  // is WEIGHT_MAX, in both directions if the graph is undirected.
+  void SetEdge(vid_t u, vid_t v, weight_t weight) {
+    for (int direction = 0; direction < 2; direction++) {
+      if (direction && (_graph->directed || u == v)) break;
+      vid_t src = direction ? v : u;
+      vid_t dst = direction ? u : v;
+      for (size_t i = 0; i < _nbrs[src].size(); i++) {
+        if (_nbrs[src][i].first != dst) continue;
+        if (weight == WEIGHT_MAX) {
+          _nbrs[src].erase(_nbrs[src].begin() + i);
+        } else {
+          _nbrs[src][i].second = weight;
+        }
+        break;
+      }
+    }
+  }
+
+  // Creates a batch of pseudo-random updates, and applies it to the graph.
+  // Half of the updates delete the first edge of a vertex, or change its
+  // weight for weighted graphs, and the other half insert edges. An edge is
+  // updated at most once per batch, as the batch lists the final state of the
+  // updated edges.
+  void CreateBatch(eid_t count, uint32_t* seed, std::vector<edge_t>* inserted,
+                   std::vector<edge_t>* deleted) {
+    inserted->clear();
+    deleted->clear();
+    std::vector<bool> updated(_graph->vertex_count, false);
+    std::vector<edge_t> added;
+    for (eid_t i = 0; i < count; i++) {
+      vid_t u = (NextRandom(seed) >> 8) % _graph->vertex_count;
+      uint32_t r = NextRandom(seed);
+      vid_t v = (r >> 8) % _graph->vertex_count;
+      weight_t weight = _graph->weighted ? 1 + (r >> 4) % 20 :
+          DEFAULT_EDGE_WEIGHT;
+      edge_t edge = {u, v, weight};
+      if (i % 2 == 0) {
+        added.push_back(edge);
+        continue;
+      }
+      if (_nbrs[u].empty() || updated[u] || updated[_nbrs[u][0].first]) {
+        continue;
+      }
+      edge.dst = _nbrs[u][0].first;
+      updated[u] = updated[edge.dst] = true;
+      weight_t old_weight = _nbrs[u][0].second;
+      if (_graph->weighted && i % 4 == 1) {
+        // Change the weight, keeping the edge.
+        SetEdge(u, edge.dst, weight);
+        if (weight < old_weight) {
+          inserted->push_back(edge);
+        } else if (weight > old_weight) {
+          deleted->push_back(edge);
+        }
+      } else {
+        SetEdge(u, edge.dst, WEIGHT_MAX);
+        deleted->push_back(edge);
+      }
+    }
+    for (size_t i = 0; i < added.size(); i++) {
+      const edge_t& edge = added[i];
+      _nbrs[edge.src].push_back(nbr_t(edge.dst, edge.weight));
+      if (!_graph->directed && edge.src != edge.dst) {
+        _nbrs[edge.dst].push_back(nbr_t(edge.src, edge.weight));
+      }
+      inserted->push_back(edge);
+    }
+    Rebuild();
+  }
+
+  typedef std::pair<vid_t, weight_t> nbr_t;
+  graph_t* _graph;
+  distance_repair_t* _engine;
+  std::vector<std::vector<nbr_t> > _nbrs;
+};
+
+// Tests invalid inputs.
+TEST_F(DistanceRepairTest, Invalid) {
+  EXPECT_EQ(FAILURE, distance_repair_initialize(0, &_engine));
+  Initialize(DATA_FOLDER("chain_1000_nodes.totem"), false);
+  std::vector<cost_t> cost(_graph->vertex_count);
+  std::vector<weight_t> distance(_graph->vertex_count);
+  EXPECT_EQ(SUCCESS, bfs_cpu(_graph, 0, &cost[0]));
+  edge_t edge = {0, 1000, 1};
+  EXPECT_EQ(FAILURE, bfs_repair_cpu(_engine, _graph, NULL, 0, &edge, 1, NULL,
+                                    0, &cost[0]));
+  EXPECT_EQ(FAILURE, bfs_repair_cpu(_engine, _graph, NULL, 1000, NULL, 0,
+                                    NULL, 0, &cost[0]));
+  EXPECT_EQ(FAILURE, bfs_repair_cpu(_engine, _graph, NULL, 0, NULL, 1, NULL,
+                                    0, &cost[0]));
+  // The weights were not loaded.
+  EXPECT_EQ(FAILURE, sssp_repair_cpu(_engine, _graph, NULL, 0, NULL, 0, NULL,
+                                     0, &distance[0]));
+  EXPECT_EQ(SUCCESS, bfs_repair_cpu(_engine, _graph, NULL, 0, NULL, 0, NULL,
+                                    0, &cost[0]));
+}
+
+// Tests that cutting a chain invalidates the part beyond the cut, and that
+// joining it back restores the distances.
+TEST_F(DistanceRepairTest, Chain) {
+  Initialize(DATA_FOLDER("chain_1000_nodes.totem"), false);
+  std::vector<cost_t> cost(_graph->vertex_count);
+  EXPECT_EQ(SUCCESS, bfs_cpu(_graph, 0, &cost[0]));
+  edge_t edge = {500, 501, 1};
+  SetEdge(500, 501, WEIGHT_MAX);
+  Rebuild();
+  EXPECT_EQ(SUCCESS, bfs_repair_cpu(_engine, _graph, NULL, 0, NULL, 0, &edge,
+                                    1, &cost[0]));
+  for (vid_t v = 0; v < _graph->vertex_count; v++) {
+    EXPECT_EQ(v <= 500 ? (cost_t)v : INF_COST, cost[v]);
+  }
+  // A shortcut from the source to the far end.
+  edge_t shortcut = {0, 999, 1};
+  _nbrs[0].push_back(nbr_t(999, 1));
+  _nbrs[999].push_back(nbr_t(0, 1));
+  Rebuild();
+  EXPECT_EQ(SUCCESS, bfs_repair_cpu(_engine, _graph, NULL, 0, &shortcut, 1,
+                                    NULL, 0, &cost[0]));
+  for (vid_t v = 501; v < _graph->vertex_count; v++) {
+    EXPECT_EQ((cost_t)(1000 - v), cost[v]);
+  }
+}
+
+// Tests batches of random updates against recomputing the distances via
+// bfs_cpu. The transpose of directed graphs is given every other batch.
+TEST_F(DistanceRepairTest, BfsBatches) {
+  const char* graph_files[] = {
+    DATA_FOLDER("grid_graph_15_nodes_weight.totem"),
+    DATA_FOLDER("chain_4_comp_40_nodes.totem"),
+    DATA_FOLDER("star_1000_nodes.totem"),
+    DATA_FOLDER("ring_center_graph_1000_nodes.totem"),
+    DATA_FOLDER("rmf_100_nodes.totem"),
+    DATA_FOLDER("acyclic_100_nodes.totem"),
+    DATA_FOLDER("washington_random.totem")
+  };
+  for (size_t i = 0; i < sizeof(graph_files) / sizeof(*graph_files); i++) {
+    Initialize(graph_files[i], false);
+    std::vector<cost_t> cost(_graph->vertex_count);
+    std::vector<cost_t> reference(_graph->vertex_count);
+    EXPECT_EQ(SUCCESS, bfs_cpu(_graph, 0, &cost[0]));
+    uint32_t seed = 1985;
+    std::vector<edge_t> inserted, deleted;
+    for (int batch = 0; batch < 6; batch++) {
+      CreateBatch(_graph->vertex_count / 10 + 2, &seed, &inserted, &deleted);
+      graph_t* incoming = NULL;
+      if (_graph->directed && batch % 2) {
+        ASSERT_EQ(SUCCESS, graph_create_transpose(_graph, &incoming));
+      }
+      EXPECT_EQ(SUCCESS, bfs_repair_cpu(_engine, _graph, incoming, 0,
+                                        inserted.empty() ? NULL : &inserted[0],
+                                        inserted.size(),
+                                        deleted.empty() ? NULL : &deleted[0],
+                                        deleted.size(), &cost[0]));
+      if (incoming) graph_finalize(incoming);
+      EXPECT_EQ(SUCCESS, bfs_cpu(_graph, 0, &reference[0]));
+      for (vid_t v = 0; v < _graph->vertex_count; v++) {
+        ASSERT_EQ(reference[v], cost[v]);
+      }
+    }
+    distance_repair_finalize(_engine);
+    graph_finalize(_graph);
+    _engine = NULL;
+    _graph = NULL;
+  }
+}
+
+// Tests batches of random updates, including weight changes, against
+// recomputing the distances via sssp_cpu.
+TEST_F(DistanceRepairTest, SsspBatches) {
+  const char* graph_files[] = {
+    DATA_FOLDER("grid_graph_sssp_15_nodes_weight.totem"),
+    DATA_FOLDER("chain_1000_nodes_weight.totem"),
+    DATA_FOLDER("complete_graph_300_nodes_weight.totem"),
+    DATA_FOLDER("chain_100_nodes_weight_directed.totem"),
+    DATA_FOLDER("washington_random.totem")
+  };
+  for (size_t i = 0; i < sizeof(graph_files) / sizeof(*graph_files); i++) {
+    Initialize(graph_files[i], true);
+    std::vector<weight_t> distance(_graph->vertex_count);
+    std::vector<weight_t> reference(_graph->vertex_count);
+    EXPECT_EQ(SUCCESS, sssp_cpu(_graph, 0, &distance[0]));
+    uint32_t seed = 2015;
+    std::vector<edge_t> decreased, increased;
+    for (int batch = 0; batch < 6; batch++) {
+      CreateBatch(_graph->vertex_count / 10 + 2, &seed, &decreased,
+                  &increased);
+      EXPECT_EQ(SUCCESS, sssp_repair_cpu(_engine, _graph, NULL, 0,
+                                         decreased.empty() ? NULL :
+                                         &decreased[0], decreased.size(),
+                                         increased.empty() ? NULL :
+                                         &increased[0], increased.size(),
+                                         &distance[0]));
+      EXPECT_EQ(SUCCESS, sssp_cpu(_graph, 0, &reference[0]));
+      for (vid_t v = 0; v < _graph->vertex_count; v++) {
+        ASSERT_EQ(reference[v], distance[v]);
+      }
+    }
+    distance_repair_finalize(_engine);
+    graph_finalize(_graph);
+    _engine = NULL;
+    _graph = NULL;
+  }
+}
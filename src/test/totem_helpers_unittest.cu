@@ -7,6 +7,9 @@
  *              Abdullah Gharaibeh
  */
 
+// system includes
+#include <vector>
+
 // totem includes
 #include "totem_bitmap.cuh"
 #include "totem_common_unittest.h"
@@ -227,6 +230,166 @@ TEST_F(GraphHelper, SubGraph) {
   graph_finalize(graph);
 }
 
+TEST_F(GraphHelper, Transpose) {
+  graph_t* graph;
+  graph_t* transpose;
+  EXPECT_EQ(FAILURE, graph_create_transpose(NULL, &transpose));
+
+  // Every edge of the graph appears reversed, with the same weight, in the
+  // transpose, and the transpose of the transpose is the graph itself.
+  graph_initialize(DATA_FOLDER("rmf_100_nodes.totem"), true, &graph);
+  EXPECT_EQ(SUCCESS, graph_create_transpose(graph, &transpose));
+  EXPECT_EQ(graph->vertex_count, transpose->vertex_count);
+  EXPECT_EQ(graph->edge_count, transpose->edge_count);
+  EXPECT_TRUE(transpose->directed);
+  EXPECT_TRUE(transpose->weighted);
+  for (vid_t u = 0; u < graph->vertex_count; u++) {
+    for (eid_t e = graph->vertices[u]; e < graph->vertices[u + 1]; e++) {
+      vid_t v = graph->edges[e];
+      bool found = false;
+      for (eid_t r = transpose->vertices[v]; r < transpose->vertices[v + 1];
+           r++) {
+        found |= (transpose->edges[r] == u &&
+                  transpose->weights[r] == graph->weights[e]);
+      }
+      EXPECT_TRUE(found);
+    }
+    for (eid_t r = transpose->vertices[u] + 1; r < transpose->vertices[u + 1];
+         r++) {
+      EXPECT_LE(transpose->edges[r - 1], transpose->edges[r]);
+    }
+  }
+  graph_t* original;
+  EXPECT_EQ(SUCCESS, graph_create_transpose(transpose, &original));
+  graph_sort_nbrs(graph);
+  for (eid_t e = 0; e < graph->edge_count; e++) {
+    EXPECT_EQ(graph->edges[e], original->edges[e]);
+  }
+  EXPECT_EQ(SUCCESS, graph_finalize(original));
+  EXPECT_EQ(SUCCESS, graph_finalize(transpose));
+  graph_finalize(graph);
+}
+
+// Checks that a subgraph is induced by the vertices of an id map: every edge
+// among them is kept, with its weight, in the same order.
+PRIVATE void ExpectInduced(const graph_t* graph, const graph_t* subgraph,
+                           const vid_t* id_map) {
+  std::vector<vid_t> map(graph->vertex_count, INFINITE);
+  for (vid_t i = 0; i < subgraph->vertex_count; i++) map[id_map[i]] = i;
+  eid_t edge_count = 0;
+  for (vid_t i = 0; i < subgraph->vertex_count; i++) {
+    vid_t u = id_map[i];
+    ASSERT_EQ(edge_count, subgraph->vertices[i]);
+    for (eid_t e = graph->vertices[u]; e < graph->vertices[u + 1]; e++) {
+      if (map[graph->edges[e]] == INFINITE) continue;
+      EXPECT_EQ(map[graph->edges[e]], subgraph->edges[edge_count]);
+      if (graph->weighted) {
+        EXPECT_EQ(graph->weights[e], subgraph->weights[edge_count]);
+      }
+      edge_count++;
+    }
+  }
+  EXPECT_EQ(edge_count, subgraph->edge_count);
+  EXPECT_EQ(edge_count, subgraph->vertices[subgraph->vertex_count]);
+}
+
+TEST_F(GraphHelper, KHopSubGraph) {
+  graph_t* graph;
+  graph_t* subgraph;
+  vid_t* id_map;
+  subgraph_extractor_t* extractor;
+  EXPECT_EQ(FAILURE, subgraph_extractor_initialize(NULL, &extractor));
+
+  // The k-hop neighborhood of the middle of a chain is a chain of 2k + 1
+  // vertices; the seeds come first, then each hop in turn.
+  graph_initialize(DATA_FOLDER("chain_1000_nodes_weight.totem"), true,
+                   &graph);
+  EXPECT_EQ(SUCCESS, subgraph_extractor_initialize(graph, &extractor));
+  vid_t seeds[] = {500, 500, 1000};
+  EXPECT_EQ(FAILURE, graph_extract_khop(extractor, seeds, 3, 2, NULL, 0,
+                                        &subgraph, &id_map));
+  for (uint32_t hops = 0; hops < 4; hops++) {
+    EXPECT_EQ(SUCCESS, graph_extract_khop(extractor, seeds, 2, hops, NULL, 0,
+                                          &subgraph, &id_map));
+    EXPECT_EQ(2 * hops + 1, subgraph->vertex_count);
+    EXPECT_EQ((eid_t)(4 * hops), subgraph->edge_count);
+    EXPECT_TRUE(subgraph->weighted);
+    EXPECT_EQ((vid_t)500, id_map[0]);
+    for (vid_t i = 1; i < subgraph->vertex_count; i++) {
+      vid_t hop = (i + 1) / 2;
+      EXPECT_EQ(hop, (vid_t)abs((int)id_map[i] - 500));
+    }
+    ExpectInduced(graph, subgraph, id_map);
+    graph_finalize(subgraph);
+    free(id_map);
+  }
+  EXPECT_EQ(SUCCESS, subgraph_extractor_finalize(extractor));
+  graph_finalize(graph);
+
+  // With a fanout cap, the hub of a star expands to a sample of its leaves
+  // that is the same for the same sample seed.
+  graph_initialize(DATA_FOLDER("star_1000_nodes.totem"), false, &graph);
+  EXPECT_EQ(SUCCESS, subgraph_extractor_initialize(graph, &extractor));
+  vid_t hub = 0;
+  uint32_t fanouts[] = {10, 0};
+  EXPECT_EQ(SUCCESS, graph_extract_khop(extractor, &hub, 1, 1, fanouts, 7,
+                                        &subgraph, &id_map));
+  EXPECT_EQ((vid_t)11, subgraph->vertex_count);
+  EXPECT_EQ((eid_t)20, subgraph->edge_count);
+  ExpectInduced(graph, subgraph, id_map);
+  graph_t* other;
+  vid_t* other_map;
+  EXPECT_EQ(SUCCESS, graph_extract_khop(extractor, &hub, 1, 1, fanouts, 7,
+                                        &other, &other_map));
+  EXPECT_EQ(subgraph->vertex_count, other->vertex_count);
+  for (vid_t i = 0; i < other->vertex_count; i++) {
+    EXPECT_EQ(id_map[i], other_map[i]);
+  }
+  graph_finalize(other);
+  free(other_map);
+  graph_finalize(subgraph);
+  free(id_map);
+  // From a leaf, the second hop reaches every leaf since it is not capped.
+  vid_t leaf = 1;
+  EXPECT_EQ(SUCCESS, graph_extract_khop(extractor, &leaf, 1, 2, fanouts, 7,
+                                        &subgraph, &id_map));
+  EXPECT_EQ(graph->vertex_count, subgraph->vertex_count);
+  EXPECT_EQ(graph->edge_count, subgraph->edge_count);
+  ExpectInduced(graph, subgraph, id_map);
+  graph_finalize(subgraph);
+  free(id_map);
+  EXPECT_EQ(SUCCESS, subgraph_extractor_finalize(extractor));
+  graph_finalize(graph);
+
+  // A ring large enough for the subgraph to be built in parallel.
+  const vid_t vertex_count = 20000;
+  graph_allocate(vertex_count, 2 * vertex_count, false, false, false, &graph);
+  for (vid_t v = 0; v < vertex_count; v++) {
+    graph->vertices[v] = 2 * v;
+    graph->edges[2 * v] = (v + vertex_count - 1) % vertex_count;
+    graph->edges[2 * v + 1] = (v + 1) % vertex_count;
+  }
+  graph->vertices[vertex_count] = 2 * vertex_count;
+  EXPECT_EQ(SUCCESS, subgraph_extractor_initialize(graph, &extractor));
+  EXPECT_EQ(SUCCESS, graph_extract_khop(extractor, &hub, 1, vertex_count / 2,
+                                        NULL, 0, &subgraph, &id_map));
+  EXPECT_EQ(vertex_count, subgraph->vertex_count);
+  ExpectInduced(graph, subgraph, id_map);
+  graph_finalize(subgraph);
+  free(id_map);
+  EXPECT_EQ(SUCCESS, subgraph_extractor_finalize(extractor));
+  bool* mask = reinterpret_cast<bool*>(calloc(vertex_count, sizeof(bool)));
+  for (vid_t v = 0; v < vertex_count; v += 3) mask[v] = mask[v + 1] = true;
+  EXPECT_EQ(SUCCESS, get_subgraph(graph, mask, &subgraph));
+  std::vector<vid_t> order;
+  for (vid_t v = 0; v < vertex_count; v++) if (mask[v]) order.push_back(v);
+  EXPECT_EQ((vid_t)order.size(), subgraph->vertex_count);
+  ExpectInduced(graph, subgraph, &order[0]);
+  graph_finalize(subgraph);
+  free(mask);
+  graph_finalize(graph);
+}
+
 TEST_F(GraphHelper, AtomicOperations) {
   // the following are used in all tests
   srand (time(NULL));
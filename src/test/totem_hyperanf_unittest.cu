@@ -0,0 +1,153 @@
+/*
+ * Contains unit tests for the HyperANF neighborhood function estimation.
+ */
+
+// system includes
+#include <algorithm>
+#include <vector>
+
+// totem includes
+#include "totem_common_unittest.h"
+
+class HyperAnfTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    // Ensure the minimum CUDA architecture is supported
+    CUDA_CHECK_VERSION();
+    _graph = NULL;
+    _neighborhood = NULL;
+  }
+  virtual void TearDown() {
+    if (_graph) graph_finalize(_graph);
+    if (_neighborhood) totem_free(_neighborhood, TOTEM_MEM_HOST_PINNED);
+  }
+
+  error_t Run(uint32_t log2_registers, uint32_t max_distance) {
+    if (_neighborhood) totem_free(_neighborhood, TOTEM_MEM_HOST_PINNED);
+    _neighborhood = NULL;
+    return hyperanf_cpu(_graph, log2_registers, max_distance, &_neighborhood,
+                        &_distance_count, &_effective_diameter,
+                        &_average_distance);
+  }
+
+  // Computes the exact neighborhood function via a BFS from every vertex.
+  void ExactNeighborhood(std::vector<double>* function) {
+    const vid_t n = _graph->vertex_count;
+    function->assign(1, n);
+    std::vector<vid_t> distance(n);
+    std::vector<vid_t> queue(n);
+    for (vid_t src = 0; src < n; src++) {
+      distance.assign(n, INFINITE);
+      distance[src] = 0;
+      queue[0] = src;
+      vid_t head = 0, tail = 1;
+      while (head < tail) {
+        vid_t u = queue[head++];
+        if (distance[u] + 1 >= function->size()) function->push_back(0);
+        for (eid_t e = _graph->vertices[u]; e < _graph->vertices[u + 1];
+             e++) {
+          vid_t v = _graph->edges[e];
+          if (distance[v] != INFINITE) continue;
+          distance[v] = distance[u] + 1;
+          (*function)[distance[v]]++;
+          queue[tail++] = v;
+        }
+      }
+    }
+    while (function->size() > 1 && function->back() == 0) function->pop_back();
+    for (size_t t = 1; t < function->size(); t++) {
+      (*function)[t] += (*function)[t - 1];
+    }
+  }
+
+  // Compares the estimated neighborhood function with the exact one, within
+  // the given relative error. The estimate may stop before the diameter, as
+  // the last vertices reached may not change any register.
+  void ExpectNeighborhood(double error) {
+    std::vector<double> exact;
+    ExactNeighborhood(&exact);
+    ASSERT_GE(exact.size(), _distance_count);
+    for (uint32_t t = 0; t < exact.size(); t++) {
+      double estimate = _neighborhood[std::min(t, _distance_count - 1)];
+      EXPECT_NEAR(exact[t], estimate, error * exact[t]);
+      if (t > 0 && t < _distance_count) {
+        EXPECT_LE(_neighborhood[t - 1], _neighborhood[t]);
+      }
+    }
+  }
+
+  graph_t* _graph;
+  double* _neighborhood;
+  uint32_t _distance_count;
+  double _effective_diameter;
+  double _average_distance;
+};
+
+// Tests invalid inputs.
+TEST_F(HyperAnfTest, Invalid) {
+  EXPECT_EQ(FAILURE, Run(8, 0));
+  EXPECT_EQ(SUCCESS, graph_initialize(DATA_FOLDER("chain_1000_nodes_weight"
+                                                  ".totem"), false, &_graph));
+  EXPECT_EQ(FAILURE, Run(3, 0));
+  EXPECT_EQ(FAILURE, Run(17, 0));
+}
+
+// Tests a graph without edges, where every vertex only reaches itself.
+TEST_F(HyperAnfTest, NoEdges) {
+  EXPECT_EQ(SUCCESS, graph_initialize(DATA_FOLDER("disconnected_1000_nodes"
+                                                  ".totem"), false, &_graph));
+  EXPECT_EQ(SUCCESS, Run(6, 0));
+  EXPECT_EQ((uint32_t)1, _distance_count);
+  EXPECT_EQ(1000, _neighborhood[0]);
+  EXPECT_EQ(0, _effective_diameter);
+  EXPECT_EQ(0, _average_distance);
+}
+
+// Tests a complete graph, where every pair is at distance one.
+TEST_F(HyperAnfTest, CompleteGraph) {
+  EXPECT_EQ(SUCCESS, graph_initialize(DATA_FOLDER("complete_graph_300_nodes"
+                                                  ".totem"), false, &_graph));
+  EXPECT_EQ(SUCCESS, Run(10, 0));
+  EXPECT_EQ((uint32_t)2, _distance_count);
+  EXPECT_NEAR(300 * 300, _neighborhood[1], 0.05 * 300 * 300);
+  EXPECT_NEAR(1, _average_distance, 1e-9);
+  EXPECT_NEAR(0.9, _effective_diameter, 0.05);
+}
+
+// Tests that the computation stops at the given distance.
+TEST_F(HyperAnfTest, MaxDistance) {
+  EXPECT_EQ(SUCCESS, graph_initialize(DATA_FOLDER("chain_1000_nodes_weight"
+                                                  ".totem"), false, &_graph));
+  EXPECT_EQ(SUCCESS, Run(6, 5));
+  EXPECT_EQ((uint32_t)6, _distance_count);
+}
+
+// Tests the estimates against the exact neighborhood function.
+TEST_F(HyperAnfTest, Reference) {
+  const char* graph_files[] = {
+    DATA_FOLDER("grid_graph_15_nodes_weight.totem"),
+    DATA_FOLDER("chain_4_comp_40_nodes.totem"),
+    DATA_FOLDER("star_1000_nodes.totem"),
+    DATA_FOLDER("wheel_graph_1000_nodes.totem"),
+    DATA_FOLDER("chain_100_nodes_weight_directed.totem"),
+    DATA_FOLDER("washington_random.totem")
+  };
+  for (size_t i = 0; i < sizeof(graph_files) / sizeof(*graph_files); i++) {
+    EXPECT_EQ(SUCCESS, graph_initialize(graph_files[i], false, &_graph));
+    ASSERT_EQ(SUCCESS, Run(12, 0));
+    ExpectNeighborhood(0.05);
+    graph_finalize(_graph);
+    _graph = NULL;
+  }
+}
+
+// Tests the statistics of a long chain against their exact values.
+TEST_F(HyperAnfTest, Chain) {
+  EXPECT_EQ(SUCCESS, graph_initialize(DATA_FOLDER("chain_1000_nodes_weight"
+                                                  ".totem"), false, &_graph));
+  EXPECT_EQ(SUCCESS, Run(10, 0));
+  ExpectNeighborhood(0.05);
+  // The average distance between two vertices of a chain of n vertices is
+  // (n + 1) / 3.
+  EXPECT_NEAR(1001.0 / 3, _average_distance, 0.05 * 1001.0 / 3);
+}
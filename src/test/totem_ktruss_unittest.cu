@@ -0,0 +1,207 @@
+/*
+ * Contains unit tests for the k-truss decomposition.
+ */
+
+// system includes
+#include <algorithm>
+#include <vector>
+
+// totem includes
+#include "totem_common_unittest.h"
+
+class KTrussTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    // Ensure the minimum CUDA architecture is supported
+    CUDA_CHECK_VERSION();
+    _graph = NULL;
+    _truss = NULL;
+  }
+  virtual void TearDown() {
+    if (_graph) graph_finalize(_graph);
+    if (_truss) totem_free(_truss, TOTEM_MEM_HOST_PINNED);
+  }
+
+  // Builds an undirected graph from a list of edges, each given once.
+  void BuildGraph(vid_t vertex_count, const vid_t (*edge_list)[2],
+                  eid_t edge_count) {
+    std::vector<std::vector<vid_t> > adjacency(vertex_count);
+    for (eid_t i = 0; i < edge_count; i++) {
+      adjacency[edge_list[i][0]].push_back(edge_list[i][1]);
+      adjacency[edge_list[i][1]].push_back(edge_list[i][0]);
+    }
+    for (vid_t u = 0; u < vertex_count; u++) {
+      std::sort(adjacency[u].begin(), adjacency[u].end());
+      adjacency[u].erase(std::unique(adjacency[u].begin(), adjacency[u].end()),
+                         adjacency[u].end());
+    }
+    AdjacencyToGraph(adjacency, false, false, &_graph);
+  }
+
+  // Computes the trussness of each edge by repeatedly removing the edges
+  // that close too few triangles, and compares it with the returned one.
+  void ExpectReferenceTruss() {
+    const vid_t n = _graph->vertex_count;
+    bool* alive = reinterpret_cast<bool*>(calloc(n * n, sizeof(bool)));
+    uint32_t* truss = reinterpret_cast<uint32_t*>(
+        calloc(n * n, sizeof(uint32_t)));
+    eid_t remaining = 0;
+    for (vid_t u = 0; u < n; u++) {
+      for (eid_t e = _graph->vertices[u]; e < _graph->vertices[u + 1]; e++) {
+        vid_t v = _graph->edges[e];
+        if (u == v) continue;
+        alive[u * n + v] = true;
+        remaining += (u < v);
+      }
+    }
+    for (uint32_t k = 2; remaining > 0; k++) {
+      bool removed = true;
+      while (removed) {
+        removed = false;
+        for (vid_t u = 0; u < n; u++) {
+          for (vid_t v = u + 1; v < n; v++) {
+            if (!alive[u * n + v]) continue;
+            uint32_t support = 0;
+            for (vid_t w = 0; w < n; w++) {
+              support += alive[u * n + w] && alive[v * n + w];
+            }
+            if (support + 2 > k) continue;
+            alive[u * n + v] = alive[v * n + u] = false;
+            truss[u * n + v] = truss[v * n + u] = k;
+            remaining--;
+            removed = true;
+          }
+        }
+      }
+    }
+    for (vid_t u = 0; u < n; u++) {
+      for (eid_t e = _graph->vertices[u]; e < _graph->vertices[u + 1]; e++) {
+        EXPECT_EQ(truss[u * n + _graph->edges[e]], _truss[e]);
+      }
+    }
+    free(alive);
+    free(truss);
+  }
+
+  graph_t* _graph;
+  uint32_t* _truss;
+};
+
+// Tests invalid inputs and graphs without edges.
+TEST_F(KTrussTest, Empty) {
+  graph_t graph;
+  graph.directed = false;
+  graph.vertex_count = 0;
+  graph.edge_count = 0;
+  EXPECT_EQ(FAILURE, ktruss_cpu(&graph, &_truss));
+
+  EXPECT_EQ(SUCCESS, graph_initialize(DATA_FOLDER("disconnected_1000_nodes"
+                                                  ".totem"), false, &_graph));
+  EXPECT_EQ(SUCCESS, ktruss_cpu(_graph, &_truss));
+  EXPECT_EQ((uint32_t*)NULL, _truss);
+}
+
+// Tests that directed graphs are rejected.
+TEST_F(KTrussTest, Directed) {
+  EXPECT_EQ(SUCCESS, graph_initialize(DATA_FOLDER("rmf_100_nodes.totem"),
+                                      false, &_graph));
+  EXPECT_EQ(FAILURE, ktruss_cpu(_graph, &_truss));
+}
+
+// Tests that graphs with unsorted neighbor lists are rejected.
+TEST_F(KTrussTest, Unsorted) {
+  EXPECT_EQ(SUCCESS, graph_initialize(DATA_FOLDER("ring_center_graph_1000_"
+                                                  "nodes.totem"), false,
+                                      &_graph));
+  EXPECT_EQ(FAILURE, ktruss_cpu(_graph, &_truss));
+  EXPECT_EQ((uint32_t*)NULL, _truss);
+}
+
+// Tests a single vertex with a self loop.
+TEST_F(KTrussTest, SingleNodeLoop) {
+  EXPECT_EQ(SUCCESS, graph_initialize(DATA_FOLDER("single_node_loop.totem"),
+                                      false, &_graph));
+  _graph->directed = false;
+  EXPECT_EQ(SUCCESS, ktruss_cpu(_graph, &_truss));
+  EXPECT_EQ((uint32_t)0, _truss[0]);
+}
+
+// Tests a 5-clique and a 4-clique that share a vertex, with a pendant edge.
+TEST_F(KTrussTest, Cliques) {
+  const vid_t edge_list[][2] = {
+    {0, 1}, {0, 2}, {0, 3}, {0, 4}, {1, 2}, {1, 3}, {1, 4}, {2, 3}, {2, 4},
+    {3, 4}, {4, 5}, {4, 6}, {4, 7}, {5, 6}, {5, 7}, {6, 7}, {7, 8}
+  };
+  BuildGraph(9, edge_list, sizeof(edge_list) / sizeof(*edge_list));
+  EXPECT_EQ(SUCCESS, ktruss_cpu(_graph, &_truss));
+  for (vid_t u = 0; u < _graph->vertex_count; u++) {
+    for (eid_t e = _graph->vertices[u]; e < _graph->vertices[u + 1]; e++) {
+      vid_t v = _graph->edges[e];
+      uint32_t expected = (u == 8 || v == 8) ? 2 : (u < 5 && v < 5) ? 5 : 4;
+      EXPECT_EQ(expected, _truss[e]);
+    }
+  }
+}
+
+// Tests a complete graph, where every edge is in the 300-truss.
+TEST_F(KTrussTest, CompleteGraph) {
+  EXPECT_EQ(SUCCESS, graph_initialize(DATA_FOLDER("complete_graph_300_nodes"
+                                                  ".totem"), false, &_graph));
+  EXPECT_EQ(SUCCESS, ktruss_cpu(_graph, &_truss));
+  for (eid_t e = 0; e < _graph->edge_count; e++) {
+    EXPECT_EQ(_graph->vertex_count, _truss[e]);
+  }
+}
+
+// Tests graphs without triangles.
+TEST_F(KTrussTest, TriangleFree) {
+  EXPECT_EQ(SUCCESS, graph_initialize(DATA_FOLDER("star_1000_nodes.totem"),
+                                      false, &_graph));
+  EXPECT_EQ(SUCCESS, ktruss_cpu(_graph, &_truss));
+  for (eid_t e = 0; e < _graph->edge_count; e++) {
+    EXPECT_EQ((uint32_t)2, _truss[e]);
+  }
+}
+
+// Tests graphs against the reference decomposition.
+TEST_F(KTrussTest, Reference) {
+  const char* graph_files[] = {
+    DATA_FOLDER("grid_graph_15_nodes_weight.totem"),
+    DATA_FOLDER("chain_4_comp_40_nodes.totem"),
+    DATA_FOLDER("wheel_graph_1000_nodes.totem")
+  };
+  for (size_t i = 0; i < sizeof(graph_files) / sizeof(*graph_files); i++) {
+    EXPECT_EQ(SUCCESS, graph_initialize(graph_files[i], false, &_graph));
+    ASSERT_EQ(SUCCESS, ktruss_cpu(_graph, &_truss));
+    ExpectReferenceTruss();
+    graph_finalize(_graph);
+    totem_free(_truss, TOTEM_MEM_HOST_PINNED);
+    _graph = NULL;
+    _truss = NULL;
+  }
+}
+
+// Tests a dense random graph, whose edges span many levels, against the
+// reference decomposition.
+TEST_F(KTrussTest, RandomGraph) {
+  const vid_t vertex_count = 80;
+  vid_t (*edge_list)[2] = reinterpret_cast<vid_t(*)[2]>(
+      malloc(vertex_count * vertex_count * sizeof(*edge_list)));
+  eid_t edge_count = 0;
+  uint32_t seed = 1985;
+  for (vid_t u = 0; u < vertex_count; u++) {
+    for (vid_t v = u + 1; v < vertex_count; v++) {
+      // Lower vertex ids are denser, which yields nested trusses.
+      if ((NextRandom(&seed) >> 16) % vertex_count <
+          vertex_count - (u + v) / 2) {
+        edge_list[edge_count][0] = u;
+        edge_list[edge_count][1] = v;
+        edge_count++;
+      }
+    }
+  }
+  BuildGraph(vertex_count, edge_list, edge_count);
+  free(edge_list);
+  ASSERT_EQ(SUCCESS, ktruss_cpu(_graph, &_truss));
+  ExpectReferenceTruss();
+}
@@ -39,6 +39,34 @@ public TestWithParam<LabelPropagationFunction> {
     if (_labels) totem_free(_labels, _mem_type);
   }
 
+  // Checks that the labels are stable, that is, the label of every vertex is
+  // one of the most frequent labels among its neighbors.
+  void ExpectStableLabels() {
+    for (vid_t v = 0; v < _graph->vertex_count; v++) {
+      eid_t degree = _graph->vertices[v + 1] - _graph->vertices[v];
+      if (degree == 0) continue;
+      eid_t own_count = 0;
+      eid_t max_count = 0;
+      for (eid_t i = _graph->vertices[v]; i < _graph->vertices[v + 1]; i++) {
+        eid_t count = 0;
+        for (eid_t j = _graph->vertices[v]; j < _graph->vertices[v + 1];
+             j++) {
+          count += (_labels[_graph->edges[i]] == _labels[_graph->edges[j]]);
+        }
+        if (_labels[_graph->edges[i]] == _labels[v]) own_count = count;
+        max_count = count > max_count ? count : max_count;
+      }
+      EXPECT_EQ(max_count, own_count);
+    }
+  }
+
+  // Checks that all the vertices ended up in a single community.
+  void ExpectSingleCommunity() {
+    for (vid_t vertex = 0; vertex < _graph->vertex_count; vertex++) {
+      EXPECT_EQ(_labels[0], _labels[vertex]);
+    }
+  }
+
  protected:
   LabelPropagationFunction labelPropagation;
   graph_t* _graph;
@@ -76,9 +104,7 @@ TEST_P(LabelPropagationTest, CompleteGraph300NodesUndirected) {
                          reinterpret_cast<void**>(&_labels)));
   EXPECT_EQ(SUCCESS, labelPropagation(_graph, _labels));
   EXPECT_FALSE(_labels == NULL);
-  for (vid_t vertex = 0; vertex < _graph->vertex_count; vertex++) {
-    EXPECT_FLOAT_EQ(0, _labels[vertex]);
-  }
+  ExpectSingleCommunity();
 }
 
 // Tests LabelPropagation for an undirected grid graph with 15 nodes.
@@ -90,15 +116,16 @@ TEST_P(LabelPropagationTest, GridGraph15NodesUndirected) {
                         reinterpret_cast<void**>(&_labels)));
   EXPECT_EQ(SUCCESS, labelPropagation(_graph, _labels));
   EXPECT_FALSE(_labels == NULL);
+  ExpectStableLabels();
+  // Each vertex of the grid has at least two neighbors, hence no vertex is
+  // left in a community of its own.
   for (vid_t vertex = 0; vertex < _graph->vertex_count; vertex++) {
-    if (vertex == 0 || vertex == 1 || vertex == 5 || vertex == 6 ||
-        vertex == 10 || vertex == 11)
-      EXPECT_FLOAT_EQ(6, _labels[vertex]);
-    else if (vertex == 2 || vertex == 7 || vertex == 12)
-      EXPECT_FLOAT_EQ(7, _labels[vertex]);
-    else if (vertex == 3 || vertex == 4 || vertex == 8 || vertex == 9 ||
-        vertex == 13 || vertex == 14)
-      EXPECT_FLOAT_EQ(8, _labels[vertex]);
+    bool shared = false;
+    for (eid_t e = _graph->vertices[vertex]; e < _graph->vertices[vertex + 1];
+         e++) {
+      shared |= (_labels[_graph->edges[e]] == _labels[vertex]);
+    }
+    EXPECT_TRUE(shared);
   }
 }
 
@@ -111,12 +138,25 @@ TEST_P(LabelPropagationTest, ChainGraph1000NodesUndirected) {
                          reinterpret_cast<void**>(&_labels)));
   EXPECT_EQ(SUCCESS, labelPropagation(_graph, _labels));
   EXPECT_FALSE(_labels == NULL);
-  // Labels of all the vertices are expected to converge with label being 1.
-  // For the chain graph, the number of iterations required for all the
-  // vertices to reach convergence appears to be quite large. After 25
-  // iterations only 6 vertices converged.
-  for (vid_t vertex = 0; vertex < 6; vertex++) {
-    EXPECT_FLOAT_EQ(1, _labels[vertex]);
+  ExpectStableLabels();
+}
+
+// Tests that labels do not propagate across connected components.
+TEST_P(LabelPropagationTest, ChainGraph4Components40NodesUndirected) {
+  EXPECT_EQ(SUCCESS,
+            graph_initialize(DATA_FOLDER("chain_4_comp_40_nodes.totem"),
+                             false, &_graph));
+  CALL_SAFE(totem_malloc(_graph->vertex_count * sizeof(vid_t), _mem_type,
+                         reinterpret_cast<void**>(&_labels)));
+  EXPECT_EQ(SUCCESS, labelPropagation(_graph, _labels));
+  ExpectStableLabels();
+  // The components are [0-9], [10-19], [20-30] and [31-39].
+  const vid_t component_start[] = {0, 10, 20, 31, 40};
+  for (int c = 0; c < 4; c++) {
+    for (vid_t v = component_start[c]; v < component_start[c + 1]; v++) {
+      EXPECT_GE(_labels[v], component_start[c]);
+      EXPECT_LT(_labels[v], component_start[c + 1]);
+    }
   }
 }
 
@@ -129,9 +169,7 @@ TEST_P(LabelPropagationTest, StarGraph1000NodesUndirected) {
                          reinterpret_cast<void**>(&_labels)));
   EXPECT_EQ(SUCCESS, labelPropagation(_graph, _labels));
   EXPECT_FALSE(_labels == NULL);
-  for (vid_t vertex = 0; vertex < _graph->vertex_count; vertex++) {
-    EXPECT_FLOAT_EQ(0, _labels[vertex]);
-  }
+  ExpectSingleCommunity();
 }
 
 // Tests LabelPropagation for a graph with 1K disconnected nodes.
@@ -158,9 +196,7 @@ TEST_P(LabelPropagationTest, WheelGraph1000NodesUndirected) {
                          reinterpret_cast<void**>(&_labels)));
   EXPECT_EQ(SUCCESS, labelPropagation(_graph, _labels));
   EXPECT_FALSE(_labels == NULL);
-  for (vid_t vertex = 0; vertex < _graph->vertex_count; vertex++) {
-    EXPECT_FLOAT_EQ(0, _labels[vertex]);
-  }
+  ExpectSingleCommunity();
 }
 
 // From Google documentation:
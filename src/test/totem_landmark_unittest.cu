@@ -0,0 +1,314 @@
+/*
+ * Contains unit tests for the landmark distance oracle, and the A* search it
+ * guides.
+ */
+
+// system includes
+#include <vector>
+
+// totem includes
+#include "totem_common_unittest.h"
+
+class LandmarkTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    // Ensure the minimum CUDA architecture is supported
+    CUDA_CHECK_VERSION();
+    _graph = NULL;
+    _index = NULL;
+    _engine = NULL;
+  }
+  virtual void TearDown() {
+    if (_engine) point_to_point_finalize(_engine);
+    if (_index) landmark_index_finalize(_index);
+    if (_graph) graph_finalize(_graph);
+  }
+
+  void Initialize(const char* graph_file, bool weighted) {
+    if (_engine) point_to_point_finalize(_engine);
+    if (_index) landmark_index_finalize(_index);
+    if (_graph) graph_finalize(_graph);
+    _engine = NULL;
+    _index = NULL;
+    ASSERT_EQ(SUCCESS, graph_initialize(graph_file, weighted, &_graph));
+    ASSERT_EQ(SUCCESS, point_to_point_initialize(_graph, &_engine));
+  }
+
+  void Build(uint32_t landmark_count, landmark_selection_t selection) {
+    if (_index) landmark_index_finalize(_index);
+    _index = NULL;
+    ASSERT_EQ(SUCCESS, landmark_index_build_cpu(_graph, landmark_count,
+                                                selection, &_index));
+  }
+
+  // Computes the distance from a source to every vertex, in hops for
+  // unweighted graphs. Unreachable vertices are at distance INFINITE.
+  void Reference(vid_t source, std::vector<weight_t>* distance) {
+    distance->assign(_graph->vertex_count, INFINITE);
+    std::vector<bool> settled(_graph->vertex_count, false);
+    (*distance)[source] = 0;
+    // A quadratic Dijkstra is enough for the test graphs.
+    while (true) {
+      vid_t u = INFINITE;
+      for (vid_t v = 0; v < _graph->vertex_count; v++) {
+        if (!settled[v] && (*distance)[v] != INFINITE &&
+            (u == INFINITE || (*distance)[v] < (*distance)[u])) {
+          u = v;
+        }
+      }
+      if (u == INFINITE) break;
+      settled[u] = true;
+      for (eid_t e = _graph->vertices[u]; e < _graph->vertices[u + 1]; e++) {
+        weight_t weight = _graph->weighted ? _graph->weights[e] : 1;
+        vid_t v = _graph->edges[e];
+        if ((*distance)[u] + weight < (*distance)[v]) {
+          (*distance)[v] = (*distance)[u] + weight;
+        }
+      }
+    }
+  }
+
+  // Checks the bounds and the A* search from every step-th source to every
+  // vertex against the reference.
+  void ExpectExact(vid_t step) {
+    std::vector<weight_t> reference;
+    std::vector<vid_t> path(_graph->vertex_count);
+    for (vid_t s = 0; s < _graph->vertex_count; s += step) {
+      Reference(s, &reference);
+      for (vid_t t = 0; t < _graph->vertex_count; t++) {
+        weight_t lower, upper;
+        ASSERT_EQ(SUCCESS, landmark_estimate(_index, s, t, &lower, &upper));
+        if (reference[t] == INFINITE) {
+          EXPECT_EQ(INFINITE, upper);
+        } else {
+          EXPECT_LE(lower, reference[t]);
+          EXPECT_GE(upper, reference[t]);
+        }
+
+        weight_t distance;
+        vid_t path_length;
+        ASSERT_EQ(SUCCESS, point_to_point_alt_cpu(_engine, _index, s, t,
+                                                  &distance, &path[0],
+                                                  &path_length));
+        ASSERT_EQ(reference[t], distance);
+        if (distance == INFINITE) {
+          EXPECT_EQ((vid_t)0, path_length);
+          continue;
+        }
+        ASSERT_LT((vid_t)0, path_length);
+        EXPECT_EQ(s, path[0]);
+        EXPECT_EQ(t, path[path_length - 1]);
+        uint64_t length = 0;
+        for (vid_t i = 1; i < path_length; i++) {
+          weight_t weight = INFINITE;
+          for (eid_t e = _graph->vertices[path[i - 1]];
+               e < _graph->vertices[path[i - 1] + 1]; e++) {
+            if (_graph->edges[e] != path[i]) continue;
+            weight = std::min(weight, _graph->weighted ?
+                              _graph->weights[e] : (weight_t)1);
+          }
+          EXPECT_NE(INFINITE, weight);
+          length += weight;
+        }
+        EXPECT_EQ(distance, length);
+      }
+    }
+  }
+
+  graph_t* _graph;
+  landmark_index_t* _index;
+  point_to_point_t* _engine;
+};
+
+// Tests invalid inputs.
+TEST_F(LandmarkTest, Invalid) {
+  EXPECT_EQ(FAILURE, landmark_index_build_cpu(NULL, 4,
+                                              LANDMARK_SELECTION_DEGREE,
+                                              &_index));
+  Initialize(DATA_FOLDER("grid_graph_15_nodes_weight.totem"), true);
+  EXPECT_EQ(FAILURE, landmark_index_build_cpu(_graph, 0,
+                                              LANDMARK_SELECTION_DEGREE,
+                                              &_index));
+  EXPECT_EQ(FAILURE, landmark_index_build_cpu(_graph, 16,
+                                              LANDMARK_SELECTION_DEGREE,
+                                              &_index));
+  Build(15, LANDMARK_SELECTION_FARTHEST);
+  weight_t lower, upper;
+  EXPECT_EQ(FAILURE, landmark_estimate(_index, 0, 15, &lower, &upper));
+
+  // The index was built for a weighted graph.
+  graph_t* graph = NULL;
+  point_to_point_t* engine = NULL;
+  EXPECT_EQ(SUCCESS, graph_initialize(DATA_FOLDER("grid_graph_15_nodes_weight"
+                                                  ".totem"), false, &graph));
+  EXPECT_EQ(SUCCESS, point_to_point_initialize(graph, &engine));
+  EXPECT_EQ(FAILURE, point_to_point_alt_cpu(engine, _index, 0, 1, &lower,
+                                            NULL, NULL));
+  point_to_point_finalize(engine);
+  graph_finalize(graph);
+}
+
+// Tests that every vertex is a landmark when they are all selected, hence the
+// bounds are exact.
+TEST_F(LandmarkTest, AllLandmarks) {
+  Initialize(DATA_FOLDER("grid_graph_15_nodes_weight.totem"), true);
+  Build(_graph->vertex_count, LANDMARK_SELECTION_FARTHEST);
+  std::vector<bool> selected(_graph->vertex_count, false);
+  for (uint32_t i = 0; i < _index->landmark_count; i++) {
+    EXPECT_FALSE(selected[_index->landmarks[i]]);
+    selected[_index->landmarks[i]] = true;
+  }
+  std::vector<weight_t> reference;
+  for (vid_t s = 0; s < _graph->vertex_count; s++) {
+    Reference(s, &reference);
+    for (vid_t t = 0; t < _graph->vertex_count; t++) {
+      weight_t lower, upper;
+      EXPECT_EQ(SUCCESS, landmark_estimate(_index, s, t, &lower, &upper));
+      EXPECT_EQ(reference[t], lower);
+      EXPECT_EQ(reference[t], upper);
+    }
+  }
+}
+
+// Tests the selection heuristics.
+TEST_F(LandmarkTest, Selection) {
+  Initialize(DATA_FOLDER("star_1000_nodes.totem"), false);
+  Build(1, LANDMARK_SELECTION_DEGREE);
+  EXPECT_EQ((vid_t)0, _index->landmarks[0]);
+
+  // On a chain, the farthest vertex from the first landmark is an end of it.
+  Initialize(DATA_FOLDER("chain_1000_nodes_weight.totem"), false);
+  Build(2, LANDMARK_SELECTION_FARTHEST);
+  EXPECT_EQ((vid_t)1, _index->landmarks[0]);
+  EXPECT_EQ((vid_t)999, _index->landmarks[1]);
+
+  // Vertices in components without a landmark come first.
+  Initialize(DATA_FOLDER("chain_4_comp_40_nodes.totem"), false);
+  Build(4, LANDMARK_SELECTION_FARTHEST);
+  std::vector<bool> component(4, false);
+  for (uint32_t i = 0; i < 4; i++) component[_index->landmarks[i] / 10] = true;
+  EXPECT_EQ(std::vector<bool>(4, true), component);
+}
+
+// Tests that distances that do not fit in 16 bits are stored in full.
+TEST_F(LandmarkTest, Compact) {
+  Initialize(DATA_FOLDER("chain_1000_nodes_weight.totem"), false);
+  Build(4, LANDMARK_SELECTION_DEGREE);
+  EXPECT_TRUE(_index->compact);
+
+  graph_finalize(_graph);
+  // A chain of four vertices, whose landmark is vertex 1.
+  graph_allocate(4, 6, false, true, false, &_graph);
+  const vid_t edges[] = {1, 0, 2, 1, 3, 2};
+  const eid_t vertices[] = {0, 1, 3, 5, 6};
+  for (eid_t e = 0; e < 6; e++) {
+    _graph->edges[e] = edges[e];
+    _graph->weights[e] = 40000;
+  }
+  for (vid_t v = 0; v <= 4; v++) _graph->vertices[v] = vertices[v];
+  Build(1, LANDMARK_SELECTION_DEGREE);
+  EXPECT_FALSE(_index->compact);
+  weight_t lower, upper;
+  EXPECT_EQ(SUCCESS, landmark_estimate(_index, 1, 3, &lower, &upper));
+  EXPECT_EQ((weight_t)80000, lower);
+  EXPECT_EQ((weight_t)80000, upper);
+}
+
+// Tests the farthest selection when zero-weight edges put every vertex at
+// distance zero from the first landmark.
+TEST_F(LandmarkTest, ZeroWeights) {
+  // A chain of four vertices whose edges all weigh zero.
+  graph_allocate(4, 6, false, true, false, &_graph);
+  const vid_t edges[] = {1, 0, 2, 1, 3, 2};
+  const eid_t vertices[] = {0, 1, 3, 5, 6};
+  for (eid_t e = 0; e < 6; e++) {
+    _graph->edges[e] = edges[e];
+    _graph->weights[e] = 0;
+  }
+  for (vid_t v = 0; v <= 4; v++) _graph->vertices[v] = vertices[v];
+
+  // The landmarks after the first one follow the degree order.
+  Build(4, LANDMARK_SELECTION_FARTHEST);
+  const vid_t expected[] = {1, 2, 0, 3};
+  for (uint32_t i = 0; i < 4; i++) {
+    EXPECT_EQ(expected[i], _index->landmarks[i]);
+  }
+  for (vid_t s = 0; s < 4; s++) {
+    for (vid_t t = 0; t < 4; t++) {
+      weight_t lower, upper;
+      EXPECT_EQ(SUCCESS, landmark_estimate(_index, s, t, &lower, &upper));
+      EXPECT_EQ((weight_t)0, lower);
+      EXPECT_EQ((weight_t)0, upper);
+    }
+  }
+}
+
+// Tests that a stored index is loaded back with the same content.
+TEST_F(LandmarkTest, StoreLoad) {
+  const char* graph_files[] = {
+    DATA_FOLDER("star_1000_nodes_diff_weight.totem"),
+    DATA_FOLDER("washington_random.totem")
+  };
+  for (int i = 0; i < 2; i++) {
+    Initialize(graph_files[i], i == 0);
+    Build(5, LANDMARK_SELECTION_FARTHEST);
+    char file_path[] = "/tmp/totem_landmark_XXXXXX";
+    int fd = mkstemp(file_path);
+    ASSERT_NE(-1, fd);
+    close(fd);
+    EXPECT_EQ(SUCCESS, landmark_index_store(_index, file_path));
+    landmark_index_t* loaded = NULL;
+    ASSERT_EQ(SUCCESS, landmark_index_load(_graph, file_path, &loaded));
+    EXPECT_EQ(_index->landmark_count, loaded->landmark_count);
+    EXPECT_EQ(_index->compact, loaded->compact);
+    EXPECT_EQ(_index->from == _index->to, loaded->from == loaded->to);
+    for (uint32_t l = 0; l < _index->landmark_count; l++) {
+      EXPECT_EQ(_index->landmarks[l], loaded->landmarks[l]);
+    }
+    for (vid_t s = 0; s < _graph->vertex_count; s += 7) {
+      for (vid_t t = 0; t < _graph->vertex_count; t += 3) {
+        weight_t lower, upper, loaded_lower, loaded_upper;
+        EXPECT_EQ(SUCCESS, landmark_estimate(_index, s, t, &lower, &upper));
+        EXPECT_EQ(SUCCESS, landmark_estimate(loaded, s, t, &loaded_lower,
+                                             &loaded_upper));
+        EXPECT_EQ(lower, loaded_lower);
+        EXPECT_EQ(upper, loaded_upper);
+      }
+    }
+    EXPECT_EQ(SUCCESS, landmark_index_finalize(loaded));
+
+    // The index does not match a graph of a different size.
+    graph_t* other = NULL;
+    EXPECT_EQ(SUCCESS, graph_initialize(DATA_FOLDER("grid_graph_15_nodes_"
+                                                    "weight.totem"), i == 0,
+                                        &other));
+    EXPECT_EQ(FAILURE, landmark_index_load(other, file_path, &loaded));
+    graph_finalize(other);
+    unlink(file_path);
+  }
+}
+
+// Tests the bounds and the A* search against a reference.
+TEST_F(LandmarkTest, Reference) {
+  const char* graph_files[] = {
+    DATA_FOLDER("grid_graph_sssp_15_nodes_weight.totem"),
+    DATA_FOLDER("chain_4_comp_40_nodes.totem"),
+    DATA_FOLDER("chain_100_nodes_weight_directed.totem"),
+    DATA_FOLDER("star_1000_nodes_diff_weight.totem"),
+    DATA_FOLDER("wheel_graph_1000_nodes.totem"),
+    DATA_FOLDER("rmf_100_nodes.totem"),
+    DATA_FOLDER("washington_random.totem")
+  };
+  const landmark_selection_t selections[] = {
+    LANDMARK_SELECTION_DEGREE, LANDMARK_SELECTION_FARTHEST
+  };
+  for (size_t i = 0; i < sizeof(graph_files) / sizeof(*graph_files); i++) {
+    for (int weighted = 0; weighted < 2; weighted++) {
+      for (int s = 0; s < 2; s++) {
+        Initialize(graph_files[i], weighted);
+        Build(4, selections[s]);
+        ExpectExact(_graph->vertex_count > 100 ? 97 : 3);
+      }
+    }
+  }
+}
@@ -0,0 +1,159 @@
+/*
+ * Contains unit tests for the Louvain community detection algorithm.
+ */
+
+// totem includes
+#include "totem_common_unittest.h"
+
+class LouvainTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    // Ensure the minimum CUDA architecture is supported
+    CUDA_CHECK_VERSION();
+    _graph = NULL;
+    _community = NULL;
+  }
+  virtual void TearDown() {
+    if (_graph) graph_finalize(_graph);
+    if (_community) totem_free(_community, TOTEM_MEM_HOST);
+  }
+
+  void Run(const char* graph_file) {
+    EXPECT_EQ(SUCCESS, graph_initialize(graph_file, _graph_weighted,
+                                        &_graph));
+    CALL_SAFE(totem_malloc(_graph->vertex_count * sizeof(vid_t),
+                           TOTEM_MEM_HOST,
+                           reinterpret_cast<void**>(&_community)));
+    EXPECT_EQ(SUCCESS, louvain_cpu(_graph, _community, &_modularity));
+    ExpectDenseCommunities();
+    EXPECT_NEAR(Modularity(), _modularity, 1e-9);
+  }
+
+  // Checks that the communities are numbered from 0 without gaps.
+  void ExpectDenseCommunities() {
+    vid_t max_community = 0;
+    for (vid_t v = 0; v < _graph->vertex_count; v++) {
+      max_community = std::max(max_community, _community[v]);
+    }
+    bool* seen = reinterpret_cast<bool*>(calloc(max_community + 1,
+                                                sizeof(bool)));
+    for (vid_t v = 0; v < _graph->vertex_count; v++) {
+      seen[_community[v]] = true;
+    }
+    for (vid_t c = 0; c <= max_community; c++) EXPECT_TRUE(seen[c]);
+    free(seen);
+  }
+
+  // Computes the modularity of the returned communities from its definition.
+  double Modularity() {
+    double two_m = 0;
+    double inside = 0;
+    double* total = reinterpret_cast<double*>(
+        calloc(_graph->vertex_count, sizeof(double)));
+    for (vid_t v = 0; v < _graph->vertex_count; v++) {
+      for (eid_t e = _graph->vertices[v]; e < _graph->vertices[v + 1]; e++) {
+        double weight = _graph->weighted ? _graph->weights[e] : 1;
+        two_m += weight;
+        total[_community[v]] += weight;
+        if (_community[v] == _community[_graph->edges[e]]) inside += weight;
+      }
+    }
+    double modularity = 0;
+    if (two_m != 0) {
+      modularity = inside / two_m;
+      for (vid_t c = 0; c < _graph->vertex_count; c++) {
+        modularity -= (total[c] / two_m) * (total[c] / two_m);
+      }
+    }
+    free(total);
+    return modularity;
+  }
+
+  graph_t* _graph;
+  bool _graph_weighted;
+  vid_t* _community;
+  double _modularity;
+};
+
+// Tests invalid inputs.
+TEST_F(LouvainTest, Empty) {
+  graph_t graph;
+  graph.directed = false;
+  graph.vertex_count = 0;
+  graph.edge_count = 0;
+  vid_t community;
+  EXPECT_EQ(FAILURE, louvain_cpu(&graph, &community, &_modularity));
+
+  EXPECT_EQ(SUCCESS, graph_initialize(DATA_FOLDER("chain_100_nodes_weight_"
+                                                  "directed.totem"), true,
+                                      &_graph));
+  CALL_SAFE(totem_malloc(_graph->vertex_count * sizeof(vid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&_community)));
+  EXPECT_EQ(FAILURE, louvain_cpu(_graph, _community, &_modularity));
+}
+
+// Tests a graph with a single vertex.
+TEST_F(LouvainTest, SingleNode) {
+  _graph_weighted = false;
+  Run(DATA_FOLDER("single_node.totem"));
+  EXPECT_EQ((vid_t)0, _community[0]);
+  EXPECT_EQ(0, _modularity);
+}
+
+// Tests a graph without edges, where each vertex is a community of its own.
+TEST_F(LouvainTest, Disconnected) {
+  _graph_weighted = false;
+  Run(DATA_FOLDER("disconnected_1000_nodes.totem"));
+  for (vid_t v = 0; v < _graph->vertex_count; v++) {
+    EXPECT_EQ(v, _community[v]);
+  }
+}
+
+// Tests that communities do not span connected components, and that each
+// chain is split into a few communities.
+TEST_F(LouvainTest, ChainComponents) {
+  _graph_weighted = false;
+  Run(DATA_FOLDER("chain_4_comp_40_nodes.totem"));
+  // The components are [0-9], [10-19], [20-30] and [31-39].
+  const vid_t component_start[] = {0, 10, 20, 31, 40};
+  for (int c = 0; c < 4; c++) {
+    for (vid_t v = component_start[c]; v < component_start[c + 1]; v++) {
+      for (int other = 0; other < 4; other++) {
+        if (other == c) continue;
+        EXPECT_NE(_community[v], _community[component_start[other]]);
+      }
+    }
+  }
+  EXPECT_GT(_modularity, 0.7);
+}
+
+// Tests a long chain, whose optimal partitioning has many communities and
+// needs several levels.
+TEST_F(LouvainTest, Chain) {
+  _graph_weighted = false;
+  Run(DATA_FOLDER("chain_1000_nodes.totem"));
+  EXPECT_GT(_modularity, 0.9);
+}
+
+// Tests a weighted graph.
+TEST_F(LouvainTest, WeightedChain) {
+  _graph_weighted = true;
+  Run(DATA_FOLDER("chain_1000_nodes_weight.totem"));
+  EXPECT_GT(_modularity, 0.9);
+}
+
+// Tests a complete graph, where no partitioning has a positive modularity.
+TEST_F(LouvainTest, CompleteGraph) {
+  _graph_weighted = false;
+  Run(DATA_FOLDER("complete_graph_300_nodes.totem"));
+  EXPECT_NEAR(0, _modularity, 1e-2);
+}
+
+// Tests a star graph, which ends up as a single community.
+TEST_F(LouvainTest, Star) {
+  _graph_weighted = false;
+  Run(DATA_FOLDER("star_1000_nodes.totem"));
+  for (vid_t v = 0; v < _graph->vertex_count; v++) {
+    EXPECT_EQ(_community[0], _community[v]);
+  }
+}
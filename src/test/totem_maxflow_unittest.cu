@@ -145,6 +145,33 @@ INSTANTIATE_TEST_CASE_P(MaxFlowGPUAndCPUTest, MaxFlowTest,
                                &maxflow_gpu,
                                &maxflow_vwarp_gpu));
 
+// Tests that a residual graph can be shared by several flow computations.
+TEST(MaxFlowResidualTest, ReuseAcrossSinks) {
+  graph_t* graph = NULL;
+  CALL_SAFE(graph_initialize(DATA_FOLDER("washington_random.totem"), true,
+                             &graph));
+  maxflow_residual_t* residual = NULL;
+  EXPECT_EQ(FAILURE, maxflow_residual_initialize(NULL, &residual));
+  EXPECT_EQ(SUCCESS, maxflow_residual_initialize(graph, &residual));
+  vid_t source = 0;
+  vid_t sink = graph->vertex_count - 1;
+  weight_t flow = 0;
+  EXPECT_EQ(FAILURE, maxflow_residual_cpu(residual, source, source, &flow));
+  EXPECT_EQ(SUCCESS, maxflow_residual_cpu(residual, source, sink, &flow));
+  EXPECT_EQ((weight_t)863, flow);
+  for (vid_t v = 1; v < graph->vertex_count; v += 7) {
+    weight_t expected = 0;
+    EXPECT_EQ(SUCCESS, maxflow_cpu(graph, source, v, &expected));
+    EXPECT_EQ(SUCCESS, maxflow_residual_cpu(residual, source, v, &flow));
+    EXPECT_EQ(expected, flow);
+  }
+  // The residual graph is not modified by the computations.
+  EXPECT_EQ(SUCCESS, maxflow_residual_cpu(residual, source, sink, &flow));
+  EXPECT_EQ((weight_t)863, flow);
+  EXPECT_EQ(SUCCESS, maxflow_residual_finalize(residual));
+  graph_finalize(graph);
+}
+
 #else
 
 // From Google documentation:
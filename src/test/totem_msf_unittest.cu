@@ -0,0 +1,190 @@
+/*
+ * Contains unit tests for the minimum spanning forest.
+ */
+
+// system includes
+#include <algorithm>
+#include <vector>
+
+// totem includes
+#include "totem_common_unittest.h"
+
+class MsfTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    // Ensure the minimum CUDA architecture is supported
+    CUDA_CHECK_VERSION();
+    _graph = NULL;
+    _forest = NULL;
+  }
+  virtual void TearDown() {
+    if (_graph) graph_finalize(_graph);
+    if (_forest) totem_free(_forest, TOTEM_MEM_HOST_PINNED);
+  }
+
+  vid_t Find(std::vector<vid_t>* parent, vid_t v) {
+    while ((*parent)[v] != v) {
+      (*parent)[v] = (*parent)[(*parent)[v]];
+      v = (*parent)[v];
+    }
+    return v;
+  }
+
+  weight_t Weight(eid_t e) {
+    return _graph->weighted ? _graph->weights[e] : DEFAULT_EDGE_WEIGHT;
+  }
+
+  // Computes the weight of the forest via Kruskal's algorithm, using the same
+  // edge weights, and checks that the returned edges form a spanning forest of
+  // that weight.
+  void ExpectMinimumForest() {
+    const vid_t n = _graph->vertex_count;
+    std::vector<std::pair<weight_t, eid_t> > edges;
+    std::vector<vid_t> source(_graph->edge_count);
+    for (vid_t u = 0; u < n; u++) {
+      for (eid_t e = _graph->vertices[u]; e < _graph->vertices[u + 1]; e++) {
+        source[e] = u;
+        if (u < _graph->edges[e]) edges.push_back(std::make_pair(Weight(e), e));
+      }
+    }
+    std::sort(edges.begin(), edges.end());
+    std::vector<vid_t> parent(n);
+    for (vid_t v = 0; v < n; v++) parent[v] = v;
+    uint64_t expected_weight = 0;
+    vid_t expected_count = 0;
+    for (size_t i = 0; i < edges.size(); i++) {
+      eid_t e = edges[i].second;
+      vid_t a = Find(&parent, source[e]);
+      vid_t b = Find(&parent, _graph->edges[e]);
+      if (a == b) continue;
+      parent[a] = b;
+      expected_weight += edges[i].first;
+      expected_count++;
+    }
+    EXPECT_EQ(expected_weight, _total_weight);
+    EXPECT_EQ(expected_count, _forest_count);
+
+    // The returned edges are canonical, sorted and acyclic.
+    for (vid_t v = 0; v < n; v++) parent[v] = v;
+    uint64_t weight = 0;
+    for (vid_t i = 0; i < _forest_count; i++) {
+      eid_t e = _forest[i];
+      ASSERT_GT(_graph->edge_count, e);
+      if (i > 0) EXPECT_LT(_forest[i - 1], e);
+      EXPECT_LT(source[e], _graph->edges[e]);
+      vid_t a = Find(&parent, source[e]);
+      vid_t b = Find(&parent, _graph->edges[e]);
+      EXPECT_NE(a, b);
+      parent[a] = b;
+      weight += Weight(e);
+    }
+    EXPECT_EQ(expected_weight, weight);
+  }
+
+  graph_t* _graph;
+  eid_t* _forest;
+  vid_t _forest_count;
+  uint64_t _total_weight;
+};
+
+// Tests invalid inputs and graphs without edges.
+TEST_F(MsfTest, Empty) {
+  graph_t graph;
+  graph.directed = false;
+  graph.vertex_count = 0;
+  graph.edge_count = 0;
+  EXPECT_EQ(FAILURE, msf_cpu(&graph, &_forest, &_forest_count,
+                             &_total_weight));
+
+  EXPECT_EQ(SUCCESS, graph_initialize(DATA_FOLDER("disconnected_1000_nodes"
+                                                  ".totem"), false, &_graph));
+  EXPECT_EQ(SUCCESS, msf_cpu(_graph, &_forest, &_forest_count,
+                             &_total_weight));
+  EXPECT_EQ((eid_t*)NULL, _forest);
+  EXPECT_EQ((vid_t)0, _forest_count);
+  EXPECT_EQ((uint64_t)0, _total_weight);
+}
+
+// Tests that directed graphs are rejected.
+TEST_F(MsfTest, Directed) {
+  EXPECT_EQ(SUCCESS, graph_initialize(DATA_FOLDER("rmf_100_nodes.totem"),
+                                      false, &_graph));
+  EXPECT_EQ(FAILURE, msf_cpu(_graph, &_forest, &_forest_count,
+                             &_total_weight));
+}
+
+// Tests a single vertex with a self loop, which is not part of the forest.
+TEST_F(MsfTest, SingleNodeLoop) {
+  EXPECT_EQ(SUCCESS, graph_initialize(DATA_FOLDER("single_node_loop.totem"),
+                                      false, &_graph));
+  _graph->directed = false;
+  EXPECT_EQ(SUCCESS, msf_cpu(_graph, &_forest, &_forest_count,
+                             &_total_weight));
+  EXPECT_EQ((vid_t)0, _forest_count);
+  EXPECT_EQ((uint64_t)0, _total_weight);
+}
+
+// Tests that a tree is its own spanning tree.
+TEST_F(MsfTest, Tree) {
+  EXPECT_EQ(SUCCESS, graph_initialize(DATA_FOLDER("chain_1000_nodes_weight"
+                                                  ".totem"), true, &_graph));
+  EXPECT_EQ(SUCCESS, msf_cpu(_graph, &_forest, &_forest_count,
+                             &_total_weight));
+  EXPECT_EQ(_graph->vertex_count - 1, _forest_count);
+  ExpectMinimumForest();
+}
+
+// Tests weighted and unweighted graphs, connected or not, against Kruskal's
+// algorithm.
+TEST_F(MsfTest, Reference) {
+  const char* graph_files[] = {
+    DATA_FOLDER("grid_graph_15_nodes_weight.totem"),
+    DATA_FOLDER("complete_graph_300_nodes_diff_weight.totem"),
+    DATA_FOLDER("star_1000_nodes_diff_weight.totem"),
+    DATA_FOLDER("chain_4_comp_40_nodes.totem"),
+    DATA_FOLDER("ring_center_graph_1000_nodes.totem"),
+    DATA_FOLDER("wheel_graph_1000_nodes.totem")
+  };
+  for (size_t i = 0; i < sizeof(graph_files) / sizeof(*graph_files); i++) {
+    EXPECT_EQ(SUCCESS, graph_initialize(graph_files[i], true, &_graph));
+    ASSERT_EQ(SUCCESS, msf_cpu(_graph, &_forest, &_forest_count,
+                               &_total_weight));
+    ExpectMinimumForest();
+    graph_finalize(_graph);
+    totem_free(_forest, TOTEM_MEM_HOST_PINNED);
+    _graph = NULL;
+    _forest = NULL;
+  }
+}
+
+// Tests a random graph with many equal weights, where ties decide the forest.
+TEST_F(MsfTest, RandomGraph) {
+  const vid_t vertex_count = 200;
+  std::vector<std::vector<std::pair<vid_t, weight_t> > > adjacency(
+      vertex_count);
+  uint32_t seed = 1985;
+  for (vid_t u = 0; u < vertex_count; u++) {
+    for (vid_t v = u + 1; v < vertex_count; v++) {
+      if ((NextRandom(&seed) >> 16) % 20 != 0) continue;
+      weight_t w = (NextRandom(&seed) >> 16) % 4;
+      adjacency[u].push_back(std::make_pair(v, w));
+      adjacency[v].push_back(std::make_pair(u, w));
+    }
+  }
+  eid_t edge_count = 0;
+  for (vid_t v = 0; v < vertex_count; v++) edge_count += adjacency[v].size();
+  graph_allocate(vertex_count, edge_count, false, true, false, &_graph);
+  eid_t e = 0;
+  for (vid_t u = 0; u < vertex_count; u++) {
+    std::sort(adjacency[u].begin(), adjacency[u].end());
+    _graph->vertices[u] = e;
+    for (size_t i = 0; i < adjacency[u].size(); i++, e++) {
+      _graph->edges[e] = adjacency[u][i].first;
+      _graph->weights[e] = adjacency[u][i].second;
+    }
+  }
+  _graph->vertices[vertex_count] = e;
+  ASSERT_EQ(SUCCESS, msf_cpu(_graph, &_forest, &_forest_count,
+                             &_total_weight));
+  ExpectMinimumForest();
+}
@@ -0,0 +1,319 @@
+/*
+ * Contains unit tests for the incremental PageRank.
+ */
+
+// system includes
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// totem includes
+#include "totem_common_unittest.h"
+
+// The tolerance of the residuals, and the largest error allowed in a rank.
+const rank_t INCREMENTAL_TOLERANCE = 1e-9;
+const double INCREMENTAL_EPSILON = 1e-5;
+
+class PageRankIncrementalTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    // Ensure the minimum CUDA architecture is supported
+    CUDA_CHECK_VERSION();
+    _graph = NULL;
+    _updated = NULL;
+    _engine = NULL;
+  }
+  virtual void TearDown() {
+    if (_graph) graph_finalize(_graph);
+    if (_updated) graph_finalize(_updated);
+    if (_engine) page_rank_incremental_finalize(_engine);
+  }
+
+  // Loads a graph, and builds an engine for it.
+  void Initialize(const char* graph_file) {
+    ASSERT_EQ(SUCCESS, graph_initialize(graph_file, false, &_graph));
+    ASSERT_EQ(SUCCESS, page_rank_incremental_initialize(_graph->vertex_count,
+                                                        &_engine));
+  }
+
+  // Frees the graphs and the engine of a test that goes over several graphs.
+  void Finalize() {
+    graph_finalize(_graph);
+    if (_updated) graph_finalize(_updated);
+    page_rank_incremental_finalize(_engine);
+    _graph = NULL;
+    _updated = NULL;
+    _engine = NULL;
+  }
+
+  // Computes the ranks of a graph by power iteration until they converge.
+  void ReferenceRanks(const graph_t* graph, std::vector<double>* rank) {
+    const double damping = PAGE_RANK_DAMPING_FACTOR;
+    rank->assign(graph->vertex_count, 1.0 / graph->vertex_count);
+    std::vector<double> next(graph->vertex_count);
+    for (int round = 0; round < 1000; round++) {
+      std::fill(next.begin(), next.end(),
+                (1 - damping) / graph->vertex_count);
+      for (vid_t u = 0; u < graph->vertex_count; u++) {
+        eid_t degree = graph->vertices[u + 1] - graph->vertices[u];
+        for (eid_t e = graph->vertices[u]; e < graph->vertices[u + 1]; e++) {
+          next[graph->edges[e]] += damping * (*rank)[u] / degree;
+        }
+      }
+      double change = 0;
+      for (vid_t v = 0; v < graph->vertex_count; v++) {
+        change += fabs(next[v] - (*rank)[v]);
+      }
+      rank->swap(next);
+      if (change < 1e-12) break;
+    }
+  }
+
+  void ExpectReference(const graph_t* graph, const std::vector<rank_t>& rank) {
+    std::vector<double> reference;
+    ReferenceRanks(graph, &reference);
+    for (vid_t v = 0; v < graph->vertex_count; v++) {
+      EXPECT_NEAR(reference[v], rank[v], INCREMENTAL_EPSILON);
+    }
+  }
+
+  // Builds the graph that results from applying a batch to _graph. The edges
+  // of an undirected graph are inserted and deleted in both directions.
+  void ApplyBatch(const std::vector<edge_t>& inserted,
+                  const std::vector<edge_t>& deleted) {
+    std::vector<std::vector<vid_t> > adjacency(_graph->vertex_count);
+    for (vid_t u = 0; u < _graph->vertex_count; u++) {
+      adjacency[u].assign(_graph->edges + _graph->vertices[u],
+                          _graph->edges + _graph->vertices[u + 1]);
+    }
+    for (size_t i = 0; i < inserted.size(); i++) {
+      adjacency[inserted[i].src].push_back(inserted[i].dst);
+      if (!_graph->directed && inserted[i].src != inserted[i].dst) {
+        adjacency[inserted[i].dst].push_back(inserted[i].src);
+      }
+    }
+    for (size_t i = 0; i < deleted.size(); i++) {
+      for (int direction = 0; direction < 2; direction++) {
+        vid_t u = direction ? deleted[i].dst : deleted[i].src;
+        vid_t v = direction ? deleted[i].src : deleted[i].dst;
+        if (direction && (_graph->directed || u == v)) break;
+        std::vector<vid_t>::iterator it =
+            std::find(adjacency[u].begin(), adjacency[u].end(), v);
+        ASSERT_TRUE(it != adjacency[u].end());
+        adjacency[u].erase(it);
+      }
+    }
+    AdjacencyToGraph(adjacency, _graph->directed, false, &_updated);
+  }
+
+  // Creates a batch that deletes the first edge of every step-th vertex, and
+  // inserts an edge from every step-th vertex to a pseudo-random one.
+  void CreateBatch(vid_t step, std::vector<edge_t>* inserted,
+                   std::vector<edge_t>* deleted) {
+    for (vid_t u = 0; u < _graph->vertex_count; u += step) {
+      edge_t edge = {u, (vid_t)((u * 7919 + 13) % _graph->vertex_count), 1};
+      inserted->push_back(edge);
+    }
+    for (vid_t u = step / 2; u < _graph->vertex_count; u += step) {
+      if (_graph->vertices[u] == _graph->vertices[u + 1]) continue;
+      edge_t edge = {u, _graph->edges[_graph->vertices[u]], 1};
+      // Avoid deleting the reverse of an edge that is already deleted.
+      bool duplicate = false;
+      for (size_t i = 0; i < deleted->size(); i++) {
+        duplicate |= ((*deleted)[i].src == edge.dst &&
+                      (*deleted)[i].dst == edge.src);
+      }
+      if (!duplicate) deleted->push_back(edge);
+    }
+  }
+
+  graph_t* _graph;
+  graph_t* _updated;
+  page_rank_incremental_t* _engine;
+};
+
+// Tests invalid inputs, and that a rejected batch leaves the ranks intact.
+TEST_F(PageRankIncrementalTest, Invalid) {
+  rank_t rank[1000];
+  EXPECT_EQ(FAILURE, page_rank_incremental_initialize(0, &_engine));
+  EXPECT_EQ(FAILURE, page_rank_incremental_cpu(NULL, NULL, NULL, 0, NULL, 0,
+                                               INCREMENTAL_TOLERANCE, rank));
+  Initialize(DATA_FOLDER("chain_1000_nodes.totem"));
+  EXPECT_EQ(FAILURE, page_rank_incremental_cpu(NULL, _graph, NULL, 0, NULL, 0,
+                                               INCREMENTAL_TOLERANCE, rank));
+  EXPECT_EQ(FAILURE, page_rank_incremental_cpu(_engine, _graph, NULL, 0, NULL,
+                                               0, 0, rank));
+  EXPECT_EQ(FAILURE, page_rank_incremental_cpu(_engine, _graph, NULL, 1, NULL,
+                                               0, INCREMENTAL_TOLERANCE,
+                                               rank));
+  EXPECT_EQ(SUCCESS, page_rank_incremental_cpu(_engine, _graph, NULL, 0, NULL,
+                                               0, INCREMENTAL_TOLERANCE,
+                                               rank));
+  std::vector<rank_t> before(rank, rank + 1000);
+  edge_t out_of_range = {0, 1000, 1};
+  EXPECT_EQ(FAILURE, page_rank_incremental_cpu(_engine, _graph, &out_of_range,
+                                               1, NULL, 0,
+                                               INCREMENTAL_TOLERANCE, rank));
+  // Vertex 0 of the chain has a single edge, hence it could not have gained
+  // two.
+  edge_t inserted[] = {{0, 5, 1}, {0, 7, 1}};
+  EXPECT_EQ(FAILURE, page_rank_incremental_cpu(_engine, _graph, inserted, 2,
+                                               NULL, 0, INCREMENTAL_TOLERANCE,
+                                               rank));
+  EXPECT_EQ(before, std::vector<rank_t>(rank, rank + 1000));
+  // The engine is sized for a different graph.
+  graph_t* other = NULL;
+  EXPECT_EQ(SUCCESS, graph_initialize(DATA_FOLDER("chain_100_nodes_weight_"
+                                                  "directed.totem"), false,
+                                      &other));
+  EXPECT_EQ(FAILURE, page_rank_incremental_cpu(_engine, other, NULL, 0, NULL,
+                                               0, INCREMENTAL_TOLERANCE,
+                                               rank));
+  graph_finalize(other);
+}
+
+// Tests the ranks computed from scratch against a reference.
+TEST_F(PageRankIncrementalTest, Scratch) {
+  const char* graph_files[] = {
+    DATA_FOLDER("single_node.totem"),
+    DATA_FOLDER("grid_graph_15_nodes_weight.totem"),
+    DATA_FOLDER("star_1000_nodes.totem"),
+    DATA_FOLDER("rmf_100_nodes.totem"),
+    DATA_FOLDER("washington_random.totem")
+  };
+  for (size_t i = 0; i < sizeof(graph_files) / sizeof(*graph_files); i++) {
+    Initialize(graph_files[i]);
+    std::vector<rank_t> rank(_graph->vertex_count);
+    EXPECT_EQ(SUCCESS, page_rank_incremental_cpu(_engine, _graph, NULL, 0,
+                                                 NULL, 0,
+                                                 INCREMENTAL_TOLERANCE,
+                                                 &rank[0]));
+    ExpectReference(_graph, rank);
+    Finalize();
+  }
+}
+
+// Tests that updating the ranks after a batch matches the ranks of the updated
+// graph, for directed and undirected graphs.
+TEST_F(PageRankIncrementalTest, Batch) {
+  const char* graph_files[] = {
+    DATA_FOLDER("grid_graph_15_nodes_weight.totem"),
+    DATA_FOLDER("star_1000_nodes.totem"),
+    DATA_FOLDER("wheel_graph_1000_nodes.totem"),
+    DATA_FOLDER("rmf_100_nodes.totem"),
+    DATA_FOLDER("washington_random.totem")
+  };
+  for (size_t i = 0; i < sizeof(graph_files) / sizeof(*graph_files); i++) {
+    Initialize(graph_files[i]);
+    std::vector<rank_t> rank(_graph->vertex_count);
+    EXPECT_EQ(SUCCESS, page_rank_incremental_cpu(_engine, _graph, NULL, 0,
+                                                 NULL, 0,
+                                                 INCREMENTAL_TOLERANCE,
+                                                 &rank[0]));
+    std::vector<edge_t> inserted, deleted;
+    CreateBatch(_graph->vertex_count > 100 ? 97 : 5, &inserted, &deleted);
+    ApplyBatch(inserted, deleted);
+    EXPECT_EQ(SUCCESS, page_rank_incremental_cpu(_engine, _updated,
+                                                 &inserted[0],
+                                                 inserted.size(), &deleted[0],
+                                                 deleted.size(),
+                                                 INCREMENTAL_TOLERANCE,
+                                                 &rank[0]));
+    ExpectReference(_updated, rank);
+    Finalize();
+  }
+}
+
+// Tests a vertex that loses all its edges, and one that gains its first.
+TEST_F(PageRankIncrementalTest, Dangling) {
+  Initialize(DATA_FOLDER("chain_100_nodes_weight_directed.totem"));
+  std::vector<rank_t> rank(_graph->vertex_count);
+  EXPECT_EQ(SUCCESS, page_rank_incremental_cpu(_engine, _graph, NULL, 0, NULL,
+                                               0, INCREMENTAL_TOLERANCE,
+                                               &rank[0]));
+  std::vector<edge_t> inserted(1), deleted(1);
+  inserted[0].src = 99;
+  inserted[0].dst = 0;
+  deleted[0].src = 49;
+  deleted[0].dst = 50;
+  ApplyBatch(inserted, deleted);
+  EXPECT_EQ(SUCCESS, page_rank_incremental_cpu(_engine, _updated, &inserted[0],
+                                               1, &deleted[0], 1,
+                                               INCREMENTAL_TOLERANCE,
+                                               &rank[0]));
+  ExpectReference(_updated, rank);
+}
+
+// Tests a sequence of batches on one engine, whose round ids wrap around in
+// the middle of the sequence; the activations left by a batch must not leak
+// into the next one.
+TEST_F(PageRankIncrementalTest, Sequence) {
+  Initialize(DATA_FOLDER("washington_random.totem"));
+  std::vector<rank_t> rank(_graph->vertex_count);
+  EXPECT_EQ(SUCCESS, page_rank_incremental_cpu(_engine, _graph, NULL, 0, NULL,
+                                               0, INCREMENTAL_TOLERANCE,
+                                               &rank[0]));
+  _engine->current_round = (uint32_t)-3;
+  for (vid_t step = 97; step > 90; step -= 2) {
+    std::vector<edge_t> inserted, deleted;
+    CreateBatch(step, &inserted, &deleted);
+    ApplyBatch(inserted, deleted);
+    EXPECT_EQ(SUCCESS, page_rank_incremental_cpu(_engine, _updated,
+                                                 &inserted[0],
+                                                 inserted.size(), &deleted[0],
+                                                 deleted.size(),
+                                                 INCREMENTAL_TOLERANCE,
+                                                 &rank[0]));
+    ExpectReference(_updated, rank);
+    std::swap(_graph, _updated);
+    graph_finalize(_updated);
+    _updated = NULL;
+  }
+}
+
+// Tests that the residuals left within a loose tolerance are carried across
+// batches: the ranks and the residuals stay exact together, that is, each
+// residual is the teleport term plus the contributions of the ranks of the
+// in-neighbors, less the rank. A tighter tolerance pushes them further.
+TEST_F(PageRankIncrementalTest, Residuals) {
+  const rank_t loose = 1e-5;
+  Initialize(DATA_FOLDER("washington_random.totem"));
+  std::vector<rank_t> rank(_graph->vertex_count);
+  EXPECT_EQ(SUCCESS, page_rank_incremental_cpu(_engine, _graph, NULL, 0, NULL,
+                                               0, loose, &rank[0]));
+  for (vid_t step = 97; step > 80; step -= 2) {
+    std::vector<edge_t> inserted, deleted;
+    CreateBatch(step, &inserted, &deleted);
+    ApplyBatch(inserted, deleted);
+    EXPECT_EQ(SUCCESS, page_rank_incremental_cpu(_engine, _updated,
+                                                 &inserted[0],
+                                                 inserted.size(), &deleted[0],
+                                                 deleted.size(), loose,
+                                                 &rank[0]));
+    std::swap(_graph, _updated);
+    graph_finalize(_updated);
+    _updated = NULL;
+  }
+  const vid_t vcount = _graph->vertex_count;
+  std::vector<double> expected(vcount,
+                               (1 - PAGE_RANK_DAMPING_FACTOR) / vcount);
+  for (vid_t u = 0; u < vcount; u++) {
+    eid_t degree = _graph->vertices[u + 1] - _graph->vertices[u];
+    for (eid_t e = _graph->vertices[u]; e < _graph->vertices[u + 1]; e++) {
+      expected[_graph->edges[e]] +=
+          PAGE_RANK_DAMPING_FACTOR * (double)rank[u] / degree;
+    }
+  }
+  for (vid_t v = 0; v < vcount; v++) {
+    EXPECT_LE(fabs(_engine->residual[v]), loose);
+    EXPECT_NEAR(expected[v] - rank[v], _engine->residual[v], 1e-8);
+  }
+
+  EXPECT_EQ(SUCCESS, page_rank_incremental_cpu(_engine, _graph, NULL, 0, NULL,
+                                               0, INCREMENTAL_TOLERANCE,
+                                               &rank[0]));
+  for (vid_t v = 0; v < vcount; v++) {
+    EXPECT_LE(fabs(_engine->residual[v]), INCREMENTAL_TOLERANCE);
+  }
+  ExpectReference(_graph, rank);
+}
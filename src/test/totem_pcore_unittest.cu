@@ -120,8 +120,67 @@ TEST_P(PCoreTest, Star) {
 // whole set of tests PCoreTest for each element of Values()
 INSTANTIATE_TEST_CASE_P(PCOREGPUAndCPUTest, PCoreTest,
                         Values(&pcore_cpu,
+                               &pcore_sweep_cpu,
                                &pcore_gpu));
 
+// Compares the bucket-based CPU implementation with the sweeping one for
+// several start and step values. Note that the sweeping implementation
+// requires symmetric edge weights.
+TEST(PCoreBucketTest, MatchesSweep) {
+  const char* graph_files[] = {
+    DATA_FOLDER("grid_graph_15_nodes_weight.totem"),
+    DATA_FOLDER("grid_graph_sssp_15_nodes_weight.totem"),
+    DATA_FOLDER("chain_4_comp_40_nodes.totem"),
+    DATA_FOLDER("ring_center_graph_1000_nodes.totem")
+  };
+  const uint32_t params[][2] = {{0, 1}, {0, 7}, {5, 3}, {1000, 1}};
+  for (size_t g = 0; g < sizeof(graph_files) / sizeof(char*); g++) {
+    graph_t* graph = NULL;
+    CALL_SAFE(graph_initialize(graph_files[g], true, &graph));
+    for (size_t p = 0; p < sizeof(params) / sizeof(params[0]); p++) {
+      uint32_t* expected = NULL;
+      uint32_t* round = NULL;
+      EXPECT_EQ(SUCCESS, pcore_sweep_cpu(graph, params[p][0], params[p][1],
+                                         &expected));
+      EXPECT_EQ(SUCCESS, pcore_cpu(graph, params[p][0], params[p][1], &round));
+      for (vid_t v = 0; v < graph->vertex_count; v++) {
+        EXPECT_EQ(expected[v], round[v]);
+      }
+      totem_free(expected, TOTEM_MEM_HOST_PINNED);
+      totem_free(round, TOTEM_MEM_HOST_PINNED);
+    }
+    graph_finalize(graph);
+  }
+}
+
+// Tests the core numbers of unweighted graphs.
+TEST(PCoreBucketTest, KCore) {
+  graph_t graph;
+  graph.directed = true;
+  graph.vertex_count = 1;
+  uint32_t* core = NULL;
+  EXPECT_EQ(FAILURE, kcore_cpu(&graph, &core));
+  EXPECT_EQ((uint32_t*)NULL, core);
+
+  const char* graph_files[] = {
+    DATA_FOLDER("chain_1000_nodes.totem"),
+    DATA_FOLDER("complete_graph_300_nodes.totem"),
+    DATA_FOLDER("wheel_graph_1000_nodes.totem"),
+    DATA_FOLDER("disconnected_1000_nodes.totem")
+  };
+  const uint32_t expected[] = {1, 299, 3, 0};
+  for (size_t g = 0; g < sizeof(graph_files) / sizeof(char*); g++) {
+    graph_t* graph = NULL;
+    CALL_SAFE(graph_initialize(graph_files[g], false, &graph));
+    EXPECT_EQ(SUCCESS, kcore_cpu(graph, &core));
+    for (vid_t v = 0; v < graph->vertex_count; v++) {
+      EXPECT_EQ(expected[g], core[v]);
+    }
+    totem_free(core, TOTEM_MEM_HOST_PINNED);
+    graph_finalize(graph);
+  }
+}
+
 #else
 
 // From Google documentation:
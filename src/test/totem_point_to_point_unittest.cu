@@ -0,0 +1,227 @@
+/*
+ * Contains unit tests for the point-to-point shortest path queries.
+ */
+
+// system includes
+#include <vector>
+
+// totem includes
+#include "totem_common_unittest.h"
+
+class PointToPointTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    // Ensure the minimum CUDA architecture is supported
+    CUDA_CHECK_VERSION();
+    _graph = NULL;
+    _engine = NULL;
+  }
+  virtual void TearDown() {
+    if (_engine) point_to_point_finalize(_engine);
+    if (_graph) graph_finalize(_graph);
+  }
+
+  void Initialize(const char* graph_file, bool weighted) {
+    if (_engine) point_to_point_finalize(_engine);
+    if (_graph) graph_finalize(_graph);
+    _engine = NULL;
+    ASSERT_EQ(SUCCESS, graph_initialize(graph_file, weighted, &_graph));
+    ASSERT_EQ(SUCCESS, point_to_point_initialize(_graph, &_engine));
+  }
+
+  // Computes the number of hops from a source to every vertex.
+  void ReferenceBfs(vid_t source, std::vector<vid_t>* distance) {
+    distance->assign(_graph->vertex_count, INFINITE);
+    std::vector<vid_t> queue(1, source);
+    (*distance)[source] = 0;
+    for (size_t head = 0; head < queue.size(); head++) {
+      vid_t u = queue[head];
+      for (eid_t e = _graph->vertices[u]; e < _graph->vertices[u + 1]; e++) {
+        vid_t v = _graph->edges[e];
+        if ((*distance)[v] != INFINITE) continue;
+        (*distance)[v] = (*distance)[u] + 1;
+        queue.push_back(v);
+      }
+    }
+  }
+
+  // Returns the smallest weight of the edges from u to v (one if hops are
+  // counted), or WEIGHT_MAX if v is not a neighbor of u.
+  weight_t EdgeWeight(vid_t u, vid_t v, bool hops) {
+    weight_t weight = WEIGHT_MAX;
+    for (eid_t e = _graph->vertices[u]; e < _graph->vertices[u + 1]; e++) {
+      if (_graph->edges[e] != v) continue;
+      weight_t w = hops ? 1 : _graph->weights[e];
+      if (w < weight) weight = w;
+    }
+    return weight;
+  }
+
+  // Checks that a path goes from source to target via edges, and returns its
+  // total weight, or its number of hops.
+  uint64_t PathLength(vid_t source, vid_t target, const vid_t* path,
+                      vid_t path_length, bool hops) {
+    EXPECT_LT((vid_t)0, path_length);
+    if (path_length == 0) return 0;
+    EXPECT_EQ(source, path[0]);
+    EXPECT_EQ(target, path[path_length - 1]);
+    uint64_t length = 0;
+    for (vid_t i = 1; i < path_length; i++) {
+      weight_t weight = EdgeWeight(path[i - 1], path[i], hops);
+      EXPECT_NE(WEIGHT_MAX, weight);
+      length += weight;
+    }
+    return length;
+  }
+
+  // Checks the bidirectional BFS against a BFS from every step-th source to
+  // every vertex.
+  void ExpectBfs(vid_t step) {
+    std::vector<vid_t> reference;
+    std::vector<vid_t> path(_graph->vertex_count);
+    for (vid_t s = 0; s < _graph->vertex_count; s += step) {
+      ReferenceBfs(s, &reference);
+      for (vid_t t = 0; t < _graph->vertex_count; t++) {
+        vid_t distance, path_length;
+        ASSERT_EQ(SUCCESS, point_to_point_bfs_cpu(_engine, s, t, &distance,
+                                                  &path[0], &path_length));
+        ASSERT_EQ(reference[t], distance);
+        if (distance == INFINITE) {
+          EXPECT_EQ((vid_t)0, path_length);
+          continue;
+        }
+        EXPECT_EQ(distance + 1, path_length);
+        EXPECT_EQ(distance, PathLength(s, t, &path[0], path_length, true));
+      }
+    }
+  }
+
+  // Checks the bidirectional Dijkstra against sssp_cpu from every step-th
+  // source to every vertex.
+  void ExpectDijkstra(vid_t step) {
+    std::vector<weight_t> reference(_graph->vertex_count);
+    std::vector<vid_t> path(_graph->vertex_count);
+    for (vid_t s = 0; s < _graph->vertex_count; s += step) {
+      ASSERT_EQ(SUCCESS, sssp_cpu(_graph, s, &reference[0]));
+      for (vid_t t = 0; t < _graph->vertex_count; t++) {
+        weight_t distance;
+        vid_t path_length;
+        ASSERT_EQ(SUCCESS, point_to_point_dijkstra_cpu(_engine, s, t,
+                                                       &distance, &path[0],
+                                                       &path_length));
+        ASSERT_EQ(reference[t], distance);
+        if (distance == WEIGHT_MAX) {
+          EXPECT_EQ((vid_t)0, path_length);
+          continue;
+        }
+        EXPECT_EQ(distance, PathLength(s, t, &path[0], path_length, false));
+      }
+    }
+  }
+
+  graph_t* _graph;
+  point_to_point_t* _engine;
+};
+
+// Tests invalid inputs.
+TEST_F(PointToPointTest, Invalid) {
+  EXPECT_EQ(FAILURE, point_to_point_initialize(NULL, &_engine));
+  Initialize(DATA_FOLDER("chain_1000_nodes_weight.totem"), false);
+  vid_t distance, path[2];
+  weight_t weight;
+  EXPECT_EQ(FAILURE, point_to_point_bfs_cpu(_engine, 0, 1000, &distance,
+                                            NULL, NULL));
+  EXPECT_EQ(FAILURE, point_to_point_bfs_cpu(_engine, 0, 1, NULL, NULL, NULL));
+  EXPECT_EQ(FAILURE, point_to_point_bfs_cpu(_engine, 0, 1, &distance, path,
+                                            NULL));
+  // The weights were not loaded.
+  EXPECT_EQ(FAILURE, point_to_point_dijkstra_cpu(_engine, 0, 1, &weight,
+                                                 NULL, NULL));
+}
+
+// Tests a query from a vertex to itself.
+TEST_F(PointToPointTest, SameVertex) {
+  Initialize(DATA_FOLDER("single_node_loop_weight.totem"), true);
+  vid_t distance, path[1], path_length;
+  weight_t weight;
+  EXPECT_EQ(SUCCESS, point_to_point_bfs_cpu(_engine, 0, 0, &distance, path,
+                                            &path_length));
+  EXPECT_EQ((vid_t)0, distance);
+  EXPECT_EQ((vid_t)1, path_length);
+  EXPECT_EQ((vid_t)0, path[0]);
+  EXPECT_EQ(SUCCESS, point_to_point_dijkstra_cpu(_engine, 0, 0, &weight, NULL,
+                                                 NULL));
+  EXPECT_EQ((weight_t)0, weight);
+}
+
+// Tests queries between disconnected vertices.
+TEST_F(PointToPointTest, Unreachable) {
+  Initialize(DATA_FOLDER("disconnected_1000_nodes.totem"), true);
+  vid_t distance, path[2], path_length;
+  weight_t weight;
+  EXPECT_EQ(SUCCESS, point_to_point_bfs_cpu(_engine, 0, 999, &distance, path,
+                                            &path_length));
+  EXPECT_EQ(INFINITE, distance);
+  EXPECT_EQ((vid_t)0, path_length);
+  EXPECT_EQ(SUCCESS, point_to_point_dijkstra_cpu(_engine, 0, 999, &weight,
+                                                 NULL, NULL));
+  EXPECT_EQ(WEIGHT_MAX, weight);
+
+  bool connected = true;
+  EXPECT_EQ(SUCCESS, stcon_cpu(_graph, 0, 999, &connected));
+  EXPECT_FALSE(connected);
+}
+
+// Tests the end points of a long chain, in both directions of a directed one.
+TEST_F(PointToPointTest, Chain) {
+  Initialize(DATA_FOLDER("chain_100_nodes_weight_directed.totem"), true);
+  std::vector<vid_t> path(_graph->vertex_count);
+  vid_t distance, path_length;
+  EXPECT_EQ(SUCCESS, point_to_point_bfs_cpu(_engine, 0, 99, &distance,
+                                            &path[0], &path_length));
+  EXPECT_EQ((vid_t)99, distance);
+  EXPECT_EQ((vid_t)100, path_length);
+  for (vid_t i = 0; i < path_length; i++) EXPECT_EQ(i, path[i]);
+  EXPECT_EQ(SUCCESS, point_to_point_bfs_cpu(_engine, 99, 0, &distance,
+                                            NULL, NULL));
+  EXPECT_EQ(INFINITE, distance);
+
+  bool connected = false;
+  EXPECT_EQ(SUCCESS, stcon_cpu(_graph, 0, 99, &connected));
+  EXPECT_TRUE(connected);
+  EXPECT_EQ(SUCCESS, stcon_cpu(_graph, 99, 0, &connected));
+  EXPECT_FALSE(connected);
+}
+
+// Tests the bidirectional BFS against a reference, reusing the engine for
+// every query.
+TEST_F(PointToPointTest, BfsReference) {
+  const char* graph_files[] = {
+    DATA_FOLDER("grid_graph_15_nodes_weight.totem"),
+    DATA_FOLDER("chain_4_comp_40_nodes.totem"),
+    DATA_FOLDER("star_1000_nodes.totem"),
+    DATA_FOLDER("ring_center_graph_1000_nodes.totem"),
+    DATA_FOLDER("rmf_100_nodes.totem"),
+    DATA_FOLDER("acyclic_100_nodes.totem"),
+    DATA_FOLDER("washington_random.totem")
+  };
+  for (size_t i = 0; i < sizeof(graph_files) / sizeof(*graph_files); i++) {
+    Initialize(graph_files[i], false);
+    ExpectBfs(_graph->vertex_count > 100 ? 97 : 1);
+  }
+}
+
+// Tests the bidirectional Dijkstra against sssp_cpu.
+TEST_F(PointToPointTest, DijkstraReference) {
+  const char* graph_files[] = {
+    DATA_FOLDER("grid_graph_sssp_15_nodes_weight.totem"),
+    DATA_FOLDER("chain_100_nodes_weight_directed.totem"),
+    DATA_FOLDER("star_1000_nodes_diff_weight.totem"),
+    DATA_FOLDER("complete_graph_300_nodes_diff_weight.totem"),
+    DATA_FOLDER("washington_random.totem")
+  };
+  for (size_t i = 0; i < sizeof(graph_files) / sizeof(*graph_files); i++) {
+    Initialize(graph_files[i], true);
+    ExpectDijkstra(_graph->vertex_count > 100 ? 37 : 1);
+  }
+}
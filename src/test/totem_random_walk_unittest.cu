@@ -0,0 +1,275 @@
+/*
+ * Contains unit tests for the random walk engine.
+ */
+
+// system includes
+#include <vector>
+
+// totem includes
+#include "totem_common_unittest.h"
+
+class RandomWalkTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    // Ensure the minimum CUDA architecture is supported
+    CUDA_CHECK_VERSION();
+    _graph = NULL;
+    _sampler = NULL;
+    _config.walk_length = 20;
+    _config.walks_per_vertex = 2;
+    _config.weighted = false;
+    _config.return_param = 1;
+    _config.inout_param = 1;
+    _config.seed = 1985;
+  }
+  virtual void TearDown() {
+    if (_sampler) random_walk_sampler_finalize(_sampler);
+    if (_graph) graph_finalize(_graph);
+  }
+
+  // Generates the given walks, and checks that every step follows an edge, and
+  // that the statistics match the walks.
+  void Walk(uint64_t first_walk, uint64_t walk_count,
+            std::vector<vid_t>* walks) {
+    walks->assign(walk_count * _config.walk_length, 0);
+    random_walk_stats_t stats;
+    ASSERT_EQ(SUCCESS, random_walk_cpu(_sampler, first_walk, walk_count,
+                                       &(*walks)[0], &stats));
+    uint64_t steps = 0;
+    for (uint64_t i = 0; i < walk_count; i++) {
+      const vid_t* walk = &(*walks)[i * _config.walk_length];
+      EXPECT_EQ((first_walk + i) % _graph->vertex_count, walk[0]);
+      for (uint32_t s = 1; s < _config.walk_length; s++) {
+        if (walk[s] == INFINITE) {
+          // A walk only stops at a vertex without neighbors.
+          if (walk[s - 1] != INFINITE) {
+            EXPECT_EQ(_graph->vertices[walk[s - 1]],
+                      _graph->vertices[walk[s - 1] + 1]);
+          }
+          continue;
+        }
+        ASSERT_NE(INFINITE, walk[s - 1]);
+        bool found = false;
+        for (eid_t e = _graph->vertices[walk[s - 1]];
+             e < _graph->vertices[walk[s - 1] + 1]; e++) {
+          found |= (_graph->edges[e] == walk[s]);
+        }
+        EXPECT_TRUE(found);
+        steps++;
+      }
+    }
+    EXPECT_EQ(walk_count, stats.walks);
+    EXPECT_EQ(steps, stats.steps);
+  }
+
+  // Builds a weighted graph in which vertex 0 is connected to vertices 1, 2
+  // and 3 with weights 1, 2 and 7, and each of them is connected back to 0.
+  void BuildWeightedStar() {
+    graph_allocate(4, 6, true, true, false, &_graph);
+    const vid_t edges[] = {1, 2, 3, 0, 0, 0};
+    const weight_t weights[] = {1, 2, 7, 1, 1, 1};
+    const eid_t vertices[] = {0, 3, 4, 5, 6};
+    for (eid_t e = 0; e < 6; e++) {
+      _graph->edges[e] = edges[e];
+      _graph->weights[e] = weights[e];
+    }
+    for (vid_t v = 0; v <= 4; v++) _graph->vertices[v] = vertices[v];
+  }
+
+  graph_t* _graph;
+  random_walk_config_t _config;
+  random_walk_sampler_t* _sampler;
+};
+
+// Tests invalid configurations.
+TEST_F(RandomWalkTest, Invalid) {
+  EXPECT_EQ(FAILURE, random_walk_sampler_initialize(NULL, &_config,
+                                                    &_sampler));
+  EXPECT_EQ(SUCCESS, graph_initialize(DATA_FOLDER("chain_100_nodes_weight_"
+                                                  "directed.totem"), false,
+                                      &_graph));
+  _config.walk_length = 0;
+  EXPECT_EQ(FAILURE, random_walk_sampler_initialize(_graph, &_config,
+                                                    &_sampler));
+  _config.walk_length = 20;
+  _config.return_param = 0;
+  EXPECT_EQ(FAILURE, random_walk_sampler_initialize(_graph, &_config,
+                                                    &_sampler));
+  _config.return_param = 1;
+  // The weights were not loaded.
+  _config.weighted = true;
+  EXPECT_EQ(FAILURE, random_walk_sampler_initialize(_graph, &_config,
+                                                    &_sampler));
+  graph_finalize(_graph);
+
+  // Second order walks require sorted neighbor lists.
+  EXPECT_EQ(SUCCESS, graph_initialize(DATA_FOLDER("ring_center_graph_1000_"
+                                                  "nodes.totem"), false,
+                                      &_graph));
+  _config.weighted = false;
+  _config.inout_param = 2;
+  EXPECT_EQ(FAILURE, random_walk_sampler_initialize(_graph, &_config,
+                                                    &_sampler));
+  _config.inout_param = 1;
+  EXPECT_EQ(SUCCESS, random_walk_sampler_initialize(_graph, &_config,
+                                                    &_sampler));
+}
+
+// Tests that walks stop at vertices without neighbors.
+TEST_F(RandomWalkTest, Sinks) {
+  EXPECT_EQ(SUCCESS, graph_initialize(DATA_FOLDER("chain_100_nodes_weight_"
+                                                  "directed.totem"), false,
+                                      &_graph));
+  EXPECT_EQ(SUCCESS, random_walk_sampler_initialize(_graph, &_config,
+                                                    &_sampler));
+  std::vector<vid_t> walks;
+  Walk(0, _graph->vertex_count, &walks);
+  const vid_t last = _graph->vertex_count - 1;
+  EXPECT_EQ(last, walks[last * _config.walk_length]);
+  EXPECT_EQ(INFINITE, walks[last * _config.walk_length + 1]);
+}
+
+// Tests that walks are reproducible, and do not depend on the batch they are
+// generated in.
+TEST_F(RandomWalkTest, Reproducible) {
+  EXPECT_EQ(SUCCESS, graph_initialize(DATA_FOLDER("grid_graph_15_nodes_weight"
+                                                  ".totem"), true, &_graph));
+  _config.weighted = true;
+  _config.return_param = 0.5;
+  _config.inout_param = 2;
+  EXPECT_EQ(SUCCESS, random_walk_sampler_initialize(_graph, &_config,
+                                                    &_sampler));
+  std::vector<vid_t> all, first, second;
+  Walk(0, 100, &all);
+  Walk(0, 30, &first);
+  Walk(30, 70, &second);
+  first.insert(first.end(), second.begin(), second.end());
+  EXPECT_EQ(all, first);
+
+  // A different seed yields different walks.
+  random_walk_sampler_finalize(_sampler);
+  _config.seed++;
+  EXPECT_EQ(SUCCESS, random_walk_sampler_initialize(_graph, &_config,
+                                                    &_sampler));
+  Walk(0, 100, &second);
+  EXPECT_NE(all, second);
+}
+
+// Tests that weighted transitions follow the edge weights.
+TEST_F(RandomWalkTest, Weighted) {
+  BuildWeightedStar();
+  _config.weighted = true;
+  _config.walk_length = 2;
+  EXPECT_EQ(SUCCESS, random_walk_sampler_initialize(_graph, &_config,
+                                                    &_sampler));
+  const uint64_t walk_count = 40000;
+  std::vector<vid_t> walks;
+  Walk(0, walk_count * _graph->vertex_count, &walks);
+  uint64_t visits[4] = {0, 0, 0, 0};
+  for (uint64_t i = 0; i < walk_count; i++) {
+    visits[walks[i * _graph->vertex_count * _config.walk_length + 1]]++;
+  }
+  EXPECT_EQ((uint64_t)0, visits[0]);
+  EXPECT_NEAR(0.1, visits[1] / (double)walk_count, 0.01);
+  EXPECT_NEAR(0.2, visits[2] / (double)walk_count, 0.01);
+  EXPECT_NEAR(0.7, visits[3] / (double)walk_count, 0.01);
+}
+
+// Tests that the alias tables reproduce the edge weights, including those of a
+// vertex whose degree exceeds the work list each thread keeps to build them.
+TEST_F(RandomWalkTest, AliasTables) {
+  const vid_t leaf_count = 5000;
+  graph_allocate(leaf_count + 1, 2 * leaf_count, true, true, false, &_graph);
+  _graph->vertices[0] = 0;
+  for (vid_t i = 0; i < leaf_count; i++) {
+    _graph->edges[i] = i + 1;
+    _graph->weights[i] = i % 3 + 1;
+    _graph->edges[leaf_count + i] = 0;
+    _graph->weights[leaf_count + i] = 1;
+    _graph->vertices[i + 1] = leaf_count + i;
+  }
+  _graph->vertices[leaf_count + 1] = 2 * leaf_count;
+  _config.weighted = true;
+  EXPECT_EQ(SUCCESS, random_walk_sampler_initialize(_graph, &_config,
+                                                    &_sampler));
+  for (vid_t v = 0; v < _graph->vertex_count; v++) {
+    const eid_t begin = _graph->vertices[v];
+    const eid_t degree = _graph->vertices[v + 1] - begin;
+    double total = 0;
+    std::vector<double> mass(degree, 0);
+    for (eid_t i = 0; i < degree; i++) {
+      total += _graph->weights[begin + i];
+      mass[i] += _sampler->alias_prob[begin + i];
+      mass[_sampler->alias[begin + i]] += 1 - _sampler->alias_prob[begin + i];
+    }
+    for (eid_t i = 0; i < degree; i++) {
+      EXPECT_NEAR(_graph->weights[begin + i] / total, mass[i] / degree, 1e-6);
+    }
+  }
+}
+
+// Tests that the node2vec return parameter biases the walks towards the
+// previous vertex: on a chain, every step either returns or moves on.
+TEST_F(RandomWalkTest, SecondOrder) {
+  EXPECT_EQ(SUCCESS, graph_initialize(DATA_FOLDER("chain_1000_nodes_weight"
+                                                  ".totem"), false, &_graph));
+  const double params[] = {0.25, 4};
+  double returns[2];
+  for (int i = 0; i < 2; i++) {
+    _config.return_param = params[i];
+    EXPECT_EQ(SUCCESS, random_walk_sampler_initialize(_graph, &_config,
+                                                      &_sampler));
+    std::vector<vid_t> walks;
+    Walk(0, _graph->vertex_count, &walks);
+    uint64_t count = 0, returned = 0;
+    for (vid_t w = 1; w < _graph->vertex_count - 1; w++) {
+      const vid_t* walk = &walks[w * _config.walk_length];
+      for (uint32_t s = 2; s < _config.walk_length; s++) {
+        // Only steps from the interior of the chain have a choice.
+        if (walk[s - 1] == 0 || walk[s - 1] == _graph->vertex_count - 1) {
+          continue;
+        }
+        count++;
+        returned += (walk[s] == walk[s - 2]);
+      }
+    }
+    returns[i] = returned / (double)count;
+    random_walk_sampler_finalize(_sampler);
+    _sampler = NULL;
+  }
+  // The return probability is (1 / p) / (1 / p + 1 / q).
+  EXPECT_NEAR(0.8, returns[0], 0.02);
+  EXPECT_NEAR(0.2, returns[1], 0.02);
+}
+
+// Tests that the walks streamed to a file match the in-memory ones.
+TEST_F(RandomWalkTest, File) {
+  EXPECT_EQ(SUCCESS, graph_initialize(DATA_FOLDER("wheel_graph_1000_nodes"
+                                                  ".totem"), false, &_graph));
+  EXPECT_EQ(SUCCESS, random_walk_sampler_initialize(_graph, &_config,
+                                                    &_sampler));
+  std::vector<vid_t> walks;
+  const uint64_t walk_count =
+      (uint64_t)_graph->vertex_count * _config.walks_per_vertex;
+  Walk(0, walk_count, &walks);
+
+  char file_path[] = "/tmp/totem_random_walk_XXXXXX";
+  int fd = mkstemp(file_path);
+  ASSERT_NE(-1, fd);
+  close(fd);
+  random_walk_stats_t stats;
+  EXPECT_EQ(SUCCESS, random_walk_file_cpu(_sampler, file_path, &stats));
+  EXPECT_EQ(walk_count, stats.walks);
+  EXPECT_EQ(walk_count * (_config.walk_length - 1), stats.steps);
+  EXPECT_LE(0, stats.steps_per_second);
+
+  std::vector<vid_t> streamed(walks.size() + 1);
+  FILE* file = fopen(file_path, "rb");
+  ASSERT_TRUE(file != NULL);
+  EXPECT_EQ(walks.size(), fread(&streamed[0], sizeof(vid_t), streamed.size(),
+                                file));
+  fclose(file);
+  unlink(file_path);
+  streamed.pop_back();
+  EXPECT_EQ(walks, streamed);
+}
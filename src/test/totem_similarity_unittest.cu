@@ -0,0 +1,212 @@
+/*
+ * Contains unit tests for the top-k vertex similarity engine.
+ */
+
+// system includes
+#include <cmath>
+#include <vector>
+
+// totem includes
+#include "totem_common_unittest.h"
+
+class SimilarityTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    // Ensure the minimum CUDA architecture is supported
+    CUDA_CHECK_VERSION();
+    _graph = NULL;
+    _offsets = NULL;
+    _neighbors = NULL;
+    _scores = NULL;
+    _config.metric = SIMILARITY_JACCARD;
+    _config.k = 5;
+    _config.hub_threshold = 0;
+    _config.exclude_neighbors = false;
+  }
+  virtual void TearDown() {
+    if (_graph) graph_finalize(_graph);
+    FreeResults();
+  }
+
+  void FreeResults() {
+    if (_offsets) totem_free(_offsets, TOTEM_MEM_HOST_PINNED);
+    if (_neighbors) totem_free(_neighbors, TOTEM_MEM_HOST_PINNED);
+    if (_scores) totem_free(_scores, TOTEM_MEM_HOST_PINNED);
+    _offsets = NULL;
+    _neighbors = NULL;
+    _scores = NULL;
+  }
+
+  error_t Run() {
+    FreeResults();
+    return similarity_topk_cpu(_graph, &_config, &_offsets, &_neighbors,
+                               &_scores);
+  }
+
+  // Returns the exact score of a pair via the sets of their neighbors.
+  double ExactScore(vid_t v, vid_t w) {
+    std::vector<bool> adjacent(_graph->vertex_count, false);
+    for (eid_t e = _graph->vertices[v]; e < _graph->vertices[v + 1]; e++) {
+      adjacent[_graph->edges[e]] = true;
+    }
+    double common = 0;
+    for (eid_t e = _graph->vertices[w]; e < _graph->vertices[w + 1]; e++) {
+      vid_t z = _graph->edges[e];
+      if (!adjacent[z]) continue;
+      eid_t degree = _graph->vertices[z + 1] - _graph->vertices[z];
+      common += _config.metric != SIMILARITY_ADAMIC_ADAR ? 1 :
+          (degree > 1 ? 1 / log((double)degree) : 0);
+    }
+    if (_config.metric != SIMILARITY_JACCARD) return common;
+    double size = (_graph->vertices[v + 1] - _graph->vertices[v]) +
+        (_graph->vertices[w + 1] - _graph->vertices[w]) - common;
+    return size > 0 ? common / size : 0;
+  }
+
+  // Checks the results of every vertex against a brute force reference: the
+  // results are candidates with exact scores, in order, and no candidate left
+  // out is better than the last result.
+  void ExpectReference() {
+    const double epsilon = 1e-5;
+    for (vid_t v = 0; v < _graph->vertex_count; v++) {
+      std::vector<bool> candidate(_graph->vertex_count, false);
+      for (eid_t e = _graph->vertices[v]; e < _graph->vertices[v + 1]; e++) {
+        vid_t u = _graph->edges[e];
+        eid_t degree = _graph->vertices[u + 1] - _graph->vertices[u];
+        if (u == v || (_config.hub_threshold &&
+                       degree > _config.hub_threshold)) {
+          continue;
+        }
+        for (eid_t f = _graph->vertices[u]; f < _graph->vertices[u + 1]; f++) {
+          candidate[_graph->edges[f]] = true;
+        }
+      }
+      candidate[v] = false;
+      if (_config.exclude_neighbors) {
+        for (eid_t e = _graph->vertices[v]; e < _graph->vertices[v + 1];
+             e++) {
+          candidate[_graph->edges[e]] = false;
+        }
+      }
+      vid_t candidate_count = 0;
+      for (vid_t w = 0; w < _graph->vertex_count; w++) {
+        candidate_count += candidate[w];
+      }
+      ASSERT_EQ(std::min(candidate_count, (vid_t)_config.k),
+                _offsets[v + 1] - _offsets[v]);
+      for (eid_t i = _offsets[v]; i < _offsets[v + 1]; i++) {
+        vid_t w = _neighbors[i];
+        ASSERT_TRUE(candidate[w]);
+        EXPECT_NEAR(ExactScore(v, w), _scores[i], epsilon);
+        if (i > _offsets[v]) EXPECT_GE(_scores[i - 1], _scores[i]);
+        candidate[w] = false;
+      }
+      if (_offsets[v + 1] == _offsets[v]) continue;
+      float last = _scores[_offsets[v + 1] - 1];
+      for (vid_t w = 0; w < _graph->vertex_count; w++) {
+        if (candidate[w]) EXPECT_LE(ExactScore(v, w), last + epsilon);
+      }
+    }
+  }
+
+  graph_t* _graph;
+  similarity_config_t _config;
+  eid_t* _offsets;
+  vid_t* _neighbors;
+  float* _scores;
+};
+
+// Tests invalid inputs.
+TEST_F(SimilarityTest, Invalid) {
+  EXPECT_EQ(FAILURE, Run());
+  EXPECT_EQ(SUCCESS, graph_initialize(DATA_FOLDER("ring_center_graph_1000_"
+                                                  "nodes.totem"), false,
+                                      &_graph));
+  _config.k = 0;
+  EXPECT_EQ(FAILURE, Run());
+  _config.k = 5;
+  // The neighbor lists are not sorted.
+  EXPECT_EQ(FAILURE, Run());
+  graph_sort_nbrs(_graph);
+  EXPECT_EQ(SUCCESS, Run());
+  graph_finalize(_graph);
+
+  // Directed graphs are not supported.
+  EXPECT_EQ(SUCCESS, graph_initialize(DATA_FOLDER("rmf_100_nodes.totem"),
+                                      false, &_graph));
+  graph_sort_nbrs(_graph);
+  EXPECT_EQ(FAILURE, Run());
+}
+
+// Tests a graph without edges, where no vertex has candidates.
+TEST_F(SimilarityTest, NoEdges) {
+  EXPECT_EQ(SUCCESS, graph_initialize(DATA_FOLDER("disconnected_1000_nodes"
+                                                  ".totem"), false, &_graph));
+  EXPECT_EQ(SUCCESS, Run());
+  EXPECT_EQ((eid_t)0, _offsets[_graph->vertex_count]);
+  EXPECT_EQ(NULL, _neighbors);
+  EXPECT_EQ(NULL, _scores);
+}
+
+// Tests the scores of a chain, where the only candidates of a vertex are at
+// distance two, and share a single neighbor.
+TEST_F(SimilarityTest, Chain) {
+  EXPECT_EQ(SUCCESS, graph_initialize(DATA_FOLDER("chain_1000_nodes_weight"
+                                                  ".totem"), false, &_graph));
+  _config.exclude_neighbors = true;
+  EXPECT_EQ(SUCCESS, Run());
+  EXPECT_EQ((eid_t)(2 * (_graph->vertex_count - 2)),
+            _offsets[_graph->vertex_count]);
+  // Vertex 2 shares vertex 1 with vertex 0 out of {1, 3}, and vertex 3 with
+  // vertex 4 out of {1, 3, 5}.
+  EXPECT_EQ((eid_t)2, _offsets[3] - _offsets[2]);
+  EXPECT_EQ((vid_t)0, _neighbors[_offsets[2]]);
+  EXPECT_FLOAT_EQ(0.5, _scores[_offsets[2]]);
+  EXPECT_EQ((vid_t)4, _neighbors[_offsets[2] + 1]);
+  EXPECT_FLOAT_EQ(1.0 / 3, _scores[_offsets[2] + 1]);
+  EXPECT_EQ((eid_t)1, _offsets[1] - _offsets[0]);
+  EXPECT_EQ((vid_t)2, _neighbors[_offsets[0]]);
+  EXPECT_FLOAT_EQ(0.5, _scores[_offsets[0]]);
+}
+
+// Tests that skipping the hubs drops their candidates, but keeps the scores of
+// the remaining ones exact.
+TEST_F(SimilarityTest, HubThreshold) {
+  EXPECT_EQ(SUCCESS, graph_initialize(DATA_FOLDER("wheel_graph_1000_nodes"
+                                                  ".totem"), false, &_graph));
+  _config.metric = SIMILARITY_COMMON_NEIGHBORS;
+  _config.exclude_neighbors = true;
+  EXPECT_EQ(SUCCESS, Run());
+  ExpectReference();
+  _config.hub_threshold = 10;
+  EXPECT_EQ(SUCCESS, Run());
+  ExpectReference();
+}
+
+// Tests the results against a brute force reference.
+TEST_F(SimilarityTest, Reference) {
+  const char* graph_files[] = {
+    DATA_FOLDER("grid_graph_15_nodes_weight.totem"),
+    DATA_FOLDER("chain_4_comp_40_nodes.totem"),
+    DATA_FOLDER("star_1000_nodes.totem"),
+    DATA_FOLDER("complete_graph_300_nodes.totem"),
+    DATA_FOLDER("wheel_graph_1000_nodes.totem")
+  };
+  const similarity_metric_t metrics[] = {
+    SIMILARITY_COMMON_NEIGHBORS, SIMILARITY_JACCARD, SIMILARITY_ADAMIC_ADAR
+  };
+  for (size_t i = 0; i < sizeof(graph_files) / sizeof(*graph_files); i++) {
+    EXPECT_EQ(SUCCESS, graph_initialize(graph_files[i], false, &_graph));
+    graph_sort_nbrs(_graph);
+    for (int m = 0; m < 3; m++) {
+      _config.metric = metrics[m];
+      _config.k = 1 + 4 * m;
+      _config.hub_threshold = m == 2 ? 20 : 0;
+      _config.exclude_neighbors = m != 1;
+      ASSERT_EQ(SUCCESS, Run());
+      ExpectReference();
+    }
+    graph_finalize(_graph);
+    _graph = NULL;
+  }
+}
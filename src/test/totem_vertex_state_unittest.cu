@@ -0,0 +1,100 @@
+/*
+ * Contains unit tests for the packed per-vertex state container.
+ */
+
+// totem includes
+#include "totem_common_unittest.h"
+#include "totem_vertex_state.h"
+
+// A field set that mixes field sizes, which exercises padding and alignment.
+typedef struct {
+  uint32_t numSPs;
+  score_t  delta;
+  cost_t   distance;
+  uint64_t count;
+} test_fields_t;
+
+class VertexStateTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    // Ensure the minimum CUDA architecture is supported
+    CUDA_CHECK_VERSION();
+  }
+
+  // Writes a distinct value in every field of every vertex, then checks that
+  // no write clobbered another field or vertex.
+  template<vertex_state_layout_t LAYOUT>
+  void TestLayout(vid_t vertex_count) {
+    vertex_state_t<test_fields_t, LAYOUT> state;
+    EXPECT_EQ(SUCCESS, vertex_state_initialize(vertex_count, TOTEM_MEM_HOST,
+                                               &state));
+    EXPECT_EQ(vertex_count, state.vertex_count);
+    for (vid_t v = 0; v < vertex_count; v++) {
+      EXPECT_EQ((uint32_t)0, vertex_state_get(state, v,
+                                              &test_fields_t::numSPs));
+      EXPECT_EQ((uint64_t)0, vertex_state_get(state, v,
+                                              &test_fields_t::count));
+    }
+    for (vid_t v = 0; v < vertex_count; v++) {
+      vertex_state_get(state, v, &test_fields_t::numSPs) = v;
+      vertex_state_get(state, v, &test_fields_t::delta) = (score_t)v / 2;
+      vertex_state_get(state, v, &test_fields_t::distance) = (cost_t)(v + 1);
+      vertex_state_get(state, v, &test_fields_t::count) =
+          (uint64_t)v << 32;
+    }
+    for (vid_t v = 0; v < vertex_count; v++) {
+      EXPECT_EQ(v, vertex_state_get(state, v, &test_fields_t::numSPs));
+      EXPECT_EQ((score_t)v / 2, vertex_state_get(state, v,
+                                                 &test_fields_t::delta));
+      EXPECT_EQ((cost_t)(v + 1), vertex_state_get(state, v,
+                                                  &test_fields_t::distance));
+      EXPECT_EQ((uint64_t)v << 32, vertex_state_get(state, v,
+                                                    &test_fields_t::count));
+      // Every field keeps the alignment of its type.
+      EXPECT_EQ((size_t)0, reinterpret_cast<size_t>(
+          &vertex_state_get(state, v, &test_fields_t::count)) %
+                sizeof(uint64_t));
+    }
+
+    // Filling one field leaves the others untouched.
+    vertex_state_fill(state, &test_fields_t::distance, (cost_t)INF_COST);
+    for (vid_t v = 0; v < vertex_count; v++) {
+      EXPECT_EQ((cost_t)INF_COST, vertex_state_get(state, v,
+                                                   &test_fields_t::distance));
+      EXPECT_EQ(v, vertex_state_get(state, v, &test_fields_t::numSPs));
+      EXPECT_EQ((score_t)v / 2, vertex_state_get(state, v,
+                                                 &test_fields_t::delta));
+    }
+    vertex_state_finalize(&state);
+  }
+};
+
+// Tests the state of empty graphs.
+TEST_F(VertexStateTest, Empty) {
+  vertex_state_t<test_fields_t, VERTEX_STATE_BLOCKED> state;
+  EXPECT_EQ(SUCCESS, vertex_state_initialize(0, TOTEM_MEM_HOST, &state));
+  EXPECT_EQ((vid_t)0, state.capacity);
+  vertex_state_fill(state, &test_fields_t::count, (uint64_t)1);
+  vertex_state_finalize(&state);
+  EXPECT_EQ(FAILURE, (vertex_state_initialize<test_fields_t, VERTEX_STATE_AOS>
+                      (1, TOTEM_MEM_HOST, NULL)));
+}
+
+// Tests the array of structs layout.
+TEST_F(VertexStateTest, ArrayOfStructs) {
+  TestLayout<VERTEX_STATE_AOS>(1);
+  TestLayout<VERTEX_STATE_AOS>(1000);
+}
+
+// Tests the struct of arrays layout.
+TEST_F(VertexStateTest, StructOfArrays) {
+  TestLayout<VERTEX_STATE_SOA>(1);
+  TestLayout<VERTEX_STATE_SOA>(1000);
+}
+
+// Tests the blocked layout, including a partially filled last block.
+TEST_F(VertexStateTest, Blocked) {
+  TestLayout<VERTEX_STATE_BLOCKED>(1);
+  TestLayout<VERTEX_STATE_BLOCKED>(VERTEX_STATE_BLOCK_SIZE);
+  TestLayout<VERTEX_STATE_BLOCKED>(1000);
+}
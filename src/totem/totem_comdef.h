@@ -190,6 +190,23 @@ inline uint32_t __sync_fetch_and_min_uint32(uint32_t* address, uint32_t val) {
   return old;
 }
 
+/**
+ * Atomic max for uint32_t values. Atomically store the maximum of value at
+ * address and val back at address and returns the old value at address.
+ * @param[in] address stores the maximum of val and old value at address
+ * @param[in] val the value to be compared with
+ * @return old value stored at address
+ */
+inline uint32_t __sync_fetch_and_max_uint32(uint32_t* address, uint32_t val) {
+  uint32_t old = *address, assumed;
+  do {
+    assumed = old;
+    uint32_t max = (val > assumed) ? val : assumed;
+    old = __sync_val_compare_and_swap(address, assumed, max);
+  } while (assumed != old);
+  return old;
+}
+
 /**
  * A single precision atomic min. Atomically store the minimum of value at
  * address and val back at address and returns the old value at address.
@@ -1,13 +1,16 @@
 
 /* TODO(lauro,abdullah,elizeu): Add license.
  *
- * Implements an algorithm to identify the weakly connected components of a
- * graph. The algorithm is based on BFS.
+ * Implements algorithms to identify the weakly connected components of a
+ * graph, which is based on BFS, and the strongly connected components of a
+ * graph, which is based on trimming, forward-backward reachability and
+ * coloring.
  *
  *  Created on: 2011-11-23
  *      Author: Abdullah Gharaibeh
  */
 
+#include "totem_bitmap.cuh"
 #include "totem_comdef.h"
 #include "totem_graph.h"
 #include "totem_mem.h"
@@ -23,6 +26,7 @@ PRIVATE error_t allocate_component_set(graph_t* graph, vid_t comp_count,
     (*comp_set)->vertex_count = (vid_t*)calloc((comp_count), sizeof(vid_t));
     (*comp_set)->edge_count = (eid_t*)calloc((comp_count), sizeof(eid_t));
     (*comp_set)->count = comp_count;
+    (*comp_set)->id_count = comp_count;
     (*comp_set)->biggest = 0;
   }
   return SUCCESS;
@@ -120,6 +124,7 @@ error_t get_components_cpu(graph_t* graph, component_set_t** comp_set_ret) {
     }
   }
   comp_set->count = comp_count;
+  comp_set->id_count = comp_count;
 
   // compute the vertex and edge count of each component
   comp_set->vertex_count = (vid_t*)calloc(comp_count, sizeof(vid_t));
@@ -153,3 +158,558 @@ error_t finalize_component_set(component_set_t* comp_set) {
   free(comp_set);
   return SUCCESS;
 }
+
+/**
+ * State of the strongly connected components algorithm. The marker array of
+ * the component set holds, for each vertex, the representative of its
+ * component (a vertex of the component) or INFINITE if it is not known yet.
+ */
+typedef struct {
+  const graph_t* graph;      // the input graph
+  const graph_t* transpose;  // the transpose of the input graph
+  vid_t*    marker;          // the representative of each vertex, if any
+  eid_t*    in_degree;       // active incoming neighbors of each vertex
+  eid_t*    out_degree;      // active outgoing neighbors of each vertex
+  vid_t*    color;           // the color of each vertex
+  vid_t*    active;          // the vertices without a component
+  vid_t     active_count;
+  vid_t*    frontier;        // the current level of a traversal
+  vid_t     frontier_count;
+  vid_t*    next;            // the next level of a traversal
+  vid_t     next_count;
+} scc_state_t;
+
+/**
+ * Drops the vertices that got a component from the active list.
+ */
+PRIVATE void scc_compact(scc_state_t* state) {
+  vid_t count = 0;
+  OMP(omp parallel for schedule(static))
+  for (vid_t i = 0; i < state->active_count; i++) {
+    vid_t v = state->active[i];
+    if (state->marker[v] != INFINITE) continue;
+    state->next[__sync_fetch_and_add(&count, 1)] = v;
+  }
+  vid_t* active = state->active;
+  state->active = state->next;
+  state->next = active;
+  state->active_count = count;
+}
+
+/**
+ * Swaps the current and the next levels of a traversal.
+ */
+PRIVATE void scc_next_level(scc_state_t* state) {
+  vid_t* frontier = state->frontier;
+  state->frontier = state->next;
+  state->next = frontier;
+  state->frontier_count = state->next_count;
+  state->next_count = 0;
+}
+
+/**
+ * Adds an active vertex to the next level if it is claimed by this call.
+ */
+inline PRIVATE void scc_claim(scc_state_t* state, vid_t v, vid_t component) {
+  if (__sync_bool_compare_and_swap(&state->marker[v], INFINITE, component)) {
+    state->next[__sync_fetch_and_add(&state->next_count, 1)] = v;
+  }
+}
+
+/**
+ * Trims the trivial components: a vertex without active incoming or outgoing
+ * neighbors (self loops aside) is a component of its own. Removing it may
+ * trim its neighbors in turn, hence the trimmed vertices are propagated as a
+ * worklist until no vertex is left to trim.
+ */
+PRIVATE void scc_trim(scc_state_t* state) {
+  const graph_t* graph = state->graph;
+  const graph_t* transpose = state->transpose;
+  state->next_count = 0;
+  OMP(omp parallel for schedule(guided))
+  for (vid_t i = 0; i < state->active_count; i++) {
+    vid_t v = state->active[i];
+    eid_t out_degree = 0;
+    for (eid_t e = graph->vertices[v]; e < graph->vertices[v + 1]; e++) {
+      vid_t u = graph->edges[e];
+      out_degree += (u != v && state->marker[u] == INFINITE);
+    }
+    eid_t in_degree = 0;
+    for (eid_t e = transpose->vertices[v]; e < transpose->vertices[v + 1];
+         e++) {
+      vid_t u = transpose->edges[e];
+      in_degree += (u != v && state->marker[u] == INFINITE);
+    }
+    state->out_degree[v] = out_degree;
+    state->in_degree[v] = in_degree;
+  }
+  OMP(omp parallel for schedule(static))
+  for (vid_t i = 0; i < state->active_count; i++) {
+    vid_t v = state->active[i];
+    if (state->out_degree[v] == 0 || state->in_degree[v] == 0) {
+      scc_claim(state, v, v);
+    }
+  }
+  scc_next_level(state);
+  while (state->frontier_count > 0) {
+    OMP(omp parallel for schedule(guided))
+    for (vid_t i = 0; i < state->frontier_count; i++) {
+      vid_t v = state->frontier[i];
+      for (eid_t e = graph->vertices[v]; e < graph->vertices[v + 1]; e++) {
+        vid_t u = graph->edges[e];
+        if (u == v || state->marker[u] != INFINITE) continue;
+        if (__sync_fetch_and_sub(&state->in_degree[u], 1) == 1) {
+          scc_claim(state, u, u);
+        }
+      }
+      for (eid_t e = transpose->vertices[v]; e < transpose->vertices[v + 1];
+           e++) {
+        vid_t u = transpose->edges[e];
+        if (u == v || state->marker[u] != INFINITE) continue;
+        if (__sync_fetch_and_sub(&state->out_degree[u], 1) == 1) {
+          scc_claim(state, u, u);
+        }
+      }
+    }
+    scc_next_level(state);
+  }
+  scc_compact(state);
+}
+
+/**
+ * Marks in the visited bitmap the active vertices reachable from the pivot
+ * via a level-synchronous traversal of the given graph.
+ */
+PRIVATE void scc_reach(scc_state_t* state, const graph_t* graph, vid_t pivot,
+                       bitmap_t visited) {
+  bitmap_set_cpu(visited, pivot);
+  state->frontier[0] = pivot;
+  state->frontier_count = 1;
+  state->next_count = 0;
+  while (state->frontier_count > 0) {
+    OMP(omp parallel for schedule(guided))
+    for (vid_t i = 0; i < state->frontier_count; i++) {
+      vid_t v = state->frontier[i];
+      for (eid_t e = graph->vertices[v]; e < graph->vertices[v + 1]; e++) {
+        vid_t u = graph->edges[e];
+        if (state->marker[u] != INFINITE || bitmap_is_set(visited, u)) {
+          continue;
+        }
+        if (bitmap_set_cpu(visited, u)) {
+          state->next[__sync_fetch_and_add(&state->next_count, 1)] = u;
+        }
+      }
+    }
+    scc_next_level(state);
+  }
+}
+
+/**
+ * Finds the component of a pivot as the intersection of the vertices it
+ * reaches and of the vertices that reach it. The pivot is the active vertex
+ * with the largest product of incoming and outgoing degrees, which is likely
+ * part of the giant component of real-world graphs.
+ */
+PRIVATE void scc_forward_backward(scc_state_t* state) {
+  vid_t pivot = state->active[0];
+  uint64_t best = 0;
+  OMP(omp parallel)
+  {
+    vid_t local_pivot = state->active[0];
+    uint64_t local_best = 0;
+    OMP(omp for schedule(static))
+    for (vid_t i = 0; i < state->active_count; i++) {
+      vid_t v = state->active[i];
+      uint64_t product = (uint64_t)state->in_degree[v] * state->out_degree[v];
+      if (product > local_best) {
+        local_best = product;
+        local_pivot = v;
+      }
+    }
+    OMP(omp critical)
+    if (local_best > best || (local_best == best && local_pivot < pivot)) {
+      best = local_best;
+      pivot = local_pivot;
+    }
+  }
+
+  bitmap_t forward = bitmap_init_cpu(state->graph->vertex_count);
+  bitmap_t backward = bitmap_init_cpu(state->graph->vertex_count);
+  scc_reach(state, state->graph, pivot, forward);
+  scc_reach(state, state->transpose, pivot, backward);
+  OMP(omp parallel for schedule(static))
+  for (vid_t i = 0; i < state->active_count; i++) {
+    vid_t v = state->active[i];
+    if (bitmap_is_set(forward, v) && bitmap_is_set(backward, v)) {
+      state->marker[v] = pivot;
+    }
+  }
+  bitmap_finalize_cpu(forward);
+  bitmap_finalize_cpu(backward);
+  scc_compact(state);
+}
+
+/**
+ * Finds the components of the active vertices via coloring. The largest
+ * vertex id that reaches each vertex is propagated as its color, hence every
+ * color class contains the component of its root, the vertex whose id is the
+ * color. The component of a root is the set of vertices of its color that
+ * reach it, found by a backward traversal restricted to the color class; all
+ * the roots are traversed at once. The remaining vertices are colored again
+ * until none is left.
+ */
+PRIVATE void scc_coloring(scc_state_t* state) {
+  const graph_t* transpose = state->transpose;
+  while (state->active_count > 0) {
+    OMP(omp parallel for schedule(static))
+    for (vid_t i = 0; i < state->active_count; i++) {
+      vid_t v = state->active[i];
+      state->color[v] = v;
+    }
+    // The colors are pulled from the incoming neighbors. The updates are
+    // asynchronous, which is safe since the colors only grow.
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      OMP(omp parallel for schedule(guided) reduction(| : changed))
+      for (vid_t i = 0; i < state->active_count; i++) {
+        vid_t v = state->active[i];
+        vid_t color = state->color[v];
+        for (eid_t e = transpose->vertices[v]; e < transpose->vertices[v + 1];
+             e++) {
+          vid_t u = transpose->edges[e];
+          if (state->marker[u] == INFINITE && state->color[u] > color) {
+            color = state->color[u];
+          }
+        }
+        if (color != state->color[v]) {
+          state->color[v] = color;
+          changed = true;
+        }
+      }
+    }
+
+    state->next_count = 0;
+    OMP(omp parallel for schedule(static))
+    for (vid_t i = 0; i < state->active_count; i++) {
+      vid_t v = state->active[i];
+      if (state->color[v] == v) scc_claim(state, v, v);
+    }
+    scc_next_level(state);
+    while (state->frontier_count > 0) {
+      OMP(omp parallel for schedule(guided))
+      for (vid_t i = 0; i < state->frontier_count; i++) {
+        vid_t v = state->frontier[i];
+        for (eid_t e = transpose->vertices[v]; e < transpose->vertices[v + 1];
+             e++) {
+          vid_t u = transpose->edges[e];
+          if (state->marker[u] == INFINITE &&
+              state->color[u] == state->color[v]) {
+            scc_claim(state, u, state->color[v]);
+          }
+        }
+      }
+      scc_next_level(state);
+    }
+    scc_compact(state);
+  }
+}
+
+error_t get_strongly_connected_components_cpu(graph_t* graph,
+                                              component_set_t** comp_set_ret) {
+  // Check for special cases
+  bool finished = false;
+  error_t rc = check_special_cases(graph, comp_set_ret, &finished);
+  if (finished) return rc;
+
+  // The transpose of an undirected graph is the graph itself.
+  graph_t* transpose = graph;
+  if (graph->directed) {
+    CALL_SAFE(graph_create_transpose(graph, &transpose));
+  }
+
+  component_set_t* comp_set;
+  allocate_component_set(graph, 0, &comp_set);
+  scc_state_t state;
+  memset(&state, 0, sizeof(scc_state_t));
+  state.graph = graph;
+  state.transpose = transpose;
+  state.marker = comp_set->marker;
+  const vid_t vcount = graph->vertex_count;
+  CALL_SAFE(totem_malloc(vcount * sizeof(eid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state.in_degree)));
+  CALL_SAFE(totem_malloc(vcount * sizeof(eid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state.out_degree)));
+  CALL_SAFE(totem_malloc(vcount * sizeof(vid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state.color)));
+  CALL_SAFE(totem_malloc(vcount * sizeof(vid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state.active)));
+  CALL_SAFE(totem_malloc(vcount * sizeof(vid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state.frontier)));
+  CALL_SAFE(totem_malloc(vcount * sizeof(vid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&state.next)));
+  OMP(omp parallel for schedule(static))
+  for (vid_t v = 0; v < vcount; v++) {
+    state.active[v] = v;
+  }
+  state.active_count = vcount;
+
+  // The trimming and forward-backward steps of [Slota14] G. M. Slota,
+  // S. Rajamanickam, K. Madduri, "BFS and Coloring-based Parallel Algorithms
+  // for Strongly Connected Components and Related Problems", IPDPS 2014,
+  // followed by coloring for the many small components that are left.
+  scc_trim(&state);
+  if (state.active_count > 0) scc_forward_backward(&state);
+  if (state.active_count > 0) scc_trim(&state);
+  scc_coloring(&state);
+
+  // Number the components in the order of their smallest vertex, as done by
+  // get_components_cpu. The color array is reused to map a representative to
+  // the id of its component.
+  OMP(omp parallel for schedule(static))
+  for (vid_t v = 0; v < vcount; v++) {
+    state.color[v] = INFINITE;
+  }
+  vid_t comp_count = 0;
+  for (vid_t v = 0; v < vcount; v++) {
+    vid_t representative = state.marker[v];
+    if (state.color[representative] == INFINITE) {
+      state.color[representative] = comp_count++;
+    }
+    state.marker[v] = state.color[representative];
+  }
+  comp_set->count = comp_count;
+  comp_set->id_count = comp_count;
+
+  // Compute the vertex count and the count of the internal edges of each
+  // component.
+  comp_set->vertex_count = (vid_t*)calloc(comp_count, sizeof(vid_t));
+  comp_set->edge_count   = (eid_t*)calloc(comp_count, sizeof(eid_t));
+  OMP(omp parallel for)
+  for (vid_t vid = 0; vid < vcount; vid++) {
+    vid_t comp = comp_set->marker[vid];
+    __sync_fetch_and_add(&(comp_set->vertex_count[comp]), 1);
+    eid_t nbr_count = 0;
+    for (eid_t i = graph->vertices[vid]; i < graph->vertices[vid + 1]; i++) {
+      nbr_count += (comp_set->marker[graph->edges[i]] == comp);
+    }
+    __sync_fetch_and_add(&(comp_set->edge_count[comp]), nbr_count);
+  }
+  comp_set->biggest = 0;
+  for (vid_t comp = 1; comp < comp_set->count; comp++) {
+    if (comp_set->vertex_count[comp] >
+        comp_set->vertex_count[comp_set->biggest]) {
+      comp_set->biggest = comp;
+    }
+  }
+
+  totem_free(state.in_degree, TOTEM_MEM_HOST);
+  totem_free(state.out_degree, TOTEM_MEM_HOST);
+  totem_free(state.color, TOTEM_MEM_HOST);
+  totem_free(state.active, TOTEM_MEM_HOST);
+  totem_free(state.frontier, TOTEM_MEM_HOST);
+  totem_free(state.next, TOTEM_MEM_HOST);
+  if (transpose != graph) graph_finalize(transpose);
+  *comp_set_ret = comp_set;
+  return SUCCESS;
+}
+
+/**
+ * Finds the root of a component in the union-find forest of a component
+ * stream. The path is halved on the way, via compare-and-swap, which is safe
+ * to race with other finds and unions: a parent is only ever replaced by one
+ * of its ancestors.
+ */
+PRIVATE vid_t component_stream_root(component_stream_t* stream, vid_t comp) {
+  vid_t parent = stream->parent[comp];
+  while (parent != comp) {
+    vid_t grandparent = stream->parent[parent];
+    if (grandparent != parent) {
+      __sync_bool_compare_and_swap(&stream->parent[comp], parent, grandparent);
+    }
+    comp = parent;
+    parent = grandparent;
+  }
+  return comp;
+}
+
+/**
+ * The roots are linked in the order of the size of their components as of the
+ * last refresh, then of their ids. The order does not change during a batch,
+ * hence concurrent unions cannot create a cycle, and the smaller component is
+ * linked to the larger one, which limits the vertices relabeled on refresh.
+ */
+inline PRIVATE bool component_stream_precedes(const component_stream_t* stream,
+                                              vid_t a, vid_t b) {
+  vid_t a_size = stream->comp_set->vertex_count[a];
+  vid_t b_size = stream->comp_set->vertex_count[b];
+  return a_size < b_size || (a_size == b_size && a > b);
+}
+
+// Marks a component as touched by the current batch.
+inline PRIVATE void component_stream_touch(component_stream_t* stream,
+                                           vid_t comp) {
+  if (!stream->touched[comp] &&
+      __sync_bool_compare_and_swap(&stream->touched[comp], 0, 1)) {
+    stream->touched_list[__sync_fetch_and_add(&stream->touched_count, 1)] =
+        comp;
+  }
+}
+
+PRIVATE void component_stream_union(component_stream_t* stream, vid_t a,
+                                    vid_t b) {
+  while (true) {
+    a = component_stream_root(stream, a);
+    b = component_stream_root(stream, b);
+    if (a == b) return;
+    if (component_stream_precedes(stream, b, a)) {
+      vid_t tmp = a;
+      a = b;
+      b = tmp;
+    }
+    if (__sync_bool_compare_and_swap(&stream->parent[a], a, b)) return;
+  }
+}
+
+error_t component_stream_initialize(component_set_t* comp_set,
+                                    component_stream_t** stream_ret) {
+  if (comp_set == NULL || comp_set->graph == NULL || comp_set->count == 0 ||
+      stream_ret == NULL) {
+    return FAILURE;
+  }
+  const vid_t vcount = comp_set->graph->vertex_count;
+  const vid_t count = comp_set->id_count;
+  component_stream_t* stream =
+      (component_stream_t*)calloc(1, sizeof(component_stream_t));
+  assert(stream);
+  stream->comp_set = comp_set;
+  stream->parent = (vid_t*)malloc(count * sizeof(vid_t));
+  stream->head = (vid_t*)malloc(count * sizeof(vid_t));
+  stream->tail = (vid_t*)malloc(count * sizeof(vid_t));
+  stream->next = (vid_t*)malloc(vcount * sizeof(vid_t));
+  stream->pending = (eid_t*)calloc(count, sizeof(eid_t));
+  stream->touched = (uint32_t*)calloc(count, sizeof(uint32_t));
+  stream->touched_list = (vid_t*)malloc(count * sizeof(vid_t));
+  assert(stream->parent && stream->head && stream->tail && stream->next &&
+         stream->pending && stream->touched && stream->touched_list);
+  memset(stream->head, 0xFF, count * sizeof(vid_t));
+  OMP(omp parallel for schedule(static))
+  for (vid_t comp = 0; comp < count; comp++) stream->parent[comp] = comp;
+
+  // Thread the members of each component into a list, which allows a refresh
+  // to relabel the vertices of a component without scanning the others.
+  for (vid_t vid = vcount; vid > 0; vid--) {
+    vid_t comp = comp_set->marker[vid - 1];
+    if (comp >= count) {
+      component_stream_finalize(stream);
+      return FAILURE;
+    }
+    if (stream->head[comp] == INFINITE) stream->tail[comp] = vid - 1;
+    stream->next[vid - 1] = stream->head[comp];
+    stream->head[comp] = vid - 1;
+  }
+  *stream_ret = stream;
+  return SUCCESS;
+}
+
+error_t component_stream_insert(component_stream_t* stream,
+                                const edge_t* edges, eid_t edge_count) {
+  if (stream == NULL || (edges == NULL && edge_count != 0)) return FAILURE;
+  const component_set_t* comp_set = stream->comp_set;
+  const vid_t vcount = comp_set->graph->vertex_count;
+  for (eid_t i = 0; i < edge_count; i++) {
+    if (edges[i].src >= vcount || edges[i].dst >= vcount) return FAILURE;
+  }
+  // An edge of an undirected graph is stored in both directions, hence it is
+  // counted twice, as in get_components_cpu.
+  const eid_t edge_weight = comp_set->graph->directed ? 1 : 2;
+  OMP(omp parallel for schedule(static))
+  for (eid_t i = 0; i < edge_count; i++) {
+    vid_t src = comp_set->marker[edges[i].src];
+    vid_t dst = comp_set->marker[edges[i].dst];
+    component_stream_touch(stream, src);
+    component_stream_touch(stream, dst);
+    __sync_fetch_and_add(&stream->pending[src], edge_weight);
+    component_stream_union(stream, src, dst);
+  }
+  return SUCCESS;
+}
+
+vid_t component_stream_find(component_stream_t* stream, vid_t vid) {
+  assert(stream && vid < stream->comp_set->graph->vertex_count);
+  return component_stream_root(stream, stream->comp_set->marker[vid]);
+}
+
+error_t component_stream_refresh(component_stream_t* stream) {
+  if (stream == NULL) return FAILURE;
+  component_set_t* comp_set = stream->comp_set;
+  const vid_t touched_count = stream->touched_count;
+  const vid_t* touched = stream->touched_list;
+  vid_t* root = (vid_t*)malloc((touched_count + 1) * sizeof(vid_t));
+  assert(root);
+  vid_t merged_count = 0;
+  for (vid_t i = 0; i < touched_count; i++) {
+    root[i] = component_stream_root(stream, touched[i]);
+    merged_count += (root[i] != touched[i]);
+  }
+  vid_t biggest = component_stream_root(stream, comp_set->biggest);
+
+  // Fold the inserted edges and the merged components into their roots, which
+  // keep their ids; the ids of the merged components are left unused.
+  for (vid_t i = 0; i < touched_count; i++) {
+    vid_t comp = touched[i];
+    comp_set->edge_count[root[i]] += stream->pending[comp];
+    stream->pending[comp] = 0;
+    if (root[i] == comp) continue;
+    comp_set->vertex_count[root[i]] += comp_set->vertex_count[comp];
+    comp_set->edge_count[root[i]] += comp_set->edge_count[comp];
+    stream->next[stream->tail[root[i]]] = stream->head[comp];
+    stream->tail[root[i]] = stream->tail[comp];
+  }
+  OMP(omp parallel for schedule(dynamic))
+  for (vid_t i = 0; i < touched_count; i++) {
+    vid_t comp = touched[i];
+    if (root[i] == comp) continue;
+    for (vid_t vid = stream->head[comp]; vid != stream->tail[comp];
+         vid = stream->next[vid]) {
+      comp_set->marker[vid] = root[i];
+    }
+    comp_set->marker[stream->tail[comp]] = root[i];
+  }
+  for (vid_t i = 0; i < touched_count; i++) {
+    vid_t comp = root[i];
+    if (comp_set->vertex_count[comp] > comp_set->vertex_count[biggest] ||
+        (comp_set->vertex_count[comp] == comp_set->vertex_count[biggest] &&
+         comp < biggest)) {
+      biggest = comp;
+    }
+  }
+
+  // Reset the state of the batch, and empty the ids of the merged components.
+  for (vid_t i = 0; i < touched_count; i++) {
+    vid_t comp = touched[i];
+    stream->touched[comp] = 0;
+    stream->parent[comp] = comp;
+    if (root[i] == comp) continue;
+    comp_set->vertex_count[comp] = 0;
+    comp_set->edge_count[comp] = 0;
+  }
+  stream->touched_count = 0;
+  comp_set->count -= merged_count;
+  comp_set->biggest = biggest;
+  free(root);
+  return SUCCESS;
+}
+
+error_t component_stream_finalize(component_stream_t* stream) {
+  if (stream == NULL) return FAILURE;
+  free(stream->parent);
+  free(stream->head);
+  free(stream->tail);
+  free(stream->next);
+  free(stream->pending);
+  free(stream->touched);
+  free(stream->touched_list);
+  free(stream);
+  return SUCCESS;
+}
@@ -5,6 +5,9 @@
  *  Author: Abdullah Gharaibeh
  */
 
+// system includes
+#include <algorithm>
+
 // totem includes
 #include "totem_graph.h"
 #include "totem_mem.h"
@@ -19,6 +22,9 @@ PRIVATE char line[MAX_LINE_LENGTH];
 // Common binary parameters.
 const uint32_t BINARY_MAGIC_WORD = 0x10102048;
 
+// The number of vertices above which subgraphs are built in parallel.
+const vid_t GRAPH_PARALLEL_SCAN_THRESHOLD = 8192;
+
 /**
  * parses the metadata at the very beginning of the graph file
  * @param[in] file_handler a handler to an opened graph file
@@ -406,62 +412,136 @@ error_t graph_initialize(const char* graph_file, bool weighted,
   return FAILURE;
 }
 
-error_t get_subgraph(const graph_t* graph, bool* mask, graph_t** subgraph_ret) {
-  assert(graph && mask);
-
-  // Used to map vertices in the graph to the subgraph to maintain the
-  // requirement that vertex ids start from 0 to vertex_count.
-  vid_t* map = reinterpret_cast<vid_t*>(calloc(graph->vertex_count,
-                                               sizeof(vid_t)));
-
-  // Get the number of vertices and edges of the subgraph and build the map.
-  vid_t subgraph_vertex_count = 0;
-  eid_t subgraph_edge_count = 0;
-  for (vid_t vertex_id = 0; vertex_id < graph->vertex_count; vertex_id++) {
-    if (mask[vertex_id]) {
-      map[vertex_id] = subgraph_vertex_count;
-      subgraph_vertex_count++;
-      for (eid_t i = graph->vertices[vertex_id];
-           i < graph->vertices[vertex_id + 1]; i++) {
-        if (mask[graph->edges[i]]) subgraph_edge_count++;
-      }
+// Large arrays are scanned in parallel: each thread sums a contiguous block,
+// the block sums are scanned, and each thread then scans its block starting
+// from the sum of the blocks before it.
+eid_t graph_exclusive_scan(eid_t* values, vid_t count) {
+  if (count < GRAPH_PARALLEL_SCAN_THRESHOLD) {
+    eid_t sum = 0;
+    for (vid_t i = 0; i < count; i++) {
+      eid_t value = values[i];
+      values[i] = sum;
+      sum += value;
+    }
+    return sum;
+  }
+  int thread_count = omp_get_max_threads();
+  eid_t* block_sums = reinterpret_cast<eid_t*>(
+      calloc(thread_count + 1, sizeof(eid_t)));
+  assert(block_sums);
+  eid_t total = 0;
+  OMP(omp parallel num_threads(thread_count))
+  {
+    int thread = omp_get_thread_num();
+    int threads = omp_get_num_threads();
+    uint64_t block = (count + threads - 1) / threads;
+    vid_t begin = std::min((uint64_t)thread * block, (uint64_t)count);
+    vid_t end = std::min(begin + block, (uint64_t)count);
+    eid_t sum = 0;
+    for (vid_t i = begin; i < end; i++) sum += values[i];
+    block_sums[thread + 1] = sum;
+    OMP(omp barrier)
+    OMP(omp single)
+    {
+      for (int t = 0; t < threads; t++) block_sums[t + 1] += block_sums[t];
+      total = block_sums[threads];
+    }
+    sum = block_sums[thread];
+    for (vid_t i = begin; i < end; i++) {
+      eid_t value = values[i];
+      values[i] = sum;
+      sum += value;
     }
   }
+  free(block_sums);
+  return total;
+}
 
-  assert(subgraph_vertex_count <= graph->vertex_count &&
-         subgraph_edge_count <= graph->edge_count);
+/**
+ * Builds the subgraph induced by a set of vertices. The subgraph id of vertex
+ * order[i] is i, and map returns the subgraph id of a vertex of the graph, or
+ * INFINITE if the vertex is not in the set. The two passes over the vertices
+ * run in parallel for large sets, with a prefix sum of the edge counts in
+ * between.
+ */
+template<typename map_t>
+PRIVATE graph_t* graph_induce(const graph_t* graph, const vid_t* order,
+                              vid_t count, const map_t& map) {
+  eid_t* offsets = reinterpret_cast<eid_t*>(malloc((count + 1) *
+                                                   sizeof(eid_t)));
+  assert(offsets);
+  OMP(omp parallel for schedule(guided) \
+      if (count >= GRAPH_PARALLEL_SCAN_THRESHOLD))
+  for (vid_t i = 0; i < count; i++) {
+    eid_t edges = 0;
+    for (eid_t e = graph->vertices[order[i]]; e < graph->vertices[order[i] + 1];
+         e++) {
+      edges += (map(graph->edges[e]) != INFINITE);
+    }
+    offsets[i] = edges;
+  }
+  eid_t edge_count = graph_exclusive_scan(offsets, count);
+  offsets[count] = edge_count;
 
-  // Allocate the subgraph and its buffers.
   graph_t* subgraph = NULL;
-  graph_allocate(subgraph_vertex_count, subgraph_edge_count, graph->directed,
-                 graph->weighted, graph->valued, &subgraph);
-
-  // Build the vertex and edge lists.
-  eid_t subgraph_edge_index = 0;
-  vid_t subgraph_vertex_index = 0;
-  for (vid_t vid = 0; vid < graph->vertex_count; vid++) {
-    if (mask[vid]) {
-      subgraph->vertices[subgraph_vertex_index] = subgraph_edge_index;
-      if (subgraph->valued) {
-        subgraph->values[subgraph_vertex_index] = graph->values[vid];
-      }
-      subgraph_vertex_index++;
-
-      for (eid_t i = graph->vertices[vid]; i < graph->vertices[vid + 1]; i++) {
-        if (mask[graph->edges[i]]) {
-          subgraph->edges[subgraph_edge_index] = map[graph->edges[i]];
-          if (subgraph->weighted) {
-            subgraph->weights[subgraph_edge_index] = graph->weights[i];
-          }
-          subgraph_edge_index++;
-        }
-      }
+  graph_allocate(count, edge_count, graph->directed, graph->weighted,
+                 graph->valued, &subgraph);
+  memcpy(subgraph->vertices, offsets, (count + 1) * sizeof(eid_t));
+  free(offsets);
+  OMP(omp parallel for schedule(guided) \
+      if (count >= GRAPH_PARALLEL_SCAN_THRESHOLD))
+  for (vid_t i = 0; i < count; i++) {
+    vid_t v = order[i];
+    if (subgraph->valued) subgraph->values[i] = graph->values[v];
+    eid_t index = subgraph->vertices[i];
+    for (eid_t e = graph->vertices[v]; e < graph->vertices[v + 1]; e++) {
+      vid_t id = map(graph->edges[e]);
+      if (id == INFINITE) continue;
+      subgraph->edges[index] = id;
+      if (subgraph->weighted) subgraph->weights[index] = graph->weights[e];
+      index++;
     }
   }
-  subgraph->vertices[subgraph_vertex_index] = subgraph_edge_index;
+  return subgraph;
+}
 
-  free(map);
-  *subgraph_ret = subgraph;
+/**
+ * Maps the vertices of a mask to their rank among the vertices of the mask.
+ */
+class GraphMaskMap {
+ public:
+  GraphMaskMap(const bool* mask, const eid_t* rank)
+      : mask_(mask), rank_(rank) {}
+  vid_t operator()(vid_t v) const {
+    return mask_[v] ? (vid_t)rank_[v] : INFINITE;
+  }
+ private:
+  const bool* mask_;
+  const eid_t* rank_;
+};
+
+error_t get_subgraph(const graph_t* graph, bool* mask, graph_t** subgraph_ret) {
+  assert(graph && mask);
+
+  // Used to map vertices in the graph to the subgraph to maintain the
+  // requirement that vertex ids start from 0 to vertex_count. The rank of each
+  // vertex is the prefix sum of the mask.
+  eid_t* rank = reinterpret_cast<eid_t*>(malloc(graph->vertex_count *
+                                                sizeof(eid_t)));
+  assert(graph->vertex_count == 0 || rank);
+  OMP(omp parallel for schedule(static))
+  for (vid_t v = 0; v < graph->vertex_count; v++) rank[v] = mask[v] ? 1 : 0;
+  vid_t count = graph_exclusive_scan(rank, graph->vertex_count);
+  vid_t* order = reinterpret_cast<vid_t*>(malloc(count * sizeof(vid_t)));
+  assert(count == 0 || order);
+  OMP(omp parallel for schedule(static))
+  for (vid_t v = 0; v < graph->vertex_count; v++) {
+    if (mask[v]) order[rank[v]] = v;
+  }
+
+  *subgraph_ret = graph_induce(graph, order, count, GraphMaskMap(mask, rank));
+  free(rank);
+  free(order);
   return SUCCESS;
 }
 
@@ -483,6 +563,162 @@ error_t graph_remove_singletons(const graph_t* graph, graph_t** subgraph) {
   return err;
 }
 
+/**
+ * Returns a random number that only depends on the seed of an extraction, and
+ * the vertex, hop and draw it is used for, hence the sampled neighbors of a
+ * vertex do not depend on the order of the expansion. It is the finalizer of
+ * SplitMix64.
+ */
+inline PRIVATE uint64_t graph_sample_random(uint64_t seed, vid_t v,
+                                            uint32_t hop, uint32_t draw) {
+  uint64_t x = seed + (((uint64_t)v << 32) ^ ((uint64_t)hop << 24) ^ draw) *
+      0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+/**
+ * Samples count distinct positions out of [0, degree) via Floyd's algorithm,
+ * whose cost depends on count rather than on the degree.
+ */
+PRIVATE void graph_sample_positions(uint64_t seed, vid_t v, uint32_t hop,
+                                    eid_t degree, uint32_t count,
+                                    eid_t* positions) {
+  uint32_t sampled = 0;
+  for (eid_t j = degree - count; j < degree; j++) {
+    eid_t position = graph_sample_random(seed, v, hop, sampled) % (j + 1);
+    for (uint32_t i = 0; i < sampled; i++) {
+      if (positions[i] == position) {
+        position = j;
+        break;
+      }
+    }
+    positions[sampled++] = position;
+  }
+}
+
+/**
+ * Maps the vertices of the current extraction of an extractor to their
+ * subgraph ids.
+ */
+class GraphExtractionMap {
+ public:
+  explicit GraphExtractionMap(const subgraph_extractor_t* extractor)
+      : extractor_(extractor) {}
+  vid_t operator()(vid_t v) const {
+    return extractor_->stamp[v] == extractor_->extraction ?
+        extractor_->map[v] : INFINITE;
+  }
+ private:
+  const subgraph_extractor_t* extractor_;
+};
+
+error_t subgraph_extractor_initialize(const graph_t* graph,
+                                      subgraph_extractor_t** extractor) {
+  if (graph == NULL || graph->vertex_count == 0 || extractor == NULL) {
+    return FAILURE;
+  }
+  subgraph_extractor_t* result = reinterpret_cast<subgraph_extractor_t*>(
+      calloc(1, sizeof(subgraph_extractor_t)));
+  assert(result);
+  result->graph = graph;
+  result->map = reinterpret_cast<vid_t*>(malloc(graph->vertex_count *
+                                                sizeof(vid_t)));
+  result->stamp = reinterpret_cast<uint32_t*>(calloc(graph->vertex_count,
+                                                     sizeof(uint32_t)));
+  assert(result->map && result->stamp);
+  *extractor = result;
+  return SUCCESS;
+}
+
+error_t subgraph_extractor_finalize(subgraph_extractor_t* extractor) {
+  if (extractor == NULL) return FAILURE;
+  free(extractor->map);
+  free(extractor->stamp);
+  free(extractor);
+  return SUCCESS;
+}
+
+error_t graph_extract_khop(subgraph_extractor_t* extractor,
+                           const vid_t* seeds, vid_t seed_count,
+                           uint32_t hops, const uint32_t* fanouts,
+                           uint64_t sample_seed, graph_t** subgraph,
+                           vid_t** id_map) {
+  if (extractor == NULL || (seeds == NULL && seed_count != 0) ||
+      subgraph == NULL || id_map == NULL) {
+    return FAILURE;
+  }
+  const graph_t* graph = extractor->graph;
+  for (vid_t i = 0; i < seed_count; i++) {
+    if (seeds[i] >= graph->vertex_count) return FAILURE;
+  }
+  // Start a new extraction; when its id wraps around, the stamps are reset.
+  extractor->extraction++;
+  if (extractor->extraction == 0) {
+    memset(extractor->stamp, 0, graph->vertex_count * sizeof(uint32_t));
+    extractor->extraction = 1;
+  }
+  uint32_t max_fanout = 0;
+  for (uint32_t hop = 0; fanouts && hop < hops; hop++) {
+    max_fanout = std::max(max_fanout, fanouts[hop]);
+  }
+  eid_t* positions = reinterpret_cast<eid_t*>(malloc((max_fanout + 1) *
+                                                     sizeof(eid_t)));
+  assert(positions);
+
+  // The vertices are collected in the order they are reached, which is also
+  // their order in the subgraph: the seeds, then each hop in turn.
+  vid_t capacity = std::max(seed_count, (vid_t)64);
+  vid_t* order = reinterpret_cast<vid_t*>(malloc(capacity * sizeof(vid_t)));
+  assert(order);
+  vid_t count = 0;
+  for (vid_t i = 0; i < seed_count; i++) {
+    vid_t v = seeds[i];
+    if (extractor->stamp[v] == extractor->extraction) continue;
+    extractor->stamp[v] = extractor->extraction;
+    extractor->map[v] = count;
+    order[count++] = v;
+  }
+  vid_t begin = 0;
+  for (uint32_t hop = 0; hop < hops && begin < count; hop++) {
+    const vid_t end = count;
+    const uint32_t fanout = fanouts ? fanouts[hop] : 0;
+    for (vid_t i = begin; i < end; i++) {
+      vid_t u = order[i];
+      const eid_t first = graph->vertices[u];
+      const eid_t degree = graph->vertices[u + 1] - first;
+      eid_t selected = degree;
+      if (fanout != 0 && degree > fanout) {
+        graph_sample_positions(sample_seed, u, hop, degree, fanout,
+                               positions);
+        selected = fanout;
+      }
+      for (eid_t j = 0; j < selected; j++) {
+        vid_t v = graph->edges[first + (selected == degree ? j :
+                                        positions[j])];
+        if (extractor->stamp[v] == extractor->extraction) continue;
+        extractor->stamp[v] = extractor->extraction;
+        extractor->map[v] = count;
+        if (count == capacity) {
+          capacity *= 2;
+          order = reinterpret_cast<vid_t*>(realloc(order, capacity *
+                                                   sizeof(vid_t)));
+          assert(order);
+        }
+        order[count++] = v;
+      }
+    }
+    begin = end;
+  }
+  free(positions);
+
+  *subgraph = graph_induce(graph, order, count,
+                           GraphExtractionMap(extractor));
+  *id_map = order;
+  return SUCCESS;
+}
+
 PRIVATE
 void graph_match_bidirected_edges(graph_t* graph, eid_t** reverse_indices) {
   // Calculate the array of indexes matching each edge to its counterpart
@@ -584,6 +820,73 @@ graph_t* graph_create_bidirectional(graph_t* graph, eid_t** reverse_indices) {
   return new_graph;
 }
 
+PRIVATE int compare_transpose_entries(const void* a, const void* b) {
+  uint64_t x = *(reinterpret_cast<const uint64_t*>(a));
+  uint64_t y = *(reinterpret_cast<const uint64_t*>(b));
+  return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+error_t graph_create_transpose(const graph_t* graph, graph_t** transpose) {
+  if (graph == NULL || graph->vertex_count == 0 || transpose == NULL) {
+    return FAILURE;
+  }
+  graph_t* result;
+  graph_allocate(graph->vertex_count, graph->edge_count, graph->directed,
+                 graph->weighted, graph->valued, &result);
+  if (graph->valued && graph->vertex_count != 0) {
+    memcpy(result->values, graph->values,
+           graph->vertex_count * sizeof(weight_t));
+  }
+
+  // Count the incoming edges of each vertex, and turn the counts into offsets.
+  memset(result->vertices, 0, (graph->vertex_count + 1) * sizeof(eid_t));
+  OMP(omp parallel for schedule(static))
+  for (eid_t e = 0; e < graph->edge_count; e++) {
+    __sync_fetch_and_add(&result->vertices[graph->edges[e] + 1], 1);
+  }
+  for (vid_t v = 0; v < graph->vertex_count; v++) {
+    result->vertices[v + 1] += result->vertices[v];
+  }
+
+  // Scatter each edge (u, v) as an entry of the list of v that packs u and the
+  // weight of the edge. The entries are placed via atomic cursors, hence each
+  // list is then sorted to make the result independent of the interleaving.
+  uint64_t* entries = NULL;
+  eid_t* cursor = NULL;
+  if (graph->edge_count != 0) {
+    CALL_SAFE(totem_malloc(graph->edge_count * sizeof(uint64_t),
+                           TOTEM_MEM_HOST,
+                           reinterpret_cast<void**>(&entries)));
+  }
+  CALL_SAFE(totem_malloc(graph->vertex_count * sizeof(eid_t), TOTEM_MEM_HOST,
+                         reinterpret_cast<void**>(&cursor)));
+  memcpy(cursor, result->vertices, graph->vertex_count * sizeof(eid_t));
+  OMP(omp parallel for schedule(guided))
+  for (vid_t u = 0; u < graph->vertex_count; u++) {
+    for (eid_t e = graph->vertices[u]; e < graph->vertices[u + 1]; e++) {
+      uint64_t weight = graph->weighted ? graph->weights[e] : 0;
+      eid_t slot = __sync_fetch_and_add(&cursor[graph->edges[e]], 1);
+      entries[slot] = ((uint64_t)u << 32) | weight;
+    }
+  }
+  OMP(omp parallel for schedule(guided))
+  for (vid_t v = 0; v < graph->vertex_count; v++) {
+    eid_t begin = result->vertices[v];
+    eid_t end = result->vertices[v + 1];
+    qsort(&entries[begin], end - begin, sizeof(uint64_t),
+          compare_transpose_entries);
+    for (eid_t e = begin; e < end; e++) {
+      result->edges[e] = (vid_t)(entries[e] >> 32);
+      if (graph->weighted) result->weights[e] = (weight_t)entries[e];
+    }
+  }
+  if (entries) totem_free(entries, TOTEM_MEM_HOST);
+  totem_free(cursor, TOTEM_MEM_HOST);
+
+  *transpose = result;
+  return SUCCESS;
+}
+
 error_t graph_finalize(graph_t* graph) {
   assert(graph);
   if (graph->vertex_count != 0) free(graph->vertices);
@@ -169,18 +169,58 @@ typedef struct graph_s {
   eid_t    edge_count_ext;
 } graph_t;
 
+// Defines an edge of a batch of updates to a graph. The weight is ignored by
+// the algorithms that do not use edge weights.
+typedef struct edge_s {
+  vid_t    src;     // The source vertex of the edge.
+  vid_t    dst;     // The destination vertex of the edge.
+  weight_t weight;  // The weight of the edge.
+} edge_t;
+
 // Defines a data type for a graph's connected components. components are
-// identified by numbers [0 - count). The marker array identifies for each
-// vertex the id of the component the vertex is part of.
+// identified by numbers [0 - id_count), which are dense ([0 - count)) unless a
+// component stream has merged components, whose ids are then left unused,
+// with a vertex count of zero. The marker array identifies for each vertex the
+// id of the component the vertex is part of.
 typedef struct component_set_s {
   graph_t* graph;         // The graph which this component set belongs to.
   vid_t    count;         // Number of components.
+  vid_t    id_count;      // Upper bound of the component ids.
   vid_t*   vertex_count;  // Vertex count of each component.
   eid_t*   edge_count;    // Edge count of each component.
   vid_t*   marker;        // The component id for each vertex
   vid_t    biggest;       // The id of the biggest component.
 } component_set_t;
 
+// Defines the state of a stream of edge insertions that maintains the weakly
+// connected components of a component set. The components are the nodes of a
+// concurrent union-find forest, and the members of each component are
+// threaded into a list, so that a refresh relabels only the vertices of the
+// components that were merged into larger ones.
+typedef struct component_stream_s {
+  component_set_t* comp_set;  // The component set refreshed by the stream.
+  vid_t*    parent;        // The union-find parent of each component.
+  vid_t*    head;          // The first member of each component.
+  vid_t*    tail;          // The last member of each component.
+  vid_t*    next;          // The next member of the component of each vertex.
+  eid_t*    pending;       // Edges inserted into each component since the
+                           // last refresh.
+  uint32_t* touched;       // Indicates if a component is touched by a batch.
+  vid_t*    touched_list;  // The components touched since the last refresh.
+  vid_t     touched_count;
+} component_stream_t;
+
+// Defines the state of a k-hop subgraph extractor. An extractor is reused
+// across extractions, and is owned by a single thread at a time; concurrent
+// extractions use one extractor each. The stamp array marks the vertices of
+// the current extraction, which avoids clearing the map between extractions.
+typedef struct subgraph_extractor_s {
+  const graph_t* graph;   // The graph to extract subgraphs from.
+  vid_t*    map;          // The subgraph id of each marked vertex.
+  uint32_t* stamp;        // The extraction which last marked each vertex.
+  uint32_t  extraction;   // The id of the current extraction.
+} subgraph_extractor_t;
+
 /**
  * Allocates space for a graph structure and its buffers, and sets the
  * various members of the structure.
@@ -283,6 +323,16 @@ void graph_sort_nbrs(graph_t* graph, bool edge_sort_dsc = false);
  */
 void graph_sort_nbrs_by_degree(graph_t* graph, bool edge_sort_dsc = false);
 
+/**
+ * Replaces each entry of an array by the sum of the entries before it, which
+ * turns an array of degrees into the offsets of a CSR. Large arrays are
+ * scanned in parallel.
+ * @param[in] values the array to scan in place
+ * @param[in] count the number of entries of the array
+ * @return the sum of all the entries
+ */
+eid_t graph_exclusive_scan(eid_t* values, vid_t count);
+
 /**
  * Given a given flow graph (ie, a directed graph where for every edge (u,v),
  * there is no edge (v,u)), creates a bidirected graph having reverse edges
@@ -299,6 +349,61 @@ void graph_sort_nbrs_by_degree(graph_t* graph, bool edge_sort_dsc = false);
  */
 graph_t* graph_create_bidirectional(graph_t* graph, eid_t** reverse_indices);
 
+/**
+ * Creates the transpose of a graph, in which every edge (u, v) of the graph
+ * becomes the edge (v, u) with the same weight. The neighbors of each vertex
+ * of the transpose are sorted by id. The transpose is built in parallel, and
+ * is de-allocated via graph_finalize.
+ * @param[in] graph the graph to transpose
+ * @param[out] transpose a reference to the allocated transpose
+ * @return generic success or failure
+ */
+error_t graph_create_transpose(const graph_t* graph, graph_t** transpose);
+
+/**
+ * Allocates a k-hop subgraph extractor for a graph. The extractor is
+ * de-allocated via subgraph_extractor_finalize.
+ * @param[in] graph the graph to extract subgraphs from
+ * @param[out] extractor a reference to the allocated extractor
+ * @return generic success or failure
+ */
+error_t subgraph_extractor_initialize(const graph_t* graph,
+                                      subgraph_extractor_t** extractor);
+
+/**
+ * De-allocates a k-hop subgraph extractor.
+ * @param[in] extractor the extractor to de-allocate
+ * @return generic success or failure
+ */
+error_t subgraph_extractor_finalize(subgraph_extractor_t* extractor);
+
+/**
+ * Extracts the subgraph induced by the vertices within a number of hops from a
+ * set of seeds, following the outgoing edges. At each hop, the expansion of a
+ * vertex can be limited to a random sample of its neighbors. The sample of a
+ * vertex depends only on the sample seed, the vertex and the hop, hence an
+ * extraction is deterministic. The subgraph vertices are numbered compactly in
+ * the order they are reached: the distinct seeds first, then each hop in turn.
+ * The subgraph keeps all the edges among its vertices, and is de-allocated via
+ * graph_finalize.
+ * @param[in] extractor the extractor to use
+ * @param[in] seeds the vertices to start the expansion from
+ * @param[in] seed_count the number of seeds
+ * @param[in] hops the number of hops to expand
+ * @param[in] fanouts the maximum number of neighbors to expand per vertex at
+ *            each hop, zero meaning all; NULL expands all the neighbors
+ * @param[in] sample_seed the seed of the neighbor sampling
+ * @param[out] subgraph a reference to the allocated subgraph
+ * @param[out] id_map maps each subgraph vertex to its id in the graph; it is
+ *             de-allocated via free
+ * @return generic success or failure
+ */
+error_t graph_extract_khop(subgraph_extractor_t* extractor,
+                           const vid_t* seeds, vid_t seed_count,
+                           uint32_t hops, const uint32_t* fanouts,
+                           uint64_t sample_seed, graph_t** subgraph,
+                           vid_t** id_map);
+
 /**
  * Identifies the weakly connected components in the graph
  * @param[in] graph
@@ -308,6 +413,23 @@ graph_t* graph_create_bidirectional(graph_t* graph, eid_t** reverse_indices);
  */
 error_t get_components_cpu(graph_t* graph, component_set_t** comp_set_ret);
 
+/**
+ * Identifies the strongly connected components of a directed graph: two
+ * vertices are in the same component if each is reachable from the other.
+ * The trivial components are trimmed first, then the giant component is found
+ * by forward-backward reachability from a pivot, and the remaining components
+ * are found via coloring. The transpose of the graph is built once, in
+ * parallel. For undirected graphs, the result is the same as the one of
+ * get_components_cpu. The edge count of a component is the number of edges
+ * between its vertices.
+ * @param[in] graph
+ * @param[out] comp_set a component set structure which
+ *             identifies the components in the graph
+ * @return generic success or failure
+ */
+error_t get_strongly_connected_components_cpu(graph_t* graph,
+                                              component_set_t** comp_set_ret);
+
 /**
  * De-allocates a component_set_t object
  * @param[in] comp_set a reference to component set type to be de-allocated
@@ -315,4 +437,59 @@ error_t get_components_cpu(graph_t* graph, component_set_t** comp_set_ret);
  */
 error_t finalize_component_set(component_set_t* comp_set);
 
+/**
+ * Creates a stream of edge insertions seeded from the weakly connected
+ * components of a graph, as returned by get_components_cpu. The stream
+ * refreshes the component set in place, hence the set must outlive the
+ * stream, and is still de-allocated via finalize_component_set. The graph of
+ * the set is only used for its vertex count and direction; it is not updated
+ * by the stream.
+ * @param[in] comp_set the component set to maintain
+ * @param[out] stream a reference to the allocated stream
+ * @return generic success or failure
+ */
+error_t component_stream_initialize(component_set_t* comp_set,
+                                    component_stream_t** stream);
+
+/**
+ * Absorbs a batch of edge insertions, in parallel. The batch is reflected in
+ * component_stream_find right away, and in the component set after a refresh.
+ * @param[in] stream the stream to insert into
+ * @param[in] edges the inserted edges
+ * @param[in] edge_count the number of inserted edges
+ * @return generic success or failure
+ */
+error_t component_stream_insert(component_stream_t* stream,
+                                const edge_t* edges, eid_t edge_count);
+
+/**
+ * Returns the component of a vertex, including the batches inserted since the
+ * last refresh. The ids are those of the set as of the last refresh: two
+ * vertices are connected if and only if their components are the same. The
+ * query is lock-free, and may run concurrently with other queries and with
+ * insertions.
+ * @param[in] stream the stream to query
+ * @param[in] vid the vertex to query
+ * @return the component id of the vertex
+ */
+vid_t component_stream_find(component_stream_t* stream, vid_t vid);
+
+/**
+ * Refreshes the component set with the batches inserted since the last
+ * refresh: the markers, the vertex and edge counts of each component, the
+ * number of components and the biggest one. A merged component takes the id of
+ * the largest of its parts, hence only the vertices of the smaller parts are
+ * relabeled, and the ids of the smaller parts are left unused.
+ * @param[in] stream the stream to refresh
+ * @return generic success or failure
+ */
+error_t component_stream_refresh(component_stream_t* stream);
+
+/**
+ * De-allocates a stream of edge insertions, but not its component set.
+ * @param[in] stream the stream to de-allocate
+ * @return generic success or failure
+ */
+error_t component_stream_finalize(component_stream_t* stream);
+
 #endif  // TOTEM_GRAPH_H
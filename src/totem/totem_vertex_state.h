@@ -0,0 +1,160 @@
+/**
+ * Defines a container for per-vertex algorithm state that packs several
+ * fields of a vertex together.
+ *
+ * Algorithms typically keep each per-vertex field in a separate array, hence
+ * visiting a vertex touches one cache line per field. The container stores the
+ * fields described by a plain struct (the field set) in one buffer, and the
+ * layout of that buffer is selected at compile time:
+ *   - VERTEX_STATE_AOS: the fields of a vertex are adjacent (array of
+ *     structs). Best when a visit reads most of the fields of a vertex.
+ *   - VERTEX_STATE_SOA: each field is stored in its own contiguous region
+ *     (struct of arrays), which matches the classical separate arrays.
+ *   - VERTEX_STATE_BLOCKED: vertices are grouped in blocks of
+ *     VERTEX_STATE_BLOCK_SIZE, and each block is laid out as a struct of
+ *     arrays. It keeps the fields of a vertex within a few cache lines while
+ *     still allowing dense scans of a single field.
+ *
+ * A field is accessed via a pointer to a member of the field set, for example:
+ *   typedef struct { cost_t distance; uint32_t numSPs; } bfs_fields_t;
+ *   vertex_state_t<bfs_fields_t, VERTEX_STATE_AOS> state;
+ *   vertex_state_get(state, v, &bfs_fields_t::distance) = 0;
+ */
+
+#ifndef TOTEM_VERTEX_STATE_H
+#define TOTEM_VERTEX_STATE_H
+
+// totem includes
+#include "totem_comdef.h"
+#include "totem_mem.h"
+
+/**
+ * Layouts supported by the vertex state container.
+ */
+typedef enum {
+  VERTEX_STATE_AOS = 0,  // array of structs
+  VERTEX_STATE_SOA,      // struct of arrays
+  VERTEX_STATE_BLOCKED   // array of blocks, each block is a struct of arrays
+} vertex_state_layout_t;
+
+/**
+ * The layout of the per-vertex state of the algorithms ported to the container
+ * (betweenness_cpu and maxflow_cpu). It is SoA, which was timed the fastest
+ * for betweenness and on par for maxflow, unless the build selects another one
+ * (make VSTATE=AOS or VSTATE=BLOCKED) to compare the layouts on the same
+ * algorithm.
+ */
+#if defined(FEATURE_VERTEX_STATE_AOS)
+#define VERTEX_STATE_DEFAULT_LAYOUT VERTEX_STATE_AOS
+#elif defined(FEATURE_VERTEX_STATE_BLOCKED)
+#define VERTEX_STATE_DEFAULT_LAYOUT VERTEX_STATE_BLOCKED
+#else
+#define VERTEX_STATE_DEFAULT_LAYOUT VERTEX_STATE_SOA
+#endif
+
+/**
+ * Number of vertices per block in the blocked layout. A block of a 4-byte
+ * field spans four cache lines.
+ */
+#define VERTEX_STATE_BLOCK_SIZE 64
+
+/**
+ * The per-vertex state of vertex_count vertices. fields_t is a plain struct
+ * that lists the fields of a vertex.
+ */
+template<typename fields_t, vertex_state_layout_t LAYOUT>
+struct vertex_state_t {
+  char*       data;          // the packed buffer
+  vid_t       vertex_count;  // number of vertices
+  vid_t       capacity;      // vertex_count rounded up to a full block
+  totem_mem_t type;          // type of memory the buffer is allocated in
+};
+
+/**
+ * Allocates the state of vertex_count vertices. The fields are zeroed.
+ * @param[in] vertex_count number of vertices
+ * @param[in] type type of memory to allocate the state in
+ * @param[out] state the state to initialize
+ * @return generic success or failure
+ */
+template<typename fields_t, vertex_state_layout_t LAYOUT>
+error_t vertex_state_initialize(vid_t vertex_count, totem_mem_t type,
+                                vertex_state_t<fields_t, LAYOUT>* state) {
+  if (state == NULL) return FAILURE;
+  state->vertex_count = vertex_count;
+  state->capacity = vertex_count;
+  if (LAYOUT == VERTEX_STATE_BLOCKED) {
+    state->capacity = ((vertex_count + VERTEX_STATE_BLOCK_SIZE - 1) /
+                       VERTEX_STATE_BLOCK_SIZE) * VERTEX_STATE_BLOCK_SIZE;
+  }
+  state->type = type;
+  state->data = NULL;
+  if (vertex_count == 0) return SUCCESS;
+  return totem_calloc((size_t)state->capacity * sizeof(fields_t), type,
+                      reinterpret_cast<void**>(&state->data));
+}
+
+/**
+ * Frees the state allocated by vertex_state_initialize.
+ * @param[in] state the state to free
+ */
+template<typename fields_t, vertex_state_layout_t LAYOUT>
+void vertex_state_finalize(vertex_state_t<fields_t, LAYOUT>* state) {
+  if (state->data) totem_free(state->data, state->type);
+  state->data = NULL;
+}
+
+/**
+ * Returns a reference to a field of a vertex. The offset of the field is a
+ * compile-time constant once the call is inlined, hence the address
+ * computation reduces to a multiply-add for the AoS and SoA layouts, and to a
+ * few shifts and masks for the blocked one.
+ *
+ * In the SoA and blocked layouts, a field at offset o of the field set starts
+ * at o times the number of vertices of the region. Since the fields of the
+ * struct do not overlap, neither do the regions, and every element keeps the
+ * alignment of its field.
+ * @param[in] state the vertex state
+ * @param[in] v the vertex
+ * @param[in] field pointer to the member of the field set to access
+ * @return a reference to the field of the vertex
+ */
+template<typename field_t, typename fields_t, vertex_state_layout_t LAYOUT>
+__host__ __device__ inline
+field_t& vertex_state_get(const vertex_state_t<fields_t, LAYOUT>& state,
+                          vid_t v, field_t fields_t::* field) {
+  const fields_t* base = reinterpret_cast<const fields_t*>(state.data);
+  size_t offset = reinterpret_cast<const char*>(&(base->*field)) -
+      reinterpret_cast<const char*>(base);
+  size_t address;
+  if (LAYOUT == VERTEX_STATE_AOS) {
+    address = (size_t)v * sizeof(fields_t) + offset;
+  } else if (LAYOUT == VERTEX_STATE_SOA) {
+    address = offset * state.capacity + (size_t)v * sizeof(field_t);
+  } else {
+    size_t block = v / VERTEX_STATE_BLOCK_SIZE;
+    size_t index = v % VERTEX_STATE_BLOCK_SIZE;
+    address = block * (sizeof(fields_t) * VERTEX_STATE_BLOCK_SIZE) +
+        offset * VERTEX_STATE_BLOCK_SIZE + index * sizeof(field_t);
+  }
+  return *reinterpret_cast<field_t*>(state.data + address);
+}
+
+/**
+ * Sets a field of all the vertices to the given value. Only host buffers are
+ * supported.
+ * @param[in] state the vertex state
+ * @param[in] field pointer to the member of the field set to set
+ * @param[in] value the value to set the field to
+ */
+template<typename field_t, typename fields_t, vertex_state_layout_t LAYOUT>
+void vertex_state_fill(const vertex_state_t<fields_t, LAYOUT>& state,
+                       field_t fields_t::* field, field_t value) {
+  assert(state.type != TOTEM_MEM_DEVICE);
+  OMP(omp parallel for schedule(static))
+  for (vid_t v = 0; v < state.vertex_count; v++) {
+    vertex_state_get(state, v, field) = value;
+  }
+}
+
+#endif  // TOTEM_VERTEX_STATE_H